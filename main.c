@@ -149,10 +149,12 @@
  */
 
 #include <stdio.h>
-#include <time.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "src/configs/libconfig.h"
 #include "src/miscellaneous/liberrorcode.h"
+#include "src/miscellaneous/libmiscellaneous.h"
 #include "src/meshreader/libmeshreader.h"
 #include "src/solver/libsolver.h"
 #include "src/miscellaneous/benchmark/libbenchmark.h"
@@ -167,7 +169,7 @@ unsigned int terminateAll(struct dataForSimulation *);
  * main: opens and reads the input file
  */
 int main(int argc, char *argv[]) {
-    clock_t begin = clock();
+    beginPhaseProfiler("tlmbht");
     struct dataForSimulation newDataConfig;
     unsigned int tlmErrorCode = 0;
 
@@ -197,26 +199,24 @@ int main(int argc, char *argv[]) {
 
     // Opening the input file
     printf("Reading the inputs...\n");
-    clock_t begin_read = clock();
+    beginPhaseProfiler("read the inputs");
     if ((tlmErrorCode = testAndReadInputFile(argc, argv, &newDataConfig)) != 0) {
         terminateAll(&newDataConfig);
         return tlmErrorCode;
     }
 
-    clock_t end_read = clock();
+    double time_spent_read = endPhaseProfiler();
     printf("Done reading the inputs.\n");
 
     if (newDataConfig.simulationInput.timingMode == 1) {
-        double time_spent_read = (double) (end_read - begin_read) / CLOCKS_PER_SEC;
-        printf("\n\nTime to read the inputs %g ms (or %g s, or %g min, or %g hours).\n\n",
-                time_spent_read * 1e3, time_spent_read, time_spent_read / 60.0, time_spent_read / (60 * 60));
+        printTimeProfiler(time_spent_read, "\n\nTime to read the inputs");
     }
 
 
 
     // Benchmark is future implementation
     if (newDataConfig.runningBenchmark == 1) {
-        if ((tlmErrorCode = runBenchmark()) != 0) {
+        if ((tlmErrorCode = runBenchmark(newDataConfig.simulationInput.Benchmark)) != 0) {
             terminateAll(&newDataConfig);
             return tlmErrorCode;
         }
@@ -230,19 +230,17 @@ int main(int argc, char *argv[]) {
 
         // Reading and Converting the input mesh if required
         printf("Reading the mesh file...\n");
-        clock_t begin_read_mesh = clock();
+        beginPhaseProfiler("read the mesh");
         if ((tlmErrorCode = meshReaderAndConverter(&newDataConfig.meshInput,
-                &newDataConfig.mesh)) != 0) {
+                &newDataConfig.mesh, &newDataConfig.simulationInput)) != 0) {
             terminateAll(&newDataConfig);
             return tlmErrorCode;
         }
-        clock_t end_read_mesh = clock();
+        double time_spent_read_mesh = endPhaseProfiler();
         printf("Done reading the mesh file.\n");
 
         if (newDataConfig.simulationInput.timingMode == 1) {
-            double time_spent_read_mesh = (double) (end_read_mesh - begin_read_mesh) / CLOCKS_PER_SEC;
-            printf("\n\nTime to read the mesh file %g ms (or %g s, or %g min, or %g hours).\n\n",
-                    time_spent_read_mesh * 1e3, time_spent_read_mesh, time_spent_read_mesh / 60.0, time_spent_read_mesh / (60 * 60));
+            printTimeProfiler(time_spent_read_mesh, "\n\nTime to read the mesh file");
         }
 
         if (newDataConfig.simulationInput.printAdditionalMode == 1)
@@ -251,41 +249,61 @@ int main(int argc, char *argv[]) {
 
         // Solving
         printf("Starting the solver.\n");
-        clock_t begin_solver = clock();
+        beginPhaseProfiler("solve");
         if ((tlmErrorCode = solve(&newDataConfig)) != 0) {
             terminateAll(&newDataConfig);
             return tlmErrorCode;
         }
-        clock_t end_solver = clock();
+        double time_spent_solver = endPhaseProfiler();
         printf("All the calculations are done.\n");
 
         if (newDataConfig.simulationInput.timingMode == 1) {
-            double time_spent_solver = (double) (end_solver - begin_solver) / CLOCKS_PER_SEC;
-            printf("\n\nTime to solve the problems %g ms (or %g s, or %g min, or %g hours).\n\n",
-                    time_spent_solver * 1e3, time_spent_solver, time_spent_solver / 60.0, time_spent_solver / (60 * 60));
+            printTimeProfiler(time_spent_solver, "\n\nTime to solve the problems");
         }
     }
 
 
+    // the report of the phases has the name of the output file, which is
+    // released with the other variables
+    char *nameOfReport = NULL;
+    if (newDataConfig.simulationInput.timingMode == 1 && newDataConfig.runningSimulation == 1 &&
+            (nameOfReport = malloc(strlen(newDataConfig.simulationInput.nameOfOutputFile) + 1)) != NULL)
+        strcpy(nameOfReport, newDataConfig.simulationInput.nameOfOutputFile);
+
     //closing the input data for configuration
     if (newDataConfig.simulationInput.verboseMode == 1) {
         printf("Cleaning the used variables...\n");
     }
 
-    if ((tlmErrorCode = terminateAll(&newDataConfig)) != 0)
+    beginPhaseProfiler("clean the variables");
+    if ((tlmErrorCode = terminateAll(&newDataConfig)) != 0) {
+        free(nameOfReport);
         return tlmErrorCode;
+    }
+    endPhaseProfiler();
 
     if (newDataConfig.simulationInput.verboseMode == 1) {
         printf("Done cleaning the used variables.\n");
     }
 
 
-    clock_t end = clock();
+    double time_spent = endPhaseProfiler();
 
     if (newDataConfig.simulationInput.timingMode == 1) {
-        double time_spent = (double) (end - begin) / CLOCKS_PER_SEC;
-        printf("\n\nTotal execution time %g ms (or %g s, or %g min, or %g hours).\n\n",
-                time_spent * 1e3, time_spent, time_spent / 60.0, time_spent / (60 * 60));
+        printTimeProfiler(time_spent, "\n\nTotal execution time");
+    }
+
+    // the times of the phases are also written to files, to be compared
+    // between versions
+    if (nameOfReport != NULL) {
+        if ((tlmErrorCode = writeReportProfiler(nameOfReport)) != 0) {
+            sendErrorCodeAndMessage(tlmErrorCode, nameOfReport, NULL, NULL, NULL);
+            free(nameOfReport);
+            return tlmErrorCode;
+        }
+        printf("Times of the phases written to %s_profile.json and %s_profile.csv.\n",
+                nameOfReport, nameOfReport);
+        free(nameOfReport);
     }
 
     return 0;
@@ -33,6 +33,7 @@
  *
  */
 
+#include <ctype.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -68,6 +69,8 @@ unsigned int testAndReadInputFile(int nInput, char* pArgs[], struct dataForSimul
                     newDataForSimu->simulationInput.verboseMode = 1;
                 } else if (compareCaseInsensitive(pArgs[i], "--timing") == 0) {
                     newDataForSimu->simulationInput.timingMode = 1;
+                } else if (compareCaseInsensitive(pArgs[i], "--restart") == 0) {
+                    newDataForSimu->simulationInput.restart = 1;
                 } else if (compareCaseInsensitive(pArgs[i], "--help") == 0) {
                     showHelp = 1;
                 } else if (compareCaseInsensitive(pArgs[i], "--version") == 0) {
@@ -88,16 +91,18 @@ unsigned int testAndReadInputFile(int nInput, char* pArgs[], struct dataForSimul
                 }
             } else {
                 for (int j = 1; j < strlen(pArgs[i]); j++) {
-                    // the input starts with '-'
-                    if (compareCaseInsensitive(pArgs[i], "e") == 0) {
+                    // the input starts with '-', so each letter is an option
+                    if (tolower(pArgs[i][j]) == 'e') {
                         newDataForSimu->simulationInput.verboseMode = 1;
-                    } else if (compareCaseInsensitive(pArgs[i], "t") == 0) {
+                    } else if (tolower(pArgs[i][j]) == 't') {
                         newDataForSimu->simulationInput.timingMode = 1;
-                    } else if (compareCaseInsensitive(pArgs[i], "h") == 0) {
+                    } else if (tolower(pArgs[i][j]) == 'r') {
+                        newDataForSimu->simulationInput.restart = 1;
+                    } else if (tolower(pArgs[i][j]) == 'h') {
                         showHelp = 1;
-                    } else if (compareCaseInsensitive(pArgs[i], "v") == 0) {
+                    } else if (tolower(pArgs[i][j]) == 'v') {
                         showVersion = 1;
-                    } else if (compareCaseInsensitive(pArgs[i], "i") == 0) {
+                    } else if (tolower(pArgs[i][j]) == 'i') {
                         if (inputPositionDefined == 1) {
                             tlmErrorCode = 317;
                             sendErrorCodeAndMessage(tlmErrorCode, &i, pArgs[i], &inputPosition, pArgs[inputPosition]);
@@ -112,6 +117,8 @@ unsigned int testAndReadInputFile(int nInput, char* pArgs[], struct dataForSimul
                         break;
                     }
                 }
+                if (tlmErrorCode != 0)
+                    break;
             }
         } else if (i == 1) {
             // it didn't start with '-' so I'm assuming this is the input
@@ -139,6 +146,8 @@ unsigned int testAndReadInputFile(int nInput, char* pArgs[], struct dataForSimul
     printf("Verbose mode on\n");
     if (newDataForSimu->simulationInput.timingMode == 1)
         printf("Timing mode on\n");
+    if (newDataForSimu->simulationInput.restart == 1)
+        printf("Restart mode on\n");
     if (showHelp == 1)
         printf("HELP\n");
     if (showVersion == 1)
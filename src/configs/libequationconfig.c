@@ -84,11 +84,46 @@ unsigned int initiateEquationVariable(struct Equation* equation) {
     equation->finalTime = 1;
     equation->finalTimeDefined = 0; // only required if dynamic simulation
 
+    equation->Engine = MATRIX;
+    equation->JumpPower = AUTOMATIC_POWER;
+    equation->steadyDetectionTolerance = 0;
+    equation->steadyDetectionInterval = 1;
+
+    equation->Renumber = NO_RENUMBERING;
+
+    equation->SteadySolver = DIRECT_LU;
+    equation->Precond = BLOCK_JACOBI;
+    equation->preconditionerDefined = 0;
+    equation->tolerance = 1e-12;
+    equation->maximumIterations = 10000;
+
     // flags to what to save
     equation->saveScalar = 0;
     equation->saveScalarBetween = 0;
     equation->saveFlux = 0;
 
+    equation->outputProbes = NULL;
+    equation->numberOfOutputProbes = 0;
+    equation->outputTags = NULL;
+    equation->numberOfOutputTags = 0;
+
+    equation->statisticsTags = NULL;
+    equation->numberOfStatisticsTags = 0;
+    equation->statisticsThreshold = 43;
+    equation->statisticsPercentile = 90;
+    equation->statisticsDoseThreshold = 240;
+    equation->saveScalarForStatistics = 0;
+
+    equation->scenarioChanges = NULL;
+    equation->numberOfScenarioChanges = 0;
+    equation->numberOfScenarios = 1;
+
+    equation->sweepChanges = NULL;
+    equation->numberOfSweepChanges = 0;
+    equation->numberOfSweepPoints = 0;
+
+    equation->topologyCache = 0;
+
     // internal flags
     equation->solveDirectly = 1;
     equation->needToSolve = 1;
@@ -115,6 +150,179 @@ unsigned int terminateEquationConfig(struct Equation *equation) {
     free(equation->nameVector);
     equation->nameVector = NULL;
 
+    free(equation->outputProbes);
+    equation->outputProbes = NULL;
+    equation->numberOfOutputProbes = 0;
+
+    free(equation->outputTags);
+    equation->outputTags = NULL;
+    equation->numberOfOutputTags = 0;
+
+    free(equation->statisticsTags);
+    equation->statisticsTags = NULL;
+    equation->numberOfStatisticsTags = 0;
+
+    free(equation->scenarioChanges);
+    equation->scenarioChanges = NULL;
+    equation->numberOfScenarioChanges = 0;
+    equation->numberOfScenarios = 1;
+
+    free(equation->sweepChanges);
+    equation->sweepChanges = NULL;
+    equation->numberOfSweepChanges = 0;
+    equation->numberOfSweepPoints = 0;
+
+    return 0;
+}
+
+/*
+ * setScenarioParameter: gets the parameter of a material or boundary changed
+ * by a scenario or a sweep. Returns 1 if it is unknown
+ */
+static int setScenarioParameter(const char *input, int boundary, enum scenarioParameter *parameter) {
+
+    if (boundary == 0 && compareCaseInsensitive(input, "source") == 0) {
+        *parameter = SCENARIO_SOURCE;
+    } else if (boundary == 0 && compareCaseInsensitive(input, "internal heat generation") == 0) {
+        *parameter = SCENARIO_INTERNAL_HEAT_GENERATION;
+    } else if (boundary == 0 && (compareCaseInsensitive(input, "initial scalar") == 0 ||
+            compareCaseInsensitive(input, "initial temperature") == 0)) {
+        *parameter = SCENARIO_INITIAL_SCALAR;
+    } else if (boundary == 0 && (compareCaseInsensitive(input, "diffusion coefficient") == 0 ||
+            compareCaseInsensitive(input, "thermal conductivity") == 0)) {
+        *parameter = SCENARIO_DIFFUSION_COEFFICIENT;
+    } else if (boundary == 0 && compareCaseInsensitive(input, "density") == 0) {
+        *parameter = SCENARIO_DENSITY;
+    } else if (boundary == 0 && compareCaseInsensitive(input, "specific heat") == 0) {
+        *parameter = SCENARIO_SPECIFIC_HEAT;
+    } else if (boundary == 0 && compareCaseInsensitive(input, "blood perfusion") == 0) {
+        *parameter = SCENARIO_BLOOD_PERFUSION;
+    } else if (boundary == 1 && (compareCaseInsensitive(input, "scalar") == 0 ||
+            compareCaseInsensitive(input, "temperature") == 0)) {
+        *parameter = SCENARIO_SCALAR;
+    } else if (boundary == 1 && (compareCaseInsensitive(input, "flux") == 0 ||
+            compareCaseInsensitive(input, "heat flux") == 0)) {
+        *parameter = SCENARIO_FLUX;
+    } else if (boundary == 1 && (compareCaseInsensitive(input, "convection scalar") == 0 ||
+            compareCaseInsensitive(input, "convection temperature") == 0)) {
+        *parameter = SCENARIO_CONVECTION_SCALAR;
+    } else if (boundary == 1 && compareCaseInsensitive(input, "convection coefficient") == 0) {
+        *parameter = SCENARIO_CONVECTION_COEFFICIENT;
+    } else {
+        return 1;
+    }
+
+    return 0;
+}
+
+/*
+ * setScenarioKind: reads 'material 10' or 'boundary 21' at the beginning of a
+ * change of a scenario or a sweep. n is the quantity of characters read.
+ * Returns 1 if it is invalid
+ */
+static int setScenarioKind(const char *input, struct scenarioChange *change, int *n) {
+    char kind[16];
+
+    if (sscanf(input, "%15s %lu %n", kind, &change->tag, n) != 2)
+        return 1;
+    if (compareCaseInsensitive(kind, "material") == 0) {
+        change->boundary = 0;
+    } else if (compareCaseInsensitive(kind, "boundary") == 0) {
+        change->boundary = 1;
+    } else {
+        return 1;
+    }
+
+    return 0;
+}
+
+/*
+ * setScenarioChange: reads one change of a scenario, as 'material 10 source 2e5'
+ * or 'boundary 21 temperature 40'. The scenarios cannot change M
+ */
+static unsigned int setScenarioChange(char *input, struct scenarioChange *change) {
+    char *value;
+    int n;
+
+    removeBlankSpacesBeforeAndAfter(input);
+
+    if (setScenarioKind(input, change, &n) != 0)
+        return 3867;
+
+    // the value is the last word, and the parameter is between the tag and it
+    input += n;
+    if ((value = strrchr(input, ' ')) == NULL || sscanf(value, "%lf", &change->value) != 1)
+        return 3867;
+    *value = '\0';
+    removeBlankSpacesBeforeAndAfter(input);
+
+    if (setScenarioParameter(input, change->boundary, &change->parameter) != 0 ||
+            change->parameter >= SCENARIO_DIFFUSION_COEFFICIENT)
+        return 3867;
+
+    return 0;
+}
+
+/*
+ * setSweepLine: reads one parameter of the sweep and its values, as
+ * 'material 10 thermal conductivity 0.4, 0.5, 0.6' or, from the start to the
+ * end with a step, 'boundary 21 convection coefficient 5 : 5 : 100'. All the
+ * lines must have the same quantity of values
+ */
+static unsigned int setSweepLine(char *input, struct Equation *equation) {
+    struct scenarioChange change, *changes;
+    char parameter[64], *values, *end;
+    double start, step, last;
+    int n, point, points;
+
+    removeBlankSpacesBeforeAndAfter(input);
+
+    if (setScenarioKind(input, &change, &n) != 0)
+        return 3866;
+
+    // the parameter is between the tag and the first value
+    input += n;
+    if ((values = strpbrk(input, "0123456789+-.")) == NULL || values - input >= 64)
+        return 3866;
+    memcpy(parameter, input, values - input);
+    parameter[values - input] = '\0';
+    removeBlankSpacesBeforeAndAfter(parameter);
+    if (setScenarioParameter(parameter, change.boundary, &change.parameter) != 0)
+        return 3866;
+
+    if (strchr(values, ':') != NULL) {
+        if (sscanf(values, "%lf : %lf : %lf %n", &start, &step, &last, &n) != 3 ||
+                values[n] != '\0' || step == 0 || (last - start) / step < 0)
+            return 3866;
+        points = 1 + (int) ((last - start) / step + 1e-9);
+    } else {
+        for (points = 1, end = values; *end != '\0'; end++)
+            points += *end == ',';
+    }
+    if (points > 1000000 || (equation->numberOfSweepPoints != 0 && points != equation->numberOfSweepPoints))
+        return 3866;
+
+    if ((changes = (struct scenarioChange *) realloc(equation->sweepChanges,
+            sizeof (struct scenarioChange)*(equation->numberOfSweepChanges + points))) == NULL)
+        return 3866;
+    equation->sweepChanges = changes;
+
+    for (point = 0; point < points; point++) {
+        if (strchr(values, ':') != NULL) {
+            change.value = start + point * step;
+        } else {
+            change.value = strtod(values, &end);
+            while (*end == ' ' || *end == '\t')
+                end++;
+            if (end == values || (*end != ',' && *end != '\0'))
+                return 3866;
+            values = end + (*end == ',');
+        }
+        change.scenario = point + 1;
+        changes[equation->numberOfSweepChanges++] = change;
+    }
+    equation->numberOfSweepPoints = points;
+
     return 0;
 }
 
@@ -326,6 +534,158 @@ unsigned int setConfigurationEquation(char * input, struct Equation * configInpu
         sscanf(input, "%lf", &configInput->finalTime);
         configInput->finalTimeDefined = 1;
 
+    } else if (compareCaseInsensitive(input, "engine") == 0) {
+        if ((errorTLMnumber = getBetweenEqualAndSemicolon(input)) != 0)
+            return errorTLMnumber;
+
+        // removes all the blank spaces before and after and only gets the string
+        // with the information
+        removeBlankSpacesBeforeAndAfter(input);
+
+        if (compareCaseInsensitive(input, "matrix") == 0) {
+            configInput->Engine = MATRIX;
+        } else if (compareCaseInsensitive(input, "matrix-free") == 0 ||
+                compareCaseInsensitive(input, "matrix free") == 0) {
+            configInput->Engine = MATRIX_FREE;
+        } else {
+            return 3893;
+        }
+
+    } else if (compareCaseInsensitive(input, "time-jump power") == 0) {
+        if ((errorTLMnumber = getBetweenEqualAndSemicolon(input)) != 0)
+            return errorTLMnumber;
+
+        // removes all the blank spaces before and after and only gets the string
+        // with the information
+        removeBlankSpacesBeforeAndAfter(input);
+
+        if (compareCaseInsensitive(input, "automatic") == 0 ||
+                compareCaseInsensitive(input, "auto") == 0) {
+            configInput->JumpPower = AUTOMATIC_POWER;
+        } else if (compareCaseInsensitive(input, "yes") == 0 ||
+                compareCaseInsensitive(input, "always") == 0) {
+            configInput->JumpPower = ALWAYS_POWER;
+        } else if (compareCaseInsensitive(input, "no") == 0 ||
+                compareCaseInsensitive(input, "never") == 0) {
+            configInput->JumpPower = NO_POWER;
+        } else {
+            return 3870;
+        }
+
+    } else if (compareCaseInsensitive(input, "steady detection tolerance") == 0) {
+        if ((errorTLMnumber = getBetweenEqualAndSemicolon(input)) != 0)
+            return errorTLMnumber;
+
+        if (sscanf(input, "%lf", &configInput->steadyDetectionTolerance) != 1 ||
+                configInput->steadyDetectionTolerance < 0)
+            return 3869;
+
+    } else if (compareCaseInsensitive(input, "steady detection interval") == 0) {
+        if ((errorTLMnumber = getBetweenEqualAndSemicolon(input)) != 0)
+            return errorTLMnumber;
+
+        if (sscanf(input, "%u", &configInput->steadyDetectionInterval) != 1 ||
+                configInput->steadyDetectionInterval == 0)
+            return 3868;
+
+    } else if (compareCaseInsensitive(input, "renumbering") == 0) {
+        if ((errorTLMnumber = getBetweenEqualAndSemicolon(input)) != 0)
+            return errorTLMnumber;
+
+        // removes all the blank spaces before and after and only gets the string
+        // with the information
+        removeBlankSpacesBeforeAndAfter(input);
+
+        if (compareCaseInsensitive(input, "none") == 0) {
+            configInput->Renumber = NO_RENUMBERING;
+        } else if (compareCaseInsensitive(input, "rcm") == 0 ||
+                compareCaseInsensitive(input, "reverse cuthill-mckee") == 0) {
+            configInput->Renumber = REVERSE_CUTHILL_MCKEE;
+        } else if (compareCaseInsensitive(input, "morton") == 0) {
+            configInput->Renumber = MORTON_CURVE;
+        } else {
+            return 3899;
+        }
+
+    } else if (compareCaseInsensitive(input, "topology cache") == 0) {
+        if ((errorTLMnumber = getBetweenEqualAndSemicolon(input)) != 0)
+            return errorTLMnumber;
+
+        // removes all the blank spaces before and after and only gets the string
+        // with the information
+        removeBlankSpacesBeforeAndAfter(input);
+
+        if (compareCaseInsensitive(input, "yes") == 0 ||
+                compareCaseInsensitive(input, "true") == 0) {
+            configInput->topologyCache = 1;
+        } else if (compareCaseInsensitive(input, "no") == 0 ||
+                compareCaseInsensitive(input, "false") == 0) {
+            configInput->topologyCache = 0;
+        } else {
+            return 3865;
+        }
+
+    } else if (compareCaseInsensitive(input, "steady solver") == 0) {
+        if ((errorTLMnumber = getBetweenEqualAndSemicolon(input)) != 0)
+            return errorTLMnumber;
+
+        // removes all the blank spaces before and after and only gets the string
+        // with the information
+        removeBlankSpacesBeforeAndAfter(input);
+
+        if (compareCaseInsensitive(input, "lu") == 0) {
+            configInput->SteadySolver = DIRECT_LU;
+        } else if (compareCaseInsensitive(input, "bicgstab") == 0) {
+            configInput->SteadySolver = ITERATIVE_BICGSTAB;
+        } else if (compareCaseInsensitive(input, "gmres") == 0) {
+            configInput->SteadySolver = ITERATIVE_GMRES;
+        } else if (compareCaseInsensitive(input, "node cg") == 0) {
+            configInput->SteadySolver = NODE_CG;
+        } else {
+            return 3894;
+        }
+
+    } else if (compareCaseInsensitive(input, "preconditioner") == 0) {
+        if ((errorTLMnumber = getBetweenEqualAndSemicolon(input)) != 0)
+            return errorTLMnumber;
+
+        // removes all the blank spaces before and after and only gets the string
+        // with the information
+        removeBlankSpacesBeforeAndAfter(input);
+
+        if (compareCaseInsensitive(input, "none") == 0) {
+            configInput->Precond = NO_PRECONDITIONER;
+        } else if (compareCaseInsensitive(input, "jacobi") == 0) {
+            configInput->Precond = JACOBI;
+        } else if (compareCaseInsensitive(input, "block jacobi") == 0 ||
+                compareCaseInsensitive(input, "block-jacobi") == 0) {
+            configInput->Precond = BLOCK_JACOBI;
+        } else if (compareCaseInsensitive(input, "ilu") == 0) {
+            configInput->Precond = ILU;
+        } else if (compareCaseInsensitive(input, "incomplete cholesky") == 0 ||
+                compareCaseInsensitive(input, "ic") == 0) {
+            configInput->Precond = INCOMPLETE_CHOLESKY;
+        } else {
+            return 3895;
+        }
+        configInput->preconditionerDefined = 1;
+
+    } else if (compareCaseInsensitive(input, "tolerance") == 0) {
+        if ((errorTLMnumber = getBetweenEqualAndSemicolon(input)) != 0)
+            return errorTLMnumber;
+
+        if (sscanf(input, "%lf", &configInput->tolerance) != 1 || configInput->tolerance <= 0)
+            return 3896;
+
+    } else if (compareCaseInsensitive(input, "maximum iterations") == 0) {
+        if ((errorTLMnumber = getBetweenEqualAndSemicolon(input)) != 0)
+            return errorTLMnumber;
+
+        if (sscanf(input, "%u", &tempVarInt) != 1 || tempVarInt == 0)
+            return 3897;
+
+        configInput->maximumIterations = tempVarInt;
+
     } else if (compareCaseInsensitive(input, "save") == 0) {
         if ((errorTLMnumber = getBetweenEqualAndSemicolon(input)) != 0)
             return errorTLMnumber;
@@ -351,6 +711,108 @@ unsigned int setConfigurationEquation(char * input, struct Equation * configInpu
 
 
 
+    } else if (compareCaseInsensitive(input, "output probe") == 0) {
+        if ((errorTLMnumber = getBetweenEqualAndSemicolon(input)) != 0)
+            return errorTLMnumber;
+
+        // x, y, z of the probe. z can be omitted in two-dimensional problems
+        double probe[3] = {0, 0, 0};
+        if (sscanf(input, "%lf , %lf , %lf", &probe[0], &probe[1], &probe[2]) < 2)
+            return 3887;
+
+        double *probes = (double *) realloc(configInput->outputProbes,
+                sizeof (double)*3 * (configInput->numberOfOutputProbes + 1));
+        if (probes == NULL)
+            return 3887;
+        configInput->outputProbes = probes;
+        memcpy(&probes[3 * configInput->numberOfOutputProbes], probe, sizeof (probe));
+        configInput->numberOfOutputProbes++;
+
+    } else if (compareCaseInsensitive(input, "output tag") == 0) {
+        if ((errorTLMnumber = getBetweenEqualAndSemicolon(input)) != 0)
+            return errorTLMnumber;
+
+        unsigned long tag;
+        if (sscanf(input, "%lu", &tag) != 1)
+            return 3888;
+
+        unsigned long *tags = (unsigned long *) realloc(configInput->outputTags,
+                sizeof (unsigned long)*(configInput->numberOfOutputTags + 1));
+        if (tags == NULL)
+            return 3888;
+        configInput->outputTags = tags;
+        tags[configInput->numberOfOutputTags] = tag;
+        configInput->numberOfOutputTags++;
+
+    } else if (compareCaseInsensitive(input, "statistics tag") == 0) {
+        if ((errorTLMnumber = getBetweenEqualAndSemicolon(input)) != 0)
+            return errorTLMnumber;
+
+        unsigned long tag;
+        if (sscanf(input, "%lu", &tag) != 1)
+            return 3889;
+
+        unsigned long *tags = (unsigned long *) realloc(configInput->statisticsTags,
+                sizeof (unsigned long)*(configInput->numberOfStatisticsTags + 1));
+        if (tags == NULL)
+            return 3889;
+        configInput->statisticsTags = tags;
+        tags[configInput->numberOfStatisticsTags] = tag;
+        configInput->numberOfStatisticsTags++;
+
+    } else if (compareCaseInsensitive(input, "statistics threshold") == 0) {
+        if ((errorTLMnumber = getBetweenEqualAndSemicolon(input)) != 0)
+            return errorTLMnumber;
+
+        if (sscanf(input, "%lf", &configInput->statisticsThreshold) != 1)
+            return 3873;
+
+    } else if (compareCaseInsensitive(input, "statistics percentile") == 0) {
+        if ((errorTLMnumber = getBetweenEqualAndSemicolon(input)) != 0)
+            return errorTLMnumber;
+
+        if (sscanf(input, "%lf", &configInput->statisticsPercentile) != 1 ||
+                configInput->statisticsPercentile < 0 || configInput->statisticsPercentile > 100)
+            return 3872;
+
+    } else if (compareCaseInsensitive(input, "statistics dose threshold") == 0) {
+        if ((errorTLMnumber = getBetweenEqualAndSemicolon(input)) != 0)
+            return errorTLMnumber;
+
+        if (sscanf(input, "%lf", &configInput->statisticsDoseThreshold) != 1 ||
+                configInput->statisticsDoseThreshold < 0)
+            return 3871;
+
+    } else if (compareCaseInsensitive(input, "scenario") == 0) {
+        if ((errorTLMnumber = getBetweenEqualAndSemicolon(input)) != 0)
+            return errorTLMnumber;
+
+        // each line is a new scenario with one or more changes separated by ','
+        char *change = strtok(input, ",");
+        if (change == NULL)
+            return 3867;
+        configInput->numberOfScenarios++;
+        for (; change != NULL; change = strtok(NULL, ",")) {
+            struct scenarioChange *changes = (struct scenarioChange *) realloc(configInput->scenarioChanges,
+                    sizeof (struct scenarioChange)*(configInput->numberOfScenarioChanges + 1));
+            if (changes == NULL)
+                return 3867;
+            configInput->scenarioChanges = changes;
+            changes[configInput->numberOfScenarioChanges].scenario = configInput->numberOfScenarios;
+            if ((errorTLMnumber = setScenarioChange(change,
+                    &changes[configInput->numberOfScenarioChanges])) != 0)
+                return errorTLMnumber;
+            configInput->numberOfScenarioChanges++;
+        }
+
+    } else if (compareCaseInsensitive(input, "sweep") == 0) {
+        if ((errorTLMnumber = getBetweenEqualAndSemicolon(input)) != 0)
+            return errorTLMnumber;
+
+        // each line is a parameter, and each of its values is a point
+        if ((errorTLMnumber = setSweepLine(input, configInput)) != 0)
+            return errorTLMnumber;
+
     } else if (input[0] == '}' && *startEndBrackets == 1) {
         if ((errorTLMnumber = testEndBrackets(input)) != 0)
             return errorTLMnumber;
@@ -480,6 +942,97 @@ unsigned int testInputEquation(struct Equation *equation, int id) {
         equation->timeStep == 1;
     }
 
+    // the matrix-free engine only changes how the time-steps are calculated
+    if (equation->Solv == STEADY && equation->Engine == MATRIX_FREE) {
+        fprintf(stderr, "\nWARNING: The matrix-free engine is only used in dynamic simulations. "
+                "Equation group %04d will be solved for steady-state with the matrix M.\n\n", id);
+        equation->Engine = MATRIX;
+    }
+
+    // the scenarios share the products with M of the time-steps. They are only
+    // calculated with M and without statistics
+    if (equation->numberOfScenarios > 1) {
+        if (equation->Solv == STEADY) {
+            fprintf(stderr, "\nWARNING: The scenarios are only calculated in dynamic simulations. "
+                    "Equation group %04d will only be solved for its case.\n\n", id);
+            equation->numberOfScenarios = 1;
+            equation->numberOfScenarioChanges = 0;
+        } else {
+            if (equation->Engine == MATRIX_FREE) {
+                fprintf(stderr, "\nWARNING: The scenarios are not calculated with the matrix-free engine. "
+                        "Equation group %04d will be solved with the matrix M.\n\n", id);
+                equation->Engine = MATRIX;
+            }
+            if (equation->numberOfStatisticsTags > 0) {
+                fprintf(stderr, "\nWARNING: The statistics are not calculated with scenarios. "
+                        "Equation group %04d will not have statistics.\n\n", id);
+                equation->numberOfStatisticsTags = 0;
+            }
+        }
+    }
+
+    // the power of M replaces M, which the matrix-free engine does not have, and
+    // skips the time-steps in which the thermal dose is accumulated
+    if (equation->Solv == DYNAMIC && equation->timeJump > 1 && equation->JumpPower == ALWAYS_POWER &&
+            (equation->Engine == MATRIX_FREE || equation->numberOfStatisticsTags > 0)) {
+        fprintf(stderr, "\nWARNING: The power of M is not used with the matrix-free engine nor "
+                "with statistics. Equation group %04d will be solved time-step by time-step.\n\n", id);
+        equation->JumpPower = NO_POWER;
+    }
+
+    // the node system is built without stubs, which are only used by the
+    // hyperbolic equations
+    if (equation->Solv == STEADY && equation->SteadySolver == NODE_CG &&
+            (equation->typeS == HYPERBOLIC_DIFFUSION || equation->typeS == HYPERBOLIC_HEAT ||
+            equation->typeS == HYPERBOLIC_PENNES)) {
+        fprintf(stderr, "\nWARNING: The node system cannot be used with hyperbolic equations. "
+                "Equation group %04d will be solved for steady-state with BiCGSTAB.\n\n", id);
+        equation->SteadySolver = ITERATIVE_BICGSTAB;
+    }
+
+    // the node system is solved for the nodes, not for the ports
+    if (equation->Solv == STEADY && equation->SteadySolver == NODE_CG &&
+            equation->Renumber != NO_RENUMBERING) {
+        fprintf(stderr, "\nWARNING: The renumbering is not used by the node system. "
+                "Equation group %04d will keep the order of the mesh.\n\n", id);
+        equation->Renumber = NO_RENUMBERING;
+    }
+
+    // the node system has one unknown per node and it is symmetric, so the
+    // blocks of the nodes are the diagonal and the incomplete LU becomes the
+    // incomplete Cholesky. The incomplete Cholesky is its default
+    if (equation->SteadySolver == NODE_CG) {
+        if (equation->preconditionerDefined == 0 || equation->Precond == ILU) {
+            equation->Precond = INCOMPLETE_CHOLESKY;
+        } else if (equation->Precond == BLOCK_JACOBI) {
+            equation->Precond = JACOBI;
+        }
+    } else if (equation->Precond == INCOMPLETE_CHOLESKY) {
+        fprintf(stderr, "\nWARNING: The incomplete Cholesky is only used by the node system. "
+                "Equation group %04d will use the incomplete LU.\n\n", id);
+        equation->Precond = ILU;
+    }
+
+    // the probes and the tags select nodes, so only the scalar in the center
+    // of the nodes is saved
+    if (equation->numberOfOutputProbes > 0 || equation->numberOfOutputTags > 0) {
+        if (equation->saveScalarBetween == 1 || equation->saveFlux == 1) {
+            fprintf(stderr, "\nWARNING: The output probes and tags only save the scalar in the center "
+                    "of the nodes. Equation group %04d will not save the scalar between the nodes "
+                    "nor the flux.\n\n", id);
+            equation->saveScalarBetween = 0;
+            equation->saveFlux = 0;
+        }
+        equation->saveScalar = 1;
+    }
+
+    // the statistics are calculated from the scalar in the center of the
+    // nodes. If it was not requested, it is calculated but not saved
+    if (equation->numberOfStatisticsTags > 0 && equation->saveScalar == 0) {
+        equation->saveScalar = 1;
+        equation->saveScalarForStatistics = 1;
+    }
+
     if (equation->solveDefined == 2) {
         // the solver was defined as dynamic but time-step was not defined
         if (equation->timeStepDefined == 0) {
@@ -520,9 +1073,21 @@ void printfAllEquaData(struct Equation* equation) {
         printf("Time-step = %9.4e s.\n", equation->timeStep);
         printf("Time-jump = %4u.\n", equation->timeJump);
         printf("Final time = %9.4e s.\n", equation->finalTime);
+        printfEngine(&equation->Engine);
+        if (equation->timeJump > 1)
+            printfJumpPower(&equation->JumpPower);
+        printfSteadyDetection(equation);
+    } else {
+        printfSteadySolver(equation);
     }
+    printfRenumbering(&equation->Renumber);
+    printfTopologyCache(equation);
 
     printWhatToSave(equation);
+    printfOutputSelection(equation);
+    printfStatistics(equation);
+    printfScenarios(equation);
+    printfSweep(equation);
 
     printHowToSolve(equation->solveDirectly);
 
@@ -659,6 +1224,200 @@ void printfSolv(enum solve *sol) {
     printf(".\n");
 }
 
+/*
+ * printfEngine: prints how the time-steps are calculated
+ */
+void printfEngine(enum engine *eng) {
+    printf("Calculating the time-steps ");
+    switch (*eng) {
+        case MATRIX: printf("with the matrix M = C*S");
+            break;
+        case MATRIX_FREE: printf("without assembling M (matrix-free)");
+            break;
+        default: printf("Unknown");
+    }
+
+    printf(".\n");
+}
+
+/*
+ * printfJumpPower: prints if the time-jump is calculated with the power of M
+ */
+void printfJumpPower(enum jumpPower *power) {
+    printf("Calculating the time-jump ");
+    switch (*power) {
+        case AUTOMATIC_POWER: printf("with the power of M if it is cheaper than the time-steps");
+            break;
+        case ALWAYS_POWER: printf("with the power of M");
+            break;
+        case NO_POWER: printf("time-step by time-step");
+            break;
+        default: printf("Unknown");
+    }
+
+    printf(".\n");
+}
+
+/*
+ * printfRenumbering: prints the order of the nodes in the matrices
+ */
+void printfRenumbering(enum renumbering *ren) {
+    printf("Ordering the nodes ");
+    switch (*ren) {
+        case NO_RENUMBERING: printf("as the elements of the mesh");
+            break;
+        case REVERSE_CUTHILL_MCKEE: printf("with reverse Cuthill-McKee");
+            break;
+        case MORTON_CURVE: printf("along the Morton curve of their centers");
+            break;
+        default: printf("Unknown");
+    }
+
+    printf(".\n");
+}
+
+/*
+ * printfOutputSelection: prints the probes and the tags whose nodes are saved
+ */
+void printfOutputSelection(struct Equation *equation) {
+    int i;
+
+    for (i = 0; i < equation->numberOfOutputProbes; i++) {
+        printf("Saving the node that contains the probe (%g, %g, %g).\n",
+                equation->outputProbes[3 * i], equation->outputProbes[3 * i + 1],
+                equation->outputProbes[3 * i + 2]);
+    }
+
+    for (i = 0; i < equation->numberOfOutputTags; i++) {
+        printf("Saving the nodes with tag %lu.\n", equation->outputTags[i]);
+    }
+}
+
+/*
+ * printfStatistics: prints the tags with statistics and their parameters
+ */
+void printfStatistics(struct Equation *equation) {
+    int i;
+
+    if (equation->numberOfStatisticsTags == 0)
+        return;
+
+    printf("Calculating the statistics of the tags ");
+    for (i = 0; i < equation->numberOfStatisticsTags - 1; i++) {
+        printf("%lu, ", equation->statisticsTags[i]);
+    }
+    printf("%lu.\n", equation->statisticsTags[i]);
+    printf("Statistics threshold = %g, percentile = %g, dose threshold = %g min.\n",
+            equation->statisticsThreshold, equation->statisticsPercentile,
+            equation->statisticsDoseThreshold);
+}
+
+/*
+ * printfScenarios: prints the changes of each scenario
+ */
+void printfScenarios(struct Equation *equation) {
+    const char *parameter[] = {"source", "internal heat generation", "initial scalar",
+        "scalar", "flux", "convection scalar", "diffusion coefficient", "density",
+        "specific heat", "blood perfusion", "convection coefficient"};
+    int i;
+
+    if (equation->numberOfScenarios == 1)
+        return;
+
+    printf("Calculating %d scenarios; the scenario 1 is the case.\n", equation->numberOfScenarios);
+    for (i = 0; i < equation->numberOfScenarioChanges; i++) {
+        printf("Scenario %d: %s %lu %s = %g.\n", equation->scenarioChanges[i].scenario,
+                equation->scenarioChanges[i].boundary ? "boundary" : "material",
+                equation->scenarioChanges[i].tag,
+                parameter[equation->scenarioChanges[i].parameter],
+                equation->scenarioChanges[i].value);
+    }
+}
+
+/*
+ * printfSweep: prints the values of each point of the sweep
+ */
+void printfSweep(struct Equation *equation) {
+    const char *parameter[] = {"source", "internal heat generation", "initial scalar",
+        "scalar", "flux", "convection scalar", "diffusion coefficient", "density",
+        "specific heat", "blood perfusion", "convection coefficient"};
+    int i;
+
+    if (equation->numberOfSweepPoints == 0)
+        return;
+
+    printf("Sweeping %d points; the point 1 is saved in the output file.\n", equation->numberOfSweepPoints);
+    for (i = 0; i < equation->numberOfSweepChanges; i++) {
+        printf("Point %d: %s %lu %s = %g.\n", equation->sweepChanges[i].scenario,
+                equation->sweepChanges[i].boundary ? "boundary" : "material",
+                equation->sweepChanges[i].tag,
+                parameter[equation->sweepChanges[i].parameter],
+                equation->sweepChanges[i].value);
+    }
+}
+
+/*
+ * printfTopologyCache: prints if the numbers and the connections of the ports
+ * are kept in the topology cache
+ */
+void printfTopologyCache(struct Equation *equation) {
+
+    if (equation->topologyCache == 0)
+        return;
+
+    printf("The numbers and the connections of the ports are kept in the topology cache.\n");
+}
+
+/*
+ * printfSteadyDetection: prints when the dynamic simulation stops before the
+ * final time
+ */
+void printfSteadyDetection(struct Equation *equation) {
+
+    if (equation->steadyDetectionTolerance == 0)
+        return;
+
+    printf("Stopping when the relative change of the incident voltages per time-step "
+            "is below %g, checked every %u time-jump(s).\n", equation->steadyDetectionTolerance,
+            equation->steadyDetectionInterval);
+}
+
+/*
+ * printfSteadySolver: prints how the steady-state system is solved
+ */
+void printfSteadySolver(struct Equation *equation) {
+    printf("Solving the steady-state system ");
+    switch (equation->SteadySolver) {
+        case DIRECT_LU: printf("directly with sparse LU.\n");
+            return;
+        case ITERATIVE_BICGSTAB: printf("iteratively with BiCGSTAB");
+            break;
+        case ITERATIVE_GMRES: printf("iteratively with GMRES");
+            break;
+        case NODE_CG: printf("for the scalar of the nodes with CG");
+            break;
+        default: printf("Unknown.\n");
+            return;
+    }
+
+    switch (equation->Precond) {
+        case NO_PRECONDITIONER: printf(" without preconditioner");
+            break;
+        case JACOBI: printf(" and Jacobi preconditioner");
+            break;
+        case BLOCK_JACOBI: printf(" and block-Jacobi preconditioner");
+            break;
+        case ILU: printf(" and incomplete LU preconditioner");
+            break;
+        case INCOMPLETE_CHOLESKY: printf(" and incomplete Cholesky preconditioner");
+            break;
+        default: printf(" and unknown preconditioner");
+    }
+
+    printf(" (tolerance = %g, maximum iterations = %u).\n",
+            equation->tolerance, equation->maximumIterations);
+}
+
 /*
  * printWhatToSave: prints what was choosen to be saved
  */
@@ -87,6 +87,68 @@ extern "C" {
         DYNAMIC
     };
 
+    enum engine // defines how the time-steps are calculated in dynamic simulations
+    {
+        MATRIX, // assembles M = C*S and multiplies it by the incident voltages
+        MATRIX_FREE // does the scattering and the connection node by node
+    };
+
+    enum jumpPower // defines if the time-jump is calculated with the power of M
+    {
+        AUTOMATIC_POWER, // uses M^k if it is cheaper than k products with M
+        ALWAYS_POWER, // always uses M^time-jump
+        NO_POWER // always does one product with M per time-step
+    };
+
+    enum renumbering // defines the order of the nodes in the matrices
+    {
+        NO_RENUMBERING, // keeps the order of the elements of the mesh
+        REVERSE_CUTHILL_MCKEE, // reverse Cuthill-McKee over the connections of the nodes
+        MORTON_CURVE // Morton (Z-order) curve over the centers of the nodes
+    };
+
+    enum steadySolver // defines how the steady-state system (I - M)*Vi = E is solved
+    {
+        DIRECT_LU, // sparse LU factorization. Simple, but the fill-in can exhaust the memory in 3D
+        ITERATIVE_BICGSTAB, // stabilized bi-conjugate gradient
+        ITERATIVE_GMRES, // restarted generalized minimal residual
+        NODE_CG // conjugate gradient on the conductance network of the nodes. Only without stubs
+    };
+
+    enum preconditioner // preconditioner of the iterative steady-state solvers
+    {
+        NO_PRECONDITIONER,
+        JACOBI, // inverse of the diagonal
+        BLOCK_JACOBI, // inverse of the block of each node
+        ILU, // incomplete LU with threshold
+        INCOMPLETE_CHOLESKY // only for the node system, which is symmetric
+    };
+
+    enum scenarioParameter // parameter changed by a scenario or by a sweep
+    {
+        SCENARIO_SOURCE, // source of a material
+        SCENARIO_INTERNAL_HEAT_GENERATION, // internal heat generation of a material
+        SCENARIO_INITIAL_SCALAR, // initial scalar of a material
+        SCENARIO_SCALAR, // scalar of a boundary
+        SCENARIO_FLUX, // flux of a boundary
+        SCENARIO_CONVECTION_SCALAR, // scalar of the convection of a boundary
+        // the next ones change M, so they can only be swept
+        SCENARIO_DIFFUSION_COEFFICIENT, // diffusion coefficient (thermal conductivity) of a material
+        SCENARIO_DENSITY, // density of a material
+        SCENARIO_SPECIFIC_HEAT, // specific heat of a material
+        SCENARIO_BLOOD_PERFUSION, // blood perfusion of a material
+        SCENARIO_CONVECTION_COEFFICIENT // coefficient of the convection of a boundary
+    };
+
+    struct scenarioChange // one change of a scenario or of a point of a sweep
+    {
+        int scenario; // from 2; the scenario 1 is the case itself. In a sweep, the point from 1
+        int boundary; // 0: the tag is a material; 1: the tag is a boundary
+        unsigned long tag; // number of the material or boundary
+        enum scenarioParameter parameter;
+        double value;
+    };
+
     struct Equation // structure that contains the information for the governing equation
     {
         enum libraryForCalc libraryForCalculation;
@@ -155,11 +217,63 @@ extern "C" {
         double finalTime;
         int finalTimeDefined; // only required if dynamic simulation
 
+        enum engine Engine; // only used if dynamic simulation
+        enum jumpPower JumpPower; // only used if dynamic simulation and time-jump > 1
+        // the dynamic simulation stops when the relative change of the incident
+        // voltages per time-step is below the tolerance. Zero: not used
+        double steadyDetectionTolerance;
+        unsigned int steadyDetectionInterval; // in time-jumps
+        enum renumbering Renumber;
+
+        enum steadySolver SteadySolver; // only used if steady-state simulation
+        enum preconditioner Precond; // only used by the iterative steady-state solvers
+        int preconditionerDefined;
+        double tolerance; // relative residual of the iterative steady-state solvers
+        unsigned int maximumIterations; // of the iterative steady-state solvers
+
         // flags to what to save
         int saveScalar;
         int saveScalarBetween;
         int saveFlux;
 
+        // outputs restricted to some nodes. If none of them is given, all the
+        // outputs selected by the flags above are saved
+        double *outputProbes; // x, y, z of each probe. The output is the node that contains it
+        int numberOfOutputProbes;
+        unsigned long *outputTags; // tags of the mesh whose nodes are saved
+        int numberOfOutputTags;
+
+        // statistics of the scalar in some tags, calculated during the
+        // simulation and written to a small text file
+        unsigned long *statisticsTags; // tags of the mesh with statistics
+        int numberOfStatisticsTags;
+        double statisticsThreshold; // the volume above it is reported
+        double statisticsPercentile; // percentile of the volume, from 0 to 100
+        double statisticsDoseThreshold; // (min) the volume with a higher CEM43 is reported
+        // 1: the scalar of the nodes is only calculated for the statistics, and it
+        // is not saved. Internal flag
+        int saveScalarForStatistics;
+
+        // scenarios solved together with the case in dynamic simulations. Each
+        // one changes some sources, initial scalars, or boundaries of the case,
+        // and all of them are calculated in the same products with M
+        struct scenarioChange *scenarioChanges;
+        int numberOfScenarioChanges;
+        int numberOfScenarios; // including the case itself
+
+        // parameter sweep. Each point is solved as a case with its own output
+        // file, but the numbers and the connections of the ports are only
+        // calculated once. Each line of the sweep is a column of the table of
+        // points
+        struct scenarioChange *sweepChanges;
+        int numberOfSweepChanges;
+        int numberOfSweepPoints; // 0: no sweep
+
+        // 1: the numbers and the connections of the ports are read from the
+        // topology cache of the equation, or written to it if it is not for this
+        // mesh and equation
+        int topologyCache;
+
 
         // internal flags that dictates if this equation can be solved directly,
         // or if it needs to be solved iteratively. Directly means that as soon
@@ -207,6 +321,16 @@ extern "C" {
     void printfMeth(enum method *);
     //void printfMeth(enum method2 *); // future implementation
     void printfSolv(enum solve *);
+    void printfEngine(enum engine *);
+    void printfJumpPower(enum jumpPower *);
+    void printfSteadyDetection(struct Equation *);
+    void printfRenumbering(enum renumbering *);
+    void printfOutputSelection(struct Equation *);
+    void printfStatistics(struct Equation *);
+    void printfScenarios(struct Equation *);
+    void printfSweep(struct Equation *);
+    void printfTopologyCache(struct Equation *);
+    void printfSteadySolver(struct Equation *);
     void printHowToSolve(int);
 
 
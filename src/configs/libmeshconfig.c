@@ -52,6 +52,7 @@ unsigned int initiateMeshVariable(struct MeshConfig *mesh) {
     mesh->nameOfOutputFile = malloc( (strlen("--case") + 1)*sizeof(char) );
     strcpy(mesh->nameOfOutputFile, "--case");
     // I'm initiating the variable nameOfOutputFile with the default value.
+    mesh->tbnF = TBN_TEXT;
     
 
     mesh->scale = (double*) malloc(sizeof (double)*3);
@@ -91,6 +92,8 @@ void printfMeshConfig(struct MeshConfig* input) {
 
     printfNameOfInputFile(input->nameOfInputFile);
     printfInputFormatOutput(&input->inputF, input->nameOfOutputFile);
+    if (input->inputF != TLMTBN)
+        printfTbnFormat(&input->tbnF);
 
     printfScale(input->scale);
 
@@ -111,7 +114,7 @@ void printfInputFormatOutput(enum inputFormat *input, char *outputName) {
 
     switch (*input) {
         case GMSH:
-            printf("gmsh (.msh, MeshFormat = 2.2), which will be converted to "
+            printf("gmsh (.msh, MeshFormat = 2.2 or 4.1), which will be converted to "
                     "tlmbht native with the following name: %s.tbn", outputName);
             break;
         case TLMTBN:
@@ -126,6 +129,23 @@ void printfInputFormatOutput(enum inputFormat *input, char *outputName) {
 
 }
 
+/*
+ * printfTbnFormat: prints how the converted mesh will be written
+ */
+void printfTbnFormat(enum tbnFormat *input) {
+    switch (*input) {
+        case TBN_TEXT:
+            printf("The .tbn will be written as text.\n");
+            break;
+        case TBN_BINARY:
+            printf("The .tbn will be written as binary.\n");
+            break;
+        case TBN_NONE:
+            printf("The .tbn will not be written.\n");
+            break;
+    }
+}
+
 /*
  * printfScale: prints the scale
  */
@@ -176,6 +196,21 @@ unsigned int setConfigurationMesh(char * input, struct MeshConfig * meshInput, i
         // flag that the input format was defined
         meshInput->inputFormatDefined = 1;
 
+    } else if (compareCaseInsensitive(input, "tbn format") == 0) {
+        if ((errorTLMnumber = getBetweenEqualAndSemicolon(input)) != 0)
+            return errorTLMnumber;
+
+        sscanf(input, "%s", input);
+        if (compareCaseInsensitive(input, "text") == 0) {
+            meshInput->tbnF = TBN_TEXT;
+        } else if (compareCaseInsensitive(input, "binary") == 0) {
+            meshInput->tbnF = TBN_BINARY;
+        } else if (compareCaseInsensitive(input, "none") == 0) {
+            meshInput->tbnF = TBN_NONE;
+        } else {
+            return 3898;
+        }
+
     } else if (compareCaseInsensitive(input, "output name") == 0) {
         if ((errorTLMnumber = getBetweenEqualAndSemicolon(input)) != 0)
             return errorTLMnumber;
@@ -45,6 +45,13 @@ extern "C" {
         GMSH // .msh (MeshFormat 2.2)
     };
 
+    // how the .tbn is written when the mesh is converted
+    enum tbnFormat {
+        TBN_TEXT, // (default)
+        TBN_BINARY, // header and the arrays of nodes and elements as in the memory
+        TBN_NONE // the converted mesh is only kept in the memory
+    };
+
     struct MeshConfig {
         enum inputFormat inputF;
         int inputFormatDefined;
@@ -53,6 +60,7 @@ extern "C" {
         int inputNameDefined;
 
         char *nameOfOutputFile;
+        enum tbnFormat tbnF;
 
         double *scale;
 
@@ -75,6 +83,7 @@ extern "C" {
     void printfMeshConfig(struct MeshConfig*);
     void printfInputFormatOutput(enum inputFormat*, char *);
     void printfNameOfInputFile(char *);
+    void printfTbnFormat(enum tbnFormat *);
     void printfScale(double *);
 
 
@@ -72,6 +72,12 @@ unsigned int initiateSimulationVariable(struct Simulation* simu) {
     // the name on it without the extension. The extension will be used to define
     // how to write the output.
     simu->outputFileExtension = 1;
+    simu->outputFloat = 0;
+    simu->outputBuffers = 2;
+    simu->checkpointSteps = 0;
+    simu->checkpointTime = 0;
+    simu->restart = 0;
+    simu->restartEquation = -1;
 
     simu->outputFileCreated = 0;
     simu->fullNameOfOutputFile = NULL;
@@ -132,6 +138,7 @@ void printfAllSimuData(struct Simulation* simu) {
     printf("Input case file: %s\n", simu->nameOfInputFile);
 
     printfOutputFile(simu);
+    printfCheckpoint(simu);
 
     printfPrintAdditionMode(simu->verboseMode);
     printfVerboseMode(simu->verboseMode);
@@ -176,9 +183,32 @@ void printfOutputFile(struct Simulation *simu) {
             printf("m\n");
             break;
 
+        case 3: // tmb file: binary, see readtmb.m or readtmb.py
+            printf("tmb, saving the outputs as %s\n", simu->outputFloat == 1 ? "float" : "double");
+            break;
+
         default:
             printf("Unknown error\n");
     }
+
+    if (simu->outputBuffers > 0) {
+        printf("Writing the outputs of dynamic simulations in another thread with %d buffers.\n",
+                simu->outputBuffers);
+    }
+}
+
+/*
+ * printfCheckpoint: prints when the dynamic simulations write checkpoints
+ */
+void printfCheckpoint(struct Simulation *simu) {
+    if (simu->checkpointSteps > 0) {
+        printf("Writing a checkpoint of dynamic simulations every %llu time-jumps.\n",
+                simu->checkpointSteps);
+    }
+    if (simu->checkpointTime > 0) {
+        printf("Writing a checkpoint of dynamic simulations every %g s.\n",
+                simu->checkpointTime);
+    }
 }
 
 /*
@@ -288,9 +318,9 @@ unsigned int setConfigurationSimu(char * input, struct Simulation * configInput,
 
         if (compareCaseInsensitive(input, "max") == 0) {
             configInput->nOpenMPcores = configInput->nOpenMPcoresMax;
-        } else {
-            sscanf(input, "%d", &configInput->nOpenMPcoresMax);
-            // return 3884;
+        } else if (sscanf(input, "%d", &configInput->nOpenMPcores) != 1 ||
+                configInput->nOpenMPcores < 1) {
+            return 3884;
         }
 
 #if defined(_OPENMP)
@@ -348,12 +378,57 @@ unsigned int setConfigurationSimu(char * input, struct Simulation * configInput,
         } else if (compareCaseInsensitive(input, "m") == 0) {
             configInput->outputFileExtension = 2;
 
+        } else if (compareCaseInsensitive(input, "tmb") == 0) {
+            configInput->outputFileExtension = 3;
+
         } else {
             return 3890;
 
         }
 
 
+    } else if (compareCaseInsensitive(input, "output buffers") == 0) {
+        if ((errorTLMnumber = getBetweenEqualAndSemicolon(input)) != 0)
+            return errorTLMnumber;
+
+        if (sscanf(input, "%d", &configInput->outputBuffers) != 1 || configInput->outputBuffers < 0)
+            return 3886;
+
+
+    } else if (compareCaseInsensitive(input, "checkpoint steps") == 0) {
+        if ((errorTLMnumber = getBetweenEqualAndSemicolon(input)) != 0)
+            return errorTLMnumber;
+
+        if (sscanf(input, "%llu", &configInput->checkpointSteps) != 1 || strchr(input, '-') != NULL)
+            return 3864;
+
+
+    } else if (compareCaseInsensitive(input, "checkpoint time") == 0) {
+        if ((errorTLMnumber = getBetweenEqualAndSemicolon(input)) != 0)
+            return errorTLMnumber;
+
+        if (sscanf(input, "%lf", &configInput->checkpointTime) != 1 || configInput->checkpointTime < 0)
+            return 3863;
+
+
+    } else if (compareCaseInsensitive(input, "output precision") == 0) {
+        if ((errorTLMnumber = getBetweenEqualAndSemicolon(input)) != 0)
+            return errorTLMnumber;
+
+        removeBlankSpacesBeforeAndAfter(input);
+
+        if (compareCaseInsensitive(input, "double") == 0) {
+            configInput->outputFloat = 0;
+
+        } else if (compareCaseInsensitive(input, "float") == 0) {
+            configInput->outputFloat = 1;
+
+        } else {
+            return 3885;
+
+        }
+
+
     } else if (compareCaseInsensitive(input, "timing mode") == 0) {
         if ((errorTLMnumber = getBetweenEqualAndSemicolon(input)) != 0)
             return errorTLMnumber;
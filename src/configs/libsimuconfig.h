@@ -72,6 +72,33 @@ extern "C" {
         int outputFileExtension;
         // tmo (default): 1
         // m: 2
+        // tmb: 3
+
+        int outputFloat;
+        // 0: the binary output (tmb) saves the outputs as double (default)
+        // 1: the binary output saves the outputs as float
+
+        int outputBuffers;
+        // buffers of the thread that writes the outputs in dynamic simulations
+        // 0: the outputs are written by the solver
+        // 2 (default): the solver goes on while the previous output is written
+
+        unsigned long long checkpointSteps;
+        // 0 (default): no checkpoint after a quantity of time-jumps
+        // n: the dynamic simulations write a checkpoint every n time-jumps
+
+        double checkpointTime;
+        // 0 (default): no checkpoint after a wall-clock time
+        // t: the dynamic simulations write a checkpoint when t seconds have
+        // passed since the last one (or since the beginning of the equation)
+
+        int restart;
+        // 0 (default): the simulation starts from the beginning
+        // 1 (--restart): the simulation continues from its checkpoint
+
+        int restartEquation;
+        // equation being restarted from the checkpoint (from 0). Its output files
+        // are opened to continue. -1: none. Internal flag
 
         // internal flags to write file
         int outputFileCreated;
@@ -115,6 +142,7 @@ extern "C" {
     void printfBench(enum benchmark *);
 
     void printfOutputFile(struct Simulation *);
+    void printfCheckpoint(struct Simulation *);
 
     void printfPrintAdditionMode(int);
     void printfVerboseMode(int);
@@ -35,28 +35,40 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
 
 #include "libgmshreader.h"
 
 #include "../miscellaneous/libstringtlmbht.h"
 #include "../miscellaneous/liberrorcode.h"
+#include "../miscellaneous/libmiscellaneous.h"
 #include "libtbnreader.h"
 
 /*
  * gmshReader: reads the gmsh input file and save it as .tbn.
  * I implemented a scale variable (which is configurable through the case.tlm)
- * that can be used to scale the mesh, if required
+ * that can be used to scale the mesh, if required.
+ * 
+ * The file is mapped to the memory (see mapFileTlmbht). The headers and the
+ * other small lines are copied one by one to pline, but the lines of the $Nodes
+ * and $Elements sections are read directly from the mapped file by
+ * readSectionGmsh, split among the OpenMP threads.
  */
-unsigned int gmshReader(struct MeshConfig * input, struct tlmInternalMesh * output) {
+unsigned int gmshReader(struct MeshConfig * input, struct tlmInternalMesh * output,
+        struct Simulation * simulation) {
 
-    unsigned int errorTLMnumber = 0, lineNumber = 0, elementCode, numberOfTags;
-    long unsigned int tagNumber;
+    unsigned int errorTLMnumber = 0, lineNumber = 0;
     struct dataGmsh2_2 inputGmsh;
+    struct mappedFileTlmbht file;
+    struct meshFormat format;
 
-    char * pline = NULL, *lineOriginal = NULL, *codeForReading = NULL;
-    long lenLine = 0;
+    char * pline = NULL, *lineOriginal = NULL;
+    size_t sizeOfPline = 0, sizeOfLineOriginal = 0;
+    const char *position, *endOfFile, *errorLine = NULL;
     enum gmsh2_2Config ConfigPoint = NOTHING_GMSH;
-    FILE *pfile, *pfileWrite;
     char* nameOfFile = (char*) malloc(strlen(input->nameOfInputFile) + 5);
     // 1 - .
     // 2 - m
@@ -68,21 +80,43 @@ unsigned int gmshReader(struct MeshConfig * input, struct tlmInternalMesh * outp
 
     printf("Opening the file %s\n", nameOfFile);
 
-    //We couldn't find the input file
-    if ((pfile = fopen(nameOfFile, "r")) == NULL) {
-        sendErrorCodeAndMessage(764, nameOfFile, NULL, NULL, NULL);
+    double begin = wallTimeTlmbht();
+
+    //We couldn't find (or read) the input file
+    if ((errorTLMnumber = mapFileTlmbht(nameOfFile, &file)) != 0) {
+        sendErrorCodeAndMessage(errorTLMnumber, nameOfFile, NULL, NULL, NULL);
         free(nameOfFile);
-        return 764;
+        return errorTLMnumber;
     }
+    endOfFile = file.data + file.size;
+
+    // the binary files and the MeshFormat 4.1 are read by blocks, directly to
+    // the internal mesh
+    if (findMeshFormatGmsh(file.data, endOfFile, &format, &position) == 0 &&
+            (format.fileType == 1 || format.version > 2.5)) {
+        errorTLMnumber = readBlocksGmsh(input, output, &format, position, endOfFile);
+        if (errorTLMnumber == 0 && simulation->timingMode == 1)
+            printReadingTimeGmsh(nameOfFile, wallTimeTlmbht() - begin, file.size);
+        unmapFileTlmbht(&file);
+
+        if (errorTLMnumber == 0) {
+            printf("The file %s was successfully read.\n", nameOfFile);
+            errorTLMnumber = writeTlmInternalMeshGmsh(input, output);
+        }
+        free(nameOfFile);
+        return errorTLMnumber;
+    }
+    position = file.data;
 
     if ((errorTLMnumber = initiateDataGmsh2_2(&inputGmsh)) != 0) {
         sendErrorCodeAndMessage(errorTLMnumber, NULL, NULL, NULL, NULL);
+        unmapFileTlmbht(&file);
         free(nameOfFile);
         return errorTLMnumber;
     }
 
-    // read the entire gmsh file until we found the end-of-file character
-        while (getlineTlmbht(&pline, &lenLine, pfile) != 1) {
+    // read the entire gmsh file until we reach the end of the file
+    while (position < endOfFile) {
         // I start the loop checking the variable for error.
         if (errorTLMnumber != 0 && errorTLMnumber != 9999 && errorTLMnumber != 9998
                 && (errorTLMnumber < 7652 || errorTLMnumber > 7658)) {
@@ -101,16 +135,16 @@ unsigned int gmshReader(struct MeshConfig * input, struct tlmInternalMesh * outp
 
         lineNumber++; //DEBUG: Count up of the number of lines
 
+        // I will copy the line as a matter to show it for troubleshooting purposes.
+        // The buffers only grow, so nothing is allocated for most lines
+        copyLineGmsh(position, endOfFile, &lineOriginal, &sizeOfLineOriginal);
+        position += copyLineGmsh(position, endOfFile, &pline, &sizeOfPline);
+
         // DEBUG: Shown the line number and content
         // printf("Line %04u: %s", lineNumber, pline);
         // DEBUG: Shown the line number, quantity of characters in the line and content
         // printf("Line %04u (%u): %s", lineNumber, strlen(pline), pline); 
 
-        // I will copy the pline as a matter to show it for troubleshooting purposes.
-        // + 1 for the end-of-line character
-        lineOriginal = (char *) realloc(lineOriginal, strlen(pline) + 1);
-        strcpy(lineOriginal, pline);
-
         // It returns 0 if it got some useful content on that line.
         // it returns 9998 if it got nothing useful
         // if there's nothing useful or an error, we should go to the next loop iteration.
@@ -161,43 +195,32 @@ unsigned int gmshReader(struct MeshConfig * input, struct tlmInternalMesh * outp
                 // reading the number of nodes
                 if (inputGmsh.numberOfNode == 0) {
                     sscanf(pline, "%llu", &inputGmsh.numberOfNode);
-                    inputGmsh.nodes = (struct node *)
-                            realloc(inputGmsh.nodes, sizeof (struct node)*
+                    output->nodes = (struct node *)
+                            realloc(output->nodes, sizeof (struct node)*
                             inputGmsh.numberOfNode);
 
                     // if the algorithm cannot allocate the variable, we will issue
                     // an error and let the user knows
-                    if (inputGmsh.nodes == NULL) {
+                    if (output->nodes == NULL) {
                         errorTLMnumber = 7510;
                         continue;
                     }
-
-                    // reading the nodes
-                } else {
-                    // in this case, == is equivalent to >= because, to be greater,
-                    // it would be required to be equal first. Note that the variable
-                    // inputGmsh.numberOfNodeReads is add one at the end
-                    if (inputGmsh.numberOfNodeReads == inputGmsh.numberOfNode) {
-                        printf("More nodes were read than the number of nodes provided by gmsh input\n");
-                        printf("%llu vs. %llu\n", inputGmsh.numberOfNodeReads + 1, inputGmsh.numberOfNode);
-                        errorTLMnumber = 6516;
+                    output->numberOfNode = inputGmsh.numberOfNode;
+
+                    // reading the nodes directly from the file to output. Only
+                    // the line $EndNodes is left for this loop
+                    if ((errorTLMnumber = readSectionGmsh(&inputGmsh, output, input->scale, NODES,
+                            &position, endOfFile, &lineNumber, simulation->nOpenMPcores,
+                            &errorLine)) != 0) {
+                        copyLineGmsh(errorLine, endOfFile, &lineOriginal, &sizeOfLineOriginal);
                         continue;
                     }
-                    // number of the node (not saved), and positions in x, y, and z
-                    sscanf(pline, "%*u %lf %lf %lf",
-                            &inputGmsh.nodes[inputGmsh.numberOfNodeReads].x,
-                            &inputGmsh.nodes[inputGmsh.numberOfNodeReads].y,
-                            &inputGmsh.nodes[inputGmsh.numberOfNodeReads].z);
-
-                    // Applying the scale factor
-                    inputGmsh.nodes[inputGmsh.numberOfNodeReads].x =
-                            inputGmsh.nodes[inputGmsh.numberOfNodeReads].x * input->scale[0];
-                    inputGmsh.nodes[inputGmsh.numberOfNodeReads].y =
-                            inputGmsh.nodes[inputGmsh.numberOfNodeReads].y * input->scale[1];
-                    inputGmsh.nodes[inputGmsh.numberOfNodeReads].z =
-                            inputGmsh.nodes[inputGmsh.numberOfNodeReads].z * input->scale[2];
-
-                    inputGmsh.numberOfNodeReads++;
+
+                } else {
+                    // readSectionGmsh stops at the first header. If it is not
+                    // $EndNodes, the file is not what I expected
+                    errorTLMnumber = 7659;
+                    continue;
                 }
                 break;
 
@@ -216,243 +239,23 @@ unsigned int gmshReader(struct MeshConfig * input, struct tlmInternalMesh * outp
                 // reading the number of elements
                 if (inputGmsh.numberOfElement == 0) {
                     sscanf(pline, "%llu", &inputGmsh.numberOfElement);
-                    inputGmsh.saveElement = (struct elementAny *)
-                            realloc(inputGmsh.saveElement, sizeof (struct elementAny)*
-                            inputGmsh.numberOfElement);
 
-                    // if the algorithm cannot allocate the variable, we will issue
-                    // an error and let the user knows
-                    if (inputGmsh.saveElement == NULL) {
-                        errorTLMnumber = 7511;
+                    // reading the elements directly from the file to the
+                    // arrays of each element type of output (see
+                    // readElementsChunkGmsh). Only the line $EndElements is
+                    // left for this loop
+                    if ((errorTLMnumber = readSectionGmsh(&inputGmsh, output, input->scale, ELEMENTS,
+                            &position, endOfFile, &lineNumber, simulation->nOpenMPcores,
+                            &errorLine)) != 0) {
+                        copyLineGmsh(errorLine, endOfFile, &lineOriginal, &sizeOfLineOriginal);
                         continue;
                     }
 
-                    // reading the elements
                 } else {
-                    // in this case, == is equivalent to >= because, to be greater,
-                    // it would be required to be equal first. Note that the variable
-                    // inputGmsh.numberOfElementReads is add one at the end
-                    if (inputGmsh.numberOfElementReads == inputGmsh.numberOfElement) {
-                        printf("More elements were read than the number of elements provided by gmsh input\n");
-                        printf("%llu vs. %llu\n", inputGmsh.numberOfElementReads + 1, inputGmsh.numberOfElement);
-                        errorTLMnumber = 6517;
-                        continue;
-                    }
-                    // the line of the element contains:
-                    // elementNumber elementCode numberOfTagsOfThisElement Tags... Nodes...
-                    //
-                    // The default sequency of tags is 1st the number of the physical
-                    // entity to which the element belongs (this is the only
-                    // tag read by the software), 2nd the number of elementary
-                    // geometrical entity to which the element belongs, 3rd the number of mesh partitions to which
-                    // the element belongs, and 4th and so on are the partition ids. Negative
-                    // partition ids indicate ghost cells.
-                    //
-                    // This code requires at least the first two tags. We will issue
-                    // an error in case we don't see it.
-                    sscanf(pline, "%*u %u %u %lu", &elementCode, &numberOfTags, &tagNumber);
-
-                    if (numberOfTags < 2) {
-                        errorTLMnumber = 6515;
-                        continue;
-                    }
-
-                    // The ones I will not read
-                    codeForReading = (char *) realloc(codeForReading,
-                            sizeof (char)*(3 + numberOfTags)*4 + 1);
-                    // elementNumber elementCode numberOfTagsOfThisElement Tags1 Tag2 Nodes...
-                    strcpy(codeForReading, "%*u %*u %*u %*u %*u ");
-
-                    // I'm not reading the others tag numbers (if any)
-                    for (int i = 0; i < numberOfTags - 2; i++)
-                        strcat(codeForReading, "%*u ");
-                    // quantity of characters for the codeForReading string:
-                    // (3 + numberOfTags)*4 = Quantity of unsigned ints not read
-                    // elementNumber, elementCode, numberOfTags, Tags...
-                    // 4 = '%*u '
-                    // 1 = '/0'
-                    // 5 * numberOfNodes. 5 = '%llu '
-
-                    switch (elementCode) {
-                        case 1: // 2 nodes line
-                            codeForReading = (char *) realloc(codeForReading,
-                                    sizeof (char)*(3 + numberOfTags)*4 + 1 + 5 * 2);
-
-                            strcat(codeForReading, "%llu %llu");
-
-                            inputGmsh.saveElement
-                                    [inputGmsh.numberOfElementReads].elementCode = 1;
-                            inputGmsh.saveElement
-                                    [inputGmsh.numberOfElementReads].tag = tagNumber;
-
-                            sscanf(pline, codeForReading, &inputGmsh.saveElement
-                                    [inputGmsh.numberOfElementReads].N1,
-                                    &inputGmsh.saveElement
-                                    [inputGmsh.numberOfElementReads].N2);
-
-                            break;
-                        case 2: // 3 nodes triangle
-                            codeForReading = (char *) realloc(codeForReading,
-                                    sizeof (char)*(3 + numberOfTags)*4 + 1 + 5 * 3);
-
-                            strcat(codeForReading, "%llu %llu %llu");
-
-                            inputGmsh.saveElement
-                                    [inputGmsh.numberOfElementReads].elementCode = 2;
-                            inputGmsh.saveElement
-                                    [inputGmsh.numberOfElementReads].tag = tagNumber;
-
-                            sscanf(pline, codeForReading, &inputGmsh.saveElement
-                                    [inputGmsh.numberOfElementReads].N1,
-                                    &inputGmsh.saveElement
-                                    [inputGmsh.numberOfElementReads].N2,
-                                    &inputGmsh.saveElement
-                                    [inputGmsh.numberOfElementReads].N3);
-
-                            break;
-                        case 3: // 4 nodes quadrangle
-                            codeForReading = (char *) realloc(codeForReading,
-                                    sizeof (char)*(3 + numberOfTags)*4 + 1 + 5 * 3);
-
-                            strcat(codeForReading, "%llu %llu %llu %llu");
-
-                            inputGmsh.saveElement
-                                    [inputGmsh.numberOfElementReads].elementCode = 3;
-                            inputGmsh.saveElement
-                                    [inputGmsh.numberOfElementReads].tag = tagNumber;
-
-                            sscanf(pline, codeForReading, &inputGmsh.saveElement
-                                    [inputGmsh.numberOfElementReads].N1,
-                                    &inputGmsh.saveElement
-                                    [inputGmsh.numberOfElementReads].N2,
-                                    &inputGmsh.saveElement
-                                    [inputGmsh.numberOfElementReads].N3,
-                                    &inputGmsh.saveElement
-                                    [inputGmsh.numberOfElementReads].N4);
-                            
-                            break;
-                        case 4: // 4 nodes tetrahedron
-                            codeForReading = (char *) realloc(codeForReading,
-                                    sizeof (char)*(3 + numberOfTags)*4 + 1 + 5 * 4);
-
-                            strcat(codeForReading, "%llu %llu %llu %llu");
-
-                            inputGmsh.saveElement
-                                    [inputGmsh.numberOfElementReads].elementCode = 4;
-                            inputGmsh.saveElement
-                                    [inputGmsh.numberOfElementReads].tag = tagNumber;
-
-                            sscanf(pline, codeForReading, &inputGmsh.saveElement
-                                    [inputGmsh.numberOfElementReads].N1,
-                                    &inputGmsh.saveElement
-                                    [inputGmsh.numberOfElementReads].N2,
-                                    &inputGmsh.saveElement
-                                    [inputGmsh.numberOfElementReads].N3,
-                                    &inputGmsh.saveElement
-                                    [inputGmsh.numberOfElementReads].N4);
-
-                            break;
-                        case 5: // 8 nodes hexahedron
-                            codeForReading = (char *) realloc(codeForReading,
-                                    sizeof (char)*(3 + numberOfTags)*4 + 1 + 5 * 8);
-
-                            strcat(codeForReading, "%llu %llu %llu %llu %llu %llu %llu %llu");
-
-                            inputGmsh.saveElement
-                                    [inputGmsh.numberOfElementReads].elementCode = 5;
-                            inputGmsh.saveElement
-                                    [inputGmsh.numberOfElementReads].tag = tagNumber;
-
-                            sscanf(pline, codeForReading, &inputGmsh.saveElement
-                                    [inputGmsh.numberOfElementReads].N1,
-                                    &inputGmsh.saveElement
-                                    [inputGmsh.numberOfElementReads].N2,
-                                    &inputGmsh.saveElement
-                                    [inputGmsh.numberOfElementReads].N3,
-                                    &inputGmsh.saveElement
-                                    [inputGmsh.numberOfElementReads].N4,
-                                    &inputGmsh.saveElement
-                                    [inputGmsh.numberOfElementReads].N5,
-                                    &inputGmsh.saveElement
-                                    [inputGmsh.numberOfElementReads].N6,
-                                    &inputGmsh.saveElement
-                                    [inputGmsh.numberOfElementReads].N7,
-                                    &inputGmsh.saveElement
-                                    [inputGmsh.numberOfElementReads].N8);
-                            
-                            break;
-                        case 6: // 6 nodes prism
-                            codeForReading = (char *) realloc(codeForReading,
-                                    sizeof (char)*(3 + numberOfTags)*4 + 1 + 5 * 6);
-
-                            strcat(codeForReading, "%llu %llu %llu %llu %llu %llu");
-
-                            inputGmsh.saveElement
-                                    [inputGmsh.numberOfElementReads].elementCode = 6;
-                            inputGmsh.saveElement
-                                    [inputGmsh.numberOfElementReads].tag = tagNumber;
-
-                            sscanf(pline, codeForReading, &inputGmsh.saveElement
-                                    [inputGmsh.numberOfElementReads].N1,
-                                    &inputGmsh.saveElement
-                                    [inputGmsh.numberOfElementReads].N2,
-                                    &inputGmsh.saveElement
-                                    [inputGmsh.numberOfElementReads].N3,
-                                    &inputGmsh.saveElement
-                                    [inputGmsh.numberOfElementReads].N4,
-                                    &inputGmsh.saveElement
-                                    [inputGmsh.numberOfElementReads].N5,
-                                    &inputGmsh.saveElement
-                                    [inputGmsh.numberOfElementReads].N6);
-                            
-                            break;
-                        case 7: // 5 nodes pyramid
-                            codeForReading = (char *) realloc(codeForReading,
-                                    sizeof (char)*(3 + numberOfTags)*4 + 1 + 5 * 5);
-
-                            strcat(codeForReading, "%llu %llu %llu %llu %llu");
-
-                            inputGmsh.saveElement
-                                    [inputGmsh.numberOfElementReads].elementCode = 7;
-                            inputGmsh.saveElement
-                                    [inputGmsh.numberOfElementReads].tag = tagNumber;
-
-                            sscanf(pline, codeForReading, &inputGmsh.saveElement
-                                    [inputGmsh.numberOfElementReads].N1,
-                                    &inputGmsh.saveElement
-                                    [inputGmsh.numberOfElementReads].N2,
-                                    &inputGmsh.saveElement
-                                    [inputGmsh.numberOfElementReads].N3,
-                                    &inputGmsh.saveElement
-                                    [inputGmsh.numberOfElementReads].N4,
-                                    &inputGmsh.saveElement
-                                    [inputGmsh.numberOfElementReads].N5);
-                            
-                            break;
-                        case 15: // 1 node point
-                            codeForReading = (char *) realloc(codeForReading,
-                                    sizeof (char)*(3 + numberOfTags)*4 + 1 + 5);
-
-                            strcat(codeForReading, "%llu");
-
-                            inputGmsh.saveElement
-                                    [inputGmsh.numberOfElementReads].elementCode = 15;
-                            inputGmsh.saveElement
-                                    [inputGmsh.numberOfElementReads].tag = tagNumber;
-
-                            sscanf(pline, codeForReading, &inputGmsh.saveElement
-                                    [inputGmsh.numberOfElementReads].N1);
-
-                            break;
-                        default:
-                            errorTLMnumber = 6514;
-                            continue;
-                            break;
-                    }
-
-                    inputGmsh.quantityOfSpecificElement[elementCode] =
-                            inputGmsh.quantityOfSpecificElement[elementCode] + 1;
-                    inputGmsh.numberOfElementReads++;
+                    // readSectionGmsh stops at the first header. If it is not
+                    // $EndElements, the file is not what I expected
+                    errorTLMnumber = 7659;
+                    continue;
                 }
                 break;
 
@@ -534,24 +337,25 @@ unsigned int gmshReader(struct MeshConfig * input, struct tlmInternalMesh * outp
     if (errorTLMnumber != 0)
         sendErrorCodeAndMessage(errorTLMnumber, &lineNumber, lineOriginal, NULL, NULL);
 
+    if (errorTLMnumber == 0 && simulation->timingMode == 1)
+        printReadingTimeGmsh(nameOfFile, wallTimeTlmbht() - begin, file.size);
+
     // freeing and closing file
     free(pline);
     pline = NULL;
     free(lineOriginal);
     lineOriginal = NULL;
-    free(codeForReading);
-    codeForReading = NULL;
-    if (fclose(pfile) == EOF) {
-        sendErrorCodeAndMessage(345, NULL, NULL, NULL, NULL);
-        errorTLMnumber = 345;
-    }
+    unmapFileTlmbht(&file);
 
     // in case of an error, terminating the Gmsh data and returning
     if (errorTLMnumber != 0 && errorTLMnumber != 9999 && errorTLMnumber != 9998
             && (errorTLMnumber < 7652 || errorTLMnumber > 7658)) {
-        // terminating the Gmsh data and showing error message if so
-        if ((errorTLMnumber = terminateDataGmsh2_2(&inputGmsh)) != 0)
-            sendErrorCodeAndMessage(errorTLMnumber, NULL, NULL, NULL, NULL);
+        // terminating the Gmsh data and showing error message if so. The
+        // error of the reading is the one returned
+        unsigned int errorTLMnumber2;
+        if ((errorTLMnumber2 = terminateDataGmsh2_2(&inputGmsh)) != 0)
+            sendErrorCodeAndMessage(errorTLMnumber2, NULL, NULL, NULL, NULL);
+        free(nameOfFile);
 
         return errorTLMnumber;
     }
@@ -559,41 +363,8 @@ unsigned int gmshReader(struct MeshConfig * input, struct tlmInternalMesh * outp
 
     printf("The file %s was successfully read.\n", nameOfFile);
 
-    // changing the name of file for saving the content read
-    nameOfFile = (char*) realloc(nameOfFile, sizeof (char)*(strlen(input->nameOfOutputFile) + 5));
-    // 4 (extension) + 1 ('\0')
-    strcpy(nameOfFile, input->nameOfOutputFile);
-    strcat(nameOfFile, ".tbn");
-
-    // Now it is writing mode. If there is a file with the same name, I'm sorry,
-    // it will be replaced
-    if ((pfileWrite = fopen(nameOfFile, "w")) == NULL) {
-        // error opening the file
-        sendErrorCodeAndMessage(764, nameOfFile, NULL, NULL, NULL);
-        errorTLMnumber = 764;
-    }
-    // at this point, all the elements and nodes were read. Now it is time to
-    // convert them.
-    // I will first try to read the internal mesh data to the memory and save the 
-    // data into the file at the same time. If we cannot do this, I will try to 
-    // deallocate the data, save the data into the file, and them read the file again.
-    if (errorTLMnumber == 0 &&
-            (errorTLMnumber = readAndWriteGmsh(output, &inputGmsh, pfileWrite)) != 0) {
-        // 9999 = no memory. Try the other approach
-        // trying to save the file, deallocate from the memory, and then read
-        if (errorTLMnumber != 9999 ||
-                (errorTLMnumber = writeThenReadGmsh(output, &inputGmsh, &pfileWrite, input)) != 0)
-            ;// not needed because the functions in writeThenReadGmsh already call this function. sendErrorCodeAndMessage(errorTLMnumber, NULL, NULL, NULL, NULL);
-    }
-
-
-    // closing and freeing the files
-    // First check if it is != than NULL because it can be already closed in the
-    // functions above    
-    if (pfileWrite != NULL && (fclose(pfileWrite) == EOF)) {
-        sendErrorCodeAndMessage(345, NULL, NULL, NULL, NULL);
-        errorTLMnumber = 345;
-    }
+    // the nodes and elements are already in output. Saving them is optional
+    errorTLMnumber = writeTlmInternalMeshGmsh(input, output);
 
     free(nameOfFile);
     nameOfFile = NULL;
@@ -606,515 +377,1267 @@ unsigned int gmshReader(struct MeshConfig * input, struct tlmInternalMesh * outp
 }
 
 /*
- * setMeshGmshConfigTo: compare the string of the input to standardized texts.
- * The comparison is case insensitive.
+ * copyLineGmsh: copies the line that starts in position (including the new
+ * line character, if any) to *line and ends it with '\0'. *line is only
+ * reallocated when the line does not fit in it.
+ * It returns the quantity of characters of the line.
  */
-unsigned int setMeshGmshConfigTo(char *input, enum gmsh2_2Config * config) {
-    if (compareCaseInsensitive(input, "$MeshFormat") == 0) {
-        *config = MESH_FORMAT;
-    } else if (compareCaseInsensitive(input, "$Nodes") == 0) {
-        *config = NODES;
-    } else if (compareCaseInsensitive(input, "$Elements") == 0) {
-        *config = ELEMENTS;
-    } else if (compareCaseInsensitive(input, "$PhysicalNames") == 0) {
-        *config = PHYSICAL_NAMES;
-    } else if (compareCaseInsensitive(input, "$Periodic") == 0) {
-        *config = PERIODIC;
-    } else if (compareCaseInsensitive(input, "$NodeData") == 0) {
-        *config = NODE_DATA;
-    } else if (compareCaseInsensitive(input, "$ElementData") == 0) {
-        *config = ELEMENT_DATA;
-    } else if (compareCaseInsensitive(input, "$ElementNodeData") == 0) {
-        *config = ELEMENT_NODE_DATA;
-    } else if (compareCaseInsensitive(input, "$InterpolationScheme") == 0) {
-        *config = INTERPOLATION_SCHEME;
-    } else if ((strncmp(input, "$", 1) == 0)) {
-        *config = UNRECOGNIZED_HEADER;
-    } else {
-        return 7659;
+size_t copyLineGmsh(const char *position, const char *end, char **line, size_t *sizeOfLine) {
+    const char *endOfLine = (const char *) memchr(position, '\n', end - position);
+    size_t length = (endOfLine == NULL) ? (size_t) (end - position) :
+            (size_t) (endOfLine - position) + 1;
+
+    // + 1 for the end-of-line character
+    if (length + 1 > *sizeOfLine) {
+        *sizeOfLine = 2 * (length + 1);
+        *line = (char *) realloc(*line, *sizeOfLine);
     }
+    memcpy(*line, position, length);
+    (*line)[length] = '\0';
 
+    return length;
+}
+
+/*
+ * findEndOfSectionGmsh: returns the beginning of the first line from position
+ * that starts with '$' (after blank spaces), which is the line that ends the
+ * section. Returns end if there is no such line. It is only used for the
+ * sections written as text.
+ */
+const char *findEndOfSectionGmsh(const char *position, const char *end) {
+    const char *dollar = position, *beginningOfLine;
 
+    // '$' is not expected inside the sections, so memchr does most of the work
+    while ((dollar = (const char *) memchr(dollar, '$', end - dollar)) != NULL) {
+        beginningOfLine = dollar;
+        while (beginningOfLine > position && (beginningOfLine[-1] == ' ' ||
+                beginningOfLine[-1] == '\t' || beginningOfLine[-1] == '\r'))
+            beginningOfLine--;
 
-    return 0;
+        if (beginningOfLine == position || beginningOfLine[-1] == '\n')
+            return beginningOfLine;
+
+        dollar++;
+    }
+
+    return end;
 }
 
 /*
- * initiateDataGmsh2_2: initiate the gmsh file with standard values
+ * isUsefulLineGmsh: returns 1 if the line from position to endOfLine has
+ * something to read. Blank lines and comments (followed by '//') are not read,
+ * as in getUsefulContent.
  */
-unsigned int initiateDataGmsh2_2(struct dataGmsh2_2 *input) {
-    input->MeshFormat.MeshFormatDefined = 0;
+int isUsefulLineGmsh(const char *position, const char *endOfLine) {
+    position = skipBlankSpacesTlmbht(position, endOfLine);
 
-    // elements from 0 to 99
-    input->quantityOfSpecificElement = (unsigned long long*)
-            malloc(sizeof (unsigned long long)*100);
-    for (int i = 0; i < 100; i++) {
-        input->quantityOfSpecificElement[i] = 0;
+    if (position == endOfLine || (position + 1 < endOfLine && position[0] == '/'
+            && position[1] == '/'))
+        return 0;
+
+    return 1;
+}
+
+/*
+ * splitSectionGmsh: splits the section from start to end in chunks of whole
+ * lines, one per thread. Then, in parallel, I count the lines of each chunk,
+ * so I know the index of the first node or element of each chunk and the
+ * number of its first line in the file (firstLine is the number of the first
+ * line of the section).
+ * Sections smaller than GMSH_CHUNK_MINIMUM per thread use less threads.
+ */
+unsigned int splitSectionGmsh(const char *start, const char *end, int nThreads,
+        unsigned int firstLine, struct chunkGmsh2_2 **chunks, int *quantityOfChunks) {
+    size_t size = (size_t) (end - start);
+    int k;
+
+    *quantityOfChunks = nThreads;
+    if ((size_t) *quantityOfChunks > size / GMSH_CHUNK_MINIMUM)
+        *quantityOfChunks = (int) (size / GMSH_CHUNK_MINIMUM);
+    if (*quantityOfChunks < 1)
+        *quantityOfChunks = 1;
+
+    if ((*chunks = (struct chunkGmsh2_2 *) calloc(*quantityOfChunks,
+            sizeof (struct chunkGmsh2_2))) == NULL)
+        return 8755;
+
+    // each chunk starts just after a new line character
+    (*chunks)[0].start = start;
+    for (k = 1; k < *quantityOfChunks; k++) {
+        const char *newLine = start + (size * k) / *quantityOfChunks;
+
+        if (newLine < (*chunks)[k - 1].start)
+            newLine = (*chunks)[k - 1].start;
+        if ((newLine = (const char *) memchr(newLine, '\n', end - newLine)) == NULL) {
+            (*chunks)[k].start = end;
+        } else {
+            (*chunks)[k].start = newLine + 1;
+        }
+        (*chunks)[k - 1].end = (*chunks)[k].start;
+    }
+    (*chunks)[*quantityOfChunks - 1].end = end;
+
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(static, 1) num_threads(*quantityOfChunks)
+#endif
+    for (k = 0; k < *quantityOfChunks; k++) {
+        const char *line, *endOfLine;
+        struct chunkGmsh2_2 *chunk = &(*chunks)[k];
+
+        for (line = chunk->start; line < chunk->end;
+            line = (endOfLine < chunk->end) ? endOfLine + 1 : chunk->end) {
+            if ((endOfLine = (const char *) memchr(line, '\n', chunk->end - line)) == NULL)
+                endOfLine = chunk->end;
+
+            chunk->quantityOfLines++;
+            if (isUsefulLineGmsh(line, endOfLine) == 1)
+                chunk->quantityRead++;
+        }
     }
-    input->saveElement = NULL;
-    input->numberOfElementReads = 0;
-    input->numberOfElement = 0;
 
+    (*chunks)[0].firstRead = 0;
+    (*chunks)[0].firstLine = firstLine;
+    for (k = 1; k < *quantityOfChunks; k++) {
+        (*chunks)[k].firstRead = (*chunks)[k - 1].firstRead + (*chunks)[k - 1].quantityRead;
+        (*chunks)[k].firstLine = (*chunks)[k - 1].firstLine + (*chunks)[k - 1].quantityOfLines;
+    }
 
-    input->nodes = NULL;
-    input->numberOfNode = 0;
-    input->numberOfNodeReads = 0;
     return 0;
 }
 
 /*
- * terminateDataGmsh2_2: terminate the gmsh file
+ * readNodesChunkGmsh: reads the nodes of one chunk of the $Nodes section to
+ * output. Each line has the number of the node (not saved) and its positions
+ * in x, y, and z, which are multiplied by the scale.
  */
-unsigned int terminateDataGmsh2_2(struct dataGmsh2_2 *input) {
+void readNodesChunkGmsh(struct dataGmsh2_2 *inputGmsh, struct tlmInternalMesh *output,
+        double *scale, struct chunkGmsh2_2 *chunk) {
+    const char *line, *endOfLine, *position;
+    unsigned long long i = chunk->firstRead, numberOfTheNode;
+    unsigned int lineNumber = chunk->firstLine - 1;
+    struct node *nodeRead;
+
+    for (line = chunk->start; line < chunk->end;
+            line = (endOfLine < chunk->end) ? endOfLine + 1 : chunk->end) {
+        if ((endOfLine = (const char *) memchr(line, '\n', chunk->end - line)) == NULL)
+            endOfLine = chunk->end;
+        lineNumber++;
+
+        if (isUsefulLineGmsh(line, endOfLine) == 0)
+            continue;
+
+        chunk->errorLine = line;
+        chunk->errorLineNumber = lineNumber;
+
+        if (i >= inputGmsh->numberOfNode) {
+            chunk->errorTLMnumber = 6516;
+            return;
+        }
 
-    free(input->quantityOfSpecificElement);
-    input->quantityOfSpecificElement = NULL;
-    free(input->saveElement);
-    input->saveElement = NULL;
-    free(input->nodes);
-    input->nodes = NULL;
+        nodeRead = &output->nodes[i];
+        if ((position = scanUnsignedTlmbht(line, endOfLine, &numberOfTheNode)) == NULL ||
+                (position = scanDoubleTlmbht(position, endOfLine, &nodeRead->x)) == NULL ||
+                (position = scanDoubleTlmbht(position, endOfLine, &nodeRead->y)) == NULL ||
+                (position = scanDoubleTlmbht(position, endOfLine, &nodeRead->z)) == NULL) {
+            chunk->errorTLMnumber = 7659;
+            return;
+        }
 
-    return 0;
+        // Applying the scale factor
+        nodeRead->x = nodeRead->x * scale[0];
+        nodeRead->y = nodeRead->y * scale[1];
+        nodeRead->z = nodeRead->z * scale[2];
+
+        i++;
+    }
 }
 
 /*
- * deallocateOnlyTheNodeGmsh: This is an strategy to release partial memory
- * while doing the processing. This function will free only the nodes.
+ * countElementsChunkGmsh: counts the elements of each element code of one
+ * chunk of the $Elements section, so the elements can be read directly to
+ * their arrays in output. Only the number and the code of each element are
+ * read here.
  */
-unsigned int deallocateOnlyTheNodeGmsh(struct dataGmsh2_2 *input) {
+void countElementsChunkGmsh(struct dataGmsh2_2 *inputGmsh, struct chunkGmsh2_2 *chunk) {
+    const char *line, *endOfLine, *position;
+    unsigned long long i = chunk->firstRead, number, elementCode;
+    unsigned int lineNumber = chunk->firstLine - 1;
+
+    for (line = chunk->start; line < chunk->end;
+            line = (endOfLine < chunk->end) ? endOfLine + 1 : chunk->end) {
+        if ((endOfLine = (const char *) memchr(line, '\n', chunk->end - line)) == NULL)
+            endOfLine = chunk->end;
+        lineNumber++;
+
+        if (isUsefulLineGmsh(line, endOfLine) == 0)
+            continue;
+
+        chunk->errorLine = line;
+        chunk->errorLineNumber = lineNumber;
+
+        if (i >= inputGmsh->numberOfElement) {
+            chunk->errorTLMnumber = 6517;
+            return;
+        }
 
-    free(input->nodes);
-    input->nodes = NULL;
+        if ((position = scanUnsignedTlmbht(line, endOfLine, &number)) == NULL ||
+                (position = scanUnsignedTlmbht(position, endOfLine, &elementCode)) == NULL) {
+            chunk->errorTLMnumber = 7659;
+            return;
+        }
 
-    return 0;
+        if (quantityOfNodesOfElementTlmInternalMesh(elementCode) == 0) {
+            chunk->errorTLMnumber = 6514;
+            return;
+        }
+
+        chunk->quantityOfSpecificElement[elementCode]++;
+        i++;
+    }
 }
 
 /*
- * deallocateOnlyTheElementGmsh: This is an strategy to release partial memory
- * while doing the processing. This function will free only the elements.
+ * readElementsChunkGmsh: reads the elements of one chunk of the $Elements
+ * section to output. The elements of each element code are saved from
+ * firstOfSpecificElement of the chunk (see countElementsChunkGmsh).
+ * 
+ * The line of the element contains:
+ * elementNumber elementCode numberOfTagsOfThisElement Tags... Nodes...
+ *
+ * The default sequency of tags is 1st the number of the physical
+ * entity to which the element belongs (this is the only
+ * tag read by the software), 2nd the number of elementary
+ * geometrical entity to which the element belongs, 3rd the number of mesh partitions to which
+ * the element belongs, and 4th and so on are the partition ids. Negative
+ * partition ids indicate ghost cells.
+ *
+ * This code requires at least the first two tags. We will issue
+ * an error in case we don't see it.
  */
-unsigned int deallocateOnlyTheElementGmsh(struct dataGmsh2_2 *input) {
+void readElementsChunkGmsh(struct tlmInternalMesh *output, struct chunkGmsh2_2 *chunk) {
+    const char *line, *endOfLine, *position;
+    unsigned long long number, elementCode, numberOfTags, tagNumber, N[8];
+    unsigned int lineNumber = chunk->firstLine - 1;
+    int quantityOfNodes;
+
+    for (line = chunk->start; line < chunk->end;
+            line = (endOfLine < chunk->end) ? endOfLine + 1 : chunk->end) {
+        if ((endOfLine = (const char *) memchr(line, '\n', chunk->end - line)) == NULL)
+            endOfLine = chunk->end;
+        lineNumber++;
+
+        if (isUsefulLineGmsh(line, endOfLine) == 0)
+            continue;
+
+        chunk->errorLine = line;
+        chunk->errorLineNumber = lineNumber;
+
+        // the number and the code were already checked by countElementsChunkGmsh
+        position = scanUnsignedTlmbht(line, endOfLine, &number);
+        position = scanUnsignedTlmbht(position, endOfLine, &elementCode);
+        if ((position = scanUnsignedTlmbht(position, endOfLine, &numberOfTags)) == NULL) {
+            chunk->errorTLMnumber = 7659;
+            return;
+        }
 
-    free(input->quantityOfSpecificElement);
-    input->quantityOfSpecificElement = NULL;
-    free(input->saveElement);
-    input->saveElement = NULL;
+        if (numberOfTags < 2) {
+            chunk->errorTLMnumber = 6515;
+            return;
+        }
 
-    return 0;
+        if ((position = scanUnsignedTlmbht(position, endOfLine, &tagNumber)) == NULL) {
+            chunk->errorTLMnumber = 7659;
+            return;
+        }
+
+        // I'm not reading the others tag numbers. The partition ids can be negative
+        for (unsigned long long j = 1; j < numberOfTags; j++) {
+            position = skipBlankSpacesTlmbht(position, endOfLine);
+            if (position < endOfLine && *position == '-')
+                position++;
+            if ((position = scanUnsignedTlmbht(position, endOfLine, &number)) == NULL) {
+                chunk->errorTLMnumber = 7659;
+                return;
+            }
+        }
+
+        quantityOfNodes = quantityOfNodesOfElementTlmInternalMesh(elementCode);
+        for (int j = 0; j < quantityOfNodes; j++) {
+            if ((position = scanUnsignedTlmbht(position, endOfLine, &N[j])) == NULL) {
+                chunk->errorTLMnumber = 7659;
+                return;
+            }
+        }
+
+        setElementTlmInternalMesh(output, elementCode,
+                chunk->firstOfSpecificElement[elementCode]++,
+                (long unsigned int) tagNumber, N);
+    }
 }
 
 /*
- * readAndWriteGmsh: Try to allocate the data into the memory and to save into
- * the file at the same time.
+ * readSectionGmsh: reads the $Nodes or $Elements section (defined by section)
+ * that starts in *position, after the line with the quantity of nodes or
+ * elements, directly to output. The section is split by splitSectionGmsh and
+ * the chunks are read in parallel. For $Elements, the elements of each chunk
+ * are counted first, so the arrays of each element type can be allocated and
+ * each chunk knows where its elements go.
+ * 
+ * At the end, *position and *lineNumber are the ones of the last line read,
+ * so the line that ends the section is read by gmshReader. In case of error,
+ * *lineNumber and *errorLine are the ones of the first line with an error.
  */
-unsigned int readAndWriteGmsh(struct tlmInternalMesh * output,
-        struct dataGmsh2_2 * input, FILE * saveFile) {
-    unsigned long long i, *quantityOfElementTypesSaved;
-    unsigned int errorTLMnumber;
+unsigned int readSectionGmsh(struct dataGmsh2_2 *inputGmsh, struct tlmInternalMesh *output,
+        double *scale, enum gmsh2_2Config section, const char **position, const char *end,
+        unsigned int *lineNumber, int nThreads, const char **errorLine) {
+    struct chunkGmsh2_2 *chunks;
+    const char *endOfSection = findEndOfSectionGmsh(*position, end);
+    unsigned long long quantityRead;
+    unsigned int errorTLMnumber = 0;
+    int quantityOfChunks, k, j;
+
+    if ((errorTLMnumber = splitSectionGmsh(*position, endOfSection, nThreads,
+            *lineNumber + 1, &chunks, &quantityOfChunks)) != 0)
+        return errorTLMnumber;
 
-    // allocating in the memory the variables for nodes and elements
-    if ((errorTLMnumber = allocateTLMInternalMeshNodesAndElements(output, input->numberOfNode,
-            input->quantityOfSpecificElement)) != 0) {
-        sendErrorCodeAndMessage(errorTLMnumber, NULL, NULL, NULL, NULL);
-        return 9999; // my code to say that we faced a problem of memory
+    if (section == ELEMENTS) {
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(static, 1) num_threads(quantityOfChunks)
+#endif
+        for (k = 0; k < quantityOfChunks; k++)
+            countElementsChunkGmsh(inputGmsh, &chunks[k]);
+
+        for (k = 0; k < quantityOfChunks && errorTLMnumber == 0; k++)
+            errorTLMnumber = chunks[k].errorTLMnumber;
+
+        // the elements of each code of a chunk come after the ones of the
+        // chunks before it
+        if (errorTLMnumber == 0) {
+            for (j = 0; j < 100; j++) {
+                for (k = 0; k < quantityOfChunks; k++) {
+                    chunks[k].firstOfSpecificElement[j] = inputGmsh->quantityOfSpecificElement[j];
+                    inputGmsh->quantityOfSpecificElement[j] += chunks[k].quantityOfSpecificElement[j];
+                }
+
+                output->quantityOfSpecificElement[j] = inputGmsh->quantityOfSpecificElement[j];
+                if (output->quantityOfSpecificElement[j] != 0) {
+                    output->quantityOfElementTypes++;
+                    if ((errorTLMnumber = allocateTLMInternalMeshElementsOnly(output, &j)) != 0)
+                        break;
+                }
+            }
+            if (errorTLMnumber != 0) {
+                free(chunks);
+                return errorTLMnumber;
+            }
+        }
     }
 
-    // variable used for incrementing the quantity of elements saved.
-    quantityOfElementTypesSaved = (unsigned long long*)
-            malloc(sizeof (unsigned long long)*100);
-    for (int i = 0; i < 100; i++) {
-        quantityOfElementTypesSaved[i] = 0;
+    if (errorTLMnumber == 0) {
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(static, 1) num_threads(quantityOfChunks)
+#endif
+        for (k = 0; k < quantityOfChunks; k++) {
+            if (section == NODES) {
+                readNodesChunkGmsh(inputGmsh, output, scale, &chunks[k]);
+            } else {
+                readElementsChunkGmsh(output, &chunks[k]);
+            }
+        }
     }
 
-    fprintf(saveFile, "Nodes\n");
-    fprintf(saveFile, "{\n");
-    fprintf(saveFile, "%llu\n", input->numberOfNode);
-    // Nodes: saving and reading in the internal mesh
-    for (i = 0; i < input->numberOfNode; i++) {
-        fprintf(saveFile, "%.17g %.17g %.17g\n", input->nodes[i].x,
-                input->nodes[i].y, input->nodes[i].z);
-
-        output->nodes[i].x = input->nodes[i].x;
-        output->nodes[i].y = input->nodes[i].y;
-        output->nodes[i].z = input->nodes[i].z;
+    quantityRead = chunks[quantityOfChunks - 1].firstRead +
+            chunks[quantityOfChunks - 1].quantityRead;
+
+    // the first error in the file is the one reported
+    for (k = 0; k < quantityOfChunks; k++) {
+        if (chunks[k].errorTLMnumber != 0) {
+            errorTLMnumber = chunks[k].errorTLMnumber;
+            *lineNumber = chunks[k].errorLineNumber;
+            *errorLine = chunks[k].errorLine;
+            break;
+        }
     }
-    fprintf(saveFile, "}\n");
 
-    // at this point, I can deallocate the Gmsh nodes
-    if ((errorTLMnumber = deallocateOnlyTheNodeGmsh(input)) != 0)
-        return errorTLMnumber;
+    if (errorTLMnumber == 6516) {
+        printf("More nodes were read than the number of nodes provided by gmsh input\n");
+        printf("%llu vs. %llu\n", quantityRead, inputGmsh->numberOfNode);
+    } else if (errorTLMnumber == 6517) {
+        printf("More elements were read than the number of elements provided by gmsh input\n");
+        printf("%llu vs. %llu\n", quantityRead, inputGmsh->numberOfElement);
+    }
 
-    // before writing information about the element, I have to allocate them
-    // into the output variable because I cannot know if the elements type
-    // are going to be in order
-    for (i = 0; i < input->numberOfElement; i++) {
-        switch (input->saveElement[i].elementCode) {
-            case 1: // 2 nodes line
-                output->elements.Line[quantityOfElementTypesSaved[1]].tag =
-                        input->saveElement[i].tag;
-                output->elements.Line[quantityOfElementTypesSaved[1]].N1 =
-                        input->saveElement[i].N1;
-                output->elements.Line[quantityOfElementTypesSaved[1]].N2 =
-                        input->saveElement[i].N2;
-
-                quantityOfElementTypesSaved[1]++;
+    if (errorTLMnumber == 0) {
+        if (section == NODES) {
+            inputGmsh->numberOfNodeReads = quantityRead;
+        } else {
+            inputGmsh->numberOfElementReads = quantityRead;
+        }
 
-                break;
-            case 2: // 3 nodes triangle
-                output->elements.Triangle[quantityOfElementTypesSaved[2]].tag =
-                        input->saveElement[i].tag;
-                output->elements.Triangle[quantityOfElementTypesSaved[2]].N1 =
-                        input->saveElement[i].N1;
-                output->elements.Triangle[quantityOfElementTypesSaved[2]].N2 =
-                        input->saveElement[i].N2;
-                output->elements.Triangle[quantityOfElementTypesSaved[2]].N3 =
-                        input->saveElement[i].N3;
-
-                quantityOfElementTypesSaved[2]++;
+        *lineNumber = chunks[quantityOfChunks - 1].firstLine +
+                chunks[quantityOfChunks - 1].quantityOfLines - 1;
+        *position = endOfSection;
+    }
 
-                break;
-            case 3: // 4 nodes quadrangle
-                output->elements.Quadrangle[quantityOfElementTypesSaved[3]].tag =
-                        input->saveElement[i].tag;
-                output->elements.Quadrangle[quantityOfElementTypesSaved[3]].N1 =
-                        input->saveElement[i].N1;
-                output->elements.Quadrangle[quantityOfElementTypesSaved[3]].N2 =
-                        input->saveElement[i].N2;
-                output->elements.Quadrangle[quantityOfElementTypesSaved[3]].N3 =
-                        input->saveElement[i].N3;
-                output->elements.Quadrangle[quantityOfElementTypesSaved[3]].N4 =
-                        input->saveElement[i].N4;
-
-                quantityOfElementTypesSaved[3]++;
+    free(chunks);
 
-                break;
-            case 4: // 4 nodes tetrahedron
-                output->elements.Tetrahedron[quantityOfElementTypesSaved[4]].tag =
-                        input->saveElement[i].tag;
-                output->elements.Tetrahedron[quantityOfElementTypesSaved[4]].N1 =
-                        input->saveElement[i].N1;
-                output->elements.Tetrahedron[quantityOfElementTypesSaved[4]].N2 =
-                        input->saveElement[i].N2;
-                output->elements.Tetrahedron[quantityOfElementTypesSaved[4]].N3 =
-                        input->saveElement[i].N3;
-                output->elements.Tetrahedron[quantityOfElementTypesSaved[4]].N4 =
-                        input->saveElement[i].N4;
-
-                quantityOfElementTypesSaved[4]++;
+    return errorTLMnumber;
+}
 
-                break;
-            case 5: // 8 nodes hexahedron
-                output->elements.Hexahedron[quantityOfElementTypesSaved[5]].tag =
-                        input->saveElement[i].tag;
-                output->elements.Hexahedron[quantityOfElementTypesSaved[5]].N1 =
-                        input->saveElement[i].N1;
-                output->elements.Hexahedron[quantityOfElementTypesSaved[5]].N2 =
-                        input->saveElement[i].N2;
-                output->elements.Hexahedron[quantityOfElementTypesSaved[5]].N3 =
-                        input->saveElement[i].N3;
-                output->elements.Hexahedron[quantityOfElementTypesSaved[5]].N4 =
-                        input->saveElement[i].N4;
-                output->elements.Hexahedron[quantityOfElementTypesSaved[5]].N5 =
-                        input->saveElement[i].N5;
-                output->elements.Hexahedron[quantityOfElementTypesSaved[5]].N6 =
-                        input->saveElement[i].N6;
-                output->elements.Hexahedron[quantityOfElementTypesSaved[5]].N7 =
-                        input->saveElement[i].N7;
-                output->elements.Hexahedron[quantityOfElementTypesSaved[5]].N8 =
-                        input->saveElement[i].N8;
-
-                quantityOfElementTypesSaved[5]++;
+/*
+ * printReadingTimeGmsh: prints the time to read the Gmsh file and the
+ * throughput of the reading (in timing mode)
+ */
+void printReadingTimeGmsh(char *nameOfFile, double time_spent, size_t size) {
+    printTimeProfiler(time_spent, "Time to read the file %s", nameOfFile);
+    printf("That is %g MB/s.\n", time_spent > 0 ? size / (time_spent * 1e6) : 0.0);
+}
 
-                break;
-            case 6: // 6 nodes prism
-                output->elements.Prism[quantityOfElementTypesSaved[6]].tag =
-                        input->saveElement[i].tag;
-                output->elements.Prism[quantityOfElementTypesSaved[6]].N1 =
-                        input->saveElement[i].N1;
-                output->elements.Prism[quantityOfElementTypesSaved[6]].N2 =
-                        input->saveElement[i].N2;
-                output->elements.Prism[quantityOfElementTypesSaved[6]].N3 =
-                        input->saveElement[i].N3;
-                output->elements.Prism[quantityOfElementTypesSaved[6]].N4 =
-                        input->saveElement[i].N4;
-                output->elements.Prism[quantityOfElementTypesSaved[6]].N5 =
-                        input->saveElement[i].N5;
-                output->elements.Prism[quantityOfElementTypesSaved[6]].N6 =
-                        input->saveElement[i].N6;
-
-                quantityOfElementTypesSaved[6]++;
+/*
+ * findMeshFormatGmsh: reads the line after $MeshFormat. It returns 0 if the
+ * file starts with $MeshFormat, and *afterFormat is the character after the
+ * line read.
+ * The ASCII MeshFormat 2.2 is read line by line by gmshReader. The binary
+ * files and the MeshFormat 4.1 are read by readBlocksGmsh.
+ */
+unsigned int findMeshFormatGmsh(const char *position, const char *end,
+        struct meshFormat *format, const char **afterFormat) {
+    unsigned long long number;
+    double version;
 
-                break;
-            case 7: // 5 nodes pyramid
-                output->elements.Pyramid[quantityOfElementTypesSaved[7]].tag =
-                        input->saveElement[i].tag;
-                output->elements.Pyramid[quantityOfElementTypesSaved[7]].N1 =
-                        input->saveElement[i].N1;
-                output->elements.Pyramid[quantityOfElementTypesSaved[7]].N2 =
-                        input->saveElement[i].N2;
-                output->elements.Pyramid[quantityOfElementTypesSaved[7]].N3 =
-                        input->saveElement[i].N3;
-                output->elements.Pyramid[quantityOfElementTypesSaved[7]].N4 =
-                        input->saveElement[i].N4;
-                output->elements.Pyramid[quantityOfElementTypesSaved[7]].N5 =
-                        input->saveElement[i].N5;
-
-                quantityOfElementTypesSaved[7]++;
+    while (position < end && (*position == ' ' || *position == '\t' ||
+            *position == '\r' || *position == '\n'))
+        position++;
 
-                break;
-            case 15: // 1 node point
-                output->elements.Point[quantityOfElementTypesSaved[15]].tag =
-                        input->saveElement[i].tag;
-                output->elements.Point[quantityOfElementTypesSaved[15]].N1 =
-                        input->saveElement[i].N1;
+    if (end - position < 11 || strncmp(position, "$MeshFormat", 11) != 0 ||
+            (position = (const char *) memchr(position, '\n', end - position)) == NULL)
+        return 1;
 
-                quantityOfElementTypesSaved[15]++;
+    if ((position = scanDoubleTlmbht(position + 1, end, &version)) == NULL)
+        return 1;
+    format->version = (float) version;
 
-                break;
-        }
+    if ((position = scanUnsignedTlmbht(position, end, &number)) == NULL)
+        return 1;
+    format->fileType = (int) number;
+
+    if ((position = scanUnsignedTlmbht(position, end, &number)) == NULL)
+        return 1;
+    format->dataSize = (int) number;
+
+    if ((position = (const char *) memchr(position, '\n', end - position)) == NULL)
+        return 1;
+    *afterFormat = position + 1;
+
+    return 0;
+}
+
+/*
+ * swapBytesGmsh: reverses the bytes of a number written by a computer with
+ * the other endianness
+ */
+void swapBytesGmsh(void *number, size_t size) {
+    unsigned char *bytes = (unsigned char *) number, temporary;
 
+    for (size_t i = 0; i < size / 2; i++) {
+        temporary = bytes[i];
+        bytes[i] = bytes[size - 1 - i];
+        bytes[size - 1 - i] = temporary;
     }
+}
 
-    // at this point, I can deallocate the elements
-    if ((errorTLMnumber = deallocateOnlyTheElementGmsh(input)) != 0)
-        return errorTLMnumber;
+/*
+ * skipSpacesGmsh: in ASCII files, skips blank spaces and new lines before the
+ * next number
+ */
+void skipSpacesGmsh(struct blockReaderGmsh *reader) {
+    while (reader->position < reader->end && (*reader->position == ' ' ||
+            *reader->position == '\t' || *reader->position == '\r' ||
+            *reader->position == '\n'))
+        reader->position++;
+}
 
-    // Now that I have the data into the output variable, I can go on and save the
-    // data into the file
-    if ((errorTLMnumber = writeElementToFileTlmFormat(output, saveFile)) != 0)
-        return errorTLMnumber;
+/*
+ * readIntGmsh: reads an int (4 bytes in the binary files)
+ */
+unsigned int readIntGmsh(struct blockReaderGmsh *reader, long long *value) {
+    const char *next;
+
+    if (reader->binary == 1) {
+        int number;
+
+        if ((size_t) (reader->end - reader->position) < sizeof (int))
+            return 6518;
+        memcpy(&number, reader->position, sizeof (int));
+        if (reader->swap == 1)
+            swapBytesGmsh(&number, sizeof (int));
+        reader->position += sizeof (int);
+        *value = number;
+    } else {
+        unsigned long long number;
+        int negative = 0;
+
+        skipSpacesGmsh(reader);
+        if (reader->position < reader->end && *reader->position == '-') {
+            negative = 1;
+            reader->position++;
+        }
+        if ((next = scanUnsignedTlmbht(reader->position, reader->end, &number)) == NULL)
+            return 6518;
+        reader->position = next;
+        *value = negative == 1 ? -(long long) number : (long long) number;
+    }
 
     return 0;
 }
 
 /*
- * writeThenReadGmsh: Write the Gmsh mesh read into the file then read it to
- * the internal mesh
+ * readSizeGmsh: reads a size_t (dataSize bytes in the binary files of the
+ * MeshFormat 4.1)
  */
-unsigned int writeThenReadGmsh(struct tlmInternalMesh * output,
-        struct dataGmsh2_2 * inputGmsh, FILE ** saveFile, struct MeshConfig * input) {
-    unsigned int errorTLMnumber;
+unsigned int readSizeGmsh(struct blockReaderGmsh *reader, unsigned long long *value) {
+    const char *next;
+
+    if (reader->binary == 1) {
+        if ((size_t) (reader->end - reader->position) < (size_t) reader->dataSize)
+            return 6518;
+        if (reader->dataSize == 8) {
+            unsigned long long number;
+
+            memcpy(&number, reader->position, 8);
+            if (reader->swap == 1)
+                swapBytesGmsh(&number, 8);
+            *value = number;
+        } else {
+            unsigned int number;
+
+            memcpy(&number, reader->position, 4);
+            if (reader->swap == 1)
+                swapBytesGmsh(&number, 4);
+            *value = number;
+        }
+        reader->position += reader->dataSize;
+    } else {
+        skipSpacesGmsh(reader);
+        if ((next = scanUnsignedTlmbht(reader->position, reader->end, value)) == NULL)
+            return 6518;
+        reader->position = next;
+    }
 
-    fprintf(stderr, "WARNING: Not enough memory to open and save the mesh at the same time. "
-            "We will save the mesh file, deallocate variables, and try to read the saved mesh.\n");
-    // deallocating what was previous allocated (if any)
-    if ((errorTLMnumber = terminateTlmInternalMesh(output)) != 0) {
-        sendErrorCodeAndMessage(errorTLMnumber, NULL, NULL, NULL, NULL);
-        return errorTLMnumber;
+    return 0;
+}
+
+/*
+ * readDoubleGmsh: reads a double (8 bytes in the binary files)
+ */
+unsigned int readDoubleGmsh(struct blockReaderGmsh *reader, double *value) {
+    const char *next;
+
+    if (reader->binary == 1) {
+        if ((size_t) (reader->end - reader->position) < sizeof (double))
+            return 6518;
+        memcpy(value, reader->position, sizeof (double));
+        if (reader->swap == 1)
+            swapBytesGmsh(value, sizeof (double));
+        reader->position += sizeof (double);
+    } else {
+        skipSpacesGmsh(reader);
+        if ((next = scanDoubleTlmbht(reader->position, reader->end, value)) == NULL)
+            return 6518;
+        reader->position = next;
     }
 
+    return 0;
+}
 
-    // only save the file, that is, do not save anything to output
-    if ((errorTLMnumber = onlyWriteGmsh2_2(inputGmsh, *saveFile)) != 0) {
-        // error here. Treat it
-        sendErrorCodeAndMessage(errorTLMnumber, NULL, NULL, NULL, NULL);
-        return errorTLMnumber;
+/*
+ * skipGmsh: skips the data of elements that were already counted. In binary
+ * files, these are quantityOfBytes. In ASCII files, these are the end of the
+ * current line and the next quantityOfLines lines.
+ */
+unsigned int skipGmsh(struct blockReaderGmsh *reader, unsigned long long quantityOfBytes,
+        unsigned long long quantityOfLines) {
+    if (reader->binary == 1) {
+        if ((unsigned long long) (reader->end - reader->position) < quantityOfBytes)
+            return 6518;
+        reader->position += quantityOfBytes;
+    } else {
+        for (unsigned long long i = 0; i <= quantityOfLines; i++) {
+            if ((reader->position = (const char *) memchr(reader->position, '\n',
+                    reader->end - reader->position)) == NULL) {
+                reader->position = reader->end;
+                return i == quantityOfLines ? 0 : 6518;
+            }
+            reader->position++;
+        }
     }
 
+    return 0;
+}
 
-    // closing the file to be read by the functions below
-    fclose(*saveFile);
-    *saveFile = NULL;
+/*
+ * skipLineGmsh: goes to the beginning of the next line. In the MeshFormat 2.2,
+ * the quantities of nodes and elements are in their own line even in binary
+ * files
+ */
+void skipLineGmsh(struct blockReaderGmsh *reader) {
+    const char *newLine = (const char *) memchr(reader->position, '\n',
+            reader->end - reader->position);
 
-    // now deallocate what we have read from Gmsh
-    if ((errorTLMnumber = terminateDataGmsh2_2(inputGmsh)) != 0) {
-        sendErrorCodeAndMessage(errorTLMnumber, NULL, NULL, NULL, NULL);
-        return errorTLMnumber;
+    reader->position = (newLine == NULL) ? reader->end : newLine + 1;
+}
+
+/*
+ * skipDataGmsh: skips the sections $NodeData, $ElementData, and
+ * $ElementNodeData of the binary files by the sizes that they declare. Their
+ * tags are written as text, one per line, and their values in binary. The
+ * third integer tag is the quantity of nodes or elements, each one with its
+ * int tag and the doubles of its components (of each of its nodes, whose
+ * quantity is the int after the tag, in $ElementNodeData)
+ */
+unsigned int skipDataGmsh(struct blockReaderGmsh *reader, int elementNodeData) {
+    struct blockReaderGmsh text = *reader;
+    long long quantity, tag, components = 0, entities = 0, nodes;
+    unsigned long long bytes;
+
+    // the string tags and the real tags
+    text.binary = 0;
+    for (int k = 0; k < 2; k++) {
+        if (readIntGmsh(&text, &quantity) != 0 || quantity < 0 ||
+                skipGmsh(&text, 0, (unsigned long long) quantity) != 0)
+            return 6518;
     }
-    
-    // I need to set the scale variable to 1. If don't do this, the mesh will be
-    // scaled twice.
-    double scale_temp[3];
-    scale_temp[0] = input->scale[0];
-    input->scale[0] = 1;
-    scale_temp[1] = input->scale[1];
-    input->scale[1] = 1;
-    scale_temp[2] = input->scale[2];
-    input->scale[2] = 1;
-    
-    // change the number of the input mesh file to the output mesh file
-    input->nameOfInputFile = realloc(input->nameOfInputFile, (strlen(input->nameOfOutputFile) + 1)*sizeof(char));
-    strcpy(input->nameOfInputFile, input->nameOfOutputFile);
-
-    // initiate the internal mesh
-    if ((errorTLMnumber = initiateTlmInternalMesh(output)) != 0) {
-        return errorTLMnumber;
+
+    // the integer tags are the time-step, the quantity of components, the
+    // quantity of nodes or elements, and the partition
+    if (readIntGmsh(&text, &quantity) != 0 || quantity < 3)
+        return 6518;
+    for (long long k = 0; k < quantity; k++) {
+        if (readIntGmsh(&text, &tag) != 0)
+            return 6518;
+        if (k == 1)
+            components = tag;
+        else if (k == 2)
+            entities = tag;
     }
-    
-    // call the function that reads the tlm native format
-    if ((errorTLMnumber = tbnReader(input, output)) != 0) {
-        return errorTLMnumber;
+    skipLineGmsh(&text);
+    reader->position = text.position;
+
+    if (components < 1 || entities < 0 ||
+            (unsigned long long) components > (unsigned long long) (reader->end - reader->position) / sizeof (double))
+        return 6518;
+
+    if (elementNodeData == 0) {
+        bytes = sizeof (int) + (unsigned long long) components * sizeof (double);
+        if ((unsigned long long) entities > (unsigned long long) (reader->end - reader->position) / bytes)
+            return 6518;
+        return skipGmsh(reader, (unsigned long long) entities * bytes, 0);
     }
-    
-    // recovering the value of the scale
-    input->scale[0] = scale_temp[0];
-    input->scale[1] = scale_temp[1];
-    input->scale[2] = scale_temp[2];
 
-    fprintf(stderr, "WARNING: We were successful to save and read the mesh.");
+    for (long long i = 0; i < entities; i++) {
+        if (readIntGmsh(reader, &tag) != 0 || readIntGmsh(reader, &nodes) != 0 || nodes < 0 ||
+                (unsigned long long) nodes > (unsigned long long) (reader->end - reader->position) /
+                ((unsigned long long) components * sizeof (double)) ||
+                skipGmsh(reader, (unsigned long long) nodes * components * sizeof (double), 0) != 0)
+            return 6518;
+    }
 
     return 0;
 }
 
 /*
- * onlyWriteGmsh2_2: Write the nodes and elements to the file
+ * setNodeNumberGmsh: saves that the node tag is the node number in
+ * output->nodes. While the tags are 1, 2, 3..., the number is the tag and
+ * nothing is saved.
  */
-unsigned int onlyWriteGmsh2_2(struct dataGmsh2_2 * input, FILE * saveFile) {
-
-    unsigned long long i, quantityOfElementSaved;
-    unsigned int errorTLMnumber, quantityOfElementTypes = 0;
-
-    fprintf(saveFile, "Nodes\n");
-    fprintf(saveFile, "{\n");
-    fprintf(saveFile, "%llu\n", input->numberOfNode);
-    // I will first look for the nodes
-    for (i = 0; i < input->numberOfNode; i++) {
-        fprintf(saveFile, "%.17g %.17g %.17g\n", input->nodes[i].x,
-                input->nodes[i].y, input->nodes[i].z);
+unsigned int setNodeNumberGmsh(struct blockReaderGmsh *reader, unsigned long long tag,
+        unsigned long long number) {
+    if (reader->nodeNumber == NULL) {
+        if (tag == number)
+            return 0;
+
+        // the tags from 1 to number - 1 were the same as the numbers
+        if (reader->minimumNodeTag > 1 && number > 1)
+            return 6518;
+        if ((reader->nodeNumber = (unsigned long long *) calloc(reader->quantityOfNodeTags,
+                sizeof (unsigned long long))) == NULL)
+            return 8755;
+        for (unsigned long long i = 1; i < number; i++)
+            reader->nodeNumber[i - reader->minimumNodeTag] = i;
     }
-    fprintf(saveFile, "}\n");
 
-    // at this point, I can deallocate the nodes
-    if ((errorTLMnumber = deallocateOnlyTheNodeGmsh(input)) != 0)
-        return errorTLMnumber;
+    if (tag < reader->minimumNodeTag || tag - reader->minimumNodeTag >= reader->quantityOfNodeTags)
+        return 6518;
+    reader->nodeNumber[tag - reader->minimumNodeTag] = number;
+
+    return 0;
+}
 
-    fprintf(saveFile, "Elements\n");
-    fprintf(saveFile, "{\n");
+/*
+ * getNodeNumberGmsh: returns (in number) the node number in output->nodes
+ * of the node tag. It returns 6520 if there is no node with this tag.
+ */
+unsigned int getNodeNumberGmsh(const struct blockReaderGmsh *reader,
+        const struct tlmInternalMesh *output, unsigned long long tag,
+        unsigned long long *number) {
+    if (reader->nodeNumber == NULL) {
+        *number = tag;
+    } else if (tag < reader->minimumNodeTag ||
+            tag - reader->minimumNodeTag >= reader->quantityOfNodeTags) {
+        *number = 0;
+    } else {
+        *number = reader->nodeNumber[tag - reader->minimumNodeTag];
+    }
+
+    if (*number == 0 || *number > output->numberOfNode)
+        return 6520;
 
+    return 0;
+}
+
+/*
+ * readEntitiesGmsh: reads the physical tag of each entity (points, curves,
+ * surfaces, and volumes) of the MeshFormat 4.1. Only the first physical tag
+ * is saved, as the tag of the elements in the MeshFormat 2.2.
+ */
+unsigned int readEntitiesGmsh(struct blockReaderGmsh *reader) {
+    unsigned long long quantity[4], numberOfTags, i = 0, j;
+    long long number;
+    double coordinate;
+    unsigned int errorTLMnumber;
+    int dimension;
+
+    for (dimension = 0; dimension < 4; dimension++)
+        if ((errorTLMnumber = readSizeGmsh(reader, &quantity[dimension])) != 0)
+            return errorTLMnumber;
+
+    free(reader->entities);
+    reader->quantityOfEntities = quantity[0] + quantity[1] + quantity[2] + quantity[3];
+    if ((reader->entities = (struct entityGmsh *) malloc(sizeof (struct entityGmsh)*
+            (reader->quantityOfEntities + 1))) == NULL)
+        return 8755;
+
+    for (dimension = 0; dimension < 4; dimension++) {
+        for (unsigned long long k = 0; k < quantity[dimension]; k++, i++) {
+            reader->entities[i].dimension = dimension;
+            reader->entities[i].physical = 0;
+            if ((errorTLMnumber = readIntGmsh(reader, &number)) != 0)
+                return errorTLMnumber;
+            reader->entities[i].tag = (int) number;
+
+            // points have X, Y, and Z. The others have minimum and maximum X, Y, and Z
+            for (j = 0; j < (dimension == 0 ? 3 : 6); j++)
+                if ((errorTLMnumber = readDoubleGmsh(reader, &coordinate)) != 0)
+                    return errorTLMnumber;
+
+            if ((errorTLMnumber = readSizeGmsh(reader, &numberOfTags)) != 0)
+                return errorTLMnumber;
+            for (j = 0; j < numberOfTags; j++) {
+                if ((errorTLMnumber = readIntGmsh(reader, &number)) != 0)
+                    return errorTLMnumber;
+                // a negative physical tag only means the opposite orientation
+                if (j == 0)
+                    reader->entities[i].physical = (long unsigned int) (number < 0 ? -number : number);
+            }
 
-    for (i = 0; i < 100; i++) {
-        if (input->quantityOfSpecificElement[i] != 0)
-            // Counting up how many elements were used
-            quantityOfElementTypes++;
+            // the entities (points, curves, or surfaces) that bound this one
+            if (dimension > 0) {
+                if ((errorTLMnumber = readSizeGmsh(reader, &numberOfTags)) != 0)
+                    return errorTLMnumber;
+                for (j = 0; j < numberOfTags; j++)
+                    if ((errorTLMnumber = readIntGmsh(reader, &number)) != 0)
+                        return errorTLMnumber;
+            }
+        }
     }
 
-    fprintf(saveFile, "%u ", quantityOfElementTypes);
+    return 0;
+}
+
+/*
+ * getPhysicalTagGmsh: returns the physical tag of the entity. The entities are
+ * searched one by one, but this is done once per block of elements.
+ * Entities without physical tag have the tag 0.
+ */
+long unsigned int getPhysicalTagGmsh(const struct blockReaderGmsh *reader,
+        long long dimension, long long tag) {
+    for (unsigned long long i = 0; i < reader->quantityOfEntities; i++)
+        if (reader->entities[i].dimension == dimension && reader->entities[i].tag == tag)
+            return reader->entities[i].physical;
+
+    return 0;
+}
 
-    for (unsigned int j = 0; j < 100; j++) {
-        if (input->quantityOfSpecificElement[j] != 0) // I go here only if it is non-zero
-            // Then I will tell how many of each element is there on the file
-            fprintf(saveFile, "%u %llu ", j, input->quantityOfSpecificElement[j]);
+/*
+ * readNodesBlocksGmsh: reads the section $Nodes directly to output->nodes.
+ * MeshFormat 2.2 (binary): the quantity of nodes in its own line, then the
+ * number (not saved), x, y, and z of each node.
+ * MeshFormat 4.1: quantity of blocks, quantity of nodes, minimum and maximum
+ * node tags, then the blocks. Each block has the entity, if it is parametric,
+ * and the quantity of nodes, followed by the tags of all of its nodes and
+ * only then by their positions.
+ */
+unsigned int readNodesBlocksGmsh(struct blockReaderGmsh *reader,
+        struct tlmInternalMesh *output, double *scale) {
+    unsigned long long quantityOfBlocks = 1, quantityOfNodes, minimumTag = 0,
+            maximumTag = 0, inBlock, tag, i = 0, j;
+    long long dimension = 0, entity, parametric = 0, number;
+    double parameter;
+    unsigned int errorTLMnumber;
+    struct node *nodeRead;
+
+    if (reader->version == 2) {
+        skipSpacesGmsh(reader);
+        if ((reader->position = scanUnsignedTlmbht(reader->position, reader->end,
+                &quantityOfNodes)) == NULL) {
+            reader->position = reader->end;
+            return 6518;
+        }
+        skipLineGmsh(reader);
+    } else {
+        if ((errorTLMnumber = readSizeGmsh(reader, &quantityOfBlocks)) != 0 ||
+                (errorTLMnumber = readSizeGmsh(reader, &quantityOfNodes)) != 0 ||
+                (errorTLMnumber = readSizeGmsh(reader, &minimumTag)) != 0 ||
+                (errorTLMnumber = readSizeGmsh(reader, &maximumTag)) != 0)
+            return errorTLMnumber;
     }
-    fprintf(saveFile, "\n"); // just go to the next line
-
-    for (unsigned int j = 0; j < 100; j++) {
-        i = 0;
-        if (input->quantityOfSpecificElement[j] != 0)
-            switch (j) {
-                case 1: // 2 nodes line
-                    for (quantityOfElementSaved = 0; quantityOfElementSaved < input->quantityOfSpecificElement[j]; i++) {
-                        if (input->saveElement[i].elementCode == 1) {
-                            fprintf(saveFile, "%lu %llu %llu\n",
-                                    input->saveElement[i].tag,
-                                    input->saveElement[i].N1,
-                                    input->saveElement[i].N2);
-                            quantityOfElementSaved++;
-                        }
-                    }
-                    break;
-                case 2: // 3 nodes triangle
-                    for (quantityOfElementSaved = 0; quantityOfElementSaved < input->quantityOfSpecificElement[j]; i++) {
-                        if (input->saveElement[i].elementCode == 2) {
-                            fprintf(saveFile, "%lu %llu %llu %llu\n",
-                                    input->saveElement[i].tag,
-                                    input->saveElement[i].N1,
-                                    input->saveElement[i].N2,
-                                    input->saveElement[i].N3);
-                            quantityOfElementSaved++;
-                        }
-                    }
-                    break;
-                case 3: // 4 nodes quadrangle
-                    for (quantityOfElementSaved = 0; quantityOfElementSaved < input->quantityOfSpecificElement[j]; i++) {
-                        if (input->saveElement[i].elementCode == 3) {
-                            fprintf(saveFile, "%lu %llu %llu %llu %llu\n",
-                                    input->saveElement[i].tag,
-                                    input->saveElement[i].N1,
-                                    input->saveElement[i].N2,
-                                    input->saveElement[i].N3,
-                                    input->saveElement[i].N4);
-                            quantityOfElementSaved++;
-                        }
-                    }
-                    break;
-                case 4: // 4 nodes tetrahedron
-                    for (quantityOfElementSaved = 0; quantityOfElementSaved < input->quantityOfSpecificElement[j]; i++) {
-                        if (input->saveElement[i].elementCode == 4) {
-                            fprintf(saveFile, "%lu %llu %llu %llu %llu\n",
-                                    input->saveElement[i].tag,
-                                    input->saveElement[i].N1,
-                                    input->saveElement[i].N2,
-                                    input->saveElement[i].N3,
-                                    input->saveElement[i].N4);
-                            quantityOfElementSaved++;
-                        }
-                    }
-                    break;
-                case 5: // 8 nodes hexahedron
-                    for (quantityOfElementSaved = 0; quantityOfElementSaved < input->quantityOfSpecificElement[j]; i++) {
-                        if (input->saveElement[i].elementCode == 5) {
-                            fprintf(saveFile, "%lu %llu %llu %llu %llu %llu %llu %llu %llu\n",
-                                    input->saveElement[i].tag,
-                                    input->saveElement[i].N1,
-                                    input->saveElement[i].N2,
-                                    input->saveElement[i].N3,
-                                    input->saveElement[i].N4,
-                                    input->saveElement[i].N5,
-                                    input->saveElement[i].N6,
-                                    input->saveElement[i].N7,
-                                    input->saveElement[i].N8);
-                            quantityOfElementSaved++;
-                        }
-                    }
-                    break;
-                case 6: // 6 nodes prism
-                    for (quantityOfElementSaved = 0; quantityOfElementSaved < input->quantityOfSpecificElement[j]; i++) {
-                        if (input->saveElement[i].elementCode == 6) {
-                            fprintf(saveFile, "%lu %llu %llu %llu %llu %llu %llu\n",
-                                    input->saveElement[i].tag,
-                                    input->saveElement[i].N1,
-                                    input->saveElement[i].N2,
-                                    input->saveElement[i].N3,
-                                    input->saveElement[i].N4,
-                                    input->saveElement[i].N5,
-                                    input->saveElement[i].N6);
-                            quantityOfElementSaved++;
-                        }
+
+    if ((output->nodes = (struct node *) realloc(output->nodes,
+            sizeof (struct node)*(quantityOfNodes + 1))) == NULL)
+        return 5499;
+    output->numberOfNode = quantityOfNodes;
+
+    free(reader->nodeNumber);
+    reader->nodeNumber = NULL;
+    reader->minimumNodeTag = minimumTag;
+    reader->quantityOfNodeTags = maximumTag >= minimumTag ? maximumTag - minimumTag + 1 : 0;
+
+    for (unsigned long long block = 0; block < quantityOfBlocks; block++) {
+        if (reader->version == 2) {
+            inBlock = quantityOfNodes;
+        } else {
+            if ((errorTLMnumber = readIntGmsh(reader, &dimension)) != 0 ||
+                    (errorTLMnumber = readIntGmsh(reader, &entity)) != 0 ||
+                    (errorTLMnumber = readIntGmsh(reader, &parametric)) != 0 ||
+                    (errorTLMnumber = readSizeGmsh(reader, &inBlock)) != 0)
+                return errorTLMnumber;
+
+            // the tags of the nodes come before their positions
+            for (j = 0; j < inBlock; j++) {
+                if ((errorTLMnumber = readSizeGmsh(reader, &tag)) != 0)
+                    return errorTLMnumber;
+                if (i + j >= quantityOfNodes)
+                    return 6518;
+                if ((errorTLMnumber = setNodeNumberGmsh(reader, tag, i + j + 1)) != 0)
+                    return errorTLMnumber;
+            }
+        }
+
+        for (j = 0; j < inBlock; j++, i++) {
+            if (i >= quantityOfNodes)
+                return 6518;
+            nodeRead = &output->nodes[i];
+
+            if (reader->version == 2 &&
+                    (errorTLMnumber = readIntGmsh(reader, &number)) != 0)
+                return errorTLMnumber;
+            if ((errorTLMnumber = readDoubleGmsh(reader, &nodeRead->x)) != 0 ||
+                    (errorTLMnumber = readDoubleGmsh(reader, &nodeRead->y)) != 0 ||
+                    (errorTLMnumber = readDoubleGmsh(reader, &nodeRead->z)) != 0)
+                return errorTLMnumber;
+
+            // the parametric coordinates are not used
+            if (parametric != 0)
+                for (long long k = 0; k < dimension; k++)
+                    if ((errorTLMnumber = readDoubleGmsh(reader, &parameter)) != 0)
+                        return errorTLMnumber;
+
+            // Applying the scale factor
+            nodeRead->x = nodeRead->x * scale[0];
+            nodeRead->y = nodeRead->y * scale[1];
+            nodeRead->z = nodeRead->z * scale[2];
+        }
+    }
+
+    if (i != quantityOfNodes)
+        return 6518;
+
+    return 0;
+}
+
+/*
+ * readElementsBlocksGmsh: reads the section $Elements directly to the arrays
+ * of each element type of output. The section is read twice. First, only the
+ * headers of the blocks, which have the type and quantity of elements, so I
+ * can allocate the arrays. Then the elements.
+ * MeshFormat 2.2 (binary): the quantity of elements in its own line, then the
+ * blocks. Each block has the element type, the quantity of elements, and the
+ * quantity of tags, followed by the number, tags, and nodes of each element.
+ * The first tag is the physical tag.
+ * MeshFormat 4.1: quantity of blocks, quantity of elements, minimum and maximum
+ * element tags, then the blocks. Each block has the entity (which gives the
+ * physical tag), the element type, and the quantity of elements, followed by
+ * the tag and nodes of each element.
+ */
+unsigned int readElementsBlocksGmsh(struct blockReaderGmsh *reader,
+        struct tlmInternalMesh *output) {
+    unsigned long long quantityOfBlocks = 0, quantityOfElements, minimumTag,
+            maximumTag, inBlock, read, quantity[100], saved[100], tag, N[8];
+    long long dimension = 0, entity = 0, elementCode, numberOfTags = 0, number;
+    long unsigned int physical = 0;
+    unsigned int errorTLMnumber;
+    const char *firstBlock;
+    int quantityOfNodes, pass, j;
+
+    if (reader->version == 2) {
+        skipSpacesGmsh(reader);
+        if ((reader->position = scanUnsignedTlmbht(reader->position, reader->end,
+                &quantityOfElements)) == NULL) {
+            reader->position = reader->end;
+            return 6518;
+        }
+        skipLineGmsh(reader);
+    } else {
+        if ((errorTLMnumber = readSizeGmsh(reader, &quantityOfBlocks)) != 0 ||
+                (errorTLMnumber = readSizeGmsh(reader, &quantityOfElements)) != 0 ||
+                (errorTLMnumber = readSizeGmsh(reader, &minimumTag)) != 0 ||
+                (errorTLMnumber = readSizeGmsh(reader, &maximumTag)) != 0)
+            return errorTLMnumber;
+    }
+    firstBlock = reader->position;
+
+    for (pass = 0; pass < 2; pass++) {
+        for (j = 0; j < 100; j++)
+            saved[j] = 0;
+        if (pass == 0) {
+            for (j = 0; j < 100; j++)
+                quantity[j] = 0;
+        }
+        reader->position = firstBlock;
+
+        // in the MeshFormat 2.2 the quantity of blocks is not known, only the
+        // quantity of elements
+        for (unsigned long long block = 0, elementsRead = 0; reader->version == 2 ?
+                elementsRead < quantityOfElements : block < quantityOfBlocks; block++) {
+            if (reader->version == 2) {
+                if ((errorTLMnumber = readIntGmsh(reader, &elementCode)) != 0 ||
+                        (errorTLMnumber = readIntGmsh(reader, &number)) != 0 ||
+                        (errorTLMnumber = readIntGmsh(reader, &numberOfTags)) != 0)
+                    return errorTLMnumber;
+                inBlock = (unsigned long long) number;
+                if (number < 0 || numberOfTags < 0)
+                    return 6518;
+            } else {
+                if ((errorTLMnumber = readIntGmsh(reader, &dimension)) != 0 ||
+                        (errorTLMnumber = readIntGmsh(reader, &entity)) != 0 ||
+                        (errorTLMnumber = readIntGmsh(reader, &elementCode)) != 0 ||
+                        (errorTLMnumber = readSizeGmsh(reader, &inBlock)) != 0)
+                    return errorTLMnumber;
+                physical = getPhysicalTagGmsh(reader, dimension, entity);
+            }
+            elementsRead += inBlock;
+
+            if (elementCode < 0 || (quantityOfNodes =
+                    quantityOfNodesOfElementTlmInternalMesh((unsigned long long) elementCode)) == 0) {
+                reader->errorElementCode = (unsigned long long) elementCode;
+                return 6519;
+            }
+
+            // first pass: only counting the elements
+            if (pass == 0) {
+                quantity[elementCode] += inBlock;
+                if (reader->version == 2) {
+                    errorTLMnumber = skipGmsh(reader, inBlock * (1 + numberOfTags +
+                            quantityOfNodes) * sizeof (int), 0);
+                } else {
+                    errorTLMnumber = skipGmsh(reader, inBlock * (1 + quantityOfNodes) *
+                            reader->dataSize, inBlock);
+                }
+                if (errorTLMnumber != 0)
+                    return errorTLMnumber;
+                continue;
+            }
+
+            for (read = 0; read < inBlock; read++) {
+                if (reader->version == 2) {
+                    if ((errorTLMnumber = readIntGmsh(reader, &number)) != 0)
+                        return errorTLMnumber;
+                    for (long long k = 0; k < numberOfTags; k++) {
+                        if ((errorTLMnumber = readIntGmsh(reader, &number)) != 0)
+                            return errorTLMnumber;
+                        if (k == 0)
+                            physical = (long unsigned int) number;
                     }
-                    break;
-                case 7: // 5 nodes pyramid
-                    for (quantityOfElementSaved = 0; quantityOfElementSaved < input->quantityOfSpecificElement[j]; i++) {
-                        if (input->saveElement[i].elementCode == 7) {
-                            fprintf(saveFile, "%lu %llu %llu %llu %llu %llu\n",
-                                    input->saveElement[i].tag,
-                                    input->saveElement[i].N1,
-                                    input->saveElement[i].N2,
-                                    input->saveElement[i].N3,
-                                    input->saveElement[i].N4,
-                                    input->saveElement[i].N5);
-                            quantityOfElementSaved++;
-                        }
+                } else if ((errorTLMnumber = readSizeGmsh(reader, &tag)) != 0) {
+                    return errorTLMnumber;
+                }
+
+                for (j = 0; j < quantityOfNodes; j++) {
+                    if (reader->version == 2) {
+                        if ((errorTLMnumber = readIntGmsh(reader, &number)) != 0)
+                            return errorTLMnumber;
+                        tag = (unsigned long long) number;
+                    } else if ((errorTLMnumber = readSizeGmsh(reader, &tag)) != 0) {
+                        return errorTLMnumber;
                     }
-                    break;
-                case 15: // 1 node point
-                    for (quantityOfElementSaved = 0; quantityOfElementSaved < input->quantityOfSpecificElement[j]; i++) {
-                        if (input->saveElement[i].elementCode == 15) {
-                            fprintf(saveFile, "%lu %llu\n",
-                                    input->saveElement[i].tag,
-                                    input->saveElement[i].N1);
-                            quantityOfElementSaved++;
-                        }
+                    if ((errorTLMnumber = getNodeNumberGmsh(reader, output, tag, &N[j])) != 0) {
+                        reader->errorNodeTag = tag;
+                        return errorTLMnumber;
                     }
-                    break;
+                }
+
+                setElementTlmInternalMesh(output, (unsigned long long) elementCode,
+                        saved[elementCode], physical, N);
+                saved[elementCode]++;
             }
+        }
+
+        // now that I know how many elements of each type there are, I can
+        // allocate them
+        if (pass == 0 && (errorTLMnumber = allocateTLMInternalMeshNodesAndElements(output,
+                output->numberOfNode, quantity)) != 0)
+            return errorTLMnumber;
     }
 
-    // at this point, I can deallocate the elements
-    if ((errorTLMnumber = deallocateOnlyTheElementGmsh(input)) != 0)
-        return errorTLMnumber;
+    return 0;
+}
+
+/*
+ * readBlocksGmsh: reads the binary files (MeshFormat 2.2 or 4.1) and the ASCII
+ * files of the MeshFormat 4.1 directly to output. position is the character
+ * after the line of the $MeshFormat with the version. The sections other than
+ * $Entities, $Nodes, and $Elements are not used. In the binary files, only the
+ * unused sections that Gmsh writes as text and the sections of data, whose
+ * sizes are declared, can be skipped.
+ */
+unsigned int readBlocksGmsh(struct MeshConfig *input, struct tlmInternalMesh *output,
+        struct meshFormat *format, const char *position, const char *end) {
+    struct blockReaderGmsh reader;
+    unsigned int errorTLMnumber = 0;
+    const char *header, *endOfLine;
+    size_t lengthOfHeader;
+    char formatRead[64];
+
+    reader.position = position;
+    reader.end = end;
+    strcpy(reader.section, "$MeshFormat");
+    reader.binary = format->fileType == 1 ? 1 : 0;
+    reader.swap = 0;
+    reader.dataSize = format->dataSize;
+    reader.quantityOfEntities = 0;
+    reader.entities = NULL;
+    reader.minimumNodeTag = 0;
+    reader.quantityOfNodeTags = 0;
+    reader.nodeNumber = NULL;
+    reader.errorElementCode = 0;
+    reader.errorNodeTag = 0;
+
+    if (format->version >= 2 && format->version < 3 && format->dataSize == sizeof (double)) {
+        reader.version = 2;
+    } else if (format->version > 4.05 && format->version < 4.15 &&
+            (format->dataSize == 4 || format->dataSize == 8)) {
+        reader.version = 4;
+    } else {
+        sprintf(formatRead, "%.1f %d %d", format->version, format->fileType, format->dataSize);
+        sendErrorCodeAndMessage(6521, formatRead, NULL, NULL, NULL);
+        return 6521;
+    }
+
+    // the binary files have the int 1 after the version, so I know if the
+    // bytes of the numbers have to be swapped
+    if (reader.binary == 1) {
+        int one = 0;
 
-    fprintf(saveFile, "}\n");
+        if ((size_t) (end - position) >= sizeof (int))
+            memcpy(&one, position, sizeof (int));
+        if (one != 1) {
+            swapBytesGmsh(&one, sizeof (int));
+            reader.swap = 1;
+        }
+        if (one != 1)
+            errorTLMnumber = 6518;
+        reader.position += sizeof (int);
+    }
+
+    while (errorTLMnumber == 0) {
+        skipSpacesGmsh(&reader);
+        if (reader.position >= end)
+            break;
+
+        header = reader.position;
+        if ((endOfLine = (const char *) memchr(header, '\n', end - header)) == NULL)
+            endOfLine = end;
+        reader.position = endOfLine < end ? endOfLine + 1 : end;
+        while (endOfLine > header && (endOfLine[-1] == '\r' || endOfLine[-1] == ' ' ||
+                endOfLine[-1] == '\t'))
+            endOfLine--;
+        lengthOfHeader = (size_t) (endOfLine - header);
+
+        // a header is expected here
+        if (*header != '$') {
+            errorTLMnumber = 6518;
+            break;
+        }
+
+        if (lengthOfHeader >= 4 && strncmp(header, "$End", 4) == 0)
+            continue;
+
+        if (lengthOfHeader > sizeof (reader.section) - 1)
+            lengthOfHeader = sizeof (reader.section) - 1;
+        memcpy(reader.section, header, lengthOfHeader);
+        reader.section[lengthOfHeader] = '\0';
+
+        if (strcmp(reader.section, "$Entities") == 0 && reader.version == 4) {
+            errorTLMnumber = readEntitiesGmsh(&reader);
+        } else if (strcmp(reader.section, "$Nodes") == 0) {
+            errorTLMnumber = readNodesBlocksGmsh(&reader, output, input->scale);
+        } else if (strcmp(reader.section, "$Elements") == 0) {
+            errorTLMnumber = readElementsBlocksGmsh(&reader, output);
+        } else if (reader.binary == 0 || strcmp(reader.section, "$PhysicalNames") == 0 ||
+                strcmp(reader.section, "$InterpolationScheme") == 0 ||
+                (reader.version == 2 && strcmp(reader.section, "$Periodic") == 0)) {
+            // not used, and written as text. I go to the line that ends it
+            reader.position = findEndOfSectionGmsh(reader.position, end);
+        } else if (strcmp(reader.section, "$NodeData") == 0 ||
+                strcmp(reader.section, "$ElementData") == 0 ||
+                strcmp(reader.section, "$ElementNodeData") == 0) {
+            // not used, and its binary data can have "\n$" anywhere, so I
+            // skip the sizes that it declares
+            if ((errorTLMnumber = skipDataGmsh(&reader,
+                    strcmp(reader.section, "$ElementNodeData") == 0)) == 0)
+                reader.position = findEndOfSectionGmsh(reader.position, end);
+        } else {
+            // not used, and the size of its binary data is not known
+            errorTLMnumber = 6524;
+        }
+    }
+
+    switch (errorTLMnumber) {
+        case 0:
+            break;
+        case 6518:
+        case 6524:
+            sendErrorCodeAndMessage(errorTLMnumber, reader.section, NULL, NULL, NULL);
+            break;
+        case 6519:
+            sendErrorCodeAndMessage(errorTLMnumber, NULL, &reader.errorElementCode, NULL, NULL);
+            break;
+        case 6520:
+            sendErrorCodeAndMessage(errorTLMnumber, NULL, &reader.errorNodeTag, NULL, NULL);
+            break;
+        default:
+            sendErrorCodeAndMessage(errorTLMnumber, NULL, NULL, NULL, NULL);
+            break;
+    }
+
+    free(reader.entities);
+    free(reader.nodeNumber);
+
+    return errorTLMnumber;
+}
+
+/*
+ * writeTlmInternalMeshGmsh: saves the mesh that was read to output as .tbn,
+ * as text or binary, or does not save it (see tbnF in MeshConfig)
+ */
+unsigned int writeTlmInternalMeshGmsh(struct MeshConfig *input, struct tlmInternalMesh *output) {
+    unsigned int errorTLMnumber = 0;
+    FILE *pfileWrite;
+    char *nameOfFile;
+
+    if (input->tbnF == TBN_NONE)
+        return 0;
+
+    nameOfFile = (char*) malloc(sizeof (char)*(strlen(input->nameOfOutputFile) + 5));
+    // 4 (extension) + 1 ('\0')
+    strcpy(nameOfFile, input->nameOfOutputFile);
+    strcat(nameOfFile, ".tbn");
+
+    // If there is a file with the same name, I'm sorry, it will be replaced
+    if ((pfileWrite = fopen(nameOfFile, input->tbnF == TBN_BINARY ? "wb" : "w")) == NULL) {
+        sendErrorCodeAndMessage(764, nameOfFile, NULL, NULL, NULL);
+        free(nameOfFile);
+        return 764;
+    }
+
+    if (input->tbnF == TBN_BINARY) {
+        if ((errorTLMnumber = writeToFileBinaryTbn(output, pfileWrite)) != 0)
+            sendErrorCodeAndMessage(errorTLMnumber, nameOfFile, NULL, NULL, NULL);
+    } else {
+        writeNodeToFileTlmFormat(output, pfileWrite);
+        writeElementToFileTlmFormat(output, pfileWrite);
+    }
+
+    if (fclose(pfileWrite) == EOF && errorTLMnumber == 0) {
+        sendErrorCodeAndMessage(345, NULL, NULL, NULL, NULL);
+        errorTLMnumber = 345;
+    }
+    free(nameOfFile);
+
+    return errorTLMnumber;
+}
 
+/*
+ * setMeshGmshConfigTo: compare the string of the input to standardized texts.
+ * The comparison is case insensitive.
+ */
+unsigned int setMeshGmshConfigTo(char *input, enum gmsh2_2Config * config) {
+    if (compareCaseInsensitive(input, "$MeshFormat") == 0) {
+        *config = MESH_FORMAT;
+    } else if (compareCaseInsensitive(input, "$Nodes") == 0) {
+        *config = NODES;
+    } else if (compareCaseInsensitive(input, "$Elements") == 0) {
+        *config = ELEMENTS;
+    } else if (compareCaseInsensitive(input, "$PhysicalNames") == 0) {
+        *config = PHYSICAL_NAMES;
+    } else if (compareCaseInsensitive(input, "$Periodic") == 0) {
+        *config = PERIODIC;
+    } else if (compareCaseInsensitive(input, "$NodeData") == 0) {
+        *config = NODE_DATA;
+    } else if (compareCaseInsensitive(input, "$ElementData") == 0) {
+        *config = ELEMENT_DATA;
+    } else if (compareCaseInsensitive(input, "$ElementNodeData") == 0) {
+        *config = ELEMENT_NODE_DATA;
+    } else if (compareCaseInsensitive(input, "$InterpolationScheme") == 0) {
+        *config = INTERPOLATION_SCHEME;
+    } else if ((strncmp(input, "$", 1) == 0)) {
+        *config = UNRECOGNIZED_HEADER;
+    } else {
+        return 7659;
+    }
+
+
+
+    return 0;
+}
+
+/*
+ * initiateDataGmsh2_2: initiate the gmsh file with standard values
+ */
+unsigned int initiateDataGmsh2_2(struct dataGmsh2_2 *input) {
+    input->MeshFormat.MeshFormatDefined = 0;
+
+    // elements from 0 to 99
+    input->quantityOfSpecificElement = (unsigned long long*)
+            malloc(sizeof (unsigned long long)*100);
+    for (int i = 0; i < 100; i++) {
+        input->quantityOfSpecificElement[i] = 0;
+    }
+    input->numberOfElementReads = 0;
+    input->numberOfElement = 0;
+
+    input->numberOfNode = 0;
+    input->numberOfNodeReads = 0;
+    return 0;
+}
+
+/*
+ * terminateDataGmsh2_2: terminate the gmsh file
+ */
+unsigned int terminateDataGmsh2_2(struct dataGmsh2_2 *input) {
+
+    free(input->quantityOfSpecificElement);
+    input->quantityOfSpecificElement = NULL;
 
     return 0;
 }
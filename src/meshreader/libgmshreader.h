@@ -40,9 +40,16 @@
 extern "C" {
 #endif
 
+#include <stddef.h>
+
 #include "../configs/libmeshconfig.h"
+#include "../configs/libsimuconfig.h"
 #include "libmeshtlmbht.h"
 
+    // smallest part (in bytes) of the $Nodes or $Elements sections that is
+    // worth reading in its own thread
+#define GMSH_CHUNK_MINIMUM 1048576
+
     enum gmsh2_2Config {
         NOTHING_GMSH,
         MESH_FORMAT,
@@ -58,9 +65,9 @@ extern "C" {
     };
 
     struct meshFormat {
-        float version; // only 2.2
-        int fileType; // 0 - ASCII; 1 - binary. Implemented only for ASCII
-        int dataSize; // size of the float point numbers
+        float version; // 2.2 or 4.1
+        int fileType; // 0 - ASCII; 1 - binary
+        int dataSize; // size of the float point numbers (2.2) or of size_t (4.1)
         //flag
         int MeshFormatDefined; // 1 - the mesh was defined. 0 - the mesh was not  defined yet
     };
@@ -74,12 +81,96 @@ extern "C" {
         unsigned long long numberOfElementReads;
 
         unsigned long long *quantityOfSpecificElement;
-        struct elementAny *saveElement;
+    };
+
+    // part of the $Nodes or $Elements section read by one thread
+
+    struct chunkGmsh2_2 {
+        const char *start; // first character of the chunk
+        const char *end; // character after the last one of the chunk
+        unsigned long long firstRead; // index of the first node or element of the chunk
+        unsigned long long quantityRead; // quantity of nodes or elements of the chunk
+        unsigned int firstLine; // number of the first line of the chunk in the file
+        unsigned int quantityOfLines;
+        unsigned long long quantityOfSpecificElement[100]; // only for $Elements
+        unsigned long long firstOfSpecificElement[100]; // index in output of the next element of each code (only for $Elements)
+
+        // the first error found in the chunk (if any)
+        unsigned int errorTLMnumber;
+        unsigned int errorLineNumber;
+        const char *errorLine;
+    };
+
+    struct entityGmsh {
+        // point (0), curve (1), surface (2), or volume (3) of the MeshFormat 4.1
+        int dimension;
+        int tag;
+        long unsigned int physical; // first physical tag; 0 if there is none
+    };
 
-        struct node *nodes;
+    struct blockReaderGmsh {
+        // Used to read the binary files and the MeshFormat 4.1
+        const char *position; // next character to be read
+        const char *end; // character after the last one of the file
+        char section[64]; // header of the section being read, for the error messages
+        int binary; // 0 - ASCII; 1 - binary
+        int swap; // 1 - the numbers were written with the other endianness
+        int dataSize; // size of size_t in the file (only 4.1)
+        int version; // 2 - MeshFormat 2.2; 4 - MeshFormat 4.1
+
+        unsigned long long quantityOfEntities;
+        struct entityGmsh *entities;
+
+        // number of each node tag in output->nodes (only 4.1). NULL while the
+        // tags are the same as the numbers (1, 2, 3...)
+        unsigned long long minimumNodeTag;
+        unsigned long long quantityOfNodeTags;
+        unsigned long long *nodeNumber;
+
+        unsigned long long errorElementCode;
+        unsigned long long errorNodeTag;
     };
 
-    unsigned int gmshReader(struct MeshConfig *, struct tlmInternalMesh *);
+    unsigned int gmshReader(struct MeshConfig *, struct tlmInternalMesh *, struct Simulation *);
+
+    // used to read the binary files and the MeshFormat 4.1
+    void printReadingTimeGmsh(char *, double, size_t);
+    unsigned int findMeshFormatGmsh(const char *, const char *, struct meshFormat *,
+            const char **);
+    void swapBytesGmsh(void *, size_t);
+    void skipSpacesGmsh(struct blockReaderGmsh *);
+    unsigned int readIntGmsh(struct blockReaderGmsh *, long long *);
+    unsigned int readSizeGmsh(struct blockReaderGmsh *, unsigned long long *);
+    unsigned int readDoubleGmsh(struct blockReaderGmsh *, double *);
+    unsigned int skipGmsh(struct blockReaderGmsh *, unsigned long long, unsigned long long);
+    void skipLineGmsh(struct blockReaderGmsh *);
+    unsigned int skipDataGmsh(struct blockReaderGmsh *, int);
+    unsigned int setNodeNumberGmsh(struct blockReaderGmsh *, unsigned long long,
+            unsigned long long);
+    unsigned int getNodeNumberGmsh(const struct blockReaderGmsh *,
+            const struct tlmInternalMesh *, unsigned long long, unsigned long long *);
+    unsigned int readEntitiesGmsh(struct blockReaderGmsh *);
+    long unsigned int getPhysicalTagGmsh(const struct blockReaderGmsh *, long long, long long);
+    unsigned int readNodesBlocksGmsh(struct blockReaderGmsh *, struct tlmInternalMesh *,
+            double *);
+    unsigned int readElementsBlocksGmsh(struct blockReaderGmsh *, struct tlmInternalMesh *);
+    unsigned int readBlocksGmsh(struct MeshConfig *, struct tlmInternalMesh *,
+            struct meshFormat *, const char *, const char *);
+    unsigned int writeTlmInternalMeshGmsh(struct MeshConfig *, struct tlmInternalMesh *);
+
+    // these functions read the $Nodes and $Elements sections from the mapped file
+    size_t copyLineGmsh(const char *, const char *, char **, size_t *);
+    const char *findEndOfSectionGmsh(const char *, const char *);
+    int isUsefulLineGmsh(const char *, const char *);
+    unsigned int splitSectionGmsh(const char *, const char *, int, unsigned int,
+            struct chunkGmsh2_2 **, int *);
+    void readNodesChunkGmsh(struct dataGmsh2_2 *, struct tlmInternalMesh *, double *,
+            struct chunkGmsh2_2 *);
+    void countElementsChunkGmsh(struct dataGmsh2_2 *, struct chunkGmsh2_2 *);
+    void readElementsChunkGmsh(struct tlmInternalMesh *, struct chunkGmsh2_2 *);
+    unsigned int readSectionGmsh(struct dataGmsh2_2 *, struct tlmInternalMesh *, double *,
+            enum gmsh2_2Config, const char **, const char *, unsigned int *, int,
+            const char **);
 
     // this function set the configuration type
     unsigned int setMeshGmshConfigTo(char *, enum gmsh2_2Config *);
@@ -89,15 +180,6 @@ extern "C" {
 
     // this function terminate the dataGmsh2_2 variable
     unsigned int terminateDataGmsh2_2(struct dataGmsh2_2*);
-    unsigned int deallocateOnlyTheNodeGmsh(struct dataGmsh2_2*);
-    unsigned int deallocateOnlyTheElementGmsh(struct dataGmsh2_2*);
-
-    // this function will copy the GMSH inputs into the output file and also
-    // save the text file
-    unsigned int readAndWriteGmsh(struct tlmInternalMesh *, struct dataGmsh2_2 *, FILE *);
-    unsigned int onlyWriteGmsh2_2(struct dataGmsh2_2 *, FILE *);
-    unsigned int writeThenReadGmsh(struct tlmInternalMesh *, struct dataGmsh2_2 *, FILE **,
-            struct MeshConfig *);
 
 
     //testing the input I got
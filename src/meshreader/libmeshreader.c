@@ -39,10 +39,11 @@
 #include "../miscellaneous/liberrorcode.h"
 
 /*
- * meshReaderAndConverter: reads the mesh and convert it to .tbn, if required
+ * meshReaderAndConverter: reads the mesh and convert it to .tbn, if required.
+ * The simulation configurations give the number of threads and the timing mode
  */
 unsigned int meshReaderAndConverter(struct MeshConfig * meshInput,
-        struct tlmInternalMesh * meshOutput) {
+        struct tlmInternalMesh * meshOutput, struct Simulation * simulation) {
     unsigned errorTLMnumber;
     
     printf("The mesh to be read will be scaled by [%lf, %lf, %lf]\n", meshInput->scale[0],
@@ -50,7 +51,7 @@ unsigned int meshReaderAndConverter(struct MeshConfig * meshInput,
 
     switch (meshInput->inputF) {
         case GMSH: // Reading the gmsh input
-            if ((errorTLMnumber = gmshReader(meshInput, meshOutput)) != 0) {
+            if ((errorTLMnumber = gmshReader(meshInput, meshOutput, simulation)) != 0) {
                 return errorTLMnumber;
             }
 
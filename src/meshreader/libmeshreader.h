@@ -41,10 +41,11 @@ extern "C" {
 #endif
 
 #include "../configs/libmeshconfig.h"
+#include "../configs/libsimuconfig.h"
 #include "libmeshtlmbht.h"
 
     unsigned int meshReaderAndConverter(struct MeshConfig *,
-            struct tlmInternalMesh *);
+            struct tlmInternalMesh *, struct Simulation *);
 
 
 
@@ -35,6 +35,7 @@
 
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "libmeshtlmbht.h"
 #include "../miscellaneous/liberrorcode.h"
@@ -195,6 +196,178 @@ unsigned int allocateTLMInternalMeshElementsOnly(struct tlmInternalMesh *input,
     return 0;
 }
 
+/*
+ * quantityOfNodesOfElementTlmInternalMesh: returns the quantity of nodes of
+ * the element code, or 0 if the element code is not known
+ */
+int quantityOfNodesOfElementTlmInternalMesh(unsigned long long elementCode) {
+    switch (elementCode) {
+        case 1: // 2 nodes line
+            return 2;
+        case 2: // 3 nodes triangle
+            return 3;
+        case 3: // 4 nodes quadrangle
+            return 4;
+        case 4: // 4 nodes tetrahedron
+            return 4;
+        case 5: // 8 nodes hexahedron
+            return 8;
+        case 6: // 6 nodes prism
+            return 6;
+        case 7: // 5 nodes pyramid
+            return 5;
+        case 15: // 1 node point
+            return 1;
+    }
+    return 0;
+}
+
+/*
+ * setElementTlmInternalMesh: saves the element of position i (among the
+ * elements of the same code) with the tag and nodes N. The elements must
+ * have been allocated by allocateTLMInternalMeshNodesAndElements
+ */
+void setElementTlmInternalMesh(struct tlmInternalMesh *input, unsigned long long elementCode,
+        unsigned long long i, long unsigned int tag, const unsigned long long *N) {
+    switch (elementCode) {
+        case 1: // 2 nodes line
+            input->elements.Line[i].tag = tag;
+            input->elements.Line[i].N1 = N[0];
+            input->elements.Line[i].N2 = N[1];
+            break;
+        case 2: // 3 nodes triangle
+            input->elements.Triangle[i].tag = tag;
+            input->elements.Triangle[i].N1 = N[0];
+            input->elements.Triangle[i].N2 = N[1];
+            input->elements.Triangle[i].N3 = N[2];
+            break;
+        case 3: // 4 nodes quadrangle
+            input->elements.Quadrangle[i].tag = tag;
+            input->elements.Quadrangle[i].N1 = N[0];
+            input->elements.Quadrangle[i].N2 = N[1];
+            input->elements.Quadrangle[i].N3 = N[2];
+            input->elements.Quadrangle[i].N4 = N[3];
+            break;
+        case 4: // 4 nodes tetrahedron
+            input->elements.Tetrahedron[i].tag = tag;
+            input->elements.Tetrahedron[i].N1 = N[0];
+            input->elements.Tetrahedron[i].N2 = N[1];
+            input->elements.Tetrahedron[i].N3 = N[2];
+            input->elements.Tetrahedron[i].N4 = N[3];
+            break;
+        case 5: // 8 nodes hexahedron
+            input->elements.Hexahedron[i].tag = tag;
+            input->elements.Hexahedron[i].N1 = N[0];
+            input->elements.Hexahedron[i].N2 = N[1];
+            input->elements.Hexahedron[i].N3 = N[2];
+            input->elements.Hexahedron[i].N4 = N[3];
+            input->elements.Hexahedron[i].N5 = N[4];
+            input->elements.Hexahedron[i].N6 = N[5];
+            input->elements.Hexahedron[i].N7 = N[6];
+            input->elements.Hexahedron[i].N8 = N[7];
+            break;
+        case 6: // 6 nodes prism
+            input->elements.Prism[i].tag = tag;
+            input->elements.Prism[i].N1 = N[0];
+            input->elements.Prism[i].N2 = N[1];
+            input->elements.Prism[i].N3 = N[2];
+            input->elements.Prism[i].N4 = N[3];
+            input->elements.Prism[i].N5 = N[4];
+            input->elements.Prism[i].N6 = N[5];
+            break;
+        case 7: // 5 nodes pyramid
+            input->elements.Pyramid[i].tag = tag;
+            input->elements.Pyramid[i].N1 = N[0];
+            input->elements.Pyramid[i].N2 = N[1];
+            input->elements.Pyramid[i].N3 = N[2];
+            input->elements.Pyramid[i].N4 = N[3];
+            input->elements.Pyramid[i].N5 = N[4];
+            break;
+        case 15: // 1 node point
+            input->elements.Point[i].tag = tag;
+            input->elements.Point[i].N1 = N[0];
+            break;
+    }
+}
+
+/*
+ * getElementTlmInternalMesh: copies the nodes of the element of position i
+ * (among the elements of the same code) to N and returns its tag
+ */
+long unsigned int getElementTlmInternalMesh(const struct tlmInternalMesh *input,
+        unsigned long long elementCode, unsigned long long i, unsigned long long *N) {
+    switch (elementCode) {
+        case 1: // 2 nodes line
+            N[0] = input->elements.Line[i].N1;
+            N[1] = input->elements.Line[i].N2;
+            return input->elements.Line[i].tag;
+        case 2: // 3 nodes triangle
+            N[0] = input->elements.Triangle[i].N1;
+            N[1] = input->elements.Triangle[i].N2;
+            N[2] = input->elements.Triangle[i].N3;
+            return input->elements.Triangle[i].tag;
+        case 3: // 4 nodes quadrangle
+            N[0] = input->elements.Quadrangle[i].N1;
+            N[1] = input->elements.Quadrangle[i].N2;
+            N[2] = input->elements.Quadrangle[i].N3;
+            N[3] = input->elements.Quadrangle[i].N4;
+            return input->elements.Quadrangle[i].tag;
+        case 4: // 4 nodes tetrahedron
+            N[0] = input->elements.Tetrahedron[i].N1;
+            N[1] = input->elements.Tetrahedron[i].N2;
+            N[2] = input->elements.Tetrahedron[i].N3;
+            N[3] = input->elements.Tetrahedron[i].N4;
+            return input->elements.Tetrahedron[i].tag;
+        case 5: // 8 nodes hexahedron
+            N[0] = input->elements.Hexahedron[i].N1;
+            N[1] = input->elements.Hexahedron[i].N2;
+            N[2] = input->elements.Hexahedron[i].N3;
+            N[3] = input->elements.Hexahedron[i].N4;
+            N[4] = input->elements.Hexahedron[i].N5;
+            N[5] = input->elements.Hexahedron[i].N6;
+            N[6] = input->elements.Hexahedron[i].N7;
+            N[7] = input->elements.Hexahedron[i].N8;
+            return input->elements.Hexahedron[i].tag;
+        case 6: // 6 nodes prism
+            N[0] = input->elements.Prism[i].N1;
+            N[1] = input->elements.Prism[i].N2;
+            N[2] = input->elements.Prism[i].N3;
+            N[3] = input->elements.Prism[i].N4;
+            N[4] = input->elements.Prism[i].N5;
+            N[5] = input->elements.Prism[i].N6;
+            return input->elements.Prism[i].tag;
+        case 7: // 5 nodes pyramid
+            N[0] = input->elements.Pyramid[i].N1;
+            N[1] = input->elements.Pyramid[i].N2;
+            N[2] = input->elements.Pyramid[i].N3;
+            N[3] = input->elements.Pyramid[i].N4;
+            N[4] = input->elements.Pyramid[i].N5;
+            return input->elements.Pyramid[i].tag;
+        case 15: // 1 node point
+            N[0] = input->elements.Point[i].N1;
+            return input->elements.Point[i].tag;
+    }
+    return 0;
+}
+
+/*
+ * writeNodeToFileTlmFormat: write the nodes data to the file
+ */
+unsigned int writeNodeToFileTlmFormat(struct tlmInternalMesh *input, FILE *saveFile) {
+    unsigned long long i;
+
+    fprintf(saveFile, "Nodes\n");
+    fprintf(saveFile, "{\n");
+    fprintf(saveFile, "%llu\n", input->numberOfNode);
+    for (i = 0; i < input->numberOfNode; i++) {
+        fprintf(saveFile, "%.17g %.17g %.17g\n", input->nodes[i].x,
+                input->nodes[i].y, input->nodes[i].z);
+    }
+    fprintf(saveFile, "}\n");
+
+    return 0;
+}
+
 /*
  * writeElementToFileTlmFormat: write the elements data to the file
  */
@@ -300,6 +473,132 @@ unsigned int writeElementToFileTlmFormat(struct tlmInternalMesh *input, FILE *sa
     return 0;
 }
 
+/*
+ * sizeOfElementTlmInternalMesh: returns the size of the structure of the
+ * element code, or 0 if the element code is not known
+ */
+size_t sizeOfElementTlmInternalMesh(int elementCode) {
+    switch (elementCode) {
+        case 1: // 2 nodes line
+            return sizeof (struct elementLine);
+        case 2: // 3 nodes triangle
+            return sizeof (struct elementTriangle);
+        case 3: // 4 nodes quadrangle
+            return sizeof (struct elementQuadrangle);
+        case 4: // 4 nodes tetrahedron
+            return sizeof (struct elementTetrahedron);
+        case 5: // 8 nodes hexahedron
+            return sizeof (struct elementHexahedron);
+        case 6: // 6 nodes prism
+            return sizeof (struct elementPrism);
+        case 7: // 5 nodes pyramid
+            return sizeof (struct elementPyramid);
+        case 15: // 1 node point
+            return sizeof (struct elementPoint);
+    }
+    return 0;
+}
+
+/*
+ * elementArrayTlmInternalMesh: returns the array of the elements with the
+ * element code, or NULL if the element code is not known
+ */
+void *elementArrayTlmInternalMesh(struct tlmInternalMesh *input, int elementCode) {
+    switch (elementCode) {
+        case 1: // 2 nodes line
+            return input->elements.Line;
+        case 2: // 3 nodes triangle
+            return input->elements.Triangle;
+        case 3: // 4 nodes quadrangle
+            return input->elements.Quadrangle;
+        case 4: // 4 nodes tetrahedron
+            return input->elements.Tetrahedron;
+        case 5: // 8 nodes hexahedron
+            return input->elements.Hexahedron;
+        case 6: // 6 nodes prism
+            return input->elements.Prism;
+        case 7: // 5 nodes pyramid
+            return input->elements.Pyramid;
+        case 15: // 1 node point
+            return input->elements.Point;
+    }
+    return NULL;
+}
+
+/*
+ * putLittleEndianTbn: writes the first bytes of value to buffer, from the
+ * least to the most significant
+ */
+static void putLittleEndianTbn(unsigned char *buffer, unsigned long long value, int bytes) {
+    for (int k = 0; k < bytes; k++)
+        buffer[k] = (unsigned char) (value >> (8 * k));
+}
+
+/*
+ * writeToFileBinaryTbn: writes the mesh as binary .tbn (see
+ * TBN_BINARY_VERSION). The numbers are converted to little-endian in a buffer,
+ * so the file does not depend on the layout of the structures. It returns
+ * 6525 if a tag does not fit in 32 bits
+ */
+unsigned int writeToFileBinaryTbn(struct tlmInternalMesh *input, FILE *saveFile) {
+    unsigned char header[TBN_BINARY_HEADER_SIZE], buffer[65536];
+    unsigned long long i, N[8], bits;
+    long unsigned int tag;
+    size_t used = 0;
+    int j, k, nodes;
+
+    memcpy(header, TBN_BINARY_MAGIC, 8);
+    putLittleEndianTbn(header + 8, TBN_BINARY_VERSION, 4);
+    putLittleEndianTbn(header + 12, TBN_BINARY_ELEMENT_CODES, 4);
+    putLittleEndianTbn(header + 16, input->numberOfNode, 8);
+    for (j = 0; j < TBN_BINARY_ELEMENT_CODES; j++)
+        putLittleEndianTbn(header + 24 + 8 * j, quantityOfNodesOfElementTlmInternalMesh(j) > 0 ?
+            input->quantityOfSpecificElement[j] : 0, 8);
+
+    if (fwrite(header, 1, TBN_BINARY_HEADER_SIZE, saveFile) != TBN_BINARY_HEADER_SIZE)
+        return 766;
+
+    // the buffer is written when the next node or element may not fit in it
+    for (i = 0; i < input->numberOfNode; i++) {
+        if (used + 3 * 8 > sizeof (buffer)) {
+            if (fwrite(buffer, 1, used, saveFile) != used)
+                return 766;
+            used = 0;
+        }
+        memcpy(&bits, &input->nodes[i].x, 8);
+        putLittleEndianTbn(buffer + used, bits, 8);
+        memcpy(&bits, &input->nodes[i].y, 8);
+        putLittleEndianTbn(buffer + used + 8, bits, 8);
+        memcpy(&bits, &input->nodes[i].z, 8);
+        putLittleEndianTbn(buffer + used + 16, bits, 8);
+        used += 3 * 8;
+    }
+
+    for (j = 0; j < TBN_BINARY_ELEMENT_CODES; j++) {
+        if ((nodes = quantityOfNodesOfElementTlmInternalMesh(j)) == 0)
+            continue;
+        for (i = 0; i < input->quantityOfSpecificElement[j]; i++) {
+            if (used + 8 * nodes + 4 > sizeof (buffer)) {
+                if (fwrite(buffer, 1, used, saveFile) != used)
+                    return 766;
+                used = 0;
+            }
+            tag = getElementTlmInternalMesh(input, j, i, N);
+            if (tag > 0xFFFFFFFFUL)
+                return 6525;
+            for (k = 0; k < nodes; k++)
+                putLittleEndianTbn(buffer + used + 8 * k, N[k], 8);
+            putLittleEndianTbn(buffer + used + 8 * nodes, tag, 4);
+            used += 8 * nodes + 4;
+        }
+    }
+
+    if (fwrite(buffer, 1, used, saveFile) != used)
+        return 766;
+
+    return 0;
+}
+
 /*
  * testTlmInternalMesh: tests if the mesh was properly read
  */
@@ -41,6 +41,7 @@ extern "C" {
 #endif
 
 #include <stdio.h>
+#include <stddef.h>
 
     struct node {
         double x;
@@ -113,19 +114,6 @@ extern "C" {
         long unsigned int tag;
     };
 
-    struct elementAny {
-        int elementCode;
-        long unsigned int tag;
-        unsigned long long N1;
-        unsigned long long N2;
-        unsigned long long N3;
-        unsigned long long N4;
-        unsigned long long N5;
-        unsigned long long N6;
-        unsigned long long N7;
-        unsigned long long N8;
-    };
-
     struct elementAll {
         struct elementLine *Line;                   // Element code: 1
         struct elementTriangle *Triangle;           // Element code: 2
@@ -147,6 +135,20 @@ extern "C" {
     };
 
 
+    // binary .tbn. All the numbers are little-endian and packed, without
+    // padding, so the file does not depend on the computer that wrote it:
+    // - header (TBN_BINARY_HEADER_SIZE bytes): TBN_BINARY_MAGIC (8 bytes),
+    //   version (uint32), quantity of element codes (uint32, always
+    //   TBN_BINARY_ELEMENT_CODES), quantity of nodes (uint64), and quantity of
+    //   elements of each element code (uint64 each);
+    // - nodes: x, y, and z of each node (float64 each);
+    // - elements: for each element code with elements, in increasing order,
+    //   the nodes (uint64 each) and the tag (uint32) of each element.
+#define TBN_BINARY_MAGIC "TBNBIN\r\n"
+#define TBN_BINARY_VERSION 2
+#define TBN_BINARY_ELEMENT_CODES 16
+#define TBN_BINARY_HEADER_SIZE (8 + 4 + 4 + 8 + 8 * TBN_BINARY_ELEMENT_CODES)
+
     unsigned int initiateTlmInternalMesh(struct tlmInternalMesh *);
 
     unsigned int terminateTlmInternalMesh(struct tlmInternalMesh *);
@@ -156,8 +158,24 @@ extern "C" {
 
     unsigned int allocateTLMInternalMeshElementsOnly(struct tlmInternalMesh *, const int *);
 
+    int quantityOfNodesOfElementTlmInternalMesh(unsigned long long);
+
+    void setElementTlmInternalMesh(struct tlmInternalMesh *, unsigned long long,
+            unsigned long long, long unsigned int, const unsigned long long *);
+
+    long unsigned int getElementTlmInternalMesh(const struct tlmInternalMesh *,
+            unsigned long long, unsigned long long, unsigned long long *);
+
+    unsigned int writeNodeToFileTlmFormat(struct tlmInternalMesh *, FILE *);
+
     unsigned int writeElementToFileTlmFormat(struct tlmInternalMesh *, FILE *);
 
+    size_t sizeOfElementTlmInternalMesh(int);
+
+    void *elementArrayTlmInternalMesh(struct tlmInternalMesh *, int);
+
+    unsigned int writeToFileBinaryTbn(struct tlmInternalMesh *, FILE *);
+
     unsigned int testTlmInternalMesh(struct tlmInternalMesh *);
 
     //print additional information about the mesh
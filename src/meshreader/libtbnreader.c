@@ -57,6 +57,7 @@ unsigned int tbnReader(struct MeshConfig * input, struct tlmInternalMesh * outpu
     char * pline = NULL, *lineOriginal = NULL, *codeForReading = NULL;
     long lenLine = 0;
     enum tlmtbnConfig ConfigPoint = NOTHING_TBN;
+    char magic[8];
     FILE *pfile;
     char* nameOfFile = (char*) malloc(strlen(input->nameOfInputFile) + 5);
     // 1 - .
@@ -69,7 +70,37 @@ unsigned int tbnReader(struct MeshConfig * input, struct tlmInternalMesh * outpu
 
     printf("Opening the file %s\n", nameOfFile);
 
-    if ((pfile = fopen(nameOfFile, "r")) == NULL) {//We couldn't find the input file
+    if ((pfile = fopen(nameOfFile, "rb")) == NULL) {//We couldn't find the input file
+        sendErrorCodeAndMessage(764, nameOfFile, NULL, NULL, NULL);
+        free(nameOfFile);
+        nameOfFile = NULL;
+        return 764;
+    }
+
+    // the binary .tbn starts with TBN_BINARY_MAGIC. The text .tbn is opened
+    // again as text
+    if (fread(magic, 1, sizeof (magic), pfile) == sizeof (magic) &&
+            memcmp(magic, TBN_BINARY_MAGIC, sizeof (magic)) == 0) {
+        rewind(pfile);
+        if ((errorTLMnumber = tbnBinaryReader(input, output, pfile)) != 0)
+            sendErrorCodeAndMessage(errorTLMnumber, nameOfFile, NULL, NULL, NULL);
+
+        // testing the output variable
+        if (errorTLMnumber == 0 && (errorTLMnumber = testTlmInternalMesh(output)) != 0)
+            sendErrorCodeAndMessage(errorTLMnumber, NULL, NULL, NULL, NULL);
+
+        if (errorTLMnumber == 0)
+            printf("The file %s was successfully read.\n", nameOfFile);
+
+        free(nameOfFile);
+        nameOfFile = NULL;
+        fclose(pfile);
+        pfile = NULL;
+
+        return errorTLMnumber;
+    }
+
+    if ((pfile = freopen(nameOfFile, "r", pfile)) == NULL) {
         sendErrorCodeAndMessage(764, nameOfFile, NULL, NULL, NULL);
         free(nameOfFile);
         nameOfFile = NULL;
@@ -351,6 +382,137 @@ unsigned int tbnReader(struct MeshConfig * input, struct tlmInternalMesh * outpu
     return errorTLMnumber;
 }
 
+/*
+ * getLittleEndianTbn: returns the number stored in the first bytes of buffer,
+ * from the least to the most significant
+ */
+static unsigned long long getLittleEndianTbn(const unsigned char *buffer, int bytes) {
+    unsigned long long value = 0;
+    for (int k = bytes - 1; k >= 0; k--)
+        value = (value << 8) | buffer[k];
+    return value;
+}
+
+/*
+ * tbnBinaryReader: reads the binary .tbn (see TBN_BINARY_VERSION and
+ * writeToFileBinaryTbn). The header is checked against the size of the file,
+ * then the nodes and the elements of each element code are read in blocks and
+ * converted from little-endian, so the file can be written by any computer.
+ */
+unsigned int tbnBinaryReader(struct MeshConfig * input, struct tlmInternalMesh * output,
+        FILE * pfile) {
+    unsigned char header[TBN_BINARY_HEADER_SIZE], buffer[65536];
+    unsigned long long quantityOfSpecificElement[100], remaining, numberOfNode;
+    unsigned long long i, block, N[8], bits;
+    long unsigned int tag;
+    long long position, size;
+    unsigned int errorTLMnumber;
+    struct node *nodeRead;
+    size_t record;
+    int j, k, nodes;
+
+    if (fread(header, 1, TBN_BINARY_HEADER_SIZE, pfile) != TBN_BINARY_HEADER_SIZE)
+        return 6523;
+
+    if (memcmp(header, TBN_BINARY_MAGIC, 8) != 0 ||
+            getLittleEndianTbn(header + 8, 4) != TBN_BINARY_VERSION ||
+            getLittleEndianTbn(header + 12, 4) != TBN_BINARY_ELEMENT_CODES)
+        return 6522;
+
+    numberOfNode = getLittleEndianTbn(header + 16, 8);
+    for (j = 0; j < 100; j++)
+        quantityOfSpecificElement[j] = j < TBN_BINARY_ELEMENT_CODES ?
+            getLittleEndianTbn(header + 24 + 8 * j, 8) : 0;
+
+    // the quantities are checked against the size of the file before anything
+    // is allocated, so a damaged header cannot allocate or read beyond it
+#if defined(_WIN32)
+    position = _ftelli64(pfile);
+    _fseeki64(pfile, 0, SEEK_END);
+    size = _ftelli64(pfile);
+    _fseeki64(pfile, position, SEEK_SET);
+#else
+    position = ftell(pfile);
+    fseek(pfile, 0, SEEK_END);
+    size = ftell(pfile);
+    fseek(pfile, position, SEEK_SET);
+#endif
+    if (position < 0 || size < position)
+        return 6523;
+    remaining = (unsigned long long) (size - position);
+
+    if (numberOfNode > remaining / (3 * 8))
+        return 6523;
+    remaining -= numberOfNode * 3 * 8;
+
+    for (j = 0; j < TBN_BINARY_ELEMENT_CODES; j++) {
+        if (quantityOfSpecificElement[j] == 0)
+            continue;
+        // this version has no elements with this code
+        if ((nodes = quantityOfNodesOfElementTlmInternalMesh(j)) == 0)
+            return 6522;
+        record = 8 * nodes + 4;
+        if (quantityOfSpecificElement[j] > remaining / record)
+            return 6523;
+        remaining -= quantityOfSpecificElement[j] * record;
+    }
+
+    if ((errorTLMnumber = allocateTLMInternalMeshNodesAndElements(output,
+            numberOfNode, quantityOfSpecificElement)) != 0)
+        return errorTLMnumber;
+
+    // nodes, as many as fit in the buffer at a time
+    for (i = 0; i < numberOfNode; i += block) {
+        block = numberOfNode - i;
+        if (block > sizeof (buffer) / (3 * 8))
+            block = sizeof (buffer) / (3 * 8);
+        if (fread(buffer, 3 * 8, block, pfile) != block)
+            return 6523;
+        for (unsigned long long n = 0; n < block; n++) {
+            nodeRead = &output->nodes[i + n];
+            bits = getLittleEndianTbn(buffer + 24 * n, 8);
+            memcpy(&nodeRead->x, &bits, 8);
+            bits = getLittleEndianTbn(buffer + 24 * n + 8, 8);
+            memcpy(&nodeRead->y, &bits, 8);
+            bits = getLittleEndianTbn(buffer + 24 * n + 16, 8);
+            memcpy(&nodeRead->z, &bits, 8);
+        }
+    }
+
+    // elements of each element code
+    for (j = 0; j < TBN_BINARY_ELEMENT_CODES; j++) {
+        if (quantityOfSpecificElement[j] == 0)
+            continue;
+        nodes = quantityOfNodesOfElementTlmInternalMesh(j);
+        record = 8 * nodes + 4;
+        for (i = 0; i < quantityOfSpecificElement[j]; i += block) {
+            block = quantityOfSpecificElement[j] - i;
+            if (block > sizeof (buffer) / record)
+                block = sizeof (buffer) / record;
+            if (fread(buffer, record, block, pfile) != block)
+                return 6523;
+            for (unsigned long long n = 0; n < block; n++) {
+                for (k = 0; k < nodes; k++)
+                    N[k] = getLittleEndianTbn(buffer + record * n + 8 * k, 8);
+                tag = (long unsigned int) getLittleEndianTbn(buffer + record * n + 8 * nodes, 4);
+                setElementTlmInternalMesh(output, j, i + n, tag, N);
+            }
+        }
+    }
+
+    // Applying the scale factor
+    if (input->scale[0] != 1 || input->scale[1] != 1 || input->scale[2] != 1) {
+        for (i = 0; i < output->numberOfNode; i++) {
+            nodeRead = &output->nodes[i];
+            nodeRead->x = nodeRead->x * input->scale[0];
+            nodeRead->y = nodeRead->y * input->scale[1];
+            nodeRead->z = nodeRead->z * input->scale[2];
+        }
+    }
+
+    return 0;
+}
+
 /*
  * setMeshTbnConfigTo: compare the string of the input to standardized texts.
  * The comparison is case insensitive.
@@ -40,6 +40,8 @@
 extern "C" {
 #endif
 
+#include <stdio.h>
+
 #include "libmeshtlmbht.h"
 #include "../configs/libmeshconfig.h"
 
@@ -51,6 +53,8 @@ extern "C" {
 
     unsigned int tbnReader(struct MeshConfig *, struct tlmInternalMesh *);
 
+    unsigned int tbnBinaryReader(struct MeshConfig *, struct tlmInternalMesh *, FILE *);
+
     unsigned int setMeshTbnConfigTo(char *, enum tlmtbnConfig *);
 
 
@@ -37,13 +37,20 @@
 #include <stdlib.h>
 #include <time.h>
 #include <math.h>
+#include <limits.h>
 
 #include "libbenchmark.h"
+#include "../libmiscellaneous.h"
+#include "../../solver/tlmsolver/libtlmsolver.h"
 
-unsigned int runBenchmark() {
+/*
+ * runBenchmark: runs the benchmarks and writes them to benchmark.txt. The
+ * fast benchmark only times the setup of the connections and of the numbers
+ * of the ports
+ */
+unsigned int runBenchmark(enum benchmark bench) {
     unsigned int errorTLMnumber = 0;
 
-    printf("Running benchmark for matrix multiplication\n");
     unsigned long long L1 = 750, L2 = 750, maxElement;
     int repetitions = 7, numberOfSparsityTests = 5;
     double lowerTime = 0.5, higherTime = 1;
@@ -60,13 +67,219 @@ unsigned int runBenchmark() {
         return 764;
     }
 
-    if ((errorTLMnumber = benchmarkSAXPY(L1, L2, repetitions, lowerTime,
-            higherTime, numberOfSparsityTests, file, maxElement)) != 0) {
-        sendErrorCodeAndMessage(errorTLMnumber, NULL, NULL, NULL, NULL);
+    if (bench == RUN || bench == RUN_AND_SOLVE) {
+        printf("Running benchmark for matrix multiplication\n");
+        if ((errorTLMnumber = benchmarkSAXPY(L1, L2, repetitions, lowerTime,
+                higherTime, numberOfSparsityTests, file, maxElement)) != 0) {
+            sendErrorCodeAndMessage(errorTLMnumber, NULL, NULL, NULL, NULL);
+        }
+    }
+
+    if (errorTLMnumber == 0) {
+        printf("Running benchmark for the connections\n");
+        if ((errorTLMnumber = benchmarkConnection(file)) != 0) {
+            sendErrorCodeAndMessage(errorTLMnumber, NULL, NULL, NULL, NULL);
+        }
+    }
+
+    if (errorTLMnumber == 0) {
+        printf("Running benchmark for the real numbers of the ports\n");
+        if ((errorTLMnumber = benchmarkRealPorts(file)) != 0) {
+            sendErrorCodeAndMessage(errorTLMnumber, NULL, NULL, NULL, NULL);
+        }
     }
 
     fclose(file);
 
 
     return errorTLMnumber;
-}
\ No newline at end of file
+}
+
+/*
+ * benchmarkConnection: times the connection variable of the faces of cubes of
+ * tetrahedrons, built as in getTLMnumbers, with the hash tables of the levels
+ * and with the linear search that was used before them. Each cube has n^3
+ * cubes of six tetrahedrons. Both give the same intersections
+ */
+unsigned int benchmarkConnection(FILE *file) {
+    unsigned int errorTLMnumber = 0, search, face, f, v;
+    unsigned long long n, a, b, c, corner, tetrahedrons, intersections, i,
+            points[5], port[2], nodes[4],
+            allocateForEachLevel[] = {1, 1, 1, 3};
+    // the six tetrahedrons of a cube go from corner 0 to corner 7 through the
+    // corners of the faces. The corners are numbered x + 2*y + 4*z
+    const unsigned int path[6][2] = {{1, 3}, {1, 5}, {2, 3}, {2, 6}, {4, 5}, {4, 6}};
+    // the faces of the tetrahedron, as in getTLMnumbers
+    const unsigned int faces[4][3] = {{0, 1, 2}, {0, 1, 3}, {0, 2, 3}, {1, 2, 3}};
+    const char *name[2] = {"hash tables", "linear search"};
+    struct connectionLeveln con;
+    double start, time_spent;
+
+    for (n = 10; n <= 30; n += 10) {
+        tetrahedrons = 6 * n * n * n;
+        for (search = 0; search < 2; search++) {
+            setLinearSearch_connectionLeveln(search == 0 ? CONNECTION_LINEAR_SEARCH : ULLONG_MAX);
+            if ((errorTLMnumber = initiate_connectionLeveln(&con, 3, allocateForEachLevel)) != 0)
+                break;
+
+            start = wallTimeTlmbht();
+            intersections = 0;
+            for (i = 0; i < tetrahedrons && errorTLMnumber == 0; i++) {
+                a = (i / 6) % n;
+                b = (i / 6 / n) % n;
+                c = i / 6 / n / n;
+                corner = a + (n + 1) * (b + (n + 1) * c);
+                nodes[0] = corner + 1;
+                nodes[3] = corner + 1 + 1 + (n + 1) * (1 + (n + 1));
+                for (v = 1; v < 3; v++) {
+                    f = path[i % 6][v - 1];
+                    nodes[v] = corner + 1 + (f & 1) + (n + 1) * (((f >> 1) & 1) + (n + 1) * (f >> 2));
+                }
+                for (face = 0; face < 4; face++) {
+                    points[0] = 3;
+                    for (v = 0; v < 3; v++)
+                        points[v + 1] = nodes[faces[face][v]];
+                    port[0] = 4 * i + face;
+                    port[1] = 0;
+                    if ((errorTLMnumber = allocatePointsPort(points, &con, 1, port)) == 1) {
+                        intersections++;
+                        errorTLMnumber = 0;
+                    }
+                }
+            }
+            if (errorTLMnumber == 0)
+                errorTLMnumber = wrap_size_connectionLeveln(&con);
+            time_spent = wallTimeTlmbht() - start;
+            terminate_connectionLeveln(&con);
+            if (errorTLMnumber != 0)
+                break;
+
+            printf("Connections of %llu tetrahedrons with the %s: %g s (%llu intersections)\n",
+                    tetrahedrons, name[search], time_spent, intersections);
+            fprintf(file, "Connections with the %s: %llu %llu %g;\n", name[search],
+                    tetrahedrons, intersections, time_spent);
+        }
+        if (errorTLMnumber != 0)
+            break;
+    }
+    setLinearSearch_connectionLeveln(CONNECTION_LINEAR_SEARCH);
+
+    return errorTLMnumber;
+}
+
+/*
+ * realPortSortedListBenchmark: real number of a port of an element code that
+ * has the sorted list of its boundary nodes, as it was found before the rank
+ * tables: the element codes and the list are scanned. Only kept to be compared
+ * with getRealPortNumber_fromAbstractPortNumber
+ */
+static unsigned long long realPortSortedListBenchmark(unsigned long long abstractPortNumber,
+        const struct aPortToRealPort *Ports, const unsigned long long *boundaryNodes,
+        unsigned long long quantity) {
+    unsigned long long j, offset;
+    unsigned int i;
+
+    for (i = 0; i < 99; i++) {
+        if ((Ports[i + 1].previousMaximumRealNode - Ports[i].previousMaximumRealNode) > 0 &&
+                Ports[i + 1].previousMaximumAbstractPort > abstractPortNumber) {
+            break;
+        }
+    }
+
+    offset = Ports[i].previousMaximumAbstractPort - Ports[i].previousMaximumRealPort;
+    for (j = 0; j < quantity; j++) {
+        if ((Ports[i].portsPerNode * (boundaryNodes[j] + 1) +
+                Ports[i].previousMaximumAbstractPort) > abstractPortNumber) {
+            break;
+        }
+    }
+
+    return abstractPortNumber - offset - Ports[i].portsPerNode * j;
+}
+
+/*
+ * benchmarkRealPorts: times the conversion of the abstract number of a port to
+ * its real number with the rank tables of getRealPortNumber_fromAbstractPortNumber
+ * and with the scan of the sorted list of boundary nodes used before them. The
+ * mesh has one element code of tetrahedrons with one boundary node in ten. The
+ * scan is only timed for a part of the ports, and both must give the same numbers
+ */
+unsigned int benchmarkRealPorts(FILE *file) {
+    const unsigned long long nodes = 200000, portsPerNode = 4, sample = 20000;
+    unsigned long long n, p, material = 0, boundary = 0, ports, lookups, output[6],
+            sumRank = 0, sumList = 0, *boundaryNodes = NULL, *rank = NULL;
+    struct aPortToRealPort Ports[100];
+    double start, timeRank, timeList;
+    unsigned int i;
+
+    if ((boundaryNodes = (unsigned long long*) malloc(sizeof (unsigned long long) * nodes)) == NULL ||
+            (rank = (unsigned long long*) malloc(sizeof (unsigned long long) * (nodes + 1))) == NULL) {
+        free(boundaryNodes);
+        return 8750;
+    }
+
+    // node n is a boundary if n % 10 == 9
+    for (n = 0; n < nodes; n++) {
+        rank[n] = material;
+        if (n % 10 == 9)
+            boundaryNodes[boundary++] = n;
+        else
+            material++;
+    }
+    rank[nodes] = material;
+
+    // only the element code 4 has nodes
+    for (i = 0; i < 100; i++) {
+        Ports[i].portsPerNode = portsPerNode;
+        Ports[i].pointerType = i == 4 ? 2 : 0;
+        Ports[i].pointerTypeStub = 0;
+        Ports[i].previousMaximumRealStubPort = 0;
+        Ports[i].nextMaterialCode = i <= 4 ? 4 : 99;
+        Ports[i].realNodeRank = i == 4 ? rank : NULL;
+        Ports[i].abstractNodeOfRealNode = NULL;
+        Ports[i].stubRank = NULL;
+        Ports[i].previousMaximumAbstractNode = i <= 4 ? 0 : nodes;
+        Ports[i].previousMaximumAbstractPort = i <= 4 ? 1 : 1 + portsPerNode * nodes;
+        Ports[i].previousMaximumRealNode = i <= 4 ? 0 : material;
+        Ports[i].previousMaximumRealPort = i <= 4 ? 0 : portsPerNode * material;
+    }
+
+    // the ports of the material nodes, whose abstract numbers start at 1
+    ports = portsPerNode * nodes;
+    start = wallTimeTlmbht();
+    for (p = 0, lookups = 0; p < ports; p++) {
+        if (p / portsPerNode % 10 == 9)
+            continue;
+        getRealPortNumber_fromAbstractPortNumber(p + 1, Ports, output);
+        sumRank += output[0];
+        lookups++;
+    }
+    timeRank = (wallTimeTlmbht() - start) / lookups;
+
+    start = wallTimeTlmbht();
+    for (p = 0, n = 0; n < sample; p += ports / sample, n++) {
+        if (p / portsPerNode % 10 == 9)
+            p += portsPerNode;
+        sumList += realPortSortedListBenchmark(p + 1, Ports, boundaryNodes, boundary);
+    }
+    timeList = (wallTimeTlmbht() - start) / sample;
+
+    // the same ports with the rank tables, to compare the numbers
+    for (p = 0, n = 0; n < sample; p += ports / sample, n++) {
+        if (p / portsPerNode % 10 == 9)
+            p += portsPerNode;
+        getRealPortNumber_fromAbstractPortNumber(p + 1, Ports, output);
+        sumList -= output[0];
+    }
+
+    free(boundaryNodes);
+    free(rank);
+
+    printf("Real numbers of the ports of %llu nodes (%llu boundary): rank tables %g ns, "
+            "sorted list %g ns per port%s\n", nodes, boundary, timeRank * 1e9, timeList * 1e9,
+            sumList == 0 ? "" : ". The numbers are different!");
+    fprintf(file, "Real ports: %llu %llu %g %g %llu;\n", nodes, boundary, timeRank,
+            timeList, sumRank);
+
+    return 0;
+}
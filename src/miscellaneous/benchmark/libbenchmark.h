@@ -41,9 +41,14 @@ extern "C" {
 
 #include "libbenchmatmult.h"
 #include "../liberrorcode.h"
+#include "../../configs/libsimuconfig.h"
 
 
-    unsigned int runBenchmark();
+    unsigned int runBenchmark(enum benchmark);
+
+    unsigned int benchmarkConnection(FILE *);
+
+    unsigned int benchmarkRealPorts(FILE *);
 
 
 #ifdef __cplusplus
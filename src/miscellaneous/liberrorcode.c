@@ -172,6 +172,16 @@ void sendErrorCodeAndMessage(unsigned int errorCode, void *input1v, void *input2
             fprintf(stderr, "Could not open file %s", input1c);
             break;
 
+        case 765:
+            // the file was opened but it could not be read to the memory
+            fprintf(stderr, "Could not read file %s to the memory", input1c);
+            break;
+
+        case 766:
+            // the file was opened but it could not be written
+            fprintf(stderr, "Could not write file %s", input1c);
+            break;
+
         case 1147:
             // error when reading the SIMULATION configurations
             fprintf(stderr, "Unknown command in line %04u: %s", *input1ui, input2c);
@@ -282,6 +292,61 @@ void sendErrorCodeAndMessage(unsigned int errorCode, void *input1v, void *input2
             fprintf(stderr, "Semicolon ';' was not found in line %04u: %s", *input1ui, input2c);
             break;
 
+        case 3863:
+            // Invalid checkpoint time
+            fprintf(stderr, "Invalid input for checkpoint time in line %04u: %s", *input1ui, input2c);
+            break;
+
+        case 3864:
+            // Invalid checkpoint steps
+            fprintf(stderr, "Invalid input for checkpoint steps in line %04u: %s", *input1ui, input2c);
+            break;
+
+        case 3865:
+            // Invalid topology cache
+            fprintf(stderr, "Invalid input for topology cache in line %04u: %s", *input1ui, input2c);
+            break;
+
+        case 3866:
+            // Invalid sweep
+            fprintf(stderr, "Invalid input for sweep in line %04u: %s", *input1ui, input2c);
+            break;
+
+        case 3867:
+            // Invalid scenario
+            fprintf(stderr, "Invalid input for scenario in line %04u: %s", *input1ui, input2c);
+            break;
+
+        case 3868:
+            // Invalid steady detection interval
+            fprintf(stderr, "Invalid input for steady detection interval in line %04u: %s", *input1ui, input2c);
+            break;
+
+        case 3869:
+            // Invalid steady detection tolerance
+            fprintf(stderr, "Invalid input for steady detection tolerance in line %04u: %s", *input1ui, input2c);
+            break;
+
+        case 3870:
+            // Unknown input for time-jump power
+            fprintf(stderr, "Unknown input for time-jump power in line %04u: %s", *input1ui, input2c);
+            break;
+
+        case 3871:
+            // Invalid statistics dose threshold
+            fprintf(stderr, "Invalid input for statistics dose threshold in line %04u: %s", *input1ui, input2c);
+            break;
+
+        case 3872:
+            // Invalid statistics percentile
+            fprintf(stderr, "Invalid input for statistics percentile in line %04u: %s", *input1ui, input2c);
+            break;
+
+        case 3873:
+            // Invalid statistics threshold
+            fprintf(stderr, "Invalid input for statistics threshold in line %04u: %s", *input1ui, input2c);
+            break;
+
         case 3874:
             // Unknown command for simulation
             fprintf(stderr, "Unknown type for simulation in line %04u: %s", *input1ui, input2c);
@@ -337,6 +402,31 @@ void sendErrorCodeAndMessage(unsigned int errorCode, void *input1v, void *input2
             fprintf(stderr, "Unknown input for number of OpenMP cores in line %04u: %s", *input1ui, input2c);
             break;
 
+        case 3885:
+            // Unknown input for output precision
+            fprintf(stderr, "Unknown input for output precision in line %04u: %s", *input1ui, input2c);
+            break;
+
+        case 3886:
+            // Invalid output buffers
+            fprintf(stderr, "Invalid input for output buffers in line %04u: %s", *input1ui, input2c);
+            break;
+
+        case 3887:
+            // Invalid output probe
+            fprintf(stderr, "Invalid input for output probe in line %04u: %s", *input1ui, input2c);
+            break;
+
+        case 3888:
+            // Invalid output tag
+            fprintf(stderr, "Invalid input for output tag in line %04u: %s", *input1ui, input2c);
+            break;
+
+        case 3889:
+            // Invalid statistics tag
+            fprintf(stderr, "Invalid input for statistics tag in line %04u: %s", *input1ui, input2c);
+            break;
+
         case 3890:
             // Unknown input for output extension
             fprintf(stderr, "Unknown input for output extension in line %04u: %s", *input1ui, input2c);
@@ -351,6 +441,41 @@ void sendErrorCodeAndMessage(unsigned int errorCode, void *input1v, void *input2
             fprintf(stderr, "Unknown input for verbose mode in line %04u: %s", *input1ui, input2c);
             break;
 
+        case 3893:
+            // Unknown input for engine
+            fprintf(stderr, "Unknown input for engine in line %04u: %s", *input1ui, input2c);
+            break;
+
+        case 3894:
+            // Unknown input for steady solver
+            fprintf(stderr, "Unknown input for steady solver in line %04u: %s", *input1ui, input2c);
+            break;
+
+        case 3895:
+            // Unknown input for preconditioner
+            fprintf(stderr, "Unknown input for preconditioner in line %04u: %s", *input1ui, input2c);
+            break;
+
+        case 3896:
+            // Invalid tolerance
+            fprintf(stderr, "Invalid input for tolerance in line %04u: %s", *input1ui, input2c);
+            break;
+
+        case 3897:
+            // Invalid maximum iterations
+            fprintf(stderr, "Invalid input for maximum iterations in line %04u: %s", *input1ui, input2c);
+            break;
+
+        case 3898:
+            // Unknown tbn format for mesh
+            fprintf(stderr, "Unknown tbn format for mesh in line %04u: %s", *input1ui, input2c);
+            break;
+
+        case 3899:
+            // Unknown input for renumbering
+            fprintf(stderr, "Unknown input for renumbering in line %04u: %s", *input1ui, input2c);
+            break;
+
         case 4441:
             // error when reading the MATERIAL configurations
             fprintf(stderr, "The flux model for the materials group %04d was defined as hyperbolic but the relaxation time was not defined", *input1ui);
@@ -606,6 +731,50 @@ void sendErrorCodeAndMessage(unsigned int errorCode, void *input1v, void *input2
                     " by the .msh file. The last read line was line %04u: %s", *input1ui, input2c);
             break;
 
+        case 6518:
+            fprintf(stderr, "The .msh file ended or had data that could not be read"
+                    " in the section %s (or just after it)", input1c);
+            break;
+
+        case 6519:
+            fprintf(stderr, "Unknown element type %llu in the .msh file. The known elements "
+                    "are: 1 - 2 nodes line; 2 - 3 nodes triangle; 3 - 4 nodes quadrangle; "
+                    "4 - 4 nodes tetrahedron; 5 - 8 nodes hexahedron; 6 - 6 nodes prism; "
+                    "7 - 5 nodes pyramid; 15 - 1 node point", *input2llui);
+            break;
+
+        case 6520:
+            fprintf(stderr, "An element of the .msh file has the node %llu, which was"
+                    " not found in the section $Nodes", *input2llui);
+            break;
+
+        case 6521:
+            fprintf(stderr, "The $MeshFormat %s is not supported. The supported formats"
+                    " are 2.2 (ASCII or binary) and 4.1 (ASCII or binary)", input1c);
+            break;
+
+        case 6522:
+            fprintf(stderr, "The binary .tbn file %s was written by another version of"
+                    " tlmbht or has elements that are not supported. Convert the mesh"
+                    " again", input1c);
+            break;
+
+        case 6523:
+            fprintf(stderr, "The binary .tbn file %s ended before all the nodes and"
+                    " elements were read", input1c);
+            break;
+
+        case 6524:
+            fprintf(stderr, "The section %s of the binary .msh file is not used by tlmbht"
+                    " and its binary data cannot be skipped. Save the mesh without it"
+                    " or in ASCII", input1c);
+            break;
+
+        case 6525:
+            fprintf(stderr, "The binary .tbn file %s cannot be written because a tag is"
+                    " larger than 4294967295. Use 'tbn format = text'", input1c);
+            break;
+
         case 6599:
             fprintf(stderr, "Unknown error reading the mesh file type");
             break;
@@ -808,6 +977,8 @@ void sendErrorCodeAndMessage(unsigned int errorCode, void *input1v, void *input2
         case 8697:
             fprintf(stderr, "Failed to wrap the memory for the connection variable at level %u and quantity of %llu", *input1ui, *input2llui);
             break;
+        case 8692:
+            /* FALLTHRU */
         case 8698:
             /* FALLTHRU */
         case 8699:
@@ -905,10 +1076,76 @@ void sendErrorCodeAndMessage(unsigned int errorCode, void *input1v, void *input2
             /* FALLTHRU */
         case 8745:
             /* FALLTHRU */
+        case 8746:
+            /* FALLTHRU */
+        case 8747:
+            /* FALLTHRU */
+        case 8748:
+            /* FALLTHRU */
+        case 8749:
+            /* FALLTHRU */
+        case 8754:
+            /* FALLTHRU */
+        case 8755:
+            /* FALLTHRU */
+        case 8758:
+            /* FALLTHRU */
         case 8750:
             fprintf(stderr, "Failed to allocate memory for the processing");
             break;
 
+        case 8751:
+            // error when finding the nodes in the scattering matrix
+            fprintf(stderr, "The scattering matrix is not formed by one block per node");
+            break;
+
+        case 8752:
+            // error when preparing the preconditioner of the steady-state solver
+            fprintf(stderr, "Failed to calculate the preconditioner of the steady-state solver");
+            break;
+
+        case 8753:
+            // error when preparing the node system
+            fprintf(stderr, "The node system cannot be used with stub ports");
+            break;
+
+        case 8756:
+            // error when selecting the outputs
+            fprintf(stderr, "An output tag is not a material of the equation");
+            break;
+
+        case 8757:
+            // error when preparing the statistics
+            fprintf(stderr, "A statistics tag is not a material of the equation");
+            break;
+
+        case 8759:
+            // error when preparing the scenarios or the points of a sweep
+            fprintf(stderr, "A scenario or sweep changes a material or boundary that is not "
+                    "in the equation, or a parameter that it does not have or that is a function");
+            break;
+
+        case 8760:
+            // error when preparing the scenarios
+            fprintf(stderr, "A scenario changes the matrix M");
+            break;
+
+        case 8761:
+            // error when writing the topology cache
+            fprintf(stderr, "Could not write the topology cache");
+            break;
+
+        case 8762:
+            // error when writing the checkpoint
+            fprintf(stderr, "Could not write the checkpoint or synchronize the output files with the disk");
+            break;
+
+        case 8763:
+            // error when restarting from the checkpoint
+            fprintf(stderr, "Could not restart from the checkpoint. It is damaged, was written by "
+                    "another computer, or does not match the simulation or its output files");
+            break;
+
         case 9998:
             // this should not be an error. This is a flag number
             fprintf(stderr, "Unknown error");
@@ -32,8 +32,31 @@
  *
  */
 
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
 #include "libmiscellaneous.h"
 
+// phases of the profiler, and the phases that are running from the top, with
+// the wall time and the heap in use (-1 if not known) when they began
+static struct profilerPhase profilerPhases[PROFILER_MAXIMUM_PHASES];
+static int profilerQuantity = 0;
+static int profilerStack[PROFILER_MAXIMUM_DEPTH];
+static double profilerBegin[PROFILER_MAXIMUM_DEPTH];
+static long long profilerHeap[PROFILER_MAXIMUM_DEPTH];
+static int profilerDepth = 0;
+
 /*
  * sortOptmizedBubbleSort: Sorts unsigned long long using the optimized 
  * bubble sort algorithm. It assumes that the position zero contains the length
@@ -66,4 +89,274 @@ int compareLLU(const void *a, const void *b) {
     if (*(unsigned long long*) a < *(unsigned long long*) b) return -1;
     if (*(unsigned long long*) a > *(unsigned long long*) b) return +1;
     return 0;
-}
\ No newline at end of file
+}
+
+/*
+ * wallTimeTlmbht: returns the time in seconds of a monotonic wall clock. Only
+ * differences of it have meaning. clock() sums the time of all the threads, so
+ * it is not used to time the phases
+ */
+double wallTimeTlmbht(void) {
+#if defined(_WIN32)
+    LARGE_INTEGER counter, frequency;
+
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+    return (double) counter.QuadPart / (double) frequency.QuadPart;
+#else
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) now.tv_sec + 1e-9 * now.tv_nsec;
+#endif
+}
+
+/*
+ * heapInUseProfiler: returns the bytes of the heap in use, or -1 if the C
+ * library does not tell it
+ */
+static long long heapInUseProfiler(void) {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    struct mallinfo2 information = mallinfo2();
+
+    return (long long) (information.uordblks + information.hblkhd);
+#else
+    return -1;
+#endif
+}
+
+/*
+ * peakResidentProfiler: returns the largest resident memory of the process
+ * since it began, in bytes, or -1 if the system does not tell it
+ */
+static long long peakResidentProfiler(void) {
+#if defined(_WIN32)
+    return -1;
+#else
+    struct rusage usage;
+
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return -1;
+#if defined(__APPLE__)
+    return (long long) usage.ru_maxrss; // bytes
+#else
+    return 1024LL * usage.ru_maxrss; // kilobytes
+#endif
+#endif
+}
+
+/*
+ * findPhaseProfiler: returns the phase called name inside the phase that is
+ * running, which is created if it does not exist. Returns -1 if there is no
+ * room for it
+ */
+static int findPhaseProfiler(const char *name) {
+    int parent = -1, p;
+
+    if (profilerDepth > 0 && profilerDepth <= PROFILER_MAXIMUM_DEPTH)
+        parent = profilerStack[profilerDepth - 1];
+
+    for (p = 0; p < profilerQuantity; p++) {
+        if (profilerPhases[p].parent == parent && strcmp(profilerPhases[p].name, name) == 0)
+            return p;
+    }
+
+    if (profilerQuantity == PROFILER_MAXIMUM_PHASES)
+        return -1;
+
+    profilerPhases[p].name = name;
+    profilerPhases[p].parent = parent;
+    profilerPhases[p].calls = 0;
+    profilerPhases[p].seconds = 0;
+    profilerPhases[p].netHeapBytes = 0;
+    profilerPhases[p].heapSampled = 0;
+    profilerPhases[p].peakResidentBytes = -1;
+    profilerQuantity++;
+
+    return p;
+}
+
+/*
+ * beginPhaseProfiler: begins a call of the phase called name inside the phase
+ * that is running. Phases deeper than PROFILER_MAXIMUM_DEPTH are not recorded
+ */
+void beginPhaseProfiler(const char *name) {
+
+    if (profilerDepth < PROFILER_MAXIMUM_DEPTH) {
+        profilerStack[profilerDepth] = findPhaseProfiler(name);
+        profilerHeap[profilerDepth] = heapInUseProfiler();
+        profilerBegin[profilerDepth] = wallTimeTlmbht();
+    }
+    profilerDepth++;
+}
+
+/*
+ * endPhaseProfiler: ends the call of the phase that is running and returns its
+ * wall time in seconds
+ */
+double endPhaseProfiler(void) {
+    long long heap, peak;
+    double seconds;
+    int p;
+
+    if (profilerDepth == 0)
+        return 0;
+    profilerDepth--;
+    if (profilerDepth >= PROFILER_MAXIMUM_DEPTH)
+        return 0;
+
+    seconds = wallTimeTlmbht() - profilerBegin[profilerDepth];
+    if ((p = profilerStack[profilerDepth]) >= 0) {
+        profilerPhases[p].calls++;
+        profilerPhases[p].seconds += seconds;
+        if ((heap = heapInUseProfiler()) >= 0 && profilerHeap[profilerDepth] >= 0) {
+            profilerPhases[p].netHeapBytes += heap - profilerHeap[profilerDepth];
+            profilerPhases[p].heapSampled = 1;
+        }
+        if ((peak = peakResidentProfiler()) > profilerPhases[p].peakResidentBytes)
+            profilerPhases[p].peakResidentBytes = peak;
+    }
+
+    return seconds;
+}
+
+/*
+ * addPhaseProfiler: adds calls of the phase called name, inside the phase
+ * that is running, that took seconds in total. Used for the phases inside the
+ * time-steps, which are timed by the solver
+ */
+void addPhaseProfiler(const char *name, double seconds, unsigned long long calls) {
+    int p;
+
+    if (profilerDepth > PROFILER_MAXIMUM_DEPTH || (p = findPhaseProfiler(name)) < 0)
+        return;
+
+    profilerPhases[p].calls += calls;
+    profilerPhases[p].seconds += seconds;
+}
+
+/*
+ * printTimeProfiler: prints the text given by format and its arguments,
+ * followed by the time in ms, s, min, and hours (in timing mode)
+ */
+void printTimeProfiler(double seconds, const char *format, ...) {
+    va_list arguments;
+
+    va_start(arguments, format);
+    vprintf(format, arguments);
+    va_end(arguments);
+    printf(" %g ms (or %g s, or %g min, or %g hours).\n", seconds * 1e3, seconds,
+            seconds / 60.0, seconds / (60 * 60));
+}
+
+/*
+ * bytesProfiler: writes bytes to text, or "n/a" (quoted if quote is 1) if
+ * they are not known, and returns text
+ */
+static const char *bytesProfiler(char *text, size_t size, long long bytes, int known, int quote) {
+    if (known == 0)
+        snprintf(text, size, quote == 1 ? "\"n/a\"" : "n/a");
+    else
+        snprintf(text, size, "%lld", bytes);
+    return text;
+}
+
+/*
+ * writeJsonProfiler: writes the phases inside parent, and theirs, as a JSON
+ * array of objects
+ */
+static void writeJsonProfiler(FILE *file, int parent, int depth) {
+    char heap[32], peak[32];
+    int p, first = 1;
+
+    for (p = 0; p < profilerQuantity; p++) {
+        if (profilerPhases[p].parent != parent)
+            continue;
+        fprintf(file, "%s\n%*s{\"name\": \"%s\", \"calls\": %llu, \"seconds\": %.9g, "
+                "\"net heap bytes\": %s, \"peak resident bytes\": %s, \"phases\": [",
+                first == 1 ? "" : ",", 2 * depth + 4, "", profilerPhases[p].name,
+                profilerPhases[p].calls, profilerPhases[p].seconds,
+                bytesProfiler(heap, sizeof (heap), profilerPhases[p].netHeapBytes,
+                profilerPhases[p].heapSampled, 1),
+                bytesProfiler(peak, sizeof (peak), profilerPhases[p].peakResidentBytes,
+                profilerPhases[p].peakResidentBytes >= 0, 1));
+        writeJsonProfiler(file, p, depth + 1);
+        fprintf(file, "]}");
+        first = 0;
+    }
+}
+
+/*
+ * writeCsvProfiler: writes one line for each phase inside parent, and theirs.
+ * The phase is written as its path, the names of its parents and its own
+ * separated by '/'
+ */
+static void writeCsvProfiler(FILE *file, int parent, int depth, char *path, size_t length,
+        size_t size) {
+    char heap[32], peak[32];
+    size_t added;
+    int p;
+
+    for (p = 0; p < profilerQuantity; p++) {
+        if (profilerPhases[p].parent != parent)
+            continue;
+        added = (size_t) snprintf(path + length, size - length, "%s%s", length > 0 ? "/" : "",
+                profilerPhases[p].name);
+        if (length + added >= size)
+            added = size - 1 - length;
+        fprintf(file, "\"%s\", %d, %llu, %.9g, %s, %s\n", path, depth, profilerPhases[p].calls,
+                profilerPhases[p].seconds,
+                bytesProfiler(heap, sizeof (heap), profilerPhases[p].netHeapBytes,
+                profilerPhases[p].heapSampled, 0),
+                bytesProfiler(peak, sizeof (peak), profilerPhases[p].peakResidentBytes,
+                profilerPhases[p].peakResidentBytes >= 0, 0));
+        writeCsvProfiler(file, p, depth + 1, path, length + added, size);
+        path[length] = '\0';
+    }
+}
+
+/*
+ * writeReportProfiler: writes the phases to name_profile.json, as a tree, and
+ * to name_profile.csv, one line for each phase. Their times are wall times in
+ * seconds. "net heap bytes" is the heap in use at the end minus at the
+ * beginning of the calls, so it can be negative, and "peak resident bytes" is
+ * the largest resident memory of the process when the phase ended. Either is
+ * "n/a" when the system does not tell it
+ */
+unsigned int writeReportProfiler(const char *name) {
+    char *nameOfFile, path[4096] = "";
+    FILE *file;
+    int written;
+
+    if ((nameOfFile = (char *) malloc(strlen(name) + 16)) == NULL)
+        return 8750;
+
+    sprintf(nameOfFile, "%s_profile.json", name);
+    if ((file = fopen(nameOfFile, "w")) == NULL) {
+        free(nameOfFile);
+        return 764;
+    }
+    fprintf(file, "{\n  \"clock\": \"monotonic wall clock\",\n  \"phases\": [");
+    writeJsonProfiler(file, -1, 0);
+    written = fprintf(file, "\n  ]\n}\n") > 0;
+    if (fclose(file) != 0 || written == 0) {
+        free(nameOfFile);
+        return 766;
+    }
+
+    sprintf(nameOfFile, "%s_profile.csv", name);
+    if ((file = fopen(nameOfFile, "w")) == NULL) {
+        free(nameOfFile);
+        return 764;
+    }
+    fprintf(file, "phase, depth, calls, seconds, net heap bytes, peak resident bytes\n");
+    writeCsvProfiler(file, -1, 0, path, 0, sizeof (path));
+    written = ferror(file) == 0;
+    if (fclose(file) != 0 || written == 0) {
+        free(nameOfFile);
+        return 766;
+    }
+
+    free(nameOfFile);
+    return 0;
+}
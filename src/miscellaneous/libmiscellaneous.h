@@ -40,10 +40,42 @@
 extern "C" {
 #endif
 
+    // profiler: the phases of the simulation are timed with a monotonic wall
+    // clock. A phase begins and ends in the same function, and the phases that
+    // begin while it is running are inside it. The same name in different
+    // parents is a different phase, and the same name in the same parent sums
+    // its calls. The heap in use is sampled when a call begins and ends, if the
+    // C library allows (glibc 2.33 or newer), and the peak resident memory of
+    // the process when it ends, if the system allows. Only the main thread uses it
+#define PROFILER_MAXIMUM_PHASES 512
+#define PROFILER_MAXIMUM_DEPTH 32
+
+    struct profilerPhase {
+        const char *name; // not copied, so it must be a literal
+        int parent; // -1 for the phases at the top
+        unsigned long long calls;
+        double seconds;
+        // heap in use at the end minus at the beginning, summed for the calls.
+        // It is negative if the phase freed more than it kept
+        long long netHeapBytes;
+        int heapSampled; // 0 if the heap in use is not known
+        // largest resident memory of the process so far, when a call ended.
+        // -1 if it is not known
+        long long peakResidentBytes;
+    };
+
     void sortOptmizedBubbleSort(unsigned long long *);
 
     int compareLLU(const void *, const void *);
 
+    double wallTimeTlmbht(void);
+
+    void beginPhaseProfiler(const char *);
+    double endPhaseProfiler(void);
+    void addPhaseProfiler(const char *, double, unsigned long long);
+    void printTimeProfiler(double, const char *, ...);
+    unsigned int writeReportProfiler(const char *);
+
 
 #ifdef __cplusplus
 }
@@ -36,6 +36,12 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 #include "libstringtlmbht.h"
 
@@ -50,7 +56,7 @@
  * is found, or until the end of the length of the input.
  * All the text after '=' or ';' is ignored.
  */
-unsigned int compareCaseInsensitive(char *input, char *wordToCompare) {
+unsigned int compareCaseInsensitive(const char *input, const char *wordToCompare) {
     // DEBUG: got inside and what was the input
     // printf("inside compareCaseInsensitive '%s' and '%s'\n", input, wordToCompare);
 
@@ -77,7 +83,7 @@ unsigned int compareCaseInsensitive(char *input, char *wordToCompare) {
     // that the following characters are blank spaces until I find '=', ';', or
     // the char length reaches the end.
 
-    char *pEqual, *pSemiColon;
+    const char *pEqual, *pSemiColon;
     int length;
     pEqual = strchr(input, '=');
     pSemiColon = strchr(input, ';');
@@ -360,6 +366,261 @@ unsigned int getlineTlmbht(char** pline, long* size_line, FILE* file) {
     return 0;
 }
 
+/*
+ * mapFileTlmbht: makes the content of the file available in file->data without
+ * reading it line by line. When possible, the file is mapped to the memory
+ * (mmap), so the operating system loads it while it is being parsed. Otherwise,
+ * I read the entire file with only one fread.
+ * 
+ * Note that file->data does not end with '\0'.
+ * 
+ * returns:
+ * 0 - no error
+ * 764 - the file could not be opened
+ * 765 - the file could not be read to the memory
+ */
+unsigned int mapFileTlmbht(const char *nameOfFile, struct mappedFileTlmbht *file) {
+    FILE *pfile;
+    long long size;
+
+    file->data = NULL;
+    file->size = 0;
+    file->mapped = 0;
+
+#if !defined(_WIN32)
+    int descriptor;
+    struct stat status;
+
+    if ((descriptor = open(nameOfFile, O_RDONLY)) == -1)
+        return 764;
+
+    // mmap does not accept empty files. They are read below
+    if (fstat(descriptor, &status) == 0 && status.st_size > 0) {
+        void *map = mmap(NULL, (size_t) status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+
+        if (map != MAP_FAILED) {
+#if defined(MADV_SEQUENTIAL)
+            madvise(map, (size_t) status.st_size, MADV_SEQUENTIAL);
+#endif
+            file->data = (const char *) map;
+            file->size = (size_t) status.st_size;
+            file->mapped = 1;
+            close(descriptor);
+            return 0;
+        }
+    }
+    close(descriptor);
+#endif
+
+    // the file could not be mapped. I will read it at once
+    if ((pfile = fopen(nameOfFile, "rb")) == NULL)
+        return 764;
+
+#if defined(_WIN32)
+    _fseeki64(pfile, 0, SEEK_END);
+    size = _ftelli64(pfile);
+    _fseeki64(pfile, 0, SEEK_SET);
+#else
+    fseek(pfile, 0, SEEK_END);
+    size = ftell(pfile);
+    fseek(pfile, 0, SEEK_SET);
+#endif
+
+    // + 1 so that empty files do not allocate 0 bytes
+    char *buffer = NULL;
+    if (size < 0 || (buffer = (char *) malloc((size_t) size + 1)) == NULL ||
+            fread(buffer, 1, (size_t) size, pfile) != (size_t) size) {
+        free(buffer);
+        fclose(pfile);
+        return 765;
+    }
+    fclose(pfile);
+
+    file->data = buffer;
+    file->size = (size_t) size;
+
+    return 0;
+}
+
+/*
+ * unmapFileTlmbht: releases the content of the file opened by mapFileTlmbht
+ */
+unsigned int unmapFileTlmbht(struct mappedFileTlmbht *file) {
+#if !defined(_WIN32)
+    if (file->mapped == 1) {
+        munmap((void *) file->data, file->size);
+    } else {
+        free((void *) file->data);
+    }
+#else
+    free((void *) file->data);
+#endif
+    file->data = NULL;
+    file->size = 0;
+    file->mapped = 0;
+
+    return 0;
+}
+
+/*
+ * skipBlankSpacesTlmbht: returns the first position from position to end that
+ * is not a blank space. The new line character is not skipped.
+ */
+const char *skipBlankSpacesTlmbht(const char *position, const char *end) {
+    while (position < end && (*position == ' ' || *position == '\t' ||
+            *position == '\r' || *position == '\v' || *position == '\f'))
+        position++;
+
+    return position;
+}
+
+/*
+ * scanUnsignedTlmbht: reads the unsigned integer that starts in position
+ * (after blank spaces) and saves it in value. The text does not need to end
+ * with '\0', because nothing after end is read. This is what allows me to read
+ * directly from the files opened by mapFileTlmbht.
+ * 
+ * It returns the position just after the number or NULL if there is no number.
+ */
+const char *scanUnsignedTlmbht(const char *position, const char *end,
+        unsigned long long *value) {
+    unsigned long long number = 0;
+    const char *start;
+
+    position = skipBlankSpacesTlmbht(position, end);
+
+    if (position < end && *position == '+')
+        position++;
+
+    start = position;
+    while (position < end && *position >= '0' && *position <= '9') {
+        number = number * 10 + (unsigned long long) (*position - '0');
+        position++;
+    }
+
+    if (position == start)
+        return NULL;
+
+    *value = number;
+
+    return position;
+}
+
+/*
+ * scanDoubleTlmbht: reads the floating point number that starts in position
+ * (after blank spaces) and saves it in value. As scanUnsignedTlmbht, nothing
+ * after end is read.
+ * 
+ * When the digits of the number are below 2^53 (about 16 significant digits)
+ * and the exponent is small, which are most numbers written by meshers, both
+ * the digits and the power of ten are exact doubles, so one multiplication or division gives the correctly rounded
+ * result, the same as strtod. The other numbers (longer, inf, nan, etc.) are
+ * copied to a small buffer and read by strtod.
+ * 
+ * It returns the position just after the number or NULL if there is no number.
+ */
+const char *scanDoubleTlmbht(const char *position, const char *end, double *value) {
+    static const double powerOfTen[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7,
+        1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19,
+        1e20, 1e21, 1e22};
+    unsigned long long mantissa = 0;
+    int significantDigits = 0, digits = 0, exponent = 0, exponentRead = 0,
+            negative = 0, negativeExponent = 0;
+    const char *start, *afterMantissa;
+
+    position = skipBlankSpacesTlmbht(position, end);
+    start = position;
+
+    if (position < end && (*position == '-' || *position == '+')) {
+        negative = (*position == '-');
+        position++;
+    }
+
+    // integer part
+    while (position < end && *position >= '0' && *position <= '9') {
+        if (mantissa != 0 || *position != '0') {
+            significantDigits++;
+        }
+        mantissa = mantissa * 10 + (unsigned long long) (*position - '0');
+        digits++;
+        position++;
+        // more than 19 digits would overflow the mantissa. strtod will take care
+        if (significantDigits > 19)
+            break;
+    }
+
+    // fractional part
+    if (significantDigits <= 19 && position < end && *position == '.') {
+        position++;
+        while (position < end && *position >= '0' && *position <= '9') {
+            if (mantissa != 0 || *position != '0') {
+                significantDigits++;
+            }
+            mantissa = mantissa * 10 + (unsigned long long) (*position - '0');
+            exponent--;
+            digits++;
+            position++;
+            if (significantDigits > 19)
+                break;
+        }
+    }
+
+    // exponent. It is only part of the number if there is a digit after e
+    afterMantissa = position;
+    if (digits > 0 && significantDigits <= 19 && position < end &&
+            (*position == 'e' || *position == 'E')) {
+        position++;
+        if (position < end && (*position == '-' || *position == '+')) {
+            negativeExponent = (*position == '-');
+            position++;
+        }
+        if (position < end && *position >= '0' && *position <= '9') {
+            while (position < end && *position >= '0' && *position <= '9') {
+                // large exponents are left to strtod
+                if (exponentRead < 10000)
+                    exponentRead = exponentRead * 10 + (*position - '0');
+                position++;
+            }
+        } else {
+            position = afterMantissa;
+        }
+    }
+    exponent += negativeExponent ? -exponentRead : exponentRead;
+
+    // 2^53 is the largest integer up to which all integers are exact doubles
+    if (digits > 0 && significantDigits <= 19 && mantissa <= 9007199254740992ULL &&
+            exponent >= -22 && exponent <= 22) {
+        *value = (double) mantissa;
+        if (exponent < 0) {
+            *value /= powerOfTen[-exponent];
+        } else {
+            *value *= powerOfTen[exponent];
+        }
+        if (negative)
+            *value = -*value;
+
+        return position;
+    }
+
+    // strtod needs '\0' at the end, so I copy the number
+    char number[128], *endOfNumber;
+    size_t length = 0;
+
+    while (start + length < end && length < sizeof (number) - 1 &&
+            start[length] != ' ' && start[length] != '\t' && start[length] != '\r' &&
+            start[length] != '\n' && start[length] != '\v' && start[length] != '\f') {
+        number[length] = start[length];
+        length++;
+    }
+    number[length] = '\0';
+
+    *value = strtod(number, &endOfNumber);
+    if (endOfNumber == number)
+        return NULL;
+
+    return start + (endOfNumber - number);
+}
+
 /*
  * readVectorIntInputs: read numbers that are allocated as line vectors
  */
@@ -41,9 +41,18 @@ extern "C" {
 #endif
 
 #include <stdio.h>
+#include <stddef.h>
+
+    // content of a file opened by mapFileTlmbht
+
+    struct mappedFileTlmbht {
+        const char *data; // content of the file. It does not end with '\0'
+        size_t size; // quantity of characters in data
+        int mapped; // 1 - data is mapped from the file; 0 - data was read to an allocated buffer
+    };
     
     // this function makes comparison without considering for the case (upper or lower)
-    unsigned int compareCaseInsensitive(char *, char *);
+    unsigned int compareCaseInsensitive(const char *, const char *);
 
     unsigned int getUsefulContent(char *);
 
@@ -61,6 +70,16 @@ extern "C" {
     
     unsigned int getlineTlmbht(char**, long*, FILE*);
 
+    unsigned int mapFileTlmbht(const char *, struct mappedFileTlmbht *);
+
+    unsigned int unmapFileTlmbht(struct mappedFileTlmbht *);
+
+    const char *skipBlankSpacesTlmbht(const char *, const char *);
+
+    const char *scanUnsignedTlmbht(const char *, const char *, unsigned long long *);
+
+    const char *scanDoubleTlmbht(const char *, const char *, double *);
+
     unsigned int readVectorIntInputs(char *, int *, int **);
     
     unsigned int readVectorStrInputs(char *, int *, char ***);
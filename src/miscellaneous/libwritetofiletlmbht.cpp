@@ -41,10 +41,55 @@
 #include <time.h>
 
 #include <iostream>
+#include <vector>
 
 #include "libwritetofiletlmbht.h"
 #include "../solver/tlmsolver/libtlmsolvereigen.h"
 
+/*
+ * writeOutputFileHeader: writes the header of an output file with
+ * quantityOfEquations equations
+ */
+static unsigned int writeOutputFileHeader(struct dataForSimulation *input, FILE *file,
+        int quantityOfEquations) {
+
+    // the binary file only has its header here. The name and version of the
+    // software are not saved
+    if (input->simulationInput.outputFileExtension == 3) {
+        struct tmbBinaryHeader header;
+        memset(&header, 0, sizeof (struct tmbBinaryHeader));
+        memcpy(header.magic, TMB_BINARY_MAGIC, 8);
+        header.version = TMB_BINARY_VERSION;
+        header.byteOrder = 0x01020304;
+        header.bytesPerValue = input->simulationInput.outputFloat == 1 ? sizeof (float) : sizeof (double);
+        header.quantityOfEquations = quantityOfEquations;
+        if (fwrite(&header, sizeof (struct tmbBinaryHeader), 1, file) != 1) {
+            return 766;
+        }
+        return 0;
+    }
+
+    time_t t = time(NULL);
+    struct tm time_now = *localtime(&t);
+
+    // my name and my version
+    fprintf(file, "%s %s %s\n",
+            input->simulationInput.comentary_string, input->myName, input->myVersion);
+    // when this file was created
+    fprintf(file, "%s Output file created in "
+            "%d-%d-%d %d:%d:%d\n", input->simulationInput.comentary_string,
+            time_now.tm_year + 1900, time_now.tm_mon + 1,
+            time_now.tm_mday, time_now.tm_hour, time_now.tm_min, time_now.tm_sec);
+
+    fprintf(file, "%s Solved for %d equation(s)\n",
+            input->simulationInput.comentary_string, quantityOfEquations);
+    fprintf(file, "%s The variable of each equation is followed"
+            "by '_' and the number of the equation\n",
+            input->simulationInput.comentary_string);
+
+    return 0;
+}
+
 /*
  * creatOutputFile: Create the output file where the data will be saved
  * 
@@ -75,33 +120,81 @@ unsigned int creatOutputFile(struct dataForSimulation *input) {
             input->simulationInput.comentary_string = (char *) malloc(2 * sizeof (char));
             strcpy(input->simulationInput.comentary_string, "%");
             break;
+        case 3:
+            strcat(input->simulationInput.fullNameOfOutputFile, ".tmb");
+            input->simulationInput.comentary_string = (char *) malloc(3 * sizeof (char));
+            strcpy(input->simulationInput.comentary_string, "//");
+            break;
+    }
+
+    // when the simulation is restarted, the output file already has the outputs
+    // up to the checkpoint. It is cut there when the checkpoint is read
+    if (input->simulationInput.restartEquation >= 0) {
+        if ((input->simulationInput.outputFileHandler = fopen(input->simulationInput.fullNameOfOutputFile,
+                "r+b")) == NULL) {
+            return 764;
+        }
+        return 0;
     }
 
-    if ((input->simulationInput.outputFileHandler = fopen(input->simulationInput.fullNameOfOutputFile, "w")) == NULL) {
+    if ((input->simulationInput.outputFileHandler = fopen(input->simulationInput.fullNameOfOutputFile,
+            input->simulationInput.outputFileExtension == 3 ? "wb" : "w")) == NULL) {
         // error opening the file
         // sendErrorCodeAndMessage(764, nameOfFile, NULL, NULL, NULL);
         free(input->simulationInput.outputFileHandler);
         return 764;
     }
 
-    time_t t = time(NULL);
-    struct tm time_now = *localtime(&t);
+    return writeOutputFileHeader(input, input->simulationInput.outputFileHandler,
+            input->quantityOfEquationsRead);
+}
 
-    // my name and my version
-    fprintf(input->simulationInput.outputFileHandler, "%s %s %s\n",
-            input->simulationInput.comentary_string, input->myName, input->myVersion);
-    // when this file was created
-    fprintf(input->simulationInput.outputFileHandler, "%s Output file created in "
-            "%d-%d-%d %d:%d:%d\n", input->simulationInput.comentary_string,
-            time_now.tm_year + 1900, time_now.tm_mon + 1,
-            time_now.tm_mday, time_now.tm_hour, time_now.tm_min, time_now.tm_sec);
+/*
+ * writeFirstDataToFileBinary: writes the equation record of the binary output,
+ * with the same information of save_, numbers_, times_, and Points_Output_
+ */
+static unsigned int writeFirstDataToFileBinary(struct dataForSimulation *input,
+        struct calculationTLMEigen *matrices, int id) {
+
+    struct tmbEquationRecord record;
+    struct Equation *equation = &(input->equationInput[id]);
+    unsigned long long i;
+
+    memset(&record, 0, sizeof (struct tmbEquationRecord));
+    record.kind = TMB_EQUATION_RECORD;
+    record.equation = id + 1;
+    record.save[0] = equation->saveScalar && equation->saveScalarForStatistics == 0;
+    record.save[1] = equation->saveScalarBetween;
+    record.save[2] = equation->saveFlux;
+    record.numbers[0] = matrices->numbers.Nodes;
+    record.numbers[1] = matrices->numbers.Ports;
+    record.numbers[2] = matrices->numbers.Intersections;
+    record.numbers[3] = matrices->numbers.Output;
+    record.numbers[4] = matrices->numbers.Points_Output;
+    if (equation->Solv == DYNAMIC) {
+        record.dynamic = 1;
+        record.times[0] = equation->timeStep * equation->timeJump;
+        record.times[1] = equation->finalTime;
+        record.times[2] = equation->timeStep;
+        record.timeJump = equation->timeJump;
+        record.quantityOfSteps = (unsigned long long) (equation->finalTime / (
+                equation->timeStep * equation->timeJump));
+    }
+
+    // the points are saved as the lines of Points_Output_
+    std::vector<double> points(3 * matrices->numbers.Output);
+    for (i = 0; i < matrices->numbers.Output; i++) {
+        points[3 * i] = matrices->Points_output[i].x;
+        points[3 * i + 1] = matrices->Points_output[i].y;
+        points[3 * i + 2] = matrices->Points_output[i].z;
+    }
+
+    if (fwrite(&record, sizeof (struct tmbEquationRecord), 1, input->simulationInput.outputFileHandler) != 1 ||
+            fwrite(points.data(), sizeof (double), points.size(), input->simulationInput.outputFileHandler)
+            != points.size()) {
+        return 766;
+    }
 
-    fprintf(input->simulationInput.outputFileHandler, "%s Solved for %d equation(s)\n",
-            input->simulationInput.comentary_string, input->quantityOfEquationsRead);
-    fprintf(input->simulationInput.outputFileHandler, "%s The variable of each equation is followed"
-            "by '_' and the number of the equation\n",
-            input->simulationInput.comentary_string);
-    
     return 0;
 }
 
@@ -115,6 +208,11 @@ unsigned int writeFirstDataToFile(struct dataForSimulation *input,
 
     unsigned long long i;
 
+    // the equation being restarted already has its first data in the file
+    if (input->simulationInput.restartEquation == id) {
+        return 0;
+    }
+
     // this switch is used to known to what format should the void pointer be 
     // casted to.
     //
@@ -123,8 +221,13 @@ unsigned int writeFirstDataToFile(struct dataForSimulation *input,
     switch (input->equationInput[id].libraryForCalculation) {
         case EIGEN:
         { // including brackets to not let the variable 'matrices' visible to the next case
+            if (input->simulationInput.outputFileExtension == 3) {
+                return writeFirstDataToFileBinary(input, (struct calculationTLMEigen*) generalMatrix, id);
+            }
+
             fprintf(input->simulationInput.outputFileHandler, "save_%d = [%d, %d, %d];\n", id + 1,
-                    input->equationInput[id].saveScalar,
+                    input->equationInput[id].saveScalar &&
+                    input->equationInput[id].saveScalarForStatistics == 0,
                     input->equationInput[id].saveScalarBetween,
                     input->equationInput[id].saveFlux);
 
@@ -176,28 +279,68 @@ unsigned int writeFirstDataToFile(struct dataForSimulation *input,
     return 0;
 }
 
+/*
+ * writeOutputToFile: writes one column of the output (position) of the
+ * equation id in file. It only uses the file, so it can be called by the
+ * output writer thread while the solver calculates the next time-steps
+ */
+unsigned int writeOutputToFile(struct dataForSimulation *input, FILE *file, const double *output,
+        unsigned long long quantity, int id, unsigned long long position) {
+
+    unsigned long long i;
+
+    // the binary output writes the doubles directly from the output vector
+    if (input->simulationInput.outputFileExtension == 3) {
+        struct tmbOutputRecord record;
+        size_t written;
+
+        record.kind = TMB_OUTPUT_RECORD;
+        record.equation = id + 1;
+        record.position = position;
+
+        if (fwrite(&record, sizeof (struct tmbOutputRecord), 1, file) != 1) {
+            return 766;
+        }
+
+        if (input->simulationInput.outputFloat == 1) {
+            std::vector<float> values(quantity);
+            for (i = 0; i < quantity; i++)
+                values[i] = (float) output[i];
+            written = fwrite(values.data(), sizeof (float), quantity, file);
+        } else {
+            written = fwrite(output, sizeof (double), quantity, file);
+        }
+
+        return written == quantity ? 0 : 766;
+    }
+
+    fprintf(file, "\n");
+    fprintf(file, "output_%d(:,%llu) = [", id + 1, position);
+
+    for (i = 0; i < quantity; i++) {
+        fprintf(file, "\n%.17g;", output[i]);
+    }
+
+
+    fprintf(file, "];");
+    fprintf(file, "\n");
+
+    return 0;
+}
+
 /*
  * writePartialOutput: writes the output to the file
  */
 unsigned int writePartialOutput(struct dataForSimulation *input,
         void * generalMatrix, int id, unsigned long long position) {
 
-    unsigned long long i;
     switch (input->equationInput[id].libraryForCalculation) {
         case EIGEN:
         { // including brackets to not let the variable 'matrices' visible to the next case
-            fprintf(input->simulationInput.outputFileHandler, "\n");
-            fprintf(input->simulationInput.outputFileHandler, "output_%d(:,%llu) = [", id + 1, position);
-
             struct calculationTLMEigen *matrices = (struct calculationTLMEigen*) generalMatrix;
 
-            for (i = 0; i < matrices->numbers.Output; i++) {
-                fprintf(input->simulationInput.outputFileHandler, "\n%.17g;", matrices->output(i));
-            }
-
-
-            fprintf(input->simulationInput.outputFileHandler, "];");
-            fprintf(input->simulationInput.outputFileHandler, "\n");
+            return writeOutputToFile(input, input->simulationInput.outputFileHandler,
+                    matrices->output.data(), matrices->numbers.Output, id, position);
         }
             break;
 
@@ -206,4 +349,110 @@ unsigned int writePartialOutput(struct dataForSimulation *input,
     }
 
     return 0;
-}
\ No newline at end of file
+}
+
+/*
+ * writeSteadyStateToFile: records in file that the dynamic simulation of the
+ * equation id reached the steady-state at time, after position saved steps.
+ * The quantity of steps of times_ becomes position and steady_ has the time
+ * and the position
+ */
+unsigned int writeSteadyStateToFile(struct dataForSimulation *input, FILE *file, int id,
+        double time, unsigned long long position) {
+
+    if (input->simulationInput.outputFileExtension == 3) {
+        struct tmbSteadyRecord record;
+
+        memset(&record, 0, sizeof (struct tmbSteadyRecord));
+        record.kind = TMB_STEADY_RECORD;
+        record.equation = id + 1;
+        record.position = position;
+        record.time = time;
+        if (fwrite(&record, sizeof (struct tmbSteadyRecord), 1, file) != 1) {
+            return 766;
+        }
+        return 0;
+    }
+
+    fprintf(file, "\n%s Steady-state reached by equation group %d at %g s\n",
+            input->simulationInput.comentary_string, id + 1, time);
+    fprintf(file, "times_%d(5) = %llu;\n", id + 1, position);
+    fprintf(file, "steady_%d = [%.17g %llu];\n", id + 1, time, position);
+
+    return 0;
+}
+
+/*
+ * creatScenarioOutputFile: create the output file of the scenario (starting
+ * from 2; the scenario 1 is saved in the output file) or of the point of a
+ * sweep (same) of the equation id. kind is "scenario" or "sweep". Its name is
+ * the name of the output file followed by '_', kind, '_', the scenario, '_',
+ * and the number of the equation. It has the same header of the output file,
+ * but with only this equation
+ */
+unsigned int creatScenarioOutputFile(struct dataForSimulation *input, int id, const char *kind,
+        int scenario, FILE **file) {
+
+    const char *extension[] = {"", ".tmo", ".m", ".tmb"};
+    std::vector<char> name(strlen(input->simulationInput.nameOfOutputFile) + strlen(kind) + 48);
+    sprintf(name.data(), "%s_%s_%d_%d%s", input->simulationInput.nameOfOutputFile, kind,
+            scenario, id + 1, extension[input->simulationInput.outputFileExtension]);
+
+    // the file of a scenario of the equation being restarted is continued
+    if (input->simulationInput.restartEquation == id) {
+        return (*file = fopen(name.data(), "r+b")) == NULL ? 764 : 0;
+    }
+
+    if ((*file = fopen(name.data(), input->simulationInput.outputFileExtension == 3 ? "wb" : "w")) == NULL) {
+        return 764;
+    }
+
+    return writeOutputFileHeader(input, *file, 1);
+}
+
+/*
+ * creatStatisticsFile: create the text file with the statistics of the tags
+ * of the equation id. Its name is the name of the output file followed by
+ * _statistics_ and the number of the equation. It has one line for each tag
+ * in each saved step
+ */
+unsigned int creatStatisticsFile(struct dataForSimulation *input, int id, FILE **file) {
+
+    std::vector<char> name(strlen(input->simulationInput.nameOfOutputFile) + 32);
+    sprintf(name.data(), "%s_statistics_%d.csv", input->simulationInput.nameOfOutputFile, id + 1);
+
+    // the statistics of the equation being restarted are continued
+    if (input->simulationInput.restartEquation == id) {
+        return (*file = fopen(name.data(), "r+b")) == NULL ? 764 : 0;
+    }
+
+    if ((*file = fopen(name.data(), "w")) == NULL) {
+        return 764;
+    }
+
+    if (fprintf(*file, "time, tag, volume, minimum, maximum, mean, percentile %g, "
+            "volume above %g, maximum CEM43, volume above CEM43 %g\n",
+            input->equationInput[id].statisticsPercentile,
+            input->equationInput[id].statisticsThreshold,
+            input->equationInput[id].statisticsDoseThreshold) < 0) {
+        return 766;
+    }
+
+    return 0;
+}
+
+/*
+ * writeStatisticsToFile: write the line of one tag to the file of the
+ * statistics. values has the 8 columns after the time and the tag
+ */
+unsigned int writeStatisticsToFile(FILE *file, double time, unsigned long tag,
+        const double *values) {
+
+    if (fprintf(file, "%.10g, %lu, %.10g, %.10g, %.10g, %.10g, %.10g, %.10g, %.10g, %.10g\n",
+            time, tag, values[0], values[1], values[2], values[3], values[4], values[5],
+            values[6], values[7]) < 0) {
+        return 766;
+    }
+
+    return 0;
+}
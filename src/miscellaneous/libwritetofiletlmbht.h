@@ -42,6 +42,52 @@ extern "C" {
 
 #include "../configs/libconfig.h"
 
+    // binary output (output extension = tmb). The file header is followed by
+    // one equation record for each equation and by one output record for each
+    // saved step. If the dynamic simulation reached the steady-state before the
+    // final time, a steady-state record follows the last output record of the
+    // equation. The values are written as in the memory of the computer
+#define TMB_BINARY_MAGIC "TMBBIN\r\n"
+#define TMB_BINARY_VERSION 1
+#define TMB_EQUATION_RECORD 1
+#define TMB_OUTPUT_RECORD 2
+#define TMB_STEADY_RECORD 3
+
+    struct tmbBinaryHeader {
+        char magic[8]; // TMB_BINARY_MAGIC, without '\0'
+        unsigned int version; // TMB_BINARY_VERSION
+        unsigned int byteOrder; // 0x01020304, as written by the computer
+        unsigned int bytesPerValue; // of the outputs: 8 (double) or 4 (float)
+        unsigned int quantityOfEquations;
+    };
+
+    struct tmbEquationRecord {
+        // followed by numbers[3] points (x, y, z) in double: Points_Output
+        unsigned int kind; // TMB_EQUATION_RECORD
+        unsigned int equation; // starting from 1
+        int save[3]; // save_: scalar, scalar between, and vector
+        unsigned int dynamic; // 1: dynamic; 0: steady-state
+        unsigned long long numbers[5]; // numbers_: nodes, ports, intersections, outputs, and points
+        double times[3]; // times_: saved time-step, final time, and time-step. Zero if steady-state
+        unsigned long long timeJump;
+        unsigned long long quantityOfSteps;
+    };
+
+    struct tmbOutputRecord {
+        // followed by numbers[3] outputs in bytesPerValue: output_(:, position)
+        unsigned int kind; // TMB_OUTPUT_RECORD
+        unsigned int equation; // starting from 1
+        unsigned long long position; // column of output_, starting from 1
+    };
+
+    struct tmbSteadyRecord {
+        // the outputs after position were not calculated
+        unsigned int kind; // TMB_STEADY_RECORD
+        unsigned int equation; // starting from 1
+        unsigned long long position; // last column of output_, i.e., the quantity of saved steps
+        double time; // time of the last column
+    };
+
     unsigned int creatOutputFile(struct dataForSimulation *);
     
     unsigned int writeFirstDataToFile(struct dataForSimulation *, 
@@ -50,6 +96,18 @@ extern "C" {
     unsigned int writePartialOutput(struct dataForSimulation *,
         void *, int, unsigned long long);
 
+    unsigned int writeOutputToFile(struct dataForSimulation *, FILE *, const double *,
+        unsigned long long, int, unsigned long long);
+
+    unsigned int writeSteadyStateToFile(struct dataForSimulation *, FILE *, int,
+        double, unsigned long long);
+
+    unsigned int creatScenarioOutputFile(struct dataForSimulation *, int, const char *, int, FILE **);
+
+    unsigned int creatStatisticsFile(struct dataForSimulation *, int, FILE **);
+
+    unsigned int writeStatisticsToFile(FILE *, double, unsigned long, const double *);
+
 
 
 #ifdef __cplusplus
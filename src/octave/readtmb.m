@@ -0,0 +1,99 @@
+function data = readtmb(fileName)
+% readtmb: reads the binary output of tlmbht (output extension = tmb).
+%
+% data = readtmb('case.tmb') returns a structure with the variables save_n,
+% numbers_n, times_n, Points_Output_n, and output_n of each equation n, the
+% same ones of the .m output. When called without an output, readtmb creates
+% these variables in the workspace that called it, so a script that runs the
+% .m output (e.g., 'cpennes3Te') can call readtmb('cpennes3Te.tmb') instead.
+% If the dynamic simulation of the equation reached the steady-state before
+% the final time, steady_n has the time and the quantity of saved steps, and
+% output_n only has these steps.
+%
+% The file is a header followed by one equation record for each equation, by
+% one output record for each saved step, and by a steady-state record for each
+% equation that reached the steady-state (see libwritetofiletlmbht.h).
+
+fid = fopen(fileName, 'r', 'ieee-le');
+if (fid < 0)
+  error('readtmb: could not open %s', fileName);
+end
+
+magic = fread(fid, [1 8], 'char=>char');
+if (~strcmp(magic, sprintf('TMBBIN\r\n')))
+  fclose(fid);
+  error('readtmb: %s is not a tmb file', fileName);
+end
+version = fread(fid, 1, 'uint32');
+byteOrder = fread(fid, 1, 'uint32');
+if (byteOrder ~= hex2dec('01020304'))
+  % written by a big-endian computer
+  fclose(fid);
+  fid = fopen(fileName, 'r', 'ieee-be');
+  fseek(fid, 8, 'bof');
+  version = fread(fid, 1, 'uint32');
+  fread(fid, 1, 'uint32');
+end
+if (version ~= 1)
+  fclose(fid);
+  error('readtmb: unknown version %d of %s', version, fileName);
+end
+bytesPerValue = fread(fid, 1, 'uint32');
+fread(fid, 1, 'uint32'); % quantity of equations
+if (bytesPerValue == 4)
+  precision = 'single';
+else
+  precision = 'double';
+end
+
+data = struct();
+while (true)
+  kind = fread(fid, 1, 'uint32');
+  if (isempty(kind))
+    break;
+  end
+  equation = fread(fid, 1, 'uint32');
+  n = num2str(equation);
+
+  if (kind == 1)
+    save = fread(fid, [1 3], 'int32');
+    dynamic = fread(fid, 1, 'uint32');
+    numbers = fread(fid, [1 5], 'uint64');
+    times = fread(fid, [1 3], 'double');
+    timeJump = fread(fid, 1, 'uint64');
+    steps = fread(fid, 1, 'uint64');
+    data.(['save_' n]) = save;
+    data.(['numbers_' n]) = numbers;
+    if (dynamic == 1)
+      data.(['times_' n]) = [times timeJump steps];
+    else
+      steps = 1;
+    end
+    data.(['Points_Output_' n]) = fread(fid, [3 numbers(4)], 'double')';
+    data.(['output_' n]) = zeros(numbers(4), steps);
+  elseif (kind == 2)
+    position = fread(fid, 1, 'uint64');
+    outputs = data.(['numbers_' n])(4);
+    data.(['output_' n])(:, position) = fread(fid, outputs, precision);
+  elseif (kind == 3)
+    position = fread(fid, 1, 'uint64');
+    time = fread(fid, 1, 'double');
+    data.(['times_' n])(5) = position;
+    data.(['steady_' n]) = [time position];
+    data.(['output_' n]) = data.(['output_' n])(:, 1:position);
+  else
+    fclose(fid);
+    error('readtmb: unknown record %d in %s', kind, fileName);
+  end
+end
+fclose(fid);
+
+if (nargout == 0)
+  names = fieldnames(data);
+  for (i = 1:numel(names))
+    assignin('caller', names{i}, data.(names{i}));
+  end
+  clear data;
+end
+
+end
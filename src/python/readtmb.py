@@ -0,0 +1,86 @@
+"""
+readtmb: reads the binary output of tlmbht (output extension = tmb).
+
+read_tmb('case.tmb') returns a dictionary with the variables save_n,
+numbers_n, times_n, Points_Output_n, and output_n of each equation n, the
+same ones of the .m output. Points_Output_n has one line per output and
+output_n has one column per saved step. If the dynamic simulation of the
+equation reached the steady-state before the final time, steady_n has the
+time and the quantity of saved steps, and output_n only has these steps.
+
+The file is a header followed by one equation record for each equation, by
+one output record for each saved step, and by a steady-state record for each
+equation that reached the steady-state (see libwritetofiletlmbht.h).
+
+Usage from the terminal: python3 readtmb.py case.tmb
+"""
+
+import struct
+import sys
+
+import numpy as np
+
+
+def read_tmb(file_name):
+    with open(file_name, 'rb') as f:
+        content = f.read()
+
+    if content[0:8] != b'TMBBIN\r\n':
+        raise ValueError('%s is not a tmb file' % file_name)
+
+    # the byte order of the computer that wrote the file
+    order = '<'
+    if struct.unpack_from('<I', content, 12)[0] != 0x01020304:
+        order = '>'
+
+    version, _, bytes_per_value, _ = struct.unpack_from(order + '4I', content, 8)
+    if version != 1:
+        raise ValueError('unknown version %d of %s' % (version, file_name))
+    value = np.dtype(order + ('f4' if bytes_per_value == 4 else 'f8'))
+
+    data = {}
+    offset = 24
+    while offset < len(content):
+        kind, equation = struct.unpack_from(order + '2I', content, offset)
+        n = str(equation)
+
+        if kind == 1:
+            fields = struct.unpack_from(order + '2I3iI5Q3d2Q', content, offset)
+            offset += 104
+            save, dynamic = fields[2:5], fields[5]
+            numbers, times = fields[6:11], fields[11:14]
+            time_jump, steps = fields[14:16]
+            data['save_' + n] = np.array(save)
+            data['numbers_' + n] = np.array(numbers)
+            if dynamic == 1:
+                data['times_' + n] = np.array(times + (time_jump, steps))
+            else:
+                steps = 1
+            points = np.frombuffer(content, order + 'f8', 3 * numbers[3], offset)
+            offset += 24 * numbers[3]
+            data['Points_Output_' + n] = points.reshape(numbers[3], 3)
+            data['output_' + n] = np.zeros((numbers[3], steps), value)
+
+        elif kind == 2:
+            position = struct.unpack_from(order + 'Q', content, offset + 8)[0]
+            offset += 16
+            outputs = data['numbers_' + n][3]
+            data['output_' + n][:, position - 1] = np.frombuffer(content, value, outputs, offset)
+            offset += outputs * value.itemsize
+
+        elif kind == 3:
+            position, time = struct.unpack_from(order + 'Qd', content, offset + 8)
+            offset += 24
+            data['times_' + n][4] = position
+            data['steady_' + n] = np.array([time, position])
+            data['output_' + n] = data['output_' + n][:, :position]
+
+        else:
+            raise ValueError('unknown record %d in %s' % (kind, file_name))
+
+    return data
+
+
+if __name__ == '__main__':
+    for name, variable in sorted(read_tmb(sys.argv[1]).items()):
+        print('%s: %s' % (name, 'x'.join(str(s) for s in np.shape(variable))))
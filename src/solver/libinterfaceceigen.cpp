@@ -80,11 +80,9 @@ extern "C" {
      * call_from_c_initiate_matrices_calculationTLMEigen: C interface for calling
      * initiate_matrices_calculationTLMEigen()
      */
-    unsigned int call_from_c_initiate_matrices_calculationTLMEigen(void * matrices,
-            unsigned int* quantityToReserve) {
+    unsigned int call_from_c_initiate_matrices_calculationTLMEigen(void * matrices) {
 
-        return (initiate_matrices_calculationTLMEigen((struct calculationTLMEigen*) matrices,
-                quantityToReserve));
+        return (initiate_matrices_calculationTLMEigen((struct calculationTLMEigen*) matrices));
     }
 
 }
\ No newline at end of file
@@ -46,7 +46,7 @@ extern "C" {
 #include "../configs/libconfig.h"
     unsigned int call_from_c_solverEigenTLM(struct dataForSimulation*, int, void **);
 
-    unsigned int call_from_c_initiate_matrices_calculationTLMEigen(void *, unsigned int*);
+    unsigned int call_from_c_initiate_matrices_calculationTLMEigen(void *);
 
 #ifdef __cplusplus
 }
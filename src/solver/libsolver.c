@@ -32,9 +32,9 @@
  *
  */
 #include <stdlib.h>
-#include <time.h>
 
 #include "libsolver.h"
+#include "../miscellaneous/libmiscellaneous.h"
 
 #include "tlmsolver/libtlmsolver.h"
 
@@ -50,10 +50,24 @@ unsigned int solve(struct dataForSimulation *input) {
     generalMatrices = malloc(input->quantityOfEquationsRead * sizeof (void*));
 
     int i;
-    clock_t begin = clock();
+
+    // when the simulation is restarted, the equations before the one of the
+    // checkpoint were already solved
+    if ((errorTLMnumber = findCheckpointTLM(input)) != 0) {
+        free(generalMatrices);
+        return errorTLMnumber;
+    }
+
+    beginPhaseProfiler("create and solve the equations");
     // I will do a loop for each equation to configure them. The equations will
     // be solved after the configuration.
     for (i = 0; i < input->quantityOfEquationsRead; i++) {
+
+        if (i < input->simulationInput.restartEquation) {
+            printf("\nEquation group %04d was solved before the checkpoint\n", i + 1);
+            generalMatrices[i] = NULL;
+            continue;
+        }
         
         printf("\nConfiguring the solver for equation group %04d\n", i + 1);
         
@@ -130,13 +144,10 @@ unsigned int solve(struct dataForSimulation *input) {
         }
     }
 
-    clock_t end = clock();
+    double time_spent = endPhaseProfiler();
 
     if (input->simulationInput.timingMode == 1) {
-        double time_spent = (double) (end - begin) / CLOCKS_PER_SEC;
-        printf("\n\nTime to create the equations (and solve equations directly, if any "
-                "equation was solved in this category) %g ms (or %g s, or %g min, or %g hours).\n\n",
-                time_spent * 1e3, time_spent, time_spent / 60.0, time_spent / (60 * 60));
+        printTimeProfiler(time_spent, "\n\nTime to create the equations (and solve equations directly, if any equation was solved in this category)");
     }
 
     // At this point I have all the matrices calculated and ready to solve.
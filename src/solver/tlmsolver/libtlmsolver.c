@@ -35,8 +35,15 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
 #include <math.h>
 #include <time.h>
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
 #include "libtlmsolver.h"
 #include "../../miscellaneous/liberrorcode.h"
@@ -113,6 +120,20 @@ unsigned int terminateBoundaryTypeAndData(struct boundaryData **input,
     return 0;
 }
 
+// up to this quantity of points, a level of the connection variable is searched
+// linearly
+static unsigned long long linearSearch_connectionLeveln = CONNECTION_LINEAR_SEARCH;
+
+/*
+ * setLinearSearch_connectionLeveln: sets up to which quantity of points a level
+ * of the connection variable is searched linearly. With ULLONG_MAX, no level
+ * gets a hash table, which is how the connections were built before them. The
+ * benchmark uses it to compare both.
+ */
+void setLinearSearch_connectionLeveln(unsigned long long quantity) {
+    linearSearch_connectionLeveln = quantity;
+}
+
 /*
  * initiate_connectionLeveln: allocate in memory the variable
  * that will hold the connections.
@@ -125,6 +146,8 @@ unsigned int initiate_connectionLeveln(struct connectionLeveln *con,
     con->quantitySaved = 0;
     con->quantityAllocated = allocateForEachLevel[0];
     con->accumulatedIntersections = NULL;
+    con->pointIndex = NULL;
+    con->pointIndexSize = 0;
     // DEBUG: show allocate for each
     //        printf("Allocate for each %llu (%llu). Level %u. Pointer address %p \n",
     //                allocateForEachLevel[0], con->quantityAllocated, con->level, con);
@@ -216,6 +239,49 @@ unsigned int reallocate_connectionLeveln(struct connectionLeveln *con, unsigned
     return 0;
 }
 
+/*
+ * hashPoint_connectionLeveln: position of a point in the hash table of a level
+ * of the connection variable. size must be a power of two.
+ */
+static unsigned long long hashPoint_connectionLeveln(unsigned long long point,
+        unsigned long long size) {
+    // Fibonacci hashing. The points are node numbers, which are mostly
+    // sequential, so I mix them before taking the bits of the table
+    return ((point * 0x9E3779B97F4A7C15ULL) >> 32) & (size - 1);
+}
+
+/*
+ * index_connectionLeveln: (re)build the hash table of a level of the connection
+ * variable with, at least, four times the quantity of points saved. I keep the
+ * load below 1/2, so the linear probing finds a point in a few steps.
+ */
+static unsigned int index_connectionLeveln(struct connectionLeveln *con) {
+    unsigned int errorTLMnumber = 0;
+    unsigned long long i, h, size = 1;
+
+    while (size < 4 * con->quantitySaved)
+        size *= 2;
+
+    free(con->pointIndex);
+    if ((con->pointIndex = (unsigned long long*) calloc(size,
+            sizeof (unsigned long long))) == NULL) {
+        errorTLMnumber = 8692;
+        sendErrorCodeAndMessage(errorTLMnumber, &(con->level), &size, NULL, NULL);
+        return errorTLMnumber;
+    }
+    con->pointIndexSize = size;
+
+    for (i = 0; i < con->quantitySaved; i++) {
+        h = hashPoint_connectionLeveln(con->portsOrPoints[i], size);
+        while (con->pointIndex[h] != 0)
+            h = (h + 1) & (size - 1);
+        // I save the position + 1, so 0 is an empty slot
+        con->pointIndex[h] = i + 1;
+    }
+
+    return 0;
+}
+
 /*
  * add_to_connectionLeveln: add a value in the variable that has the connections
  */
@@ -223,7 +289,7 @@ unsigned int add_to_connectionLeveln(struct connectionLeveln * con,
         unsigned long long* Points,
         unsigned int quantityOfPortsToAdd, unsigned long long* numberOfPortsToAdd) {
     unsigned int errorTLMnumber = 0, newInterception = 0;
-    unsigned long long PointToSave = 0, i;
+    unsigned long long PointToSave = 0, i, h = 0;
     // if the quantity of points is less than the level that we are, then, we
     // access an special point number, which is number zero (initial value). Point number zero
     // indicates the intersections that do not involve those levels.
@@ -238,10 +304,23 @@ unsigned int add_to_connectionLeveln(struct connectionLeveln * con,
 
         // did I find matching points? If I find a matching point, then, I call
         // this function recursively. If I did not find a matching point, then,
-        // I execute the code after the for (i.e., on the goto)
-        for (i = 0; i < con->quantitySaved; i++) {
-            if (con->portsOrPoints[i] == PointToSave) {
-                goto get_out_if;
+        // I execute the code after the search (i.e., on the goto).
+        // Levels with few points are searched linearly. The others have a
+        // hash table, so building the connections is O(n) instead of O(n^2)
+        if (con->pointIndex != NULL) {
+            h = hashPoint_connectionLeveln(PointToSave, con->pointIndexSize);
+            while (con->pointIndex[h] != 0) {
+                i = con->pointIndex[h] - 1;
+                if (con->portsOrPoints[i] == PointToSave) {
+                    goto get_out_if;
+                }
+                h = (h + 1) & (con->pointIndexSize - 1);
+            }
+        } else {
+            for (i = 0; i < con->quantitySaved; i++) {
+                if (con->portsOrPoints[i] == PointToSave) {
+                    goto get_out_if;
+                }
             }
         }
 
@@ -263,6 +342,14 @@ unsigned int add_to_connectionLeveln(struct connectionLeveln * con,
         // flag to indicate that this is a new interception point
         newInterception = 1;
 
+        // updating the hash table. h is the empty slot where the search stopped
+        if (con->pointIndex != NULL && 2 * con->quantitySaved <= con->pointIndexSize) {
+            con->pointIndex[h] = con->quantitySaved;
+        } else if (con->quantitySaved > linearSearch_connectionLeveln) {
+            if ((errorTLMnumber = index_connectionLeveln(con)) != 0)
+                return errorTLMnumber;
+        }
+
 get_out_if:
 
         errorTLMnumber = add_to_connectionLeveln(&(con->innerLevel[i]), Points,
@@ -307,6 +394,11 @@ unsigned int wrap_size_connectionLeveln(struct connectionLeveln *con) {
     unsigned int errorTLMnumber;
     unsigned long long i;
 
+    // the hash table is only needed while adding points
+    free(con->pointIndex);
+    con->pointIndex = NULL;
+    con->pointIndexSize = 0;
+
     // if quantity saved = 0, then I deallocate everything. Otherwise, only
     // deallocate what was not used
     if (con->quantitySaved != 0) {
@@ -417,6 +509,10 @@ unsigned int terminate_connectionLeveln(struct connectionLeveln *con) {
 
         free(con->accumulatedIntersections);
         con->accumulatedIntersections = NULL;
+
+        free(con->pointIndex);
+        con->pointIndex = NULL;
+        con->pointIndexSize = 0;
     }
 
 
@@ -471,21 +567,30 @@ unsigned int getPortsOrPoints(struct connectionLeveln *con,
         return 0;
     }
 
-    // going to an inner level if this is not the level 0
-    for (unsigned long long i = 0; i < con->quantitySaved; i++) {
-        // I will go to the level where position is at most equal to the 
-        // highest number of that level
-        if (position < con->accumulatedIntersections[i + 1]) {
-            // if I'm going to a position greater than position 0, I need to 
-            // wrap the value of position. I do this by removing the accumulated
-            // value of the anterior position
-            if (i > 0)
-                position = position - con->accumulatedIntersections[i];
-            
-            return getPortsOrPoints(&(con->innerLevel[i]), position,
-                    output);
-        }
+    // going to an inner level if this is not the level 0.
+    // I will go to the level where position is at most equal to the
+    // highest number of that level. accumulatedIntersections is increasing,
+    // so I find it with a binary search over positions 1 to quantitySaved
+    unsigned long long low = 0, high = con->quantitySaved, middle;
+    while (low < high) {
+        middle = low + (high - low) / 2;
+        if (position < con->accumulatedIntersections[middle + 1])
+            high = middle;
+        else
+            low = middle + 1;
     }
+
+    if (low == con->quantitySaved)
+        return 0;
+
+    // if I'm going to a position greater than position 0, I need to
+    // wrap the value of position. I do this by removing the accumulated
+    // value of the anterior position
+    if (low > 0)
+        position = position - con->accumulatedIntersections[low];
+
+    return getPortsOrPoints(&(con->innerLevel[low]), position,
+            output);
 }
 
 /*
@@ -1342,7 +1447,7 @@ unsigned int getTLMnumbers(const struct dataForSimulation * input,
     if (input->simulationInput.verboseMode == 1) {
         printf("Initiating TLM numbers... \n");
     }
-    unsigned int errorTLMnumber = 0, flag, flagStub, j, k, l, quantityOfPortsToAdd;
+    unsigned int errorTLMnumber = 0, flag, flagStub, j, l, quantityOfPortsToAdd = 0;
     // flag:
     // 0 - Undefined (not a boundary neither a material)
     // 1 - Boundary element
@@ -1368,18 +1473,18 @@ unsigned int getTLMnumbers(const struct dataForSimulation * input,
     unsigned long tag;
 
 
-    clock_t begin_iN = clock();
+    beginPhaseProfiler("allocate the numbers");
     // initiate the TLM numbers
-    if ((errorTLMnumber = initiateTLMnumbers(numbers)) != 0)
+    if ((errorTLMnumber = initiateTLMnumbers(numbers)) != 0) {
+        endPhaseProfiler();
         return errorTLMnumber;
-    clock_t end_iN = clock();
+    }
+    double time_spent_iN = endPhaseProfiler();
 
     if (input->simulationInput.verboseMode == 1) {
         printf("Done initiating the TLM numbers\n");
         if (input->simulationInput.timingMode == 1) {
-            double time_spent_iN = (double) (end_iN - begin_iN) / CLOCKS_PER_SEC;
-            printf("Time to allocate the numbers %g ms (or %g s, or %g min, or %g hours).\n",
-                    time_spent_iN * 1e3, time_spent_iN, time_spent_iN / 60.0, time_spent_iN / (60 * 60));
+            printTimeProfiler(time_spent_iN, "Time to allocate the numbers");
         }
     }
     // initiate the variable that will be used to convert the abstract number of the port
@@ -1392,27 +1497,25 @@ unsigned int getTLMnumbers(const struct dataForSimulation * input,
     if (input->simulationInput.verboseMode == 1) {
         printf("Initiating the converter from abstract number to real number...\n");
     }
-    clock_t begin_ar = clock();
+    beginPhaseProfiler("allocate the converter from Abstract number to Real number");
     if ((errorTLMnumber = initiate_aPortToRealPort(input, &(numbers->abstractPortsToReal), id)) != 0) {
+        endPhaseProfiler();
         return errorTLMnumber;
     }
-    clock_t end_ar = clock();
+    double time_spent_ar = endPhaseProfiler();
 
     if (input->simulationInput.verboseMode == 1) {
         printf("Done initiating the converter from abstract number to real number.\n");
 
         if (input->simulationInput.timingMode == 1) {
-            double time_spent_ar = (double) (end_ar - begin_ar) / CLOCKS_PER_SEC;
-
-            printf("Time to allocate the converter from Abstract number to Real number %g ms (or %g s, or %g min, or %g hours).\n",
-                    time_spent_ar * 1e3, time_spent_ar, time_spent_ar / 60.0, time_spent_ar / (60 * 60));
+            printTimeProfiler(time_spent_ar, "Time to allocate the converter from Abstract number to Real number");
         }
     }
 
     if (input->simulationInput.verboseMode == 1) {
         printf("Allocating and saving connection positions in memory...\n");
     }
-    clock_t begin_al = clock();
+    beginPhaseProfiler("allocate and save connection positions in memory");
     // this loop can be fully parallelized given that the accesses to the
     // functions below are synchronized. Maybe OpenMP would be a better approach
     // here given that this function is not expected to by very heavy. I think
@@ -1427,8 +1530,7 @@ unsigned int getTLMnumbers(const struct dataForSimulation * input,
         for (i = 0; i < input->mesh.quantityOfSpecificElement[l]; i++) {
             // l: element type level
             // i: element level
-            // j: boundary and material type level
-            // k: different tag numbers for the same boundary type
+            // j: number of the boundary or material of the element
 
             // DEBUG: show the number of the element an its quantity
             // printf("Element code %d, elements %lld of %lld \n", l, i+1, 
@@ -1437,7 +1539,7 @@ unsigned int getTLMnumbers(const struct dataForSimulation * input,
             flag = 0;
             flagStub = 0;
 
-            // get the tag number of this element and use the inner two for-loops to
+            // get the tag number of this element and use the table of tags to
             // see if it is a material or a boundary
             switch (l) {
                 case 1: // 2 nodes line
@@ -1467,50 +1569,25 @@ unsigned int getTLMnumbers(const struct dataForSimulation * input,
             }
 
 
-            // I will use goto to get out of these two inner 'for' loops. Bare in mind
-            // that I'm just getting out the loops. You can also think that 
-            // I'm going to the next 'i', that is, incrementing i by 1 and going
-            // to the next value of i (if any).
-            for (j = 0; j < input->equationInput[id].numberOfBoundaries; j++)
-                for (k = 0; k < input->boundaryInput[ input->equationInput[id].boundaryNumbers[j] ].quantityOfNumberInput; k++) {
-                    // checking if this is a boundary
-                    if (tag == input->boundaryInput[ input->equationInput[id].boundaryNumbers[j] ].numberInput[k]) {
-                        flag = 1;
-                        temp[0] = 0; // flag that indicates that this is a boundary
-                        temp[1] = input->equationInput[id].boundaryNumbers[j]; // number of the boundary
-                        quantityOfPortsToAdd = 2; // we add two ports
-                        numbers->BoundaryElements[l]++; // increment the number of boundary elements
-                        // DEBUG: show where we were
-                        //                        printf("We were at Boundary (%u, %llu, %u, %u) total %llu\n",
-                        //                                l, i, j, k, numbers->BoundaryElements[l]);
-
-                        goto end_for_j_and_for_k_line;
-                    }
-                }
-
-            // I will get here if the element was not a boundary
-            for (j = 0; j < input->equationInput[id].numberOfMaterials; j++)
-                for (k = 0; k < input->materialInput[ input->equationInput[id].materialNumbers[j] ].quantityOfNumberInput; k++) {
-
-                    if (tag == input->materialInput[ input->equationInput[id].materialNumbers[j] ].numberInput[k]) {
-                        flag = 2;
-                        // I will probably have to modify this part when I code to solve for parameters that change
-                        if (input->materialInput[ input->equationInput[id].materialNumbers[j] ].generalized_relaxationTime != 0) {
-                            flagStub = 1;
-                        }
-                        quantityOfPortsToAdd = 1;
-                        numbers->MaterialElements[l]++;
-                        // DEBUG: show where we were
-                        //                        printf("We were at Material (%u, %llu, %u, %u) total %llu\n",
-                        //                                l, i, j, k, numbers->MaterialElements[l]);
-                        goto end_for_j_and_for_k_line;
+            // the table of tags says if this is a boundary or a material
+            switch (flag = getTagTLMnumbers(numbers, tag, &j)) {
+                case 1:
+                    temp[0] = 0; // flag that indicates that this is a boundary
+                    temp[1] = j; // number of the boundary
+                    quantityOfPortsToAdd = 2; // we add two ports
+                    numbers->BoundaryElements[l]++; // increment the number of boundary elements
+                    break;
+                case 2:
+                    // I will probably have to modify this part when I code to solve for parameters that change
+                    if (input->materialInput[j].generalized_relaxationTime != 0) {
+                        flagStub = 1;
                     }
-                }
-
+                    quantityOfPortsToAdd = 1;
+                    numbers->MaterialElements[l]++;
+                    break;
+            }
 
-end_for_j_and_for_k_line:
-            // we only get here if the node was detected as boundary or material.
-            // Otherwise, flag = 0;
+            // flag is 0 if the node is neither a boundary nor a material
             if (flag != 0) {
                 switch (l) {
                     case 1: // 2 nodes line
@@ -1530,6 +1607,7 @@ end_for_j_and_for_k_line:
                                         numbers->Intersections++;
                                         errorTLMnumber = 0;
                                     } else {
+                                        endPhaseProfiler();
                                         return errorTLMnumber;
                                     }
                                 }
@@ -1544,6 +1622,7 @@ end_for_j_and_for_k_line:
                                         numbers->Intersections++;
                                         errorTLMnumber = 0;
                                     } else {
+                                        endPhaseProfiler();
                                         return errorTLMnumber;
                                     }
                                 }
@@ -1568,6 +1647,7 @@ end_for_j_and_for_k_line:
                                         numbers->Intersections++;
                                         errorTLMnumber = 0;
                                     } else {
+                                        endPhaseProfiler();
                                         return errorTLMnumber;
                                     }
                                 }
@@ -1597,6 +1677,7 @@ end_for_j_and_for_k_line:
                                         numbers->Intersections++;
                                         errorTLMnumber = 0;
                                     } else {
+                                        endPhaseProfiler();
                                         return errorTLMnumber;
                                     }
                                 }
@@ -1613,6 +1694,7 @@ end_for_j_and_for_k_line:
                                         numbers->Intersections++;
                                         errorTLMnumber = 0;
                                     } else {
+                                        endPhaseProfiler();
                                         return errorTLMnumber;
                                     }
                                 }
@@ -1629,6 +1711,7 @@ end_for_j_and_for_k_line:
                                         numbers->Intersections++;
                                         errorTLMnumber = 0;
                                     } else {
+                                        endPhaseProfiler();
                                         return errorTLMnumber;
                                     }
                                 }
@@ -1653,6 +1736,7 @@ end_for_j_and_for_k_line:
                                         numbers->Intersections++;
                                         errorTLMnumber = 0;
                                     } else {
+                                        endPhaseProfiler();
                                         return errorTLMnumber;
                                     }
                                 }
@@ -1685,6 +1769,7 @@ end_for_j_and_for_k_line:
                                         numbers->Intersections++;
                                         errorTLMnumber = 0;
                                     } else {
+                                        endPhaseProfiler();
                                         return errorTLMnumber;
                                     }
                                 }
@@ -1701,6 +1786,7 @@ end_for_j_and_for_k_line:
                                         numbers->Intersections++;
                                         errorTLMnumber = 0;
                                     } else {
+                                        endPhaseProfiler();
                                         return errorTLMnumber;
                                     }
                                 }
@@ -1717,6 +1803,7 @@ end_for_j_and_for_k_line:
                                         numbers->Intersections++;
                                         errorTLMnumber = 0;
                                     } else {
+                                        endPhaseProfiler();
                                         return errorTLMnumber;
                                     }
                                 }
@@ -1733,6 +1820,7 @@ end_for_j_and_for_k_line:
                                         numbers->Intersections++;
                                         errorTLMnumber = 0;
                                     } else {
+                                        endPhaseProfiler();
                                         return errorTLMnumber;
                                     }
                                 }
@@ -1759,6 +1847,7 @@ end_for_j_and_for_k_line:
                                         numbers->Intersections++;
                                         errorTLMnumber = 0;
                                     } else {
+                                        endPhaseProfiler();
                                         return errorTLMnumber;
                                     }
                                 }
@@ -1792,6 +1881,7 @@ end_for_j_and_for_k_line:
                                         numbers->Intersections++;
                                         errorTLMnumber = 0;
                                     } else {
+                                        endPhaseProfiler();
                                         return errorTLMnumber;
                                     }
                                 }
@@ -1809,6 +1899,7 @@ end_for_j_and_for_k_line:
                                         numbers->Intersections++;
                                         errorTLMnumber = 0;
                                     } else {
+                                        endPhaseProfiler();
                                         return errorTLMnumber;
                                     }
                                 }
@@ -1826,6 +1917,7 @@ end_for_j_and_for_k_line:
                                         numbers->Intersections++;
                                         errorTLMnumber = 0;
                                     } else {
+                                        endPhaseProfiler();
                                         return errorTLMnumber;
                                     }
                                 }
@@ -1843,6 +1935,7 @@ end_for_j_and_for_k_line:
                                         numbers->Intersections++;
                                         errorTLMnumber = 0;
                                     } else {
+                                        endPhaseProfiler();
                                         return errorTLMnumber;
                                     }
                                 }
@@ -1876,6 +1969,7 @@ end_for_j_and_for_k_line:
                                         numbers->Intersections++;
                                         errorTLMnumber = 0;
                                     } else {
+                                        endPhaseProfiler();
                                         return errorTLMnumber;
                                     }
                                 }
@@ -1894,6 +1988,7 @@ end_for_j_and_for_k_line:
                                         numbers->Intersections++;
                                         errorTLMnumber = 0;
                                     } else {
+                                        endPhaseProfiler();
                                         return errorTLMnumber;
                                     }
                                 }
@@ -1912,6 +2007,7 @@ end_for_j_and_for_k_line:
                                         numbers->Intersections++;
                                         errorTLMnumber = 0;
                                     } else {
+                                        endPhaseProfiler();
                                         return errorTLMnumber;
                                     }
                                 }
@@ -1930,6 +2026,7 @@ end_for_j_and_for_k_line:
                                         numbers->Intersections++;
                                         errorTLMnumber = 0;
                                     } else {
+                                        endPhaseProfiler();
                                         return errorTLMnumber;
                                     }
                                 }
@@ -1948,6 +2045,7 @@ end_for_j_and_for_k_line:
                                         numbers->Intersections++;
                                         errorTLMnumber = 0;
                                     } else {
+                                        endPhaseProfiler();
                                         return errorTLMnumber;
                                     }
                                 }
@@ -1966,6 +2064,7 @@ end_for_j_and_for_k_line:
                                         numbers->Intersections++;
                                         errorTLMnumber = 0;
                                     } else {
+                                        endPhaseProfiler();
                                         return errorTLMnumber;
                                     }
                                 }
@@ -2005,6 +2104,7 @@ end_for_j_and_for_k_line:
                                         numbers->Intersections++;
                                         errorTLMnumber = 0;
                                     } else {
+                                        endPhaseProfiler();
                                         return errorTLMnumber;
                                     }
                                 }
@@ -2023,6 +2123,7 @@ end_for_j_and_for_k_line:
                                         numbers->Intersections++;
                                         errorTLMnumber = 0;
                                     } else {
+                                        endPhaseProfiler();
                                         return errorTLMnumber;
                                     }
                                 }
@@ -2040,6 +2141,7 @@ end_for_j_and_for_k_line:
                                         numbers->Intersections++;
                                         errorTLMnumber = 0;
                                     } else {
+                                        endPhaseProfiler();
                                         return errorTLMnumber;
                                     }
                                 }
@@ -2057,6 +2159,7 @@ end_for_j_and_for_k_line:
                                         numbers->Intersections++;
                                         errorTLMnumber = 0;
                                     } else {
+                                        endPhaseProfiler();
                                         return errorTLMnumber;
                                     }
                                 }
@@ -2074,6 +2177,7 @@ end_for_j_and_for_k_line:
                                         numbers->Intersections++;
                                         errorTLMnumber = 0;
                                     } else {
+                                        endPhaseProfiler();
                                         return errorTLMnumber;
                                     }
                                 }
@@ -2106,6 +2210,7 @@ end_for_j_and_for_k_line:
                                         numbers->Intersections++;
                                         errorTLMnumber = 0;
                                     } else {
+                                        endPhaseProfiler();
                                         return errorTLMnumber;
                                     }
                                 }
@@ -2125,31 +2230,32 @@ end_for_j_and_for_k_line:
             }
 
             if ((errorTLMnumber =
-                    add_to_aPortToRealPort(flag, flagStub, j, &(numbers->abstractPortsToReal[l]))) != 0)
+                    add_to_aPortToRealPort(flag, flagStub, i, &(numbers->abstractPortsToReal[l]))) != 0) {
                 // add_to_a[bstract]PortToRealPort. I add the number of the node
+                endPhaseProfiler();
                 return errorTLMnumber;
+            }
         }
     }
 
-    clock_t end_al = clock();
+    double time_spent_al = endPhaseProfiler();
     if (input->simulationInput.verboseMode == 1) {
         printf("Done allocating and saving connection positions in memory.\n");
         if (input->simulationInput.timingMode == 1) {
-            double time_spent_al = (double) (end_al - begin_al) / CLOCKS_PER_SEC;
-
-            printf("Time to allocate and save connection positions in memory %g ms (or %g s, or %g min, or %g hours).\n",
-                    time_spent_al * 1e3, time_spent_al, time_spent_al / 60.0, time_spent_al / (60 * 60));
+            printTimeProfiler(time_spent_al, "Time to allocate and save connection positions in memory");
         }
     }
 
     if (input->simulationInput.verboseMode == 1) {
         printf("Wrapping the TLM numbers...\n");
     }
-    clock_t begin_wN = clock();
+    beginPhaseProfiler("wrap the numbers");
     // wrap the TLM numbers, taking away points that are not needed
-    if ((errorTLMnumber = wrapTLMnumbers(input, numbers, id)) != 0)
+    if ((errorTLMnumber = wrapTLMnumbers(input, numbers, id)) != 0) {
+        endPhaseProfiler();
         return errorTLMnumber;
-    clock_t end_wN = clock();
+    }
+    double time_spent_wN = endPhaseProfiler();
     // if number of nodes is equal to zero, it did not find any material elements
     // associated with the tags provided
     if (numbers->Nodes == 0)
@@ -2159,29 +2265,25 @@ end_for_j_and_for_k_line:
     if (input->simulationInput.verboseMode == 1) {
         printf("Done wrapping the TLM numbers.\n");
         if (input->simulationInput.timingMode == 1) {
-            double time_spent_wN = (double) (end_wN - begin_wN) / CLOCKS_PER_SEC;
-
-            printf("Time to wrap the numbers %g ms (or %g s, or %g min, or %g hours).\n",
-                    time_spent_wN * 1e3, time_spent_wN, time_spent_wN / 60.0, time_spent_wN / (60 * 60));
+            printTimeProfiler(time_spent_wN, "Time to wrap the numbers");
         }
     }
 
     if (input->simulationInput.verboseMode == 1) {
         printf("Wrapping the connection variable...\n");
     }
-    clock_t begin_wC = clock();
+    beginPhaseProfiler("wrap the connection");
     // now that we have the connections, we can wrap the intersection variable
-    if ((errorTLMnumber = wrap_size_connectionLeveln(intersections)) != 0)
+    if ((errorTLMnumber = wrap_size_connectionLeveln(intersections)) != 0) {
+        endPhaseProfiler();
         return errorTLMnumber;
-    clock_t end_wC = clock();
+    }
+    double time_spent_wC = endPhaseProfiler();
 
     if (input->simulationInput.verboseMode == 1) {
         printf("Done wrapping connection variable.\n");
         if (input->simulationInput.timingMode == 1) {
-            double time_spent_wC = (double) (end_wC - begin_wC) / CLOCKS_PER_SEC;
-
-            printf("Time to wrap the connection %g ms (or %g s, or %g min, or %g hours).\n",
-                    time_spent_wC * 1e3, time_spent_wC, time_spent_wC / 60.0, time_spent_wC / (60 * 60));
+            printTimeProfiler(time_spent_wC, "Time to wrap the connection");
         }
     }
 
@@ -2231,9 +2333,751 @@ unsigned int terminateTLMnumbers(struct TLMnumbers* numbers) {
     free(numbers->NotDefinedElements);
     numbers->NotDefinedElements = NULL;
 
+    free(numbers->tagCode);
+    numbers->tagCode = NULL;
+
+    free(numbers->tagSorted);
+    numbers->tagSorted = NULL;
+    numbers->tagQuantity = 0;
+
     terminate_aPortToRealPort(&(numbers->abstractPortsToReal));
 }
 
+/*
+ * initiateTagsTLMnumbers: create the table that gives the boundary or material
+ * of each tag of equation id, so the elements do not have to scan all the
+ * boundaries and materials of the equation. As in getTLMnumbers, the boundaries
+ * come before the materials and the first definition of a tag is the one kept
+ */
+unsigned int initiateTagsTLMnumbers(const struct dataForSimulation * input,
+        struct TLMnumbers* numbers, int id) {
+
+    unsigned long long quantity = 0, n = 0, q = 0, first, last, middle;
+    unsigned int j, k, number, *code;
+    long long *tag, maximum = 0;
+
+    numbers->tagMinimum = 0;
+    numbers->tagQuantity = 0;
+    numbers->tagCode = NULL;
+    numbers->tagSorted = NULL;
+
+    for (j = 0; j < input->equationInput[id].numberOfBoundaries; j++)
+        quantity += input->boundaryInput[ input->equationInput[id].boundaryNumbers[j] ].quantityOfNumberInput;
+    for (j = 0; j < input->equationInput[id].numberOfMaterials; j++)
+        quantity += input->materialInput[ input->equationInput[id].materialNumbers[j] ].quantityOfNumberInput;
+    if (quantity == 0) {
+        return 0;
+    }
+
+    // all the tags and their codes, in the order they are checked
+    tag = (long long *) malloc(sizeof (long long)*quantity);
+    code = (unsigned int *) malloc(sizeof (unsigned int)*quantity);
+    if (tag == NULL || code == NULL) {
+        free(tag);
+        free(code);
+        return 8754;
+    }
+    for (j = 0; j < input->equationInput[id].numberOfBoundaries; j++) {
+        number = input->equationInput[id].boundaryNumbers[j];
+        for (k = 0; k < input->boundaryInput[number].quantityOfNumberInput; k++) {
+            tag[n] = input->boundaryInput[number].numberInput[k];
+            code[n++] = 4 * number + 1;
+        }
+    }
+    for (j = 0; j < input->equationInput[id].numberOfMaterials; j++) {
+        number = input->equationInput[id].materialNumbers[j];
+        for (k = 0; k < input->materialInput[number].quantityOfNumberInput; k++) {
+            tag[n] = input->materialInput[number].numberInput[k];
+            code[n++] = 4 * number + 2;
+        }
+    }
+    numbers->tagMinimum = tag[0];
+    maximum = tag[0];
+    for (n = 1; n < quantity; n++) {
+        if (tag[n] < numbers->tagMinimum)
+            numbers->tagMinimum = tag[n];
+        if (tag[n] > maximum)
+            maximum = tag[n];
+    }
+
+    if (maximum - numbers->tagMinimum < TAGS_DENSE_MAXIMUM) {
+        // the table is indexed by the tag
+        numbers->tagQuantity = maximum - numbers->tagMinimum + 1;
+        if ((numbers->tagCode = (unsigned int *) calloc(numbers->tagQuantity,
+                sizeof (unsigned int))) == NULL) {
+            free(tag);
+            free(code);
+            return 8754;
+        }
+        for (n = 0; n < quantity; n++) {
+            if (numbers->tagCode[tag[n] - numbers->tagMinimum] == 0)
+                numbers->tagCode[tag[n] - numbers->tagMinimum] = code[n];
+        }
+    } else {
+        // the tags are sorted. A tag that is already there is not inserted again
+        numbers->tagCode = (unsigned int *) malloc(sizeof (unsigned int)*quantity);
+        numbers->tagSorted = (long long *) malloc(sizeof (long long)*quantity);
+        if (numbers->tagCode == NULL || numbers->tagSorted == NULL) {
+            free(tag);
+            free(code);
+            return 8754;
+        }
+        for (n = 0; n < quantity; n++) {
+            first = 0;
+            last = q;
+            while (first < last) {
+                middle = first + (last - first) / 2;
+                if (numbers->tagSorted[middle] < tag[n])
+                    first = middle + 1;
+                else
+                    last = middle;
+            }
+            if (first < q && numbers->tagSorted[first] == tag[n])
+                continue;
+            for (middle = q; middle > first; middle--) {
+                numbers->tagSorted[middle] = numbers->tagSorted[middle - 1];
+                numbers->tagCode[middle] = numbers->tagCode[middle - 1];
+            }
+            numbers->tagSorted[first] = tag[n];
+            numbers->tagCode[first] = code[n];
+            q++;
+        }
+        numbers->tagQuantity = q;
+    }
+
+    free(tag);
+    free(code);
+
+    return 0;
+}
+
+/*
+ * getTagTLMnumbers: returns 1 if the tag is a boundary of the equation, 2 if it
+ * is a material, and 0 if it is not defined. number gets the number of the
+ * boundary (in boundaryInput) or of the material (in materialInput)
+ */
+unsigned int getTagTLMnumbers(const struct TLMnumbers* numbers, unsigned long tag,
+        unsigned int *number) {
+
+    unsigned long long first = 0, last = numbers->tagQuantity, middle;
+    unsigned int code = 0;
+
+    if (numbers->tagSorted == NULL) {
+        if ((long long) tag >= numbers->tagMinimum &&
+                (unsigned long long) ((long long) tag - numbers->tagMinimum) < numbers->tagQuantity)
+            code = numbers->tagCode[(long long) tag - numbers->tagMinimum];
+    } else {
+        while (first < last) {
+            middle = first + (last - first) / 2;
+            if (numbers->tagSorted[middle] < (long long) tag)
+                first = middle + 1;
+            else
+                last = middle;
+        }
+        if (first < numbers->tagQuantity && numbers->tagSorted[first] == (long long) tag)
+            code = numbers->tagCode[first];
+    }
+
+    *number = code / 4;
+    return code % 4;
+}
+
+/*
+ * hashTopologyCacheTLM: mixes size bytes of data into the hash of the topology
+ * cache. It is FNV-1a, but with 8 bytes at a time because the mesh is large
+ */
+static unsigned long long hashTopologyCacheTLM(unsigned long long hash,
+        const void *data, size_t size) {
+    const unsigned char *bytes = (const unsigned char *) data;
+    unsigned long long word;
+    size_t i;
+
+    for (i = 0; i + sizeof (word) <= size; i += sizeof (word)) {
+        memcpy(&word, bytes + i, sizeof (word));
+        hash = (hash ^ word) * 1099511628211ULL;
+        hash ^= hash >> 32;
+    }
+    for (; i < size; i++)
+        hash = (hash ^ bytes[i]) * 1099511628211ULL;
+
+    return hash;
+}
+
+/*
+ * keyTopologyCacheTLM: returns the key of the topology cache of equation id.
+ * It is the hash of the mesh and of everything that getTLMnumbers uses from the
+ * equation: the dimensions, the type, what is saved, and the tags of each
+ * boundary and material (and if the material has stubs)
+ */
+unsigned long long keyTopologyCacheTLM(const struct dataForSimulation * input, int id) {
+    const struct Equation *equation = &input->equationInput[id];
+    struct tlmInternalMesh *mesh = (struct tlmInternalMesh *) &input->mesh;
+    unsigned long long hash = 14695981039346656037ULL, size;
+    int j, number, value[5];
+
+    hash = hashTopologyCacheTLM(hash, &mesh->numberOfNode, sizeof (unsigned long long));
+    hash = hashTopologyCacheTLM(hash, mesh->nodes, sizeof (struct node)*mesh->numberOfNode);
+    hash = hashTopologyCacheTLM(hash, mesh->quantityOfSpecificElement, sizeof (unsigned long long)*100);
+    for (j = 0; j < 100; j++) {
+        size = sizeOfElementTlmInternalMesh(j);
+        if (size != 0 && mesh->quantityOfSpecificElement[j] != 0)
+            hash = hashTopologyCacheTLM(hash, elementArrayTlmInternalMesh(mesh, j),
+                size * mesh->quantityOfSpecificElement[j]);
+    }
+
+    value[0] = equation->dimen;
+    value[1] = equation->typeS;
+    value[2] = equation->saveScalar;
+    value[3] = equation->saveScalarBetween;
+    value[4] = equation->saveFlux;
+    hash = hashTopologyCacheTLM(hash, value, sizeof (value));
+
+    for (j = 0; j < equation->numberOfBoundaries; j++) {
+        number = equation->boundaryNumbers[j];
+        value[0] = number;
+        value[1] = input->boundaryInput[number].quantityOfNumberInput;
+        hash = hashTopologyCacheTLM(hash, value, 2 * sizeof (int));
+        hash = hashTopologyCacheTLM(hash, input->boundaryInput[number].numberInput,
+                sizeof (int)*input->boundaryInput[number].quantityOfNumberInput);
+    }
+    for (j = 0; j < equation->numberOfMaterials; j++) {
+        number = equation->materialNumbers[j];
+        value[0] = number;
+        value[1] = input->materialInput[number].quantityOfNumberInput;
+        value[2] = input->materialInput[number].generalized_relaxationTime != 0;
+        hash = hashTopologyCacheTLM(hash, value, 3 * sizeof (int));
+        hash = hashTopologyCacheTLM(hash, input->materialInput[number].numberInput,
+                sizeof (int)*input->materialInput[number].quantityOfNumberInput);
+    }
+
+    return hash;
+}
+
+/*
+ * setTopologyCacheHeader: fills the header of the topology cache with the key
+ * and the sizes of this computer
+ */
+static void setTopologyCacheHeader(struct tlcCacheHeader *header, unsigned long long key) {
+    memset(header, 0, sizeof (struct tlcCacheHeader));
+    memcpy(header->magic, TLC_CACHE_MAGIC, sizeof (header->magic));
+    header->version = TLC_CACHE_VERSION;
+    header->byteOrder = 0x01020304;
+    header->key = key;
+    header->sizeOfNumbers = sizeof (struct TLMnumbers);
+    header->sizeOfPorts = sizeof (struct aPortToRealPort);
+}
+
+/*
+ * writeConnectionTopologyCache: writes the wrapped connection variable. Each
+ * level is its quantity of points or ports, followed by them and by its inner
+ * levels (level > 0). Returns 0 if it could not write
+ */
+static int writeConnectionTopologyCache(FILE *file, const struct connectionLeveln *con) {
+
+    if (fwrite(&con->quantitySaved, sizeof (unsigned long long), 1, file) != 1)
+        return 0;
+    // after wrapping, nothing is allocated in the levels without points
+    if (con->quantitySaved == 0)
+        return 1;
+
+    if (fwrite(con->portsOrPoints, sizeof (unsigned long long), con->quantitySaved, file)
+            != con->quantitySaved)
+        return 0;
+
+    if (con->level > 0) {
+        for (unsigned long long i = 0; i < con->quantitySaved; i++) {
+            if (writeConnectionTopologyCache(file, &con->innerLevel[i]) == 0)
+                return 0;
+        }
+    }
+
+    return 1;
+}
+
+/*
+ * readConnectionTopologyCache: reads the level of the connection variable
+ * written by writeConnectionTopologyCache. The accumulated intersections are
+ * calculated as in wrap_size_connectionLeveln. What was read can be released
+ * with terminate_connectionLeveln, even if it fails. Returns 0 if it could not read
+ */
+static int readConnectionTopologyCache(FILE *file, struct connectionLeveln *con,
+        unsigned int level) {
+
+    unsigned long long i;
+
+    con->level = level;
+    con->quantitySaved = 0;
+    con->quantityAllocated = 0;
+    con->portsOrPoints = NULL;
+    con->innerLevel = NULL;
+    con->accumulatedIntersections = NULL;
+    con->pointIndex = NULL;
+    con->pointIndexSize = 0;
+    if (fread(&con->quantitySaved, sizeof (unsigned long long), 1, file) != 1)
+        return 0;
+    if (con->quantitySaved == 0)
+        return 1;
+    con->quantityAllocated = con->quantitySaved;
+
+    if ((con->portsOrPoints = (unsigned long long*) malloc(
+            sizeof (unsigned long long)*con->quantitySaved)) == NULL ||
+            fread(con->portsOrPoints, sizeof (unsigned long long), con->quantitySaved, file)
+            != con->quantitySaved)
+        return 0;
+
+    if (level > 0) {
+        if ((con->innerLevel = (struct connectionLeveln*) malloc(
+                sizeof (struct connectionLeveln)*con->quantitySaved)) == NULL ||
+                (con->accumulatedIntersections = (unsigned long long*) malloc(
+                sizeof (unsigned long long)*(con->quantitySaved + 1))) == NULL)
+            return 0;
+        for (i = 0; i < con->quantitySaved; i++)
+            con->innerLevel[i].portsOrPoints = NULL;
+
+        con->accumulatedIntersections[0] = 0;
+        for (i = 0; i < con->quantitySaved; i++) {
+            // as after wrapping, the inner levels have points
+            if (readConnectionTopologyCache(file, &con->innerLevel[i], level - 1) == 0 ||
+                    con->innerLevel[i].quantitySaved == 0)
+                return 0;
+
+            // at level 1, each position is one intersection
+            if (level == 1)
+                con->accumulatedIntersections[0]++;
+            else
+                con->accumulatedIntersections[0] +=
+                    con->innerLevel[i].accumulatedIntersections[0];
+            con->accumulatedIntersections[i + 1] = con->accumulatedIntersections[0];
+        }
+    }
+
+    return 1;
+}
+
+/*
+ * writeNumbersTopologyCache: writes the wrapped TLM numbers. The structures are
+ * followed by the arrays that they have allocated. Returns 0 if it could not write
+ */
+static int writeNumbersTopologyCache(const struct dataForSimulation * input,
+        FILE *file, const struct TLMnumbers* numbers) {
+
+    const struct aPortToRealPort *ports = numbers->abstractPortsToReal;
+    int sorted = numbers->tagSorted != NULL;
+
+    if (fwrite(numbers, sizeof (struct TLMnumbers), 1, file) != 1 ||
+            fwrite(numbers->BoundaryElements, sizeof (unsigned long long), 100, file) != 100 ||
+            fwrite(numbers->MaterialElements, sizeof (unsigned long long), 100, file) != 100 ||
+            fwrite(numbers->NotDefinedElements, sizeof (unsigned long long), 100, file) != 100 ||
+            fwrite(ports, sizeof (struct aPortToRealPort), 100, file) != 100)
+        return 0;
+
+    for (unsigned int i = 0; i < 100; i++) {
+        if (ports[i].pointerType == 2 || ports[i].pointerType == 3) {
+            if (fwrite(ports[i].realNodeRank, sizeof (unsigned long long),
+                    input->mesh.quantityOfSpecificElement[i] + 1, file)
+                    != input->mesh.quantityOfSpecificElement[i] + 1 ||
+                    fwrite(ports[i].abstractNodeOfRealNode, sizeof (unsigned long long),
+                    numbers->MaterialElements[i], file) != numbers->MaterialElements[i])
+                return 0;
+        }
+        if (ports[i].pointerTypeStub == 2 || ports[i].pointerTypeStub == 3) {
+            if (fwrite(ports[i].stubRank, sizeof (unsigned long long),
+                    numbers->MaterialElements[i] + 1, file) != numbers->MaterialElements[i] + 1)
+                return 0;
+        }
+    }
+
+    if (fwrite(&sorted, sizeof (int), 1, file) != 1 ||
+            fwrite(numbers->tagCode, sizeof (unsigned int), numbers->tagQuantity, file)
+            != numbers->tagQuantity ||
+            (sorted && fwrite(numbers->tagSorted, sizeof (long long), numbers->tagQuantity, file)
+            != numbers->tagQuantity))
+        return 0;
+
+    return 1;
+}
+
+/*
+ * readArrayTopologyCache: allocates and reads an array of the topology cache.
+ * Returns 0 if it could not
+ */
+static int readArrayTopologyCache(FILE *file, void **array, size_t size,
+        unsigned long long quantity) {
+
+    if (quantity == 0)
+        return 1;
+    if ((*array = malloc(size * quantity)) == NULL)
+        return 0;
+    return fread(*array, size, quantity, file) == quantity;
+}
+
+/*
+ * readNumbersTopologyCache: reads the TLM numbers written by
+ * writeNumbersTopologyCache. What was read can be released with
+ * terminateTLMnumbers, even if it fails. Returns 0 if it could not read
+ */
+static int readNumbersTopologyCache(const struct dataForSimulation * input,
+        FILE *file, struct TLMnumbers* numbers) {
+
+    struct aPortToRealPort *ports;
+    int sorted = 0;
+    size_t read = fread(numbers, sizeof (struct TLMnumbers), 1, file);
+    unsigned int i;
+
+    numbers->BoundaryElements = NULL;
+    numbers->MaterialElements = NULL;
+    numbers->NotDefinedElements = NULL;
+    numbers->abstractPortsToReal = NULL;
+    numbers->tagCode = NULL;
+    numbers->tagSorted = NULL;
+    if (read != 1 ||
+            readArrayTopologyCache(file, (void **) &numbers->BoundaryElements,
+            sizeof (unsigned long long), 100) == 0 ||
+            readArrayTopologyCache(file, (void **) &numbers->MaterialElements,
+            sizeof (unsigned long long), 100) == 0 ||
+            readArrayTopologyCache(file, (void **) &numbers->NotDefinedElements,
+            sizeof (unsigned long long), 100) == 0)
+        return 0;
+
+    if ((ports = (struct aPortToRealPort*) malloc(sizeof (struct aPortToRealPort)*100)) == NULL)
+        return 0;
+    read = fread(ports, sizeof (struct aPortToRealPort), 100, file);
+    for (i = 0; i < 100; i++) {
+        ports[i].nodesNumbers = NULL;
+        ports[i].nodesNumbersStub = NULL;
+        ports[i].realNodeRank = NULL;
+        ports[i].abstractNodeOfRealNode = NULL;
+        ports[i].stubRank = NULL;
+    }
+    numbers->abstractPortsToReal = ports;
+    if (read != 100)
+        return 0;
+
+    for (i = 0; i < 100; i++) {
+        if ((ports[i].pointerType == 2 || ports[i].pointerType == 3) &&
+                (readArrayTopologyCache(file, (void **) &ports[i].realNodeRank,
+                sizeof (unsigned long long), input->mesh.quantityOfSpecificElement[i] + 1) == 0 ||
+                readArrayTopologyCache(file, (void **) &ports[i].abstractNodeOfRealNode,
+                sizeof (unsigned long long), numbers->MaterialElements[i]) == 0))
+            return 0;
+        if ((ports[i].pointerTypeStub == 2 || ports[i].pointerTypeStub == 3) &&
+                readArrayTopologyCache(file, (void **) &ports[i].stubRank,
+                sizeof (unsigned long long), numbers->MaterialElements[i] + 1) == 0)
+            return 0;
+    }
+
+    if (fread(&sorted, sizeof (int), 1, file) != 1 ||
+            readArrayTopologyCache(file, (void **) &numbers->tagCode,
+            sizeof (unsigned int), numbers->tagQuantity) == 0 ||
+            (sorted && readArrayTopologyCache(file, (void **) &numbers->tagSorted,
+            sizeof (long long), numbers->tagQuantity) == 0))
+        return 0;
+
+    return 1;
+}
+
+/*
+ * writeTopologyCacheTLM: writes the TLM numbers and the connection variable
+ * created by getTLMnumbers to the topology cache. The file is written with
+ * another name and renamed at the end, so a cache that was not completely
+ * written is never read
+ */
+unsigned int writeTopologyCacheTLM(const struct dataForSimulation * input,
+        const char *name, unsigned long long key, const struct TLMnumbers* numbers,
+        const struct connectionLeveln * intersections) {
+
+    struct tlcCacheHeader header;
+    char *temporary;
+    FILE *file;
+    int written;
+
+    if ((temporary = (char *) malloc(strlen(name) + 5)) == NULL)
+        return 8750;
+    sprintf(temporary, "%s.tmp", name);
+
+    if ((file = fopen(temporary, "wb")) == NULL) {
+        free(temporary);
+        return 8761;
+    }
+
+    setTopologyCacheHeader(&header, key);
+    written = fwrite(&header, sizeof (struct tlcCacheHeader), 1, file) == 1 &&
+            writeNumbersTopologyCache(input, file, numbers) &&
+            fwrite(&intersections->level, sizeof (unsigned int), 1, file) == 1 &&
+            writeConnectionTopologyCache(file, intersections);
+    if (fclose(file) != 0)
+        written = 0;
+
+    if (written == 0 || rename(temporary, name) != 0) {
+        remove(temporary);
+        free(temporary);
+        return 8761;
+    }
+
+    free(temporary);
+    return 0;
+}
+
+/*
+ * readTopologyCacheTLM: reads the TLM numbers and the connection variable from
+ * the topology cache. Returns 0 if they were read, or 1 if the file does not
+ * exist, was written for another key or computer, or could not be read. In
+ * this case, nothing is left allocated and they have to be created
+ */
+unsigned int readTopologyCacheTLM(const struct dataForSimulation * input,
+        const char *name, unsigned long long key, struct TLMnumbers* numbers,
+        struct connectionLeveln * intersections) {
+
+    struct tlcCacheHeader header, expected;
+    unsigned int level;
+    FILE *file;
+    int read;
+
+    if ((file = fopen(name, "rb")) == NULL)
+        return 1;
+
+    setTopologyCacheHeader(&expected, key);
+    if (fread(&header, sizeof (struct tlcCacheHeader), 1, file) != 1 ||
+            memcmp(&header, &expected, sizeof (struct tlcCacheHeader)) != 0) {
+        fclose(file);
+        return 1;
+    }
+
+    intersections->portsOrPoints = NULL;
+    read = readNumbersTopologyCache(input, file, numbers) &&
+            fread(&level, sizeof (unsigned int), 1, file) == 1 && level <= 4 &&
+            readConnectionTopologyCache(file, intersections, level);
+    fclose(file);
+
+    if (read == 0) {
+        terminateTLMnumbers(numbers);
+        terminate_connectionLeveln(intersections);
+        return 1;
+    }
+
+    return 0;
+}
+
+/*
+ * nameCheckpointTLM: returns the name of the checkpoint of the simulation, the
+ * name of the output file followed by .tlr, or NULL if there is no memory. It
+ * has to be freed
+ */
+char *nameCheckpointTLM(const struct dataForSimulation * input) {
+    char *name;
+
+    if ((name = (char *) malloc(strlen(input->simulationInput.nameOfOutputFile) + 5)) == NULL)
+        return NULL;
+    sprintf(name, "%s.tlr", input->simulationInput.nameOfOutputFile);
+
+    return name;
+}
+
+/*
+ * keyCheckpointTLM: returns the key of the checkpoint of equation id. It is the
+ * key of the topology cache with the times, the order of the ports, the
+ * scenarios, and how the outputs are written. The other inputs (materials,
+ * sources, boundaries) are not in it, so they must not be changed before a
+ * restart
+ */
+unsigned long long keyCheckpointTLM(const struct dataForSimulation * input, int id) {
+    const struct Equation *equation = &input->equationInput[id];
+    unsigned long long hash = keyTopologyCacheTLM(input, id);
+    double times[3];
+    int value[7];
+
+    times[0] = equation->timeStep;
+    times[1] = equation->finalTime;
+    times[2] = (double) equation->timeJump;
+    hash = hashTopologyCacheTLM(hash, times, sizeof (times));
+
+    value[0] = equation->Renumber;
+    value[1] = equation->numberOfScenarios;
+    value[2] = equation->numberOfSweepPoints;
+    value[3] = equation->numberOfStatisticsTags;
+    value[4] = equation->numberOfOutputProbes + equation->numberOfOutputTags;
+    value[5] = input->simulationInput.outputFileExtension;
+    value[6] = input->simulationInput.outputFloat;
+    hash = hashTopologyCacheTLM(hash, value, sizeof (value));
+
+    return hash;
+}
+
+/*
+ * setCheckpointHeader: fills the magic, version, and byte order of the header
+ * of the checkpoint
+ */
+static void setCheckpointHeader(struct tlrCheckpointHeader *header) {
+    memcpy(header->magic, TLR_CHECKPOINT_MAGIC, sizeof (header->magic));
+    header->version = TLR_CHECKPOINT_VERSION;
+    header->byteOrder = 0x01020304;
+}
+
+/*
+ * syncOutputFileTLM: writes what is buffered in file to the disk and returns its
+ * size, or -1 if it could not be written. The position must be at the end
+ */
+long long syncOutputFileTLM(FILE *file) {
+    if (fflush(file) != 0)
+        return -1;
+
+#if defined(_WIN32)
+    if (_commit(_fileno(file)) != 0)
+        return -1;
+    return _ftelli64(file);
+#else
+    if (fsync(fileno(file)) != 0)
+        return -1;
+    return ftell(file);
+#endif
+}
+
+/*
+ * truncateOutputFileTLM: cuts file at size, the size that it had when the
+ * checkpoint was written, and puts the position there. The outputs written
+ * after the checkpoint are written again. Returns 8763 if file is smaller
+ */
+unsigned int truncateOutputFileTLM(FILE *file, long long size) {
+    long long end;
+
+    if (fflush(file) != 0)
+        return 8763;
+
+#if defined(_WIN32)
+    _fseeki64(file, 0, SEEK_END);
+    end = _ftelli64(file);
+    if (end < size || _chsize_s(_fileno(file), size) != 0 || _fseeki64(file, size, SEEK_SET) != 0)
+        return 8763;
+#else
+    fseek(file, 0, SEEK_END);
+    end = ftell(file);
+    if (end < size || ftruncate(fileno(file), (off_t) size) != 0 || fseek(file, size, SEEK_SET) != 0)
+        return 8763;
+#endif
+
+    return 0;
+}
+
+/*
+ * findCheckpointTLM: when the simulation is restarted, finds the equation of
+ * the checkpoint. The equations before it were already solved, and the files
+ * of its outputs are opened to continue. If there is no checkpoint, the
+ * simulation starts from the beginning
+ */
+unsigned int findCheckpointTLM(struct dataForSimulation * input) {
+    struct tlrCheckpointHeader header, expected;
+    char *name;
+    FILE *file;
+    int read;
+
+    input->simulationInput.restartEquation = -1;
+    if (input->simulationInput.restart == 0)
+        return 0;
+
+    if ((name = nameCheckpointTLM(input)) == NULL)
+        return 8750;
+
+    if ((file = fopen(name, "rb")) == NULL) {
+        fprintf(stderr, "\nWARNING: There is no checkpoint %s. The simulation starts "
+                "from the beginning.\n\n", name);
+        free(name);
+        return 0;
+    }
+
+    setCheckpointHeader(&expected);
+    read = fread(&header, sizeof (struct tlrCheckpointHeader), 1, file) == 1 &&
+            memcmp(&header, &expected, offsetof(struct tlrCheckpointHeader, equation)) == 0 &&
+            header.equation >= 0 && header.equation < input->quantityOfEquationsRead;
+    fclose(file);
+    if (read == 0) {
+        free(name);
+        return 8763;
+    }
+
+    printf("Restarting from the checkpoint %s of equation %04d at %g s.\n",
+            name, header.equation + 1, header.time);
+    input->simulationInput.restartEquation = header.equation;
+    free(name);
+
+    return 0;
+}
+
+/*
+ * writeCheckpointTLM: writes the checkpoint with the header, the size of each
+ * output file, the incident voltages, and the thermal doses. The magic, the
+ * version, and the byte order of the header are set here. The file is written
+ * with another name, synchronized with the disk, and renamed at the end, so the
+ * last checkpoint is kept until the new one is complete
+ */
+unsigned int writeCheckpointTLM(const char *name, const struct tlrCheckpointHeader * header,
+        const long long *offsets, const double *Vi, const double *dose) {
+
+    struct tlrCheckpointHeader written;
+    char *temporary;
+    FILE *file;
+    int ok;
+
+    if ((temporary = (char *) malloc(strlen(name) + 5)) == NULL)
+        return 8750;
+    sprintf(temporary, "%s.tmp", name);
+
+    if ((file = fopen(temporary, "wb")) == NULL) {
+        free(temporary);
+        return 8762;
+    }
+
+    written = *header;
+    setCheckpointHeader(&written);
+    ok = fwrite(&written, sizeof (struct tlrCheckpointHeader), 1, file) == 1 &&
+            fwrite(offsets, sizeof (long long), written.quantityOfFiles, file) ==
+            (size_t) written.quantityOfFiles &&
+            fwrite(Vi, sizeof (double), written.sizeOfVi, file) == written.sizeOfVi &&
+            (written.sizeOfDose == 0 ||
+            fwrite(dose, sizeof (double), written.sizeOfDose, file) == written.sizeOfDose) &&
+            syncOutputFileTLM(file) >= 0;
+    if (fclose(file) != 0)
+        ok = 0;
+
+    if (ok == 0 || rename(temporary, name) != 0) {
+        remove(temporary);
+        free(temporary);
+        return 8762;
+    }
+
+    free(temporary);
+    return 0;
+}
+
+/*
+ * readCheckpointTLM: reads the checkpoint into header, offsets, Vi, and dose.
+ * The equation, the key, the quantity of files, and the sizes must be the ones
+ * of expected, whose magic, version, and byte order are set here
+ */
+unsigned int readCheckpointTLM(const char *name, const struct tlrCheckpointHeader * expected,
+        struct tlrCheckpointHeader * header, long long *offsets, double *Vi, double *dose) {
+
+    struct tlrCheckpointHeader wanted;
+    FILE *file;
+    int ok;
+
+    if ((file = fopen(name, "rb")) == NULL)
+        return 8763;
+
+    wanted = *expected;
+    setCheckpointHeader(&wanted);
+    ok = fread(header, sizeof (struct tlrCheckpointHeader), 1, file) == 1 &&
+            memcmp(header, &wanted, offsetof(struct tlrCheckpointHeader, iteration)) == 0 &&
+            header->sizeOfVi == wanted.sizeOfVi && header->sizeOfDose == wanted.sizeOfDose &&
+            fread(offsets, sizeof (long long), header->quantityOfFiles, file) ==
+            (size_t) header->quantityOfFiles &&
+            fread(Vi, sizeof (double), header->sizeOfVi, file) == header->sizeOfVi &&
+            (header->sizeOfDose == 0 ||
+            fread(dose, sizeof (double), header->sizeOfDose, file) == header->sizeOfDose);
+    fclose(file);
+
+    return ok ? 0 : 8763;
+}
+
 /*
  * initiate_aPortToRealPort: allocate aPortToRealPort. This variable is used
  * to convert abstract ports to real ports. What are abstract ports? At the beginning
@@ -2516,6 +3360,12 @@ unsigned int initiate_aPortToRealPort(const struct dataForSimulation * input,
                 (*Ports)[i].quantityAllocatedStub)) == NULL)
             return 8741;
 
+        // the tables are created when wrapping the TLM numbers
+        (*Ports)[i].nextMaterialCode = 99;
+        (*Ports)[i].realNodeRank = NULL;
+        (*Ports)[i].abstractNodeOfRealNode = NULL;
+        (*Ports)[i].stubRank = NULL;
+
     }
 
 
@@ -2728,41 +3578,34 @@ unsigned int wrapTLMnumbers(const struct dataForSimulation * input,
                     sizeof (unsigned long long),
                     compareLLU);
 
-            // can we reduce the size of nodesNumbers by inverting the pointerType?
-            // that is, if I saved more than half of the elements I will change the type
-            // of the pointerType so that it will have less than half
-            if (numbers->abstractPortsToReal[i].quantitySaved >
-                    (numbers->MaterialElements[i] - numbers->abstractPortsToReal[i].quantitySaved)) {
-                // changing the nodesNumberStub type. Inside this function I also
-                // change the value of quantitySavedStub
-                if ((errorTLMnumber = changeNodesNumbersType(
-                        &numbers->abstractPortsToReal[i].nodesNumbers,
-                        &numbers->abstractPortsToReal[i].quantitySaved,
-                        numbers->MaterialElements[i])) != 0) {
-                    return errorTLMnumber;
-                }
-
-                // here I change pointerTypeStub
-                if (numbers->abstractPortsToReal[i].pointerType == 3) {
-                    numbers->abstractPortsToReal[i].pointerType = 2;
-                } else {
-                    numbers->abstractPortsToReal[i].pointerType = 3;
-                }
+            // real number of each abstract node. When pointerType == 3 the
+            // nodes saved are the material ones, so I count them. Otherwise,
+            // I count the nodes that were not saved
+            if ((errorTLMnumber = rank_aPortToRealPort(
+                    numbers->abstractPortsToReal[i].nodesNumbers,
+                    numbers->abstractPortsToReal[i].quantitySaved, NULL,
+                    input->mesh.quantityOfSpecificElement[i],
+                    numbers->abstractPortsToReal[i].pointerType == 3,
+                    &numbers->abstractPortsToReal[i].realNodeRank)) != 0)
+                return errorTLMnumber;
 
+            // and the inverse, from the real number to the abstract number
+            if ((numbers->abstractPortsToReal[i].abstractNodeOfRealNode = (unsigned long long*)
+                    malloc(sizeof (unsigned long long)*numbers->MaterialElements[i])) == NULL)
+                return 8748;
 
-                // I'm already with the allocation that has the smallest length of nodesNumbersStub
-            } else {
-                // shortening the pointer to the quantity saved
-                if ((numbers->abstractPortsToReal[i].nodesNumbers = (unsigned long long*)
-                        realloc(numbers->abstractPortsToReal[i].nodesNumbers,
-                        sizeof (unsigned long long)*
-                        numbers->abstractPortsToReal[i].quantitySaved)) == NULL)
-                    return 8738;
+            for (unsigned long long n = 0; n < input->mesh.quantityOfSpecificElement[i]; n++) {
+                if (numbers->abstractPortsToReal[i].realNodeRank[n + 1] >
+                        numbers->abstractPortsToReal[i].realNodeRank[n])
+                    numbers->abstractPortsToReal[i].abstractNodeOfRealNode[
+                        numbers->abstractPortsToReal[i].realNodeRank[n]] = n;
             }
         }
 
-        numbers->abstractPortsToReal[i].quantityAllocated =
-                numbers->abstractPortsToReal[i].quantitySaved;
+        // the tables above replace the list of nodes
+        free(numbers->abstractPortsToReal[i].nodesNumbers);
+        numbers->abstractPortsToReal[i].nodesNumbers = NULL;
+        numbers->abstractPortsToReal[i].quantityAllocated = 0;
 
 
 
@@ -2812,40 +3655,35 @@ unsigned int wrapTLMnumbers(const struct dataForSimulation * input,
                     sizeof (unsigned long long),
                     compareLLU);
 
-            // can we reduce the size of nodesNumbersStub by inverting the pointerTypeStub?
-            // that is, if I saved more than half of the elements I will change the type
-            // of the pointerTypeStub so that it will have less than half
-            if (numbers->abstractPortsToReal[i].quantitySavedStub >
-                    (numbers->MaterialElements[i] - numbers->abstractPortsToReal[i].quantitySavedStub)) {
-                // changing the nodesNumberStub type. Inside this function I also
-                // change the value of quantitySavedStub
-                if ((errorTLMnumber = changeNodesNumbersType(
-                        &numbers->abstractPortsToReal[i].nodesNumbersStub,
-                        &numbers->abstractPortsToReal[i].quantitySavedStub,
-                        numbers->MaterialElements[i])) != 0) {
-                    return errorTLMnumber;
-                }
-
-                // here I change pointerTypeStub
-                if (numbers->abstractPortsToReal[i].pointerTypeStub == 3) {
-                    numbers->abstractPortsToReal[i].pointerTypeStub = 2;
-                } else {
-                    numbers->abstractPortsToReal[i].pointerTypeStub = 3;
-                }
+            // quantity of stubs before each real node. The numbers saved are
+            // abstract, so I convert them with realNodeRank (if any). When
+            // pointerTypeStub == 3 the nodes saved are the ones with stub
+            if ((errorTLMnumber = rank_aPortToRealPort(
+                    numbers->abstractPortsToReal[i].nodesNumbersStub,
+                    numbers->abstractPortsToReal[i].quantitySavedStub,
+                    numbers->abstractPortsToReal[i].realNodeRank,
+                    numbers->MaterialElements[i],
+                    numbers->abstractPortsToReal[i].pointerTypeStub == 3,
+                    &numbers->abstractPortsToReal[i].stubRank)) != 0)
+                return errorTLMnumber;
+        }
 
+        // the table above replaces the list of nodes
+        free(numbers->abstractPortsToReal[i].nodesNumbersStub);
+        numbers->abstractPortsToReal[i].nodesNumbersStub = NULL;
+        numbers->abstractPortsToReal[i].quantityAllocatedStub = 0;
+    }
 
-                // I'm already with the allocation that has the smallest length of nodesNumbersStub
-            } else {
-                // shortening the pointer to the quantity saved
-                if ((numbers->abstractPortsToReal[i].nodesNumbersStub = (unsigned long long*)
-                        realloc(numbers->abstractPortsToReal[i].nodesNumbersStub,
-                        sizeof (unsigned long long)*
-                        numbers->abstractPortsToReal[i].quantitySavedStub)) == NULL)
-                    return 8742;
-            }
+    // the next element code with material nodes. I use it to find the element
+    // code of a port without going through all the 100 codes
+    numbers->abstractPortsToReal[99].nextMaterialCode = 99;
+    for (int i = 98; i >= 0; i--) {
+        if (numbers->MaterialElements[i] > 0) {
+            numbers->abstractPortsToReal[i].nextMaterialCode = i;
+        } else {
+            numbers->abstractPortsToReal[i].nextMaterialCode =
+                    numbers->abstractPortsToReal[i + 1].nextMaterialCode;
         }
-        numbers->abstractPortsToReal[i].quantityAllocatedStub =
-                numbers->abstractPortsToReal[i].quantitySavedStub;
     }
 
 
@@ -2871,46 +3709,39 @@ unsigned int wrapTLMnumbers(const struct dataForSimulation * input,
 }
 
 /*
- * changeNodesNumbersType: change the type of the nodesNumbers by changing what
- * is in nodesNumbers. For instance, if nodesNumbers have the number of the nodes
- * that DO have stub, it will change it to have the number of nodes that DO NOT have stub.
+ * rank_aPortToRealPort: create the prefix count (rank) of a sorted list of nodes.
+ * rank[n] is the quantity of nodes with number < n that are counted, where
+ * counted means that the node is in the list (countListed = 1) or that it is
+ * not in the list (countListed = 0). If map is not NULL, the numbers in the
+ * list are converted with map before (map must keep them sorted).
+ * The rank has size universe + 1.
  */
-unsigned int changeNodesNumbersType(unsigned long long **input,
-        unsigned long long *size, unsigned long long maxNodeNumber) {
-    unsigned long long i, j, k;
-    unsigned int errorTLMnumber;
-
-    // first I copy the content of input
-    unsigned long long *input_copied;
-    if ((input_copied = malloc(*size * sizeof (unsigned long long))) == NULL) {
-        errorTLMnumber = 8743;
-        sendErrorCodeAndMessage(errorTLMnumber, NULL, NULL, NULL, NULL);
-        return errorTLMnumber;
-    }
-
-    for (i = 0; i < *size; i++) {
-        input_copied[i] = (*input)[i];
-    }
-
-    // now I realloc input so that it matches the new size
-    if ((*input = realloc(*input, (maxNodeNumber - *size) * sizeof (unsigned long long))) == NULL) {
-        errorTLMnumber = 8744;
-        sendErrorCodeAndMessage(errorTLMnumber, NULL, NULL, NULL, NULL);
-        return errorTLMnumber;
-    }
-
-    // changing the content of input
-    for (i = 0; i < input_copied[0]; i++) {
-        (*input)[i] = i;
-    }
-    k = i;
-    for (j = 0; j < *size; j++) {
-        for (i = input_copied[j] + 1; i < input_copied[j + 1]; i++) {
-            (*input)[k] = i;
+unsigned int rank_aPortToRealPort(const unsigned long long *list,
+        unsigned long long quantity, const unsigned long long *map,
+        unsigned long long universe, unsigned int countListed,
+        unsigned long long **rank) {
+    unsigned long long n, k = 0, value;
+    unsigned int listed;
+
+    if ((*rank = (unsigned long long*) malloc(
+            sizeof (unsigned long long)*(universe + 1))) == NULL)
+        return 8749;
+
+    (*rank)[0] = 0;
+    for (n = 0; n < universe; n++) {
+        listed = 0;
+        while (k < quantity) {
+            value = (map == NULL) ? list[k] : map[list[k]];
+            if (value > n)
+                break;
+            if (value == n)
+                listed = 1;
             k++;
         }
+
+        (*rank)[n + 1] = (*rank)[n] + (listed == countListed);
     }
-    *size = maxNodeNumber - *size;
+
     return 0;
 }
 
@@ -2926,6 +3757,15 @@ unsigned int terminate_aPortToRealPort(struct aPortToRealPort** Ports) {
 
             free((*Ports)[i].nodesNumbersStub);
             (*Ports)[i].nodesNumbersStub = NULL;
+
+            free((*Ports)[i].realNodeRank);
+            (*Ports)[i].realNodeRank = NULL;
+
+            free((*Ports)[i].abstractNodeOfRealNode);
+            (*Ports)[i].abstractNodeOfRealNode = NULL;
+
+            free((*Ports)[i].stubRank);
+            (*Ports)[i].stubRank = NULL;
         }
 
         free((*Ports));
@@ -3071,6 +3911,50 @@ unsigned int getNumberOfPortsGivenElement(unsigned int elementCode,
     }
 }
 
+/*
+ * realNode_aPortToRealPort: real number of the node (starting at zero for each
+ * element code) given its abstract number
+ */
+static inline unsigned long long realNode_aPortToRealPort(const struct aPortToRealPort* Ports,
+        unsigned long long abstractNodeNumber) {
+    // when pointerType is 0 or 1 the numbers are the same
+    if (Ports->realNodeRank == NULL)
+        return abstractNodeNumber;
+
+    return Ports->realNodeRank[abstractNodeNumber];
+}
+
+/*
+ * stubsBefore_aPortToRealPort: quantity of nodes of this element code with
+ * real number < realNodeNumber that have stub. If hasStub is not NULL, I also
+ * return if the node realNodeNumber has stub.
+ */
+static inline unsigned long long stubsBefore_aPortToRealPort(const struct aPortToRealPort* Ports,
+        unsigned long long realNodeNumber, unsigned long long *hasStub) {
+    unsigned long long before = 0, stub = 0;
+
+    switch (Ports->pointerTypeStub) {
+        case 0:
+            // all nodes of this element type DO NOT have stub
+            break;
+        case 1:
+            // all nodes of this element type DO have stub
+            before = realNodeNumber;
+            stub = 1;
+            break;
+        default:
+            // part of them have stub
+            before = Ports->stubRank[realNodeNumber];
+            stub = Ports->stubRank[realNodeNumber + 1] - before;
+            break;
+    }
+
+    if (hasStub != NULL)
+        *hasStub = stub;
+
+    return before;
+}
+
 /*
  * getRealPortNumber_fromAbstractPortNumber: receive the abstract number of the port
  * and return the real number of the port, the first port number of that node, and
@@ -3089,154 +3973,44 @@ void getRealPortNumber_fromAbstractPortNumber(
     // 4 - same as 3 + offset from stub
     // 5 - same as 4 + offset from stub and is the stub port number if this node has stub
 
-    unsigned long long j, offset, numberOfNodeWithinElement;
-    unsigned int i, offsetStub;
+    unsigned long long abstractNodeNumber, realNodeNumber, portOrder, stubs, hasStub;
+    unsigned int i;
 
     // the element type of the abstractPortNumber is the type that has at most
-    // the number of the abstract port number.
-    for (i = 0; i < 99; i++) {
-        // I will only see this if this element code has any real node allocated
-        if ((Ports[i + 1].previousMaximumRealNode - Ports[i].previousMaximumRealNode) > 0 &&
-                Ports[i + 1].previousMaximumAbstractPort > abstractPortNumber) {
-            break;
-        }
-        // if I don't get into the 'if', then, the number of the element that has
-        // this port number shall be the element 100.
+    // the number of the abstract port number. I only visit the element codes
+    // that have real nodes. If none of them has it, the element that has
+    // this port number shall be the element 100.
+    i = Ports[0].nextMaterialCode;
+    while (i < 99 && Ports[i + 1].previousMaximumAbstractPort <= abstractPortNumber) {
+        i = Ports[i + 1].nextMaterialCode;
     }
 
-    // difference between the number of abstract ports and real ports
-    offset = Ports[i].previousMaximumAbstractPort -
-            Ports[i].previousMaximumRealPort; // this is the minimum value of the offset
-
-
-    // this contains the number of the nodes that are boundary or undefined
-    if (Ports[i].pointerType == 2) {
-        for (j = 0; j < Ports[i].quantitySaved; j++) {
-            if ((Ports[i].portsPerNode * (Ports[i].nodesNumbers[j] + 1) +
-                    Ports[i].previousMaximumAbstractPort) > abstractPortNumber) {
-                // when this happens, then, this node number does not influence
-                // on the offset
-                break;
-            }
-        }
-        // j is the number of boundary nodes
-        offset = offset + Ports[i].portsPerNode * (j);
-
+    // the abstract number of the node within this element code and the
+    // order of the port in this node
+    abstractNodeNumber = (abstractPortNumber - Ports[i].previousMaximumAbstractPort) /
+            Ports[i].portsPerNode;
+    portOrder = (abstractPortNumber - Ports[i].previousMaximumAbstractPort) %
+            Ports[i].portsPerNode;
 
-        // this contains the number of the nodes that are material
-    } else if (Ports[i].pointerType == 3) {
-        for (j = 0; j < Ports[i].quantitySaved; j++) {
-            if ((Ports[i].portsPerNode * (Ports[i].nodesNumbers[j] + 1) +
-                    Ports[i].previousMaximumAbstractPort) > abstractPortNumber) {
-
-                break;
-            }
-        }
-        // j is the number of material nodes
-        // to get the number of boundary nodes, I need to add Ports[i].nodesNumbers[j]
-        offset = offset - Ports[i].portsPerNode * (j);
-
-        // if j = quantitySaved, I have to reduce it because I cannot access the 
-        // nodesNumber at j = quantitySaved
-        if (j == Ports[i].quantitySaved) j--;
-
-        offset = offset +
-                Ports[i].portsPerNode * Ports[i].nodesNumbers[j];
-
-    }
+    // the boundary and not defined nodes before it have no ports
+    realNodeNumber = realNode_aPortToRealPort(&Ports[i], abstractNodeNumber);
 
     // this is the real port number
-    output[0] = (abstractPortNumber - offset);
-    // this is the remainder of the division
-    // the remainder will be zero if this is the first port number
-    // and will be portsPerNode - 1 if this is the last port
-    output[1] = (abstractPortNumber
-            - Ports[i].previousMaximumAbstractPort) % Ports[i].portsPerNode;
+    output[0] = Ports[i].previousMaximumRealPort +
+            Ports[i].portsPerNode * realNodeNumber + portOrder;
 
-    output[2] = output[0] + (Ports[i].portsPerNode - output[1]);
+    output[1] = output[0] - portOrder;
 
-    output[1] = output[0] - output[1];
+    output[2] = output[1] + Ports[i].portsPerNode;
 
-    // calculating the effects of stub offset on this node
-    switch (Ports[i].pointerTypeStub) {
-        case 0:
-            // all nodes of the element DO NOT have stub
-            output[3] = output[0] + Ports[i].previousMaximumRealStubPort;
-            output[4] = output[1] + Ports[i].previousMaximumRealStubPort;
-            output[5] = output[2] + Ports[i].previousMaximumRealStubPort;
-            break;
-
-            // all nodes of this element DO have stub
-        case 1:
-            // this is the number of THIS node (starting at zero).
-            numberOfNodeWithinElement = (output[1] -
-                    (Ports[i].previousMaximumRealPort - 1)) / Ports[i].portsPerNode;
-
-            output[3] = output[0] + Ports[i].previousMaximumRealStubPort
-                    + numberOfNodeWithinElement; // offset from the previous nodes of this element
-            output[4] = output[1] + Ports[i].previousMaximumRealStubPort
-                    + numberOfNodeWithinElement; // offset from the previous nodes of this element
-            output[5] = output[2] + Ports[i].previousMaximumRealStubPort
-                    + numberOfNodeWithinElement + 1; // offset from the previous nodes of this element + the stub of itself
-            break;
-
-            // this contains the nodes that DO NOT have stub
-        case 2:
-            // this is the number of THIS node (starting at zero).
-            numberOfNodeWithinElement = (output[1] -
-                    (Ports[i].previousMaximumRealPort - 1)) / Ports[i].portsPerNode;
-
-            // how many stub nodes are there that have a number LESS than
-            // this.
-            for (j = 0; j < Ports[i].quantitySavedStub; j++) {
-                if (Ports[i].nodesNumbers[j] >= numberOfNodeWithinElement) {
-                    break;
-                }
-            }
-            // if they are equal then THIS node does not have stub
-            if (Ports[i].nodesNumbers[j] == numberOfNodeWithinElement) {
-                offsetStub = 0;
-            } else {
-                offsetStub = 1;
-            }
-            output[3] = output[0] + Ports[i].previousMaximumRealStubPort
-                    + (numberOfNodeWithinElement - j); // offset from the previous nodes of this element
-            output[4] = output[1] + Ports[i].previousMaximumRealStubPort
-                    + (numberOfNodeWithinElement - j); // offset from the previous nodes of this element
-            output[5] = output[2] + Ports[i].previousMaximumRealStubPort
-                    + (numberOfNodeWithinElement - j) // offset from the previous nodes of this element
-                    + offsetStub; //  + the stub of itself
-            break;
-
-            // this contains the nodes that DO have stub
-        case 3:
-            // this is the number of THIS node (starting at zero).
-            numberOfNodeWithinElement = (output[1] -
-                    (Ports[i].previousMaximumRealPort - 1)) / Ports[i].portsPerNode;
-
-            // how many nodes without stub are there that have a number LESS than
-            // this.
-            for (j = 0; j < Ports[i].quantitySavedStub; j++) {
-                if (Ports[i].nodesNumbers[j] >= numberOfNodeWithinElement) {
-                    break;
-                }
-            }
-            // if they are equal then THIS node does have stub
-            if (Ports[i].nodesNumbers[j] == numberOfNodeWithinElement) {
-                offsetStub = 1;
-            } else {
-                offsetStub = 0;
-            }
-            output[3] = output[0] + Ports[i].previousMaximumRealStubPort
-                    + j; // offset from the previous nodes of this element
-            output[4] = output[1] + Ports[i].previousMaximumRealStubPort
-                    + j; // offset from the previous nodes of this element
-            output[5] = output[2] + Ports[i].previousMaximumRealStubPort
-                    + j // offset from the previous nodes of this element
-                    + offsetStub; //  + the stub of itself
-            break;
-    }
+    // calculating the effects of stub offset on this node: the stubs of the
+    // previous element codes and of the previous nodes of this element
+    stubs = Ports[i].previousMaximumRealStubPort +
+            stubsBefore_aPortToRealPort(&Ports[i], realNodeNumber, &hasStub);
 
+    output[3] = output[0] + stubs;
+    output[4] = output[1] + stubs;
+    output[5] = output[2] + stubs + hasStub; //  + the stub of itself
 
     return;
 }
@@ -3250,113 +4024,24 @@ void getRealPortNumber_fromAbstractPortNumber(
 void getRealNodeAndPort_fromAbstractNode(unsigned int elementCode,
         unsigned long long abstractNodeNumber, struct aPortToRealPort* Ports,
         unsigned long long *output) {
-    unsigned long long j;
+    unsigned long long realNodeNumber;
 
     // abstractNodeNumber starts at 0 for every elementCode.
     // the previousMaximumRealNode contains the number of node of the previous element + 1
-    // Hence, I can safely do abstractNodeNumber + previousMaximumRealNode.
-    // Also note that previousMaximumRealPort has + 1 offset. What I mean by offset?
-    // when abastractNodenumber = 0, previousMaximumRealNode = realNumber of this node
-    // and previousMaximumRealPort = firstRealPortNumber of this node. I do -1
-    // for the realPort number because it has an offset + 1.
-
-    // all nodes of this boundary are material.
-    if (Ports[elementCode].pointerType == 1) {
-        output[0] = abstractNodeNumber + Ports[elementCode].previousMaximumRealNode;
-
-        output[1] = Ports[elementCode].portsPerNode * abstractNodeNumber +
-                Ports[elementCode].previousMaximumRealPort;
-
-        // this contains the number of the nodes that are boundary or undefined
-    } else if (Ports[elementCode].pointerType == 2) {
-        for (j = 0; j < Ports[elementCode].quantitySaved; j++) {
-            // I do a loop until I can find the boundary-element that has an abstract
-            // number greater than the abstract number I'm asking to get the real numbers.
-            // That is, the boundary-elements from 0 until j-1 will influence the calculated
-            // real numbers that I'm asking
-            if (Ports[elementCode].nodesNumbers[j] > abstractNodeNumber) {
-                break;
-            }
-        }
-        // j represents the quantity of nodes that are boundary and has a number less than the
-        // abstractNodeNumber. Then, we remove these extras js from the real
-        // node number (output[0])
-        output[0] = abstractNodeNumber - j
-                + Ports[elementCode].previousMaximumRealNode;
-
-        output[1] = Ports[elementCode].portsPerNode * (abstractNodeNumber - j)
-                + Ports[elementCode].previousMaximumRealPort;
-
-        // this contains the number of the nodes that are material
-    } else if (Ports[elementCode].pointerType == 3) {
-        for (unsigned long long j = 0; j < Ports[elementCode].quantitySaved; j++) {
-            // I do a loop until I can find the material-element that has an abstract
-            // number equal or greater than the abstract number I'm asking to get
-            // the real numbers. It is likely that this will end when they are
-            // equal and so I should be able to change >= by ==.
-            if (Ports[elementCode].nodesNumbers[j] >= abstractNodeNumber) {
-                break;
-            }
-        }
-        // j represents the position of the abstractNodeNumber in the vector
-        // nodesNumbers. That is, j represents the number of nodes that are
-        // material - 1.
-        output[0] = j
-                + Ports[elementCode].previousMaximumRealNode;
-
-        output[1] = Ports[elementCode].portsPerNode * j
-                + Ports[elementCode].previousMaximumRealPort;
-    }
+    // Hence, I can safely do realNodeNumber + previousMaximumRealNode.
+    // when abstractNodeNumber = 0, previousMaximumRealNode = realNumber of this node
+    // and previousMaximumRealPort = firstRealPortNumber of this node.
+    realNodeNumber = realNode_aPortToRealPort(&Ports[elementCode], abstractNodeNumber);
 
-    // considering the effect of stub in the numbering
-
-    // all nodes of this element type DO NOT have stub
-    if (Ports[elementCode].pointerTypeStub == 0) {
-        // number of realPorts + offset done by previous stubs
-        output[2] = output[1] + Ports[elementCode].previousMaximumRealStubPort;
-
-        // all nodes of this element type DO have stub
-    } else if (Ports[elementCode].pointerTypeStub == 1) {
-        // number of realPorts + offset done by previous stubs
-        // + offset done by previous nodes that have stub
-        output[2] = output[1] + Ports[elementCode].previousMaximumRealStubPort +
-                abstractNodeNumber;
-
-        // contains the number of the nodes that DO NOT have stub
-    } else if (Ports[elementCode].pointerTypeStub == 2) {
-        for (unsigned long long j = 0; j < Ports[elementCode].quantitySavedStub; j++) {
-            // I do a loop until I can find the node without stub that has an abstract
-            // number equal or greater than the abstract number I'm asking to get
-            // the real numbers.
-            if (Ports[elementCode].nodesNumbers[j] >= abstractNodeNumber) {
-                break;
-            }
-        }
-        // j represents the number of nodes without stub before abstractNodeNumber.
-        // Then, to get the number of nodes with stub we do (abstractNodeNumber - j)
-        output[2] = output[1] + Ports[elementCode].previousMaximumRealStubPort +
-                (abstractNodeNumber - j);
-
-        // contains the number of the nodes that DO have stub
-    } else if (Ports[elementCode].pointerTypeStub == 3) {
-        for (j = 0; j < Ports[elementCode].quantitySavedStub; j++) {
-            // I do a loop until I can find the stubed-node that has an abstract
-            // number equal or greater than the abstract number I'm asking to get the real numbers.
-            // That is, the stubed-node from 0 until j-1 will influence the calculated
-            // stub offset that I'm asking
-            if (Ports[elementCode].nodesNumbers[j] >= abstractNodeNumber) {
-                break;
-            }
-        }
-        // j represents the quantity of nodes that have stub and has a number less than the
-        // abstractNodeNumber. Then, we add these extras js 
-        // 
-        // number of realPorts + offset done by previous stubs
-        // + offset done by previous nodes that have stub
-        output[2] = output[1] + Ports[elementCode].previousMaximumRealStubPort +
-                j;
-    }
+    output[0] = realNodeNumber + Ports[elementCode].previousMaximumRealNode;
+
+    output[1] = Ports[elementCode].portsPerNode * realNodeNumber +
+            Ports[elementCode].previousMaximumRealPort;
 
+    // number of realPorts + offset done by previous stubs
+    // + offset done by previous nodes that have stub
+    output[2] = output[1] + Ports[elementCode].previousMaximumRealStubPort +
+            stubsBefore_aPortToRealPort(&Ports[elementCode], realNodeNumber, NULL);
 
     return;
 }
@@ -4520,22 +5205,22 @@ unsigned int getNodeNumberAndPortOrderFromRealPortNumber(struct aPortToRealPort
     
     unsigned int i;
     // the element type of the realPort is the type that has at most
-    // the number of the real port number.
-    for (i = 0; i < 99; i++) {
-        // I will only see this if this element code has any real node allocated
-        if ((Ports[i + 1].previousMaximumRealPort - Ports[i].previousMaximumRealPort) > 0 &&
-                Ports[i + 1].previousMaximumRealPort > realPort) {
-
-            break;
-        }
-        // if I don't get into the 'if', then, the number of the element that has
-        // this port number shall be the element 100.
+    // the number of the real port number. I only visit the element codes
+    // that have real nodes. If none of them has it, the element that has
+    // this port number shall be the element 100.
+    i = Ports[0].nextMaterialCode;
+    while (i < 99 && Ports[i + 1].previousMaximumRealPort <= realPort) {
+        i = Ports[i + 1].nextMaterialCode;
     }
 
 
     *nodeNumber = (unsigned long long) ((realPort
             - Ports[i].previousMaximumRealPort) / Ports[i].portsPerNode);
 
+    // the number of the element in the mesh is the abstract one
+    if (Ports[i].abstractNodeOfRealNode != NULL)
+        *nodeNumber = Ports[i].abstractNodeOfRealNode[*nodeNumber];
+
     // 0, 1, 2, ... , or n-1
     *portOrder = (realPort - Ports[i].previousMaximumRealPort) % Ports[i].portsPerNode;
     
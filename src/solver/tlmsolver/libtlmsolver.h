@@ -44,6 +44,53 @@ extern "C" {
 #include "../../meshreader/libmeshtlmbht.h"
 #include "../libinterfaceceigen.h"
 
+    // up to this quantity of points, a level of the connection variable is
+    // searched linearly. Above it, the level gets a hash table (pointIndex).
+    // setLinearSearch_connectionLeveln changes it (the benchmark uses it)
+#define CONNECTION_LINEAR_SEARCH 16
+
+    // if the tags of the equation span up to this quantity of numbers, the table
+    // of tags is indexed by the tag. Otherwise, the tags are searched by bisection
+#define TAGS_DENSE_MAXIMUM 1048576
+
+    // topology cache (.tlc): this header, then the TLM numbers and the
+    // connection variable as they are after getTLMnumbers. The key is a hash of
+    // the mesh and of what getTLMnumbers uses from the equation, so the cache
+    // is only read if they did not change
+#define TLC_CACHE_MAGIC "TLCBIN\r\n"
+#define TLC_CACHE_VERSION 1
+
+    struct tlcCacheHeader {
+        char magic[8]; // TLC_CACHE_MAGIC, without '\0'
+        unsigned int version; // TLC_CACHE_VERSION
+        unsigned int byteOrder; // 0x01020304, as written by the computer
+        unsigned long long key; // see keyTopologyCacheTLM
+        // sizes of the structures in the computer that wrote the file
+        unsigned int sizeOfNumbers;
+        unsigned int sizeOfPorts;
+    };
+
+    // checkpoint (.tlr) of a dynamic simulation: this header, then the size of
+    // each output file when the checkpoint was written (-1 if the file is not
+    // used), the incident voltages, and the thermal doses of the statistics.
+    // There is only one, the last one, for the simulation
+#define TLR_CHECKPOINT_MAGIC "TLRBIN\r\n"
+#define TLR_CHECKPOINT_VERSION 1
+
+    struct tlrCheckpointHeader {
+        char magic[8]; // TLR_CHECKPOINT_MAGIC, without '\0'
+        unsigned int version; // TLR_CHECKPOINT_VERSION
+        unsigned int byteOrder; // 0x01020304, as written by the computer
+        int equation; // from 0
+        int quantityOfFiles; // output files of the scenarios and the file of the statistics
+        unsigned long long key; // see keyCheckpointTLM
+        unsigned long long iteration; // time-jumps already calculated
+        unsigned long long position; // position of the next output
+        double time; // time of the last output
+        unsigned long long sizeOfVi;
+        unsigned long long sizeOfDose;
+    };
+
     /*
      * the structure connectionLeveln is intended to find out where TLM nodes
      * (which are interpreted as element, in the finite element terminology) connect. 
@@ -63,6 +110,12 @@ extern "C" {
      * or points (at level > 0)
      * d) quantityAllocated: the size of the pointer
      * e) *innerLevel: allocated for level > 0.
+     * f) *pointIndex: open-addressing hash table (level > 0) that gives the
+     * position + 1 of a point in portsOrPoints (0 means empty). It is only
+     * created when the level holds more than CONNECTION_LINEAR_SEARCH points
+     * (or the quantity given to setLinearSearch_connectionLeveln)
+     * and it is released when the connection variable is wrapped.
+     * g) pointIndexSize: the size of pointIndex (power of two, or 0).
      */
 
     // level n: the connection per si. I have the quantity of ports (quantityOfPorts)
@@ -80,6 +133,9 @@ extern "C" {
         // each position has accumulated in total. Position 0 contains the the total number for that level
         // Useful to parallelize when I want
         // to read the intersection points.
+
+        unsigned long long *pointIndex;
+        unsigned long long pointIndexSize;
     };
 
 
@@ -166,6 +222,25 @@ extern "C" {
         // nodes that DO NOT have stub.
         // When pointerTypeStub == 3, nodesNumber has allocated the (sorted) number of the 
         // nodes that DO have stub.
+
+
+        // Tables used to convert the numbers in constant time. They are
+        // created by wrapTLMnumbers, which releases nodesNumbers and nodesNumbersStub
+        unsigned int nextMaterialCode;
+        // the smallest element code >= this one that has material nodes (99 if none)
+
+        unsigned long long *realNodeRank;
+        // used when pointerType == 2 or pointerType == 3. realNodeRank[n] is the
+        // quantity of material nodes with abstract number < n, i.e., the real
+        // number of the node n of this element code (size: elements + 1)
+
+        unsigned long long *abstractNodeOfRealNode;
+        // used when pointerType == 2 or pointerType == 3. Inverse of realNodeRank:
+        // the abstract number of each real node of this element code
+
+        unsigned long long *stubRank;
+        // used when pointerTypeStub == 2 or pointerTypeStub == 3. stubRank[r] is the
+        // quantity of real nodes with number < r that have stub (size: material nodes + 1)
     };
 
     struct TLMnumbers {
@@ -186,6 +261,18 @@ extern "C" {
         unsigned long long *NotDefinedElements;
 
         struct aPortToRealPort *abstractPortsToReal;
+
+        // the boundary or material of each tag of the equation. Created by
+        // initiateTagsTLMnumbers. Each code is 4*number + type, where type is
+        // 1 for boundary, 2 for material, and 0 (code 0) for not defined
+        long long tagMinimum;
+        // smallest tag
+        unsigned long long tagQuantity;
+        // size of tagCode
+        unsigned int *tagCode;
+        // code of each tag - tagMinimum (dense), or of each tag in tagSorted
+        long long *tagSorted;
+        // tags in increasing order. NULL if the table is dense
     };
 
     struct connectionAndBoundaryCoefficients {
@@ -258,6 +345,7 @@ extern "C" {
 
     unsigned int terminateBoundaryTypeAndData(struct boundaryData **, const struct dataForSimulation *, int);
 
+    void setLinearSearch_connectionLeveln(unsigned long long);
     unsigned int initiate_connectionLeveln(struct connectionLeveln *, unsigned int,
             unsigned long long *);
     unsigned int reallocate_connectionLeveln(struct connectionLeveln *, unsigned int);
@@ -294,10 +382,30 @@ extern "C" {
             struct TLMnumbers*, struct connectionLeveln *, int);
     unsigned int wrapTLMnumbers(const struct dataForSimulation *,
             struct TLMnumbers*, int);
-    unsigned int changeNodesNumbersType(unsigned long long **,
-            unsigned long long *, unsigned long long);
+
     unsigned int terminateTLMnumbers(struct TLMnumbers*);
 
+    unsigned int initiateTagsTLMnumbers(const struct dataForSimulation *,
+            struct TLMnumbers*, int);
+
+    unsigned long long keyTopologyCacheTLM(const struct dataForSimulation *, int);
+    unsigned int writeTopologyCacheTLM(const struct dataForSimulation *, const char *,
+            unsigned long long, const struct TLMnumbers*, const struct connectionLeveln *);
+    unsigned int readTopologyCacheTLM(const struct dataForSimulation *, const char *,
+            unsigned long long, struct TLMnumbers*, struct connectionLeveln *);
+
+    char *nameCheckpointTLM(const struct dataForSimulation *);
+    unsigned long long keyCheckpointTLM(const struct dataForSimulation *, int);
+    unsigned int findCheckpointTLM(struct dataForSimulation *);
+    long long syncOutputFileTLM(FILE *);
+    unsigned int truncateOutputFileTLM(FILE *, long long);
+    unsigned int writeCheckpointTLM(const char *, const struct tlrCheckpointHeader *,
+            const long long *, const double *, const double *);
+    unsigned int readCheckpointTLM(const char *, const struct tlrCheckpointHeader *,
+            struct tlrCheckpointHeader *, long long *, double *, double *);
+    unsigned int getTagTLMnumbers(const struct TLMnumbers*, unsigned long,
+            unsigned int *);
+
     unsigned int getNumberOfPortsGivenElement(unsigned int, enum dimSim);
 
 
@@ -309,6 +417,9 @@ extern "C" {
     unsigned int reallocate_aPortToRealPortStub(struct aPortToRealPort*);
     unsigned int add_to_aPortToRealPort(unsigned int, unsigned int, unsigned long long,
             struct aPortToRealPort*);
+    unsigned int rank_aPortToRealPort(const unsigned long long *, unsigned long long,
+            const unsigned long long *, unsigned long long, unsigned int,
+            unsigned long long **);
 
     unsigned int terminate_aPortToRealPort(struct aPortToRealPort**);
 
@@ -34,29 +34,181 @@
  */
 
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <stdexcept>
 #include <omp.h>
 #include <time.h>
 
+#include <Eigen/Dense>
+#include <unsupported/Eigen/IterativeSolvers>
+
 #include "libtlmsolvereigen.h"
 #include "../../miscellaneous/libwritetofiletlmbht.h"
+#include "../../miscellaneous/libmiscellaneous.h"
+
+/*
+ * BlockJacobiPreconditionerEigen: preconditioner for the iterative solvers of
+ * Eigen. I invert the block of I - M of each node, so the scattering inside the
+ * node is solved exactly and the solver only iterates the connections. The
+ * nodes must be set before compute and the matrix must be row-major.
+ */
+class BlockJacobiPreconditionerEigen {
+public:
+    typedef long long StorageIndex;
+
+    enum {
+        ColsAtCompileTime = Dynamic,
+        MaxColsAtCompileTime = Dynamic
+    };
+
+    BlockJacobiPreconditionerEigen() : quantityOfNodes(0), nodeFirstPort(NULL),
+    blockFirst(), inverse(), nThreads(1), m_info(Success) {
+    }
+
+    void setNodes(unsigned long long nodes, const long long *first, int threads) {
+        quantityOfNodes = nodes;
+        nodeFirstPort = first;
+        nThreads = threads;
+    }
+
+    Index rows() const {
+        return quantityOfNodes == 0 ? 0 : nodeFirstPort[quantityOfNodes];
+    }
+
+    Index cols() const {
+        return rows();
+    }
+
+    template<typename MatType>
+    BlockJacobiPreconditionerEigen& analyzePattern(const MatType &) {
+        long long n, size;
+
+        // position of the inverse of each block
+        blockFirst.resize(quantityOfNodes + 1);
+        blockFirst[0] = 0;
+        for (n = 0; n < (long long) quantityOfNodes; n++) {
+            size = nodeFirstPort[n + 1] - nodeFirstPort[n];
+            blockFirst[n + 1] = blockFirst[n] + size * size;
+        }
+        inverse.resize(blockFirst[quantityOfNodes]);
+
+        return *this;
+    }
+
+    template<typename MatType>
+    BlockJacobiPreconditionerEigen& factorize(const MatType &mat) {
+        long long n, p, size, singular = 0;
+
+        m_info = Success;
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(nThreads) schedule(static) private(p, size) reduction(+:singular)
+#endif
+        for (n = 0; n < (long long) quantityOfNodes; n++) {
+            const long long first = nodeFirstPort[n];
+            size = nodeFirstPort[n + 1] - first;
+            MatrixXd block = MatrixXd::Zero(size, size);
+            for (p = first; p < first + size; p++) {
+                for (typename MatType::InnerIterator it(mat, p); it; ++it) {
+                    if (it.col() >= first && it.col() < first + size)
+                        block(p - first, it.col() - first) = it.value();
+                }
+            }
+
+            FullPivLU<MatrixXd> lu(block);
+            if (lu.isInvertible()) {
+                Map<MatrixXd>(inverse.data() + blockFirst[n], size, size) = lu.inverse();
+            } else {
+                singular++;
+            }
+        }
+        if (singular > 0)
+            m_info = NumericalIssue;
+
+        return *this;
+    }
+
+    template<typename MatType>
+    BlockJacobiPreconditionerEigen& compute(const MatType &mat) {
+        return analyzePattern(mat).factorize(mat);
+    }
+
+    template<typename Rhs, typename Dest>
+    void _solve_impl(const Rhs &b, Dest &x) const {
+        long long n, size;
+
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(nThreads) schedule(static) private(size)
+#endif
+        for (n = 0; n < (long long) quantityOfNodes; n++) {
+            size = nodeFirstPort[n + 1] - nodeFirstPort[n];
+            x.segment(nodeFirstPort[n], size) =
+                    Map<const MatrixXd>(inverse.data() + blockFirst[n], size, size) *
+                    b.segment(nodeFirstPort[n], size);
+        }
+    }
+
+    template<typename Rhs>
+    inline const Solve<BlockJacobiPreconditionerEigen, Rhs> solve(const MatrixBase<Rhs> &b) const {
+        return Solve<BlockJacobiPreconditionerEigen, Rhs>(*this, b.derived());
+    }
+
+    ComputationInfo info() {
+        return m_info;
+    }
+
+private:
+    unsigned long long quantityOfNodes;
+    const long long *nodeFirstPort;
+    std::vector<long long> blockFirst;
+    VectorXd inverse;
+    int nThreads;
+    ComputationInfo m_info;
+};
 
 /*
  * initiate_matrices_calculationTLMEigen: allocate the memory for the matrices
  * used in the calculation process
  */
-unsigned int initiate_matrices_calculationTLMEigen(struct calculationTLMEigen *matrices,
-        unsigned int *quantityToReserve) {
+unsigned int initiate_matrices_calculationTLMEigen(struct calculationTLMEigen *matrices) {
 
     matrices->M.resize(matrices->numbers.Ports + matrices->numbers.StubPorts,
             matrices->numbers.Ports + matrices->numbers.StubPorts);
-    // this means that each column has reserved 'n' spaces
-    matrices->M.reserve(VectorXi::Constant(matrices->numbers.Ports + matrices->numbers.StubPorts,
-            quantityToReserve[0]));
+    // M and tau are built in tlmAssembleElementsEigen and tlmConnectPortsEigen
 
 
-    matrices->E.resize(matrices->numbers.Ports + matrices->numbers.StubPorts);
+    // E, Vi, and E_output are accumulated while the elements and the
+    // connections are calculated
+    matrices->E.setZero(matrices->numbers.Ports + matrices->numbers.StubPorts);
+
+    // the matrix-free engine is only allocated if required
+    matrices->matrixFree.used = 0;
+    matrices->matrixFree.quantityOfNodes = 0;
+    matrices->matrixFree.nodeFirstPort = NULL;
+    matrices->matrixFree.tau = NULL;
+    matrices->matrixFree.diagonal = NULL;
+    matrices->matrixFree.reflection = NULL;
+    matrices->matrixFree.transmission = NULL;
+    matrices->matrixFree.connectedPort = NULL;
+
+    // the node system is only allocated if required
+    matrices->nodeSystem.used = 0;
+    matrices->nodeSystem.portNode = NULL;
+    matrices->nodeSystem.otherPort = NULL;
+    matrices->nodeSystem.zConductance = NULL;
+    matrices->nodeSystem.zCurrent = NULL;
+
+    // the statistics are only allocated if required
+    matrices->statistics.used = 0;
+    matrices->statistics.file = NULL;
+
+    // the scenarios are only allocated if required
+    matrices->scenarios.quantity = 1;
+    matrices->scenarios.files.clear();
+
+    // the numbers and the connections are only kept by the sweeps
+    matrices->keepTopology = 0;
 
     // allocating for all the resistances
     if (((*matrices).R = (double*) malloc(sizeof (double)*matrices->numbers.Ports)) == NULL) {
@@ -68,7 +220,7 @@ unsigned int initiate_matrices_calculationTLMEigen(struct calculationTLMEigen *m
         return 8717;
     }
 
-    matrices->Vi.resize(matrices->numbers.Ports + matrices->numbers.StubPorts);
+    matrices->Vi.setZero(matrices->numbers.Ports + matrices->numbers.StubPorts);
 
     // allocating the characteristic length vector
     if (((*matrices).L = (double*) malloc(sizeof (double)*matrices->numbers.Ports)) == NULL) {
@@ -80,13 +232,16 @@ unsigned int initiate_matrices_calculationTLMEigen(struct calculationTLMEigen *m
         return 8726;
     }
 
+    // allocating the volumes of the nodes
+    if (((*matrices).volume = (double*) malloc(sizeof (double)*(matrices->numbers.Nodes + 1))) == NULL) {
+        return 8758;
+    }
+
 
     matrices->tau.resize(matrices->numbers.Output, matrices->numbers.Ports + matrices->numbers.StubPorts);
-    // this means that each line has reserved 'm' spaces
-    matrices->tau.reserve(VectorXi::Constant(matrices->numbers.Ports + matrices->numbers.StubPorts, quantityToReserve[1]));
     matrices->output.resize(matrices->numbers.Output);
 
-    matrices->E_output.resize(matrices->numbers.Output);
+    matrices->E_output.setZero(matrices->numbers.Output);
 
     // allocating the port's lengths
     if (((*matrices).Points_output = (struct Point*)
@@ -105,8 +260,11 @@ unsigned int terminate_matrices_calculationTLMEigen(struct calculationTLMEigen *
     // deallocating matrix M and tau columns
     matrices->M.resize(0, 0);
     matrices->tau.resize(0, 0);
+    matrices->tauRow.resize(0, 0);
     matrices->identity.resize(0, 0);
     matrices->Msteady.resize(0, 0);
+    matrices->MsteadyRow.resize(0, 0);
+    matrices->Mrow.resize(0, 0);
 
     matrices->E.resize(0);
 
@@ -117,6 +275,15 @@ unsigned int terminate_matrices_calculationTLMEigen(struct calculationTLMEigen *
     (*matrices).Z = NULL;
 
     matrices->Vi.resize(0);
+    matrices->Vi_next.resize(0);
+
+    std::vector< std::vector< Triplet<double, long long> > >().swap(matrices->tripletsM);
+    std::vector< std::vector< Triplet<double, long long> > >().swap(matrices->tripletsTau);
+
+    tlmTerminateMatrixFreeEigen(matrices);
+    tlmTerminateNodeSystemEigen(matrices);
+    tlmTerminateStatisticsEigen(matrices);
+    tlmTerminateScenariosEigen(matrices);
 
     free((*matrices).L);
     (*matrices).L = NULL;
@@ -124,6 +291,9 @@ unsigned int terminate_matrices_calculationTLMEigen(struct calculationTLMEigen *
     free((*matrices).deltal);
     (*matrices).deltal = NULL;
 
+    free((*matrices).volume);
+    (*matrices).volume = NULL;
+
     matrices->output.resize(0);
 
     matrices->E_output.resize(0);
@@ -131,7 +301,8 @@ unsigned int terminate_matrices_calculationTLMEigen(struct calculationTLMEigen *
     free((*matrices).Points_output);
     (*matrices).Points_output = NULL;
 
-    terminateTLMnumbers(&(matrices->numbers));
+    if (matrices->keepTopology == 0)
+        terminateTLMnumbers(&(matrices->numbers));
 
 
     return 0;
@@ -141,17 +312,41 @@ unsigned int terminate_matrices_calculationTLMEigen(struct calculationTLMEigen *
  * tlmInitializeSteadyMatrices: Initiate the matrices used to solve steady-state
  * problems in the TLM method
  */
-unsigned int tlmInitializeSteadyMatrices(struct calculationTLMEigen *matrices) {
+unsigned int tlmInitializeSteadyMatrices(struct calculationTLMEigen *matrices,
+        const struct Equation *equation) {
+
+    // the node system was assembled with the connections
+    if (equation->SteadySolver == NODE_CG) {
+        struct nodeSystemTLMEigen *ns = &(matrices->nodeSystem);
+        ns->A.resize(ns->b.size(), ns->b.size());
+        ns->A.setFromTriplets(ns->triplets.begin(), ns->triplets.end());
+        ns->A.makeCompressed();
+        std::vector< Triplet<double, long long> >().swap(ns->triplets);
+        return 0;
+    }
 
     matrices->identity.resize(matrices->numbers.Ports, matrices->numbers.Ports);
-    matrices->M.reserve(VectorXi::Constant(matrices->numbers.Ports, 1));
+    matrices->identity.reserve(VectorXi::Constant(matrices->numbers.Ports, 1));
     for (unsigned long long i = 0; i < matrices->numbers.Ports; i++)
         matrices->identity.insert(i, i) = 1;
     matrices->identity.makeCompressed();
 
-    matrices->Msteady.resize(matrices->numbers.Ports, matrices->numbers.Ports);
-    matrices->Msteady = matrices->identity - matrices->M;
-    matrices->Msteady.makeCompressed();
+    if (equation->SteadySolver == DIRECT_LU) {
+        matrices->Msteady.resize(matrices->numbers.Ports, matrices->numbers.Ports);
+        matrices->Msteady = matrices->identity - matrices->M;
+        matrices->Msteady.makeCompressed();
+    } else {
+        // the iterative solvers only multiply by I - M. Eigen does this product
+        // with OpenMP if the matrix is row-major. M and the identity are not
+        // used anymore.
+        matrices->MsteadyRow = matrices->identity - matrices->M;
+        matrices->MsteadyRow.makeCompressed();
+
+        matrices->M.resize(0, 0);
+        matrices->M.data().squeeze();
+        matrices->identity.resize(0, 0);
+        matrices->identity.data().squeeze();
+    }
 
 
     return 0;
@@ -176,10 +371,14 @@ unsigned int terminateSome_calculationTLMEigen(struct calculationTLMEigen * matr
     free((*matrices).deltal);
     (*matrices).deltal = NULL;
 
+    free((*matrices).volume);
+    (*matrices).volume = NULL;
+
     free((*matrices).Points_output);
     (*matrices).Points_output = NULL;
 
-    terminateTLMnumbers(&(matrices->numbers));
+    if (matrices->keepTopology == 0)
+        terminateTLMnumbers(&(matrices->numbers));
 
     return 0;
 }
@@ -194,220 +393,2683 @@ unsigned int terminateSomeVariablesEigen(struct dataForSimulation *input,
 
     terminateSome_calculationTLMEigen(matrices);
 
+    // the boundaries have the parameters of the point of the sweep
     terminateBoundaryTypeAndData(boundaries, input, id);
 
-    terminate_connectionLeveln(connection);
+    if (matrices->keepTopology == 0)
+        terminate_connectionLeveln(connection);
 
 
     return 0;
 }
 
 /*
- * tlmSolveMatricesTimeDomainEigen: solve the TLM matrix equation in time-domain and write
- * data to file
+ * tlmInitiateElementTripletsEigen: allocate one list of entries of M and one of
+ * tau for each thread that calculates the elements
  */
-unsigned int tlmSolveMatricesTimeDomainEigen(struct calculationTLMEigen * matrices,
-        struct dataForSimulation * input, int id) {
+unsigned int tlmInitiateElementTripletsEigen(struct calculationTLMEigen *matrices,
+        int nThreads) {
 
-    printf("\n\nSolving dynamic problem for equation %04d directly...\n", id + 1);
+    if (nThreads < 1) {
+        nThreads = 1;
+    }
+    matrices->tripletsM.assign(nThreads, std::vector< Triplet<double, long long> >());
+    matrices->tripletsTau.assign(nThreads, std::vector< Triplet<double, long long> >());
 
-    unsigned long long quantityOfIterations, position = 1;
-    double time;
+    return 0;
+}
 
-    clock_t begin_Vi, end_Vi, begin_T, end_T, begin_write, end_write;
-    double time_Vi, time_T, time_write;
-    time_Vi = 0;
-    time_T = 0;
-    time_write = 0;
+/*
+ * tlmSortColumnEigen: sort the entries of a column by their line
+ */
+static void tlmSortColumnEigen(long long *line, double *value, long long quantity) {
 
-    quantityOfIterations = input->equationInput[id].finalTime / (
-            input->equationInput[id].timeStep *
-            input->equationInput[id].timeJump);
+    long long i, j, l;
+    double v;
 
-    //    clock_t begin_JM, end_JM;
-    //    begin_JM = clock();
-    //    if (input->simulationInput.timeJump != 1)
-    //        adjustTimeJumpEigen(matrices, input->simulationInput.timeJump);
-    //    end_JM = clock();
-    //        double time_JM = (double) (end_JM - begin_JM) / CLOCKS_PER_SEC;
-    for (unsigned long long i = 0; i < quantityOfIterations; i++) {
-        time = (i) *
-                input->equationInput[id].timeStep *
-                input->equationInput[id].timeJump +
-                (1) *
-                input->equationInput[id].timeStep;
+    for (i = 1; i < quantity; i++) {
+        l = line[i];
+        v = value[i];
+        for (j = i; j > 0 && line[j - 1] > l; j--) {
+            line[j] = line[j - 1];
+            value[j] = value[j - 1];
+        }
+        line[j] = l;
+        value[j] = v;
+    }
+}
 
-        printf("Calculating for time %g s to ", time);
-        time = (i) *
-                input->equationInput[id].timeStep *
-                input->equationInput[id].timeJump +
-                (input->equationInput[id].timeJump) *
-                input->equationInput[id].timeStep;
-        printf("%g s...", time);
+/*
+ * tlmBuildFromTripletsEigen: build A, compressed, from the lists of the
+ * threads and free the lists. Each list has the entries of whole elements and
+ * the elements do not share ports, so the lists have different columns of A.
+ * Then, each thread counts and saves the entries of its list, and each column
+ * is sorted by one thread
+ */
+static void tlmBuildFromTripletsEigen(SparseMatrix<double, ColMajor, long long> &A,
+        std::vector< std::vector< Triplet<double, long long> > > &triplets) {
+
+    long long t, q, nThreads = triplets.size(), cols = A.cols();
+    size_t i;
 
-        for (unsigned long long j = 0; j < input->equationInput[id].timeJump; j++) {
+    A.resize(A.rows(), cols);
+    A.makeCompressed();
+    long long *outer = A.outerIndexPtr();
+    for (q = 0; q <= cols; q++) {
+        outer[q] = 0;
+    }
 
-            // Calculate Vi_(k+1)
-            begin_Vi = clock();
-            matrices->Vi = matrices->M * matrices->Vi + matrices->E;
-            end_Vi = clock();
-            time_Vi += (double) (end_Vi - begin_Vi) / CLOCKS_PER_SEC;
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(static, 1) num_threads(nThreads) private(i)
+#endif
+    for (t = 0; t < nThreads; t++) {
+        for (i = 0; i < triplets[t].size(); i++) {
+            outer[triplets[t][i].col() + 1]++;
+        }
+    }
+    for (q = 0; q < cols; q++) {
+        outer[q + 1] += outer[q];
+    }
+    A.resizeNonZeros(outer[cols]);
+    long long *line = A.innerIndexPtr();
+    double *value = A.valuePtr();
+    std::vector<long long> position(outer, outer + cols);
+
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(static, 1) num_threads(nThreads) private(i)
+#endif
+    for (t = 0; t < nThreads; t++) {
+        for (i = 0; i < triplets[t].size(); i++) {
+            const Triplet<double, long long> &e = triplets[t][i];
+            line[position[e.col()]] = e.row();
+            value[position[e.col()]++] = e.value();
         }
+        std::vector< Triplet<double, long long> >().swap(triplets[t]);
+    }
 
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(static) num_threads(nThreads)
+#endif
+    for (q = 0; q < cols; q++) {
+        tlmSortColumnEigen(line + outer[q], value + outer[q], outer[q + 1] - outer[q]);
+    }
+}
 
-        // calculate the output at k+1
-        if (input->simulationInput.printAdditionalMode == 1) {
-            printf("\nCalculating the output...\n");
+/*
+ * tlmAssembleElementsEigen: build M and tau from the entries that the threads
+ * saved while calculating the elements, and free the lists. M is S, the
+ * scattering matrix, until tlmConnectPortsEigen
+ */
+unsigned int tlmAssembleElementsEigen(struct calculationTLMEigen *matrices) {
+
+    tlmBuildFromTripletsEigen(matrices->M, matrices->tripletsM);
+    tlmBuildFromTripletsEigen(matrices->tau, matrices->tripletsTau);
+    std::vector< std::vector< Triplet<double, long long> > >().swap(matrices->tripletsM);
+    std::vector< std::vector< Triplet<double, long long> > >().swap(matrices->tripletsTau);
+
+    return 0;
+}
+
+/*
+ * tlmSortPortTargetsEigen: sort the targets by the port they come from, so
+ * targets[first[p]] to targets[first[p + 1] - 1] are the targets of port p
+ */
+static void tlmSortPortTargetsEigen(std::vector< Triplet<double, long long> > &targets,
+        long long ports, std::vector<long long> &first, std::vector<long long> &line,
+        std::vector<double> &value) {
+
+    size_t t;
+    long long p;
+
+    first.assign(ports + 1, 0);
+    for (t = 0; t < targets.size(); t++) {
+        first[targets[t].row() + 1]++;
+    }
+    for (p = 0; p < ports; p++) {
+        first[p + 1] += first[p];
+    }
+    std::vector<long long> position(first.begin(), first.end() - 1);
+    line.resize(targets.size());
+    value.resize(targets.size());
+    for (t = 0; t < targets.size(); t++) {
+        line[position[targets[t].row()]] = targets[t].col();
+        value[position[targets[t].row()]++] = targets[t].value();
+    }
+    std::vector< Triplet<double, long long> >().swap(targets);
+}
+
+/*
+ * tlmConnectPortsEigen: include the connections in M and tau. M must have
+ * only S. The line of S of port p goes to:
+ * - line p of M, times reflection[p];
+ * - line t of M, times c, for each (p, t, c) in transmission;
+ * - line o of tau, times c, for each (p, o, c) in output.
+ * The elements do not share ports, so each column of S only has the lines of
+ * the ports of its node. I build each column of M and tau from the same column
+ * of S and so there is no search in M. The columns are independent, and I
+ * split them among the threads. If buildM is 0, M is released and only tau is
+ * built. The intersections connect ports of different nodes, so no entry is
+ * repeated
+ */
+unsigned int tlmConnectPortsEigen(struct calculationTLMEigen *matrices,
+        const std::vector<double> &reflection,
+        std::vector< Triplet<double, long long> > &transmission,
+        std::vector< Triplet<double, long long> > &output, int buildM, int nThreads) {
+
+    SparseMatrix<double, ColMajor, long long> S, tauS;
+    std::vector<long long> firstT, lineT, firstO, lineO;
+    std::vector<double> valueT, valueO;
+    long long ports = matrices->M.cols(), q, k, r, t, n, nnzM = 0, nnzTau = 0;
+
+    S.swap(matrices->M);
+    S.makeCompressed(); // it already is, see tlmAssembleElementsEigen
+    tauS.swap(matrices->tau);
+    tauS.makeCompressed();
+    const long long *outerS = S.outerIndexPtr(), *lineS = S.innerIndexPtr();
+    const double *valueS = S.valuePtr();
+    const long long *outerTauS = tauS.outerIndexPtr(), *lineTauS = tauS.innerIndexPtr();
+    const double *valueTauS = tauS.valuePtr();
+
+    tlmSortPortTargetsEigen(transmission, ports, firstT, lineT, valueT);
+    tlmSortPortTargetsEigen(output, ports, firstO, lineO, valueO);
+
+    matrices->M.resize(buildM ? ports : 0, buildM ? ports : 0);
+    matrices->M.makeCompressed();
+    matrices->tau.resize(tauS.rows(), ports);
+    matrices->tau.makeCompressed();
+    long long *outerM = buildM ? matrices->M.outerIndexPtr() : NULL;
+    long long *outerTau = matrices->tau.outerIndexPtr();
+
+    // quantity of entries of each column
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(static) num_threads(nThreads) private(k, r) reduction(+:nnzM, nnzTau)
+#endif
+    for (q = 0; q < ports; q++) {
+        long long quantityM = 0, quantityTau = outerTauS[q + 1] - outerTauS[q];
+        for (k = outerS[q]; k < outerS[q + 1]; k++) {
+            r = lineS[k];
+            quantityM += 1 + firstT[r + 1] - firstT[r];
+            quantityTau += firstO[r + 1] - firstO[r];
         }
-        begin_T = clock();
-        matrices->output = matrices->tau * matrices->Vi + matrices->E_output;
-        end_T = clock();
-        time_T += (double) (end_T - begin_T) / CLOCKS_PER_SEC;
+        if (buildM) {
+            outerM[q + 1] = quantityM;
+        }
+        outerTau[q + 1] = quantityTau;
+        nnzM += quantityM;
+        nnzTau += quantityTau;
+    }
+    outerTau[0] = 0;
+    for (q = 0; q < ports; q++) {
+        outerTau[q + 1] += outerTau[q];
+    }
+    matrices->tau.resizeNonZeros(nnzTau);
+    long long *lineTau = matrices->tau.innerIndexPtr();
+    double *valueTau = matrices->tau.valuePtr();
+    long long *lineM = NULL;
+    double *valueM = NULL;
+    if (buildM) {
+        outerM[0] = 0;
+        for (q = 0; q < ports; q++) {
+            outerM[q + 1] += outerM[q];
+        }
+        matrices->M.resizeNonZeros(nnzM);
+        lineM = matrices->M.innerIndexPtr();
+        valueM = matrices->M.valuePtr();
+    }
 
-        if (input->simulationInput.printAdditionalMode == 1) {
-            printf("Writing data to file...\n");
+    // the entries of each column
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(static) num_threads(nThreads) private(k, r, t, n)
+#endif
+    for (q = 0; q < ports; q++) {
+        if (buildM) {
+            n = outerM[q];
+            for (k = outerS[q]; k < outerS[q + 1]; k++) {
+                r = lineS[k];
+                lineM[n] = r;
+                valueM[n++] = reflection[r] * valueS[k];
+                for (t = firstT[r]; t < firstT[r + 1]; t++) {
+                    lineM[n] = lineT[t];
+                    valueM[n++] = valueT[t] * valueS[k];
+                }
+            }
+            tlmSortColumnEigen(lineM + outerM[q], valueM + outerM[q], n - outerM[q]);
         }
-        begin_write = clock();
-        writePartialOutput(input, matrices, id, position);
-        end_write = clock();
-        time_write += (double) (end_write - begin_write) / CLOCKS_PER_SEC;
 
-        printf("Done\n\n");
-        position++;
+        n = outerTau[q];
+        for (k = outerTauS[q]; k < outerTauS[q + 1]; k++) {
+            lineTau[n] = lineTauS[k];
+            valueTau[n++] = valueTauS[k];
+        }
+        for (k = outerS[q]; k < outerS[q + 1]; k++) {
+            r = lineS[k];
+            for (t = firstO[r]; t < firstO[r + 1]; t++) {
+                lineTau[n] = lineO[t];
+                valueTau[n++] = valueO[t] * valueS[k];
+            }
+        }
+        tlmSortColumnEigen(lineTau + outerTau[q], valueTau + outerTau[q], n - outerTau[q]);
     }
 
-    printf("Done solving dynamic problem for equation %04d directly.\n", id + 1);
+    return 0;
+}
 
-    if (input->simulationInput.timingMode == 1) {
+/*
+ * tlmFindNodesEigen: find the ports of each node. It must be called after the
+ * scattering matrix S was calculated in M and before the connections. The ports
+ * of a node are consecutive and they are the lines of the first column of its
+ * block of S. The nodes are saved in matrixFree, even if M is used.
+ */
+unsigned int tlmFindNodesEigen(struct calculationTLMEigen *matrices) {
+
+    struct matrixFreeTLMEigen *mf = &(matrices->matrixFree);
+    long long ports = matrices->M.rows(), p, q, last, n;
 
-        printf("Time to calculate the incident voltages %g ms (or %g s, or %g min, or %g hours).\n",
-                time_Vi * 1e3, time_Vi, time_Vi / 60.0, time_Vi / (60 * 60));
+    mf->nodeFirstPort = (long long*) realloc(mf->nodeFirstPort, sizeof (long long)*(ports + 1));
+    if (mf->nodeFirstPort == NULL) {
+        return 8746;
+    }
+
+    n = 0;
+    p = 0;
+    while (p < ports) {
+        mf->nodeFirstPort[n] = p;
+
+        // the ports of this node are the lines of column p
+        last = p;
+        for (SparseMatrix<double, ColMajor, long long>::InnerIterator it(matrices->M, p); it; ++it) {
+            if (it.row() > last)
+                last = it.row();
+        }
 
-        printf("Time to calculate the outputs %g ms (or %g s, or %g min, or %g hours).\n",
-                time_T * 1e3, time_T, time_T / 60.0, time_T / (60 * 60));
+        // a port of this node cannot scatter into other nodes
+        for (q = p; q <= last; q++) {
+            for (SparseMatrix<double, ColMajor, long long>::InnerIterator it(matrices->M, q); it; ++it) {
+                if (it.row() < p || it.row() > last)
+                    return 8751;
+            }
+        }
 
-        printf("Time to write the outputs %g ms (or %g s, or %g min, or %g hours).\n",
-                time_write * 1e3, time_write, time_write / 60.0, time_write / (60 * 60));
+        n++;
+        p = last + 1;
     }
+    mf->nodeFirstPort[n] = ports;
+    mf->quantityOfNodes = n;
+    mf->nodeFirstPort = (long long*) realloc(mf->nodeFirstPort, sizeof (long long)*(n + 1));
 
     return 0;
+}
+
+/*
+ * tlmInitiateMatrixFreeEigen: prepare the matrix-free engine. It must be called
+ * after the scattering matrix S was calculated in M and before the connections.
+ * Each node is a block of S with S(p, q) = tau[q] for p != q. I save only tau
+ * and the diagonal of each port.
+ */
+unsigned int tlmInitiateMatrixFreeEigen(struct calculationTLMEigen *matrices) {
+
+    unsigned int errorTLMnumber;
+    struct matrixFreeTLMEigen *mf = &(matrices->matrixFree);
+    long long ports = matrices->M.rows(), p, q, last, n, count, tauDefined;
+    double diagonal;
+
+    if ((errorTLMnumber = tlmFindNodesEigen(matrices)) != 0)
+        return errorTLMnumber;
+
+    mf->tau = (double*) malloc(sizeof (double)*ports);
+    mf->diagonal = (double*) malloc(sizeof (double)*ports);
+    mf->reflection = (double*) malloc(sizeof (double)*ports);
+    mf->transmission = (double*) malloc(sizeof (double)*ports);
+    mf->connectedPort = (long long*) malloc(sizeof (long long)*ports);
+    mf->used = 1;
+
+    if (mf->tau == NULL || mf->diagonal == NULL || mf->reflection == NULL ||
+            mf->transmission == NULL || mf->connectedPort == NULL) {
+        return 8746;
+    }
+
+    for (n = 0; n < (long long) mf->quantityOfNodes; n++) {
+        p = mf->nodeFirstPort[n];
+        last = mf->nodeFirstPort[n + 1] - 1;
+
+        for (q = p; q <= last; q++) {
+            mf->tau[q] = 0;
+            diagonal = 0;
+            count = 0;
+            tauDefined = 0;
+            for (SparseMatrix<double, ColMajor, long long>::InnerIterator it(matrices->M, q); it; ++it) {
+                count++;
+                if (it.row() == q) {
+                    diagonal = it.value();
+                } else if (tauDefined == 0) {
+                    mf->tau[q] = it.value();
+                    tauDefined = 1;
+                } else if (it.value() != mf->tau[q]) {
+                    return 8751;
+                }
+            }
+            if (last > p && count != last - p + 1)
+                return 8751;
+
+            mf->diagonal[q] = diagonal;
+
+            // until the connections are calculated, each port reflects
+            // everything back into itself
+            mf->reflection[q] = 1;
+            mf->transmission[q] = 0;
+            mf->connectedPort[q] = q;
+        }
+    }
+
+    mf->Vr.resize(ports);
 
+    return 0;
 }
 
 /*
- * tlmSolveMatricesSteadyStateEigen: solve the TLM matrix equation for steady-state
- * and write data to file
+ * tlmTerminateMatrixFreeEigen: deallocate the variables of the matrix-free engine
  */
-unsigned int tlmSolveMatricesSteadyStateEigen(struct calculationTLMEigen * matrices,
-        struct dataForSimulation * input, int id) {
+unsigned int tlmTerminateMatrixFreeEigen(struct calculationTLMEigen *matrices) {
 
-    unsigned long long position = 1;
-    SparseLU< SparseMatrix<double, ColMajor, long long>, COLAMDOrdering<long long> > solver;
+    free(matrices->matrixFree.nodeFirstPort);
+    matrices->matrixFree.nodeFirstPort = NULL;
 
-    clock_t begin_Vi, end_Vi, begin_T, end_T, begin_write, end_write;
-    double time_Vi, time_T, time_write;
-    time_Vi = 0;
-    time_T = 0;
-    time_write = 0;
+    free(matrices->matrixFree.tau);
+    matrices->matrixFree.tau = NULL;
 
-    printf("\n\nSolving the steady-state problem for equation %04d directly...\n", id);
+    free(matrices->matrixFree.diagonal);
+    matrices->matrixFree.diagonal = NULL;
 
-    if (input->simulationInput.printAdditionalMode == 1) {
-        printf("Solving Vi using LU...\n");
+    free(matrices->matrixFree.reflection);
+    matrices->matrixFree.reflection = NULL;
+
+    free(matrices->matrixFree.transmission);
+    matrices->matrixFree.transmission = NULL;
+
+    free(matrices->matrixFree.connectedPort);
+    matrices->matrixFree.connectedPort = NULL;
+
+    matrices->matrixFree.Vr.resize(0);
+    matrices->matrixFree.used = 0;
+
+    return 0;
+}
+
+/*
+ * tlmCuthillMcKeeEigen: breadth-first search from start over the nodes not
+ * marked with mark. The neighbours of each node are visited in increasing
+ * order of degree and appended to order
+ */
+static void tlmCuthillMcKeeEigen(long long start, const std::vector<long long> &neighbourFirst,
+        const std::vector<long long> &neighbours, std::vector<long long> &visited,
+        long long mark, std::vector<long long> &order) {
+
+    std::vector< std::pair<long long, long long> > next;
+    long long head = order.size(), n, k, m;
+
+    visited[start] = mark;
+    order.push_back(start);
+    while (head < (long long) order.size()) {
+        n = order[head++];
+        next.clear();
+        for (k = neighbourFirst[n]; k < neighbourFirst[n + 1]; k++) {
+            m = neighbours[k];
+            if (visited[m] != mark) {
+                visited[m] = mark;
+                next.push_back(std::make_pair(neighbourFirst[m + 1] - neighbourFirst[m], m));
+            }
+        }
+        std::sort(next.begin(), next.end());
+        for (k = 0; k < (long long) next.size(); k++)
+            order.push_back(next[k].second);
     }
+}
 
-    // Calculate Vi_(steady)
-    begin_Vi = clock();
-    solver.analyzePattern(matrices->Msteady);
-    solver.factorize(matrices->Msteady);
-    // if(solver.info() != Success) // decomposition failed
-    matrices->Vi = solver.solve(matrices->E);
-    // if(solver.info() != Success) // solver failed
-    end_Vi = clock();
-    time_Vi += (double) (end_Vi - begin_Vi) / CLOCKS_PER_SEC;
+/*
+ * tlmMortonKeyEigen: interleave the bits of the three coordinates, scaled to
+ * 21 bits each, so that nodes close in space get close keys
+ */
+static unsigned long long tlmMortonKeyEigen(const unsigned long long *coordinate) {
 
+    unsigned long long key = 0;
+    int b, k;
 
-    // calculate the output at k+1
-    if (input->simulationInput.printAdditionalMode == 1) {
-        printf("Calculating the output...\n");
+    for (b = 0; b < 21; b++)
+        for (k = 0; k < 3; k++)
+            key |= ((coordinate[k] >> b) & 1ULL) << (3 * b + k);
+
+    return key;
+}
+
+/*
+ * tlmRenumberNodesEigen: renumber the ports so that connected nodes are close
+ * in Vi, and the rows of M read Vi from a few cache lines. The ports of a node
+ * stay together, so I move the nodes found by tlmFindNodesEigen, while M was
+ * still S, in the order of the reverse Cuthill-McKee over the connections of
+ * the nodes or of the Morton curve over their centers. M, E, Vi, the columns
+ * of tau, and the coefficients of the matrix-free engine are permuted. The
+ * lines of tau are not, so the output keeps the order of the mesh.
+ */
+unsigned int tlmRenumberNodesEigen(struct calculationTLMEigen *matrices,
+        enum renumbering method, int nThreads, int verbose) {
+
+    struct matrixFreeTLMEigen *mf = &(matrices->matrixFree);
+    const long long nodes = mf->quantityOfNodes, ports = matrices->Vi.size();
+    long long n, m, p, q, k, t, next, edges;
+    double distanceBefore, distanceAfter;
+
+    if (mf->nodeFirstPort == NULL || nodes == 0 || mf->nodeFirstPort[nodes] != ports)
+        return 8751;
+    const long long *first = mf->nodeFirstPort;
+
+    std::vector<long long> portNode(ports);
+    for (n = 0; n < nodes; n++)
+        for (p = first[n]; p < first[n + 1]; p++)
+            portNode[p] = n;
+
+    // nodes connected to each node. Column first[n] of M = C*S has the ports
+    // of node n and the ports connected to them
+    std::vector<long long> neighbourFirst(nodes + 1), neighbours, visited(nodes, -1);
+    neighbours.reserve(2 * (ports - nodes));
+    for (n = 0; n < nodes; n++) {
+        neighbourFirst[n] = neighbours.size();
+        visited[n] = n;
+        if (mf->used == 1) {
+            for (p = first[n]; p < first[n + 1]; p++) {
+                m = portNode[mf->connectedPort[p]];
+                if (visited[m] != n) {
+                    visited[m] = n;
+                    neighbours.push_back(m);
+                }
+            }
+        } else {
+            for (SparseMatrix<double, ColMajor, long long>::InnerIterator it(matrices->M, first[n]); it; ++it) {
+                m = portNode[it.row()];
+                if (visited[m] != n) {
+                    visited[m] = n;
+                    neighbours.push_back(m);
+                }
+            }
+        }
+    }
+    neighbourFirst[nodes] = neighbours.size();
+
+    // order[k] is the node that goes to position k
+    std::vector<long long> order;
+    order.reserve(nodes);
+    if (method == REVERSE_CUTHILL_MCKEE) {
+        // each connected part starts from a node far from its node of lowest
+        // degree: the last one found by a first search from it
+        std::vector< std::pair<long long, long long> > byDegree(nodes);
+        std::vector<long long> level;
+        for (n = 0; n < nodes; n++) {
+            byDegree[n] = std::make_pair(neighbourFirst[n + 1] - neighbourFirst[n], n);
+            visited[n] = 0;
+        }
+        std::sort(byDegree.begin(), byDegree.end());
+        for (k = 0; k < nodes; k++) {
+            n = byDegree[k].second;
+            if (visited[n] == 1)
+                continue;
+            level.clear();
+            tlmCuthillMcKeeEigen(n, neighbourFirst, neighbours, visited, -1, level);
+            tlmCuthillMcKeeEigen(level.back(), neighbourFirst, neighbours, visited, 1, order);
+        }
+        std::reverse(order.begin(), order.end());
+    } else {
+        // the center of the node is its output point. Its line is the first
+        // of tau in the column of its first port
+        std::vector< std::pair<unsigned long long, long long> > byKey(nodes);
+        std::vector<struct Point> center(nodes);
+        struct Point lowest, highest;
+        unsigned long long coordinate[3];
+        double scale[3];
+        for (n = 0; n < nodes; n++) {
+            SparseMatrix<double, ColMajor, long long>::InnerIterator it(matrices->tau, first[n]);
+            if (!it || it.row() >= (long long) matrices->numbers.Points_Output)
+                return 8751;
+            center[n] = matrices->Points_output[it.row()];
+        }
+        lowest = highest = center[0];
+        for (n = 1; n < nodes; n++) {
+            lowest.x = center[n].x < lowest.x ? center[n].x : lowest.x;
+            lowest.y = center[n].y < lowest.y ? center[n].y : lowest.y;
+            lowest.z = center[n].z < lowest.z ? center[n].z : lowest.z;
+            highest.x = center[n].x > highest.x ? center[n].x : highest.x;
+            highest.y = center[n].y > highest.y ? center[n].y : highest.y;
+            highest.z = center[n].z > highest.z ? center[n].z : highest.z;
+        }
+        scale[0] = highest.x > lowest.x ? 2097151.0 / (highest.x - lowest.x) : 0;
+        scale[1] = highest.y > lowest.y ? 2097151.0 / (highest.y - lowest.y) : 0;
+        scale[2] = highest.z > lowest.z ? 2097151.0 / (highest.z - lowest.z) : 0;
+        for (n = 0; n < nodes; n++) {
+            coordinate[0] = (unsigned long long) ((center[n].x - lowest.x) * scale[0]);
+            coordinate[1] = (unsigned long long) ((center[n].y - lowest.y) * scale[1]);
+            coordinate[2] = (unsigned long long) ((center[n].z - lowest.z) * scale[2]);
+            byKey[n] = std::make_pair(tlmMortonKeyEigen(coordinate), n);
+        }
+        std::sort(byKey.begin(), byKey.end());
+        for (n = 0; n < nodes; n++)
+            order.push_back(byKey[n].second);
     }
-    begin_T = clock();
-    matrices->output = matrices->tau * matrices->Vi + matrices->E_output;
-    end_T = clock();
-    time_T += (double) (end_T - begin_T) / CLOCKS_PER_SEC;
 
+    // new position of each node and new number of each port
+    std::vector<long long> position(nodes), newFirst(nodes + 1), newPort(ports);
+    newFirst[0] = 0;
+    for (k = 0; k < nodes; k++) {
+        n = order[k];
+        position[n] = k;
+        newFirst[k + 1] = newFirst[k] + first[n + 1] - first[n];
+        for (p = first[n]; p < first[n + 1]; p++)
+            newPort[p] = newFirst[k] + p - first[n];
+    }
 
-    // saving the data
-    if (input->simulationInput.printAdditionalMode == 1) {
-        printf("Writing data to file...\n");
+    if (verbose == 1) {
+        distanceBefore = 0;
+        distanceAfter = 0;
+        for (n = 0; n < nodes; n++) {
+            for (k = neighbourFirst[n]; k < neighbourFirst[n + 1]; k++) {
+                m = neighbours[k];
+                distanceBefore += n > m ? n - m : m - n;
+                distanceAfter += position[n] > position[m] ? position[n] - position[m] : position[m] - position[n];
+            }
+        }
+        edges = neighbours.size() > 0 ? neighbours.size() : 1;
+        printf("Renumbered %lld nodes with %s. Mean distance between connected nodes: %g before and %g after.\n",
+                nodes, method == REVERSE_CUTHILL_MCKEE ? "reverse Cuthill-McKee" : "the Morton curve",
+                distanceBefore / edges, distanceAfter / edges);
     }
-    begin_write = clock();
-    writePartialOutput(input, matrices, id, position);
-    end_write = clock();
-    time_write += (double) (end_write - begin_write) / CLOCKS_PER_SEC;
-    printf("\nDone solving the steady-state problem for equation %04d directly.\n", id);
 
-    if (input->simulationInput.timingMode == 1) {
+    // Vi and E
+    VectorXd permuted(ports);
+    for (p = 0; p < ports; p++)
+        permuted(newPort[p]) = matrices->Vi(p);
+    matrices->Vi.swap(permuted);
+    for (p = 0; p < ports; p++)
+        permuted(newPort[p]) = matrices->E(p);
+    matrices->E.swap(permuted);
+
+    // M moves its lines and columns; tau only its columns. Column q goes to
+    // column newPort[q], so I build the new ones from the old ones
+    if (matrices->M.rows() == ports) {
+        SparseMatrix<double, ColMajor, long long> old;
+        old.swap(matrices->M);
+        old.makeCompressed();
+        matrices->M.resize(ports, ports);
+        matrices->M.makeCompressed();
+        matrices->M.resizeNonZeros(old.nonZeros());
+        const long long *outerOld = old.outerIndexPtr(), *lineOld = old.innerIndexPtr();
+        const double *valueOld = old.valuePtr();
+        long long *outer = matrices->M.outerIndexPtr(), *line = matrices->M.innerIndexPtr();
+        double *value = matrices->M.valuePtr();
+        outer[0] = 0;
+        for (k = 0; k < nodes; k++)
+            for (p = first[order[k]]; p < first[order[k] + 1]; p++)
+                outer[newPort[p] + 1] = outer[newPort[p]] + outerOld[p + 1] - outerOld[p];
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(static) num_threads(nThreads) private(t, next)
+#endif
+        for (q = 0; q < ports; q++) {
+            next = outer[newPort[q]];
+            for (t = outerOld[q]; t < outerOld[q + 1]; t++) {
+                line[next] = newPort[lineOld[t]];
+                value[next++] = valueOld[t];
+            }
+            tlmSortColumnEigen(line + outer[newPort[q]], value + outer[newPort[q]],
+                    outerOld[q + 1] - outerOld[q]);
+        }
+    }
+    {
+        SparseMatrix<double, ColMajor, long long> old;
+        old.swap(matrices->tau);
+        old.makeCompressed();
+        matrices->tau.resize(old.rows(), ports);
+        matrices->tau.makeCompressed();
+        matrices->tau.resizeNonZeros(old.nonZeros());
+        const long long *outerOld = old.outerIndexPtr(), *lineOld = old.innerIndexPtr();
+        const double *valueOld = old.valuePtr();
+        long long *outer = matrices->tau.outerIndexPtr(), *line = matrices->tau.innerIndexPtr();
+        double *value = matrices->tau.valuePtr();
+        outer[0] = 0;
+        for (k = 0; k < nodes; k++)
+            for (p = first[order[k]]; p < first[order[k] + 1]; p++)
+                outer[newPort[p] + 1] = outer[newPort[p]] + outerOld[p + 1] - outerOld[p];
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(static) num_threads(nThreads) private(t, next)
+#endif
+        for (q = 0; q < ports; q++) {
+            next = outer[newPort[q]];
+            for (t = outerOld[q]; t < outerOld[q + 1]; t++) {
+                line[next] = lineOld[t];
+                value[next++] = valueOld[t];
+            }
+        }
+    }
+
+    // the coefficients of the matrix-free engine are saved by port
+    if (mf->used == 1) {
+        std::vector<double> coefficient(ports);
+        double *arrays[] = {mf->tau, mf->diagonal, mf->reflection, mf->transmission};
+        for (k = 0; k < 4; k++) {
+            for (p = 0; p < ports; p++)
+                coefficient[newPort[p]] = arrays[k][p];
+            std::copy(coefficient.begin(), coefficient.end(), arrays[k]);
+        }
+        std::vector<long long> connected(ports);
+        for (p = 0; p < ports; p++)
+            connected[newPort[p]] = newPort[mf->connectedPort[p]];
+        std::copy(connected.begin(), connected.end(), mf->connectedPort);
+    }
+
+    std::copy(newFirst.begin(), newFirst.end(), mf->nodeFirstPort);
+
+    return 0;
+}
+
+/*
+ * tlmInsideSimplexEigen: returns 1 if the point p is inside the line, the
+ * triangle, or the tetrahedron of the vertices v (2, 3, or 4 vertices), and 0
+ * otherwise. The points on the faces are inside
+ */
+static int tlmInsideSimplexEigen(const struct node * const *v, int vertices,
+        const Vector3d &p) {
+    const double tolerance = 1e-10;
+    Vector3d a(v[0]->x, v[0]->y, v[0]->z);
+    Matrix3d edges;
+
+    for (int k = 1; k < vertices; k++)
+        edges.col(k - 1) = Vector3d(v[k]->x, v[k]->y, v[k]->z) - a;
+
+    switch (vertices) {
+        case 2:
+        {
+            // the one-dimensional problems only use x
+            if (edges(0, 0) == 0)
+                return 0;
+            double lambda = (p(0) - a(0)) / edges(0, 0);
+            return lambda >= -tolerance && lambda <= 1 + tolerance;
+        }
+        case 3:
+        {
+            // coordinates of the projection of p on the plane of the triangle
+            Matrix2d normal = edges.leftCols(2).transpose() * edges.leftCols(2);
+            if (normal.determinant() == 0)
+                return 0;
+            Vector2d lambda = normal.inverse() * (edges.leftCols(2).transpose() * (p - a));
+            return lambda.minCoeff() >= -tolerance && lambda.sum() <= 1 + tolerance;
+        }
+        case 4:
+        {
+            if (edges.determinant() == 0)
+                return 0;
+            Vector3d lambda = edges.inverse() * (p - a);
+            return lambda.minCoeff() >= -tolerance && lambda.sum() <= 1 + tolerance;
+        }
+    }
+    return 0;
+}
+
+/*
+ * tlmElementVerticesEigen: saves in v the vertices of the element i of the
+ * element code and returns their quantity. tag gets the tag of the element
+ */
+static int tlmElementVerticesEigen(const struct tlmInternalMesh *mesh,
+        unsigned int code, unsigned long long i, const struct node **v,
+        unsigned long *tag) {
+    unsigned long long n[8];
+    int vertices = 0;
+
+    switch (code) {
+        case 1:
+            n[0] = mesh->elements.Line[i].N1;
+            n[1] = mesh->elements.Line[i].N2;
+            *tag = mesh->elements.Line[i].tag;
+            vertices = 2;
+            break;
+        case 2:
+            n[0] = mesh->elements.Triangle[i].N1;
+            n[1] = mesh->elements.Triangle[i].N2;
+            n[2] = mesh->elements.Triangle[i].N3;
+            *tag = mesh->elements.Triangle[i].tag;
+            vertices = 3;
+            break;
+        case 3:
+            n[0] = mesh->elements.Quadrangle[i].N1;
+            n[1] = mesh->elements.Quadrangle[i].N2;
+            n[2] = mesh->elements.Quadrangle[i].N3;
+            n[3] = mesh->elements.Quadrangle[i].N4;
+            *tag = mesh->elements.Quadrangle[i].tag;
+            vertices = 4;
+            break;
+        case 4:
+            n[0] = mesh->elements.Tetrahedron[i].N1;
+            n[1] = mesh->elements.Tetrahedron[i].N2;
+            n[2] = mesh->elements.Tetrahedron[i].N3;
+            n[3] = mesh->elements.Tetrahedron[i].N4;
+            *tag = mesh->elements.Tetrahedron[i].tag;
+            vertices = 4;
+            break;
+        case 5:
+            n[0] = mesh->elements.Hexahedron[i].N1;
+            n[1] = mesh->elements.Hexahedron[i].N2;
+            n[2] = mesh->elements.Hexahedron[i].N3;
+            n[3] = mesh->elements.Hexahedron[i].N4;
+            n[4] = mesh->elements.Hexahedron[i].N5;
+            n[5] = mesh->elements.Hexahedron[i].N6;
+            n[6] = mesh->elements.Hexahedron[i].N7;
+            n[7] = mesh->elements.Hexahedron[i].N8;
+            *tag = mesh->elements.Hexahedron[i].tag;
+            vertices = 8;
+            break;
+        case 7:
+            n[0] = mesh->elements.Pyramid[i].N1;
+            n[1] = mesh->elements.Pyramid[i].N2;
+            n[2] = mesh->elements.Pyramid[i].N3;
+            n[3] = mesh->elements.Pyramid[i].N4;
+            n[4] = mesh->elements.Pyramid[i].N5;
+            *tag = mesh->elements.Pyramid[i].tag;
+            vertices = 5;
+            break;
+    }
+
+    // the -1 is necessary because my number of node starts at 1
+    for (int k = 0; k < vertices; k++)
+        v[k] = &mesh->nodes[n[k] - 1];
+
+    return vertices;
+}
+
+/*
+ * tlmInsideElementEigen: returns 1 if the point p is inside the element of the
+ * element code and vertices v. The quadrangles, hexahedrons, and pyramids are
+ * split in triangles and tetrahedrons, with the order of the vertices of Gmsh
+ */
+static int tlmInsideElementEigen(unsigned int code, const struct node **v,
+        int vertices, const Vector3d &p) {
+    static const int quadrangle[2][4] = {
+        {0, 1, 2},
+        {0, 2, 3}
+    };
+    static const int pyramid[2][4] = {
+        {0, 1, 2, 4},
+        {0, 2, 3, 4}
+    };
+    static const int hexahedron[6][4] = {
+        {0, 1, 2, 6},
+        {0, 2, 3, 6},
+        {0, 1, 5, 6},
+        {0, 4, 5, 6},
+        {0, 3, 7, 6},
+        {0, 4, 7, 6}
+    };
+    const int (*split)[4] = NULL;
+    int parts = 1, corners = vertices;
+    const struct node *simplex[4];
+    Vector3d lowest(v[0]->x, v[0]->y, v[0]->z), highest = lowest;
+
+    // most of the elements are far from p
+    for (int k = 1; k < vertices; k++) {
+        lowest = lowest.cwiseMin(Vector3d(v[k]->x, v[k]->y, v[k]->z));
+        highest = highest.cwiseMax(Vector3d(v[k]->x, v[k]->y, v[k]->z));
+    }
+    double margin = 1e-10 * (highest - lowest).maxCoeff();
+    if ((p - lowest).minCoeff() < -margin || (highest - p).minCoeff() < -margin)
+        return 0;
+
+    switch (code) {
+        case 3:
+            split = quadrangle;
+            parts = 2;
+            corners = 3;
+            break;
+        case 5:
+            split = hexahedron;
+            parts = 6;
+            corners = 4;
+            break;
+        case 7:
+            split = pyramid;
+            parts = 2;
+            corners = 4;
+            break;
+    }
+
+    if (split == NULL)
+        return tlmInsideSimplexEigen(v, vertices, p);
+
+    for (int k = 0; k < parts; k++) {
+        for (int m = 0; m < corners; m++)
+            simplex[m] = v[split[k][m]];
+        if (tlmInsideSimplexEigen(simplex, corners, p))
+            return 1;
+    }
+    return 0;
+}
+
+/*
+ * tlmNodeElementCodesEigen: saves in codes the element codes of the nodes of a
+ * problem of dimension dimen and returns their quantity
+ */
+static unsigned int tlmNodeElementCodesEigen(enum dimSim dimen, unsigned int *codes) {
+    switch (dimen) {
+        case ONE:
+            codes[0] = 1;
+            return 1;
+        case TWO:
+            codes[0] = 2;
+            codes[1] = 3;
+            return 2;
+        case THREE:
+            codes[0] = 4;
+            codes[1] = 5;
+            codes[2] = 7;
+            return 3;
+    }
+    return 0;
+}
+
+/*
+ * tlmSelectOutputsEigen: keeps only the lines of tau, E_output, and
+ * Points_output that are saved. With output probes or output tags, these are
+ * the nodes selected by them: first the probes, in the order of the input,
+ * and then the nodes of the tags, in the order of the mesh. A probe is saved as
+ * the node of the element that contains it; if no element contains it, I warn
+ * and use the node with the closest center. Otherwise, if the scalar of the
+ * nodes was only calculated for the statistics, its lines are removed. It must
+ * be called after tau is complete and before the first data is written to the
+ * output file. The lines of the nodes are the first lines of tau
+ */
+unsigned int tlmSelectOutputsEigen(struct calculationTLMEigen *matrices,
+        struct dataForSimulation *input, int id) {
+    const struct Equation *equation = &(input->equationInput[id]);
+    const struct tlmInternalMesh *mesh = &(input->mesh);
+    const int probes = equation->numberOfOutputProbes;
+    unsigned int codes[3], quantityOfCodes, material;
+    unsigned long long numbersNodeAndPort[3];
+    const struct node *v[8];
+    unsigned long tag;
+    int k, vertices;
+    std::vector<long long> lines, pointLines;
+
+    if (probes > 0 || equation->numberOfOutputTags > 0) {
+        for (k = 0; k < equation->numberOfOutputTags; k++) {
+            if (getTagTLMnumbers(&(matrices->numbers), equation->outputTags[k], &material) != 2)
+                return 8756;
+        }
+
+        quantityOfCodes = tlmNodeElementCodesEigen(equation->dimen, codes);
+
+        std::vector<long long> probeLines(probes, -1);
+        std::vector<long long> tagLines;
+        int found = 0;
+
+        for (unsigned int c = 0; c < quantityOfCodes; c++) {
+            for (unsigned long long i = 0; i < mesh->quantityOfSpecificElement[codes[c]]; i++) {
+                vertices = tlmElementVerticesEigen(mesh, codes[c], i, v, &tag);
+                if (getTagTLMnumbers(&(matrices->numbers), tag, &material) != 2)
+                    continue;
+                getRealNodeAndPort_fromAbstractNode(codes[c], i,
+                        matrices->numbers.abstractPortsToReal, numbersNodeAndPort);
+
+                for (k = 0; k < equation->numberOfOutputTags; k++) {
+                    if (equation->outputTags[k] == tag) {
+                        tagLines.push_back(numbersNodeAndPort[0]);
+                        break;
+                    }
+                }
+
+                for (k = 0; k < probes && found < probes; k++) {
+                    if (probeLines[k] == -1 && tlmInsideElementEigen(codes[c], v, vertices,
+                            Map<const Vector3d>(&equation->outputProbes[3 * k]))) {
+                        probeLines[k] = numbersNodeAndPort[0];
+                        found++;
+                    }
+                }
+            }
+        }
+
+        // probes outside of the mesh
+        for (k = 0; k < probes; k++) {
+            if (probeLines[k] != -1)
+                continue;
+            Map<const Vector3d> p(&equation->outputProbes[3 * k]);
+            double distance, closest = -1;
+            for (unsigned long long n = 0; n < matrices->numbers.Nodes; n++) {
+                distance = (Vector3d(matrices->Points_output[n].x, matrices->Points_output[n].y,
+                        matrices->Points_output[n].z) - p).squaredNorm();
+                if (closest < 0 || distance < closest) {
+                    closest = distance;
+                    probeLines[k] = n;
+                }
+            }
+            fprintf(stderr, "\nWARNING: The probe (%g, %g, %g) of equation group %04d is not inside "
+                    "any node. The node with the closest center will be saved.\n\n",
+                    p(0), p(1), p(2), id + 1);
+        }
+
+        lines = probeLines;
+        lines.insert(lines.end(), tagLines.begin(), tagLines.end());
+        pointLines = lines;
+    } else if (equation->saveScalarForStatistics == 1) {
+        // the other outputs keep their order. Points_output may have more
+        // lines than the outputs (the positions of the flux)
+        for (unsigned long long n = matrices->numbers.Nodes; n < matrices->numbers.Points_Output; n++) {
+            if (n < matrices->numbers.Output)
+                lines.push_back(n);
+            pointLines.push_back(n);
+        }
+    } else {
+        return 0;
+    }
+
+    // tau = P*tau, where P has one 1 in each line, in the column of the output
+    // that is kept
+    const long long quantity = (long long) lines.size();
+    const long long quantityOfPoints = (long long) pointLines.size();
+    SparseMatrix<double, RowMajor, long long> P(quantity, matrices->tau.rows());
+    std::vector< Triplet<double, long long> > selection;
+    struct Point *points;
+    VectorXd E_output(quantity);
+
+    if ((points = (struct Point*) malloc(sizeof (struct Point)*(quantityOfPoints > 0 ? quantityOfPoints : 1))) == NULL)
+        return 8750;
+
+    selection.reserve(quantity);
+    for (long long r = 0; r < quantity; r++) {
+        selection.emplace_back(r, lines[r], 1.0);
+        E_output(r) = matrices->E_output(lines[r]);
+    }
+    for (long long r = 0; r < quantityOfPoints; r++)
+        points[r] = matrices->Points_output[pointLines[r]];
+    P.setFromTriplets(selection.begin(), selection.end());
+
+    matrices->tauRow = P * matrices->tau;
+    matrices->tau = matrices->tauRow;
+    matrices->E_output.swap(E_output);
+    free(matrices->Points_output);
+    matrices->Points_output = points;
+    matrices->numbers.Output = quantity;
+    matrices->numbers.Points_Output = quantityOfPoints;
+    matrices->output.resize(quantity);
+
+    return 0;
+}
+
+/*
+ * tlmInitiateStatisticsEigen: prepare the statistics of the tags of the
+ * equation and create their file. I take the lines of the nodes of each tag
+ * from tau and E_output, so it must be called after tau is complete and before
+ * tlmSelectOutputsEigen. The volumes of the nodes were saved by the materials
+ */
+unsigned int tlmInitiateStatisticsEigen(struct calculationTLMEigen *matrices,
+        struct dataForSimulation *input, int id) {
+    const struct Equation *equation = &(input->equationInput[id]);
+    struct statisticsTLMEigen *st = &(matrices->statistics);
+    unsigned int codes[3], quantityOfCodes, material, errorTLMnumber;
+    unsigned long long numbersNodeAndPort[3];
+    const struct node *v[8];
+    unsigned long tag;
+    int k;
+
+    if (equation->numberOfStatisticsTags == 0)
+        return 0;
+
+    for (k = 0; k < equation->numberOfStatisticsTags; k++) {
+        if (getTagTLMnumbers(&(matrices->numbers), equation->statisticsTags[k], &material) != 2)
+            return 8757;
+    }
+
+    // the nodes of each tag, in the order of the mesh
+    std::vector< std::vector<long long> > linesOfTag(equation->numberOfStatisticsTags);
+    quantityOfCodes = tlmNodeElementCodesEigen(equation->dimen, codes);
+    for (unsigned int c = 0; c < quantityOfCodes; c++) {
+        for (unsigned long long i = 0; i < input->mesh.quantityOfSpecificElement[codes[c]]; i++) {
+            tlmElementVerticesEigen(&(input->mesh), codes[c], i, v, &tag);
+            for (k = 0; k < equation->numberOfStatisticsTags; k++) {
+                if (equation->statisticsTags[k] == tag)
+                    break;
+            }
+            if (k == equation->numberOfStatisticsTags ||
+                    getTagTLMnumbers(&(matrices->numbers), tag, &material) != 2)
+                continue;
+            getRealNodeAndPort_fromAbstractNode(codes[c], i,
+                    matrices->numbers.abstractPortsToReal, numbersNodeAndPort);
+            linesOfTag[k].push_back(numbersNodeAndPort[0]);
+        }
+    }
+
+    st->firstLine.assign(1, 0);
+    for (k = 0; k < equation->numberOfStatisticsTags; k++)
+        st->firstLine.push_back(st->firstLine.back() + linesOfTag[k].size());
+
+    const long long quantity = st->firstLine.back();
+    SparseMatrix<double, RowMajor, long long> P(quantity, matrices->tau.rows());
+    std::vector< Triplet<double, long long> > selection;
+    long long r = 0;
+
+    st->E.resize(quantity);
+    st->volume.resize(quantity);
+    selection.reserve(quantity);
+    for (k = 0; k < equation->numberOfStatisticsTags; k++) {
+        for (unsigned long long n = 0; n < linesOfTag[k].size(); n++, r++) {
+            selection.emplace_back(r, linesOfTag[k][n], 1.0);
+            st->E(r) = matrices->E_output(linesOfTag[k][n]);
+            st->volume(r) = matrices->volume[linesOfTag[k][n]];
+        }
+    }
+    P.setFromTriplets(selection.begin(), selection.end());
+    st->tau = P * matrices->tau;
+    st->scalar.setZero(quantity);
+    st->dose.setZero(quantity);
+
+    if ((errorTLMnumber = creatStatisticsFile(input, id, &(st->file))) != 0)
+        return errorTLMnumber;
+
+    st->used = 1;
+
+    return 0;
+}
+
+/*
+ * tlmAccumulateDoseEigen: calculate the scalar of the nodes of the tags and
+ * add the thermal dose of a time-step of timeStep seconds. The dose is the
+ * cumulative equivalent minutes at 43 oC (CEM43), with R = 0.5 above 43 oC
+ * and R = 0.25 below it
+ */
+void tlmAccumulateDoseEigen(struct calculationTLMEigen *matrices, double timeStep, int nThreads) {
+    struct statisticsTLMEigen *st = &(matrices->statistics);
+    const long long quantity = st->scalar.size();
+    const double minutes = timeStep / 60.0;
+
+    st->scalar = st->tau * matrices->Vi + st->E;
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(static) num_threads(nThreads)
+#endif
+    for (long long r = 0; r < quantity; r++) {
+        // R^(43 - T) = 2^(T - 43) for R = 0.5, and 2^(2*(T - 43)) for R = 0.25
+        const double above = st->scalar(r) - 43;
+        st->dose(r) += minutes * std::exp2(above >= 0 ? above : 2 * above);
+    }
+}
+
+/*
+ * tlmWriteStatisticsEigen: write one line for each tag with the statistics of
+ * the last scalar calculated by tlmAccumulateDoseEigen: volume, minimum,
+ * maximum, mean, percentile, volume above the threshold, maximum CEM43, and
+ * volume above the dose threshold. The mean and the percentile are weighted
+ * by the volume of the nodes
+ */
+unsigned int tlmWriteStatisticsEigen(struct calculationTLMEigen *matrices,
+        struct dataForSimulation *input, int id, double time) {
+    const struct Equation *equation = &(input->equationInput[id]);
+    struct statisticsTLMEigen *st = &(matrices->statistics);
+    std::vector< std::pair<double, double> > sorted;
+    double values[8];
+    unsigned int errorTLMnumber;
+
+    for (int k = 0; k < equation->numberOfStatisticsTags; k++) {
+        const long long first = st->firstLine[k], last = st->firstLine[k + 1];
+
+        for (int m = 0; m < 8; m++)
+            values[m] = 0;
+        if (last > first) {
+            values[1] = st->scalar(first);
+            values[2] = st->scalar(first);
+        }
+        sorted.clear();
+        for (long long r = first; r < last; r++) {
+            values[0] += st->volume(r);
+            values[1] = st->scalar(r) < values[1] ? st->scalar(r) : values[1];
+            values[2] = st->scalar(r) > values[2] ? st->scalar(r) : values[2];
+            values[3] += st->volume(r) * st->scalar(r);
+            if (st->scalar(r) > equation->statisticsThreshold)
+                values[5] += st->volume(r);
+            values[6] = st->dose(r) > values[6] ? st->dose(r) : values[6];
+            if (st->dose(r) >= equation->statisticsDoseThreshold)
+                values[7] += st->volume(r);
+            sorted.push_back(std::make_pair(st->scalar(r), st->volume(r)));
+        }
+        if (values[0] > 0)
+            values[3] /= values[0];
+
+        // the percentile is the scalar below which the fraction of the volume is found
+        std::sort(sorted.begin(), sorted.end());
+        double volume = 0, target = values[0] * equation->statisticsPercentile / 100.0;
+        for (unsigned long long n = 0; n < sorted.size(); n++) {
+            values[4] = sorted[n].first;
+            volume += sorted[n].second;
+            if (volume >= target)
+                break;
+        }
+
+        if ((errorTLMnumber = writeStatisticsToFile(st->file, time, equation->statisticsTags[k], values)) != 0)
+            return errorTLMnumber;
+    }
+
+    return 0;
+}
+
+/*
+ * tlmTerminateStatisticsEigen: close the file of the statistics and release
+ * their memory
+ */
+unsigned int tlmTerminateStatisticsEigen(struct calculationTLMEigen *matrices) {
+    struct statisticsTLMEigen *st = &(matrices->statistics);
+
+    if (st->file != NULL)
+        fclose(st->file);
+    st->file = NULL;
+    st->used = 0;
+    st->tau.resize(0, 0);
+    st->E.resize(0);
+    st->scalar.resize(0);
+    st->volume.resize(0);
+    st->dose.resize(0);
+    std::vector<long long>().swap(st->firstLine);
+
+    return 0;
+}
+
+/*
+ * tlmTerminateScenariosEigen: close the output files of the scenarios. The
+ * first one is the output file, which is closed with the other equations
+ */
+unsigned int tlmTerminateScenariosEigen(struct calculationTLMEigen *matrices) {
+    struct scenariosTLMEigen *sc = &(matrices->scenarios);
+
+    for (size_t s = 1; s < sc->files.size(); s++) {
+        if (sc->files[s] != NULL)
+            fclose(sc->files[s]);
+    }
+    std::vector<FILE*>().swap(sc->files);
+    sc->quantity = 1;
+
+    return 0;
+}
+
+/*
+ * tlmInitiateNodeSystemEigen: prepare the node system for the steady-state. It
+ * must be called after the scattering matrix S was calculated in M and before
+ * the connections, when E is still Zhat*Is. For each node, Zhat = tau*Z/2 and
+ * the sum of tau is 2*Zhat*sum(1/Z), so I get G and Is without saving them
+ * during the calculation of the materials. Stubs are not supported.
+ */
+unsigned int tlmInitiateNodeSystemEigen(struct calculationTLMEigen *matrices) {
+
+    unsigned int errorTLMnumber;
+    struct nodeSystemTLMEigen *ns = &(matrices->nodeSystem);
+    long long ports = matrices->M.rows(), nodes, n, p, first, last;
+    double tau, sumTau, tauFirst, Zhat;
+
+    if (matrices->numbers.StubPorts != 0)
+        return 8753;
+
+    if ((errorTLMnumber = tlmFindNodesEigen(matrices)) != 0)
+        return errorTLMnumber;
+    nodes = matrices->matrixFree.quantityOfNodes;
+
+    ns->portNode = (long long*) malloc(sizeof (long long)*ports);
+    ns->otherPort = (long long*) malloc(sizeof (long long)*ports);
+    ns->zConductance = (double*) malloc(sizeof (double)*ports);
+    ns->zCurrent = (double*) malloc(sizeof (double)*ports);
+    ns->used = 1;
+
+    if (ns->portNode == NULL || ns->otherPort == NULL || ns->zConductance == NULL ||
+            ns->zCurrent == NULL) {
+        return 8747;
+    }
+
+    // each node has G in the diagonal and each connection between two nodes
+    // has four entries
+    ns->triplets.reserve(nodes + 2 * ports);
+    ns->b.setZero(nodes);
+
+    for (n = 0; n < nodes; n++) {
+        first = matrices->matrixFree.nodeFirstPort[n];
+        last = matrices->matrixFree.nodeFirstPort[n + 1];
+
+        sumTau = 0;
+        tauFirst = 0;
+        for (p = first; p < last; p++) {
+            // tau of port p is in the other lines of column p
+            tau = 0;
+            for (SparseMatrix<double, ColMajor, long long>::InnerIterator it(matrices->M, p); it; ++it) {
+                if (it.row() != p) {
+                    tau = it.value();
+                    break;
+                }
+            }
+            if (tau == 0)
+                return 8751;
+            if (p == first)
+                tauFirst = tau;
+            sumTau += tau;
+
+            ns->portNode[p] = n;
+            ns->otherPort[p] = -1;
+            ns->zConductance[p] = 0;
+            ns->zCurrent[p] = 0;
+        }
+
+        Zhat = tauFirst * matrices->Z[first] / 2;
+
+        // G = 1/Zhat - sum(1/Z)
+        ns->triplets.push_back(Triplet<double, long long>(n, n, (1 - sumTau / 2) / Zhat));
+        // Is = E/Zhat
+        ns->b(n) = matrices->E(first) / Zhat;
+    }
+
+    return 0;
+}
+
+/*
+ * tlmAddConnectionToNodeSystemEigen: include one intersection in the node
+ * system. It must be called before B includes the transmission of E. For one
+ * port, Vi = reflection*Vr + B and Vi + Vr = U at steady-state, so the current
+ * (Vr - Vi)/Z is a conductance (1 - reflection)/(Z*(1 + reflection)) to the
+ * ground plus a source 2*B/(Z*(1 + reflection)). For two ports, the
+ * conductance is 1/(R0 + R1).
+ */
+void tlmAddConnectionToNodeSystemEigen(struct calculationTLMEigen *matrices,
+        const struct connectionAndBoundaryCoefficients *coeff) {
+
+    struct nodeSystemTLMEigen *ns = &(matrices->nodeSystem);
+    long long p0, p1, n0, n1;
+    double g, Z;
+
+    p0 = coeff->startEnd[coeff->offsetStubPort0];
+    n0 = ns->portNode[p0];
+
+    if (coeff->startEnd[0] == 1) {
+        Z = matrices->Z[p0];
+        g = (1 - coeff->reflection[0]) / (Z * (1 + coeff->reflection[0]));
+
+        ns->zConductance[p0] = Z * g;
+        ns->zCurrent[p0] = 2 * coeff->B[0] / (1 + coeff->reflection[0]);
+
+        ns->triplets.push_back(Triplet<double, long long>(n0, n0, g));
+        ns->b(n0) += ns->zCurrent[p0] / Z;
+    } else {
+        p1 = coeff->startEnd[coeff->offsetStubPort1];
+        n1 = ns->portNode[p1];
+
+        g = 1 / (matrices->R[coeff->startEnd[coeff->offsetRealPort0]] +
+                matrices->R[coeff->startEnd[coeff->offsetRealPort1]]);
+
+        ns->otherPort[p0] = p1;
+        ns->otherPort[p1] = p0;
+        ns->zConductance[p0] = matrices->Z[p0] * g;
+        ns->zConductance[p1] = matrices->Z[p1] * g;
+
+        ns->triplets.push_back(Triplet<double, long long>(n0, n0, g));
+        ns->triplets.push_back(Triplet<double, long long>(n1, n1, g));
+        ns->triplets.push_back(Triplet<double, long long>(n0, n1, -g));
+        ns->triplets.push_back(Triplet<double, long long>(n1, n0, -g));
+    }
+}
+
+/*
+ * tlmNodeSystemToIncidentVoltagesEigen: the outputs are calculated from Vi.
+ * With the current I leaving the node through each port, Vi + Vr = U and
+ * Vr - Vi = Z*I, so Vi = (U - Z*I)/2.
+ */
+static void tlmNodeSystemToIncidentVoltagesEigen(struct calculationTLMEigen *matrices, int nThreads) {
+
+    const struct nodeSystemTLMEigen *ns = &(matrices->nodeSystem);
+    long long ports = matrices->Vi.size(), p;
+    double U, zI;
+
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(nThreads) schedule(static) private(U, zI)
+#endif
+    for (p = 0; p < ports; p++) {
+        U = ns->U(ns->portNode[p]);
+        if (ns->otherPort[p] >= 0)
+            zI = ns->zConductance[p] * (U - ns->U(ns->portNode[ns->otherPort[p]]));
+        else
+            zI = ns->zConductance[p] * U - ns->zCurrent[p];
+        matrices->Vi(p) = (U - zI) / 2;
+    }
+}
+
+/*
+ * tlmTerminateNodeSystemEigen: deallocate the variables of the node system
+ */
+unsigned int tlmTerminateNodeSystemEigen(struct calculationTLMEigen *matrices) {
+
+    free(matrices->nodeSystem.portNode);
+    matrices->nodeSystem.portNode = NULL;
+
+    free(matrices->nodeSystem.otherPort);
+    matrices->nodeSystem.otherPort = NULL;
+
+    free(matrices->nodeSystem.zConductance);
+    matrices->nodeSystem.zConductance = NULL;
+
+    free(matrices->nodeSystem.zCurrent);
+    matrices->nodeSystem.zCurrent = NULL;
+
+    std::vector< Triplet<double, long long> >().swap(matrices->nodeSystem.triplets);
+    matrices->nodeSystem.A.resize(0, 0);
+    matrices->nodeSystem.A.data().squeeze();
+    matrices->nodeSystem.b.resize(0);
+    matrices->nodeSystem.U.resize(0);
+    matrices->nodeSystem.used = 0;
+
+    return 0;
+}
+
+/*
+ * tlmRowMajorInPlaceEigen: move the entries of the column-major M to the
+ * row-major Mrow without a second copy of them. Mrow takes the arrays of M, and
+ * the entries are moved to their lines following the cycles of the
+ * permutation. Each entry taken out of its place is put in the next free place
+ * of its line, and so the extra memory is one bit for each entry and the
+ * indexes of the lines and of the columns. The entries of each line are sorted
+ * by column at the end, as in Mrow = M.
+ */
+static void tlmRowMajorInPlaceEigen(SparseMatrix<double, ColMajor, long long> &M,
+        SparseMatrix<double, RowMajor, long long> &Mrow) {
+
+    const long long rows = M.rows(), cols = M.cols();
+    long long p, q, r, start, line, column, nextLine, nextColumn;
+    double value, nextValue;
+
+    M.makeCompressed();
+    Mrow.resize(rows, cols);
+    Mrow.data().swap(M.data());
+
+    const long long nonZeros = Mrow.data().size();
+    const long long *outerM = M.outerIndexPtr();
+    long long *outer = Mrow.outerIndexPtr(), *inner = Mrow.innerIndexPtr();
+    double *values = Mrow.valuePtr();
+
+    // first place of each line, and the next free place while moving
+    for (p = 0; p < nonZeros; p++)
+        outer[inner[p] + 1]++;
+    for (r = 0; r < rows; r++)
+        outer[r + 1] += outer[r];
+    std::vector<long long> next(outer, outer + rows);
+    std::vector<bool> moved(nonZeros, false);
+
+    for (start = 0; start < nonZeros; start++) {
+        if (moved[start])
+            continue;
+        // the column of a place is found in the outer indexes of M
+        column = std::upper_bound(outerM, outerM + cols + 1, start) - outerM - 1;
+        line = inner[start];
+        value = values[start];
+        moved[start] = true;
+        while (1) {
+            q = next[line]++;
+            if (q != start) {
+                nextLine = inner[q];
+                nextColumn = std::upper_bound(outerM, outerM + cols + 1, q) - outerM - 1;
+                nextValue = values[q];
+                moved[q] = true;
+            }
+            inner[q] = column;
+            values[q] = value;
+            if (q == start)
+                break;
+            line = nextLine;
+            column = nextColumn;
+            value = nextValue;
+        }
+    }
+    std::vector<bool>().swap(moved);
+    std::vector<long long>().swap(next);
+    SparseMatrix<double, ColMajor, long long>().swap(M);
+
+    // the lines have a few entries, so I sort them by insertion
+    for (r = 0; r < rows; r++) {
+        for (p = outer[r] + 1; p < outer[r + 1]; p++) {
+            column = inner[p];
+            value = values[p];
+            for (q = p; q > outer[r] && inner[q - 1] > column; q--) {
+                inner[q] = inner[q - 1];
+                values[q] = values[q - 1];
+            }
+            inner[q] = column;
+            values[q] = value;
+        }
+    }
+}
+
+/*
+ * tlmPrepareTimeDomainEigen: move M to the row-major matrix used by
+ * tlmUpdateIncidentVoltagesEigen. M is not used after this point in the
+ * time-domain solution, and its arrays are reused by the row-major matrix, so
+ * the memory of M is not doubled.
+ */
+unsigned int tlmPrepareTimeDomainEigen(struct calculationTLMEigen *matrices, int nThreads) {
+
+    long long i, rows = matrices->Vi.size();
+
+    // the matrix-free engine does not have M
+    if (matrices->matrixFree.used == 0)
+        tlmRowMajorInPlaceEigen(matrices->M, matrices->Mrow);
+
+    // I touch Vi_next (and Vr) with the same partition used in the time-steps so
+    // that their pages are placed close to the threads that will write them
+    matrices->Vi_next.resize(rows);
+    double *Vi_next = matrices->Vi_next.data();
+    double *Vr = matrices->matrixFree.Vr.data();
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(static) num_threads(nThreads)
+#endif
+    for (i = 0; i < rows; i++) {
+        Vi_next[i] = 0;
+        if (matrices->matrixFree.used == 1)
+            Vr[i] = 0;
+    }
+
+    return 0;
+}
+
+/*
+ * tlmUpdateIncidentVoltagesMatrixFreeEigen: calculate Vi_(k+1) = C*S*Vi_k + E
+ * without M. First, each node scatters its incident voltages (Vr = S*Vi). Then,
+ * each port gets its reflected voltage and the transmitted voltage of the port
+ * connected to it.
+ */
+static void tlmUpdateIncidentVoltagesMatrixFreeEigen(struct calculationTLMEigen *matrices, int nThreads) {
+
+    const struct matrixFreeTLMEigen *mf = &(matrices->matrixFree);
+    const long long nodes = mf->quantityOfNodes;
+    const long long ports = mf->nodeFirstPort[nodes];
+    const long long *first = mf->nodeFirstPort;
+    const long long *connectedPort = mf->connectedPort;
+    const double *tau = mf->tau, *diagonal = mf->diagonal;
+    const double *reflection = mf->reflection, *transmission = mf->transmission;
+    const double *Vi = matrices->Vi.data();
+    const double *E = matrices->E.data();
+    double *Vr = matrices->matrixFree.Vr.data();
+    double *Vi_next = matrices->Vi_next.data();
+    long long n, p, q;
+    double sum;
+
+#if defined(_OPENMP)
+#pragma omp parallel num_threads(nThreads) private(p, q, sum)
+#endif
+    {
+        // scattering
+#if defined(_OPENMP)
+#pragma omp for schedule(static)
+#endif
+        for (n = 0; n < nodes; n++) {
+            for (p = first[n]; p < first[n + 1]; p++) {
+                // line p of S. Summing tau*Vi once and correcting only the
+                // diagonal is cheaper, but it loses precision when the
+                // diagonal is far from tau (hyperbolic equations)
+                sum = 0;
+                for (q = first[n]; q < first[n + 1]; q++)
+                    sum += (q == p ? diagonal[q] : tau[q]) * Vi[q];
+                Vr[p] = sum;
+            }
+        }
+
+        // connection. Ports that are not connected point to themselves
+        // with transmission equal to zero
+#if defined(_OPENMP)
+#pragma omp for schedule(static)
+#endif
+        for (p = 0; p < ports; p++)
+            Vi_next[p] = reflection[p] * Vr[p] + transmission[p] * Vr[connectedPort[p]] + E[p];
+    }
+
+    // Vi_(k+1) becomes Vi_k for the next time-step
+    matrices->Vi.swap(matrices->Vi_next);
+}
+
+/*
+ * tlmUpdateScenarioBlockEigen: calculate Vi_(k+1) = M*Vi_k + E for the
+ * Block scenarios from first. Each entry of M is read once and multiplied by
+ * the incident voltages of the Block scenarios, which are side by side in Vi.
+ * Each scenario has its own sum, done in the same order as with one scenario,
+ * so it has the same result as if it was solved alone
+ */
+template<int Block>
+static void tlmUpdateScenarioBlockEigen(struct calculationTLMEigen *matrices, int first, int nThreads) {
+
+    const long long rows = matrices->Mrow.rows();
+    const long long *outer = matrices->Mrow.outerIndexPtr();
+    const long long *inner = matrices->Mrow.innerIndexPtr();
+    const double *values = matrices->Mrow.valuePtr();
+    const int scenarios = matrices->scenarios.quantity;
+    const double *Vi = matrices->Vi.data() + first;
+    const double *E = matrices->E.data() + first;
+    double *Vi_next = matrices->Vi_next.data() + first;
+    long long i, k;
+    int s;
+
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(static) num_threads(nThreads) private(k, s)
+#endif
+    for (i = 0; i < rows; i++) {
+        double sum[Block];
+        for (s = 0; s < Block; s++)
+            sum[s] = 0;
+        for (k = outer[i]; k < outer[i + 1]; k++) {
+            const double value = values[k];
+            const double *line = &Vi[inner[k] * scenarios];
+            for (s = 0; s < Block; s++)
+                sum[s] += value * line[s];
+        }
+        for (s = 0; s < Block; s++)
+            Vi_next[i * scenarios + s] = sum[s] + E[i * scenarios + s];
+    }
+}
+
+/*
+ * tlmUpdateScenariosEigen: calculate Vi_(k+1) = M*Vi_k + E for all the
+ * scenarios, in blocks of up to 8 scenarios. M is read once for each block
+ */
+static void tlmUpdateScenariosEigen(struct calculationTLMEigen *matrices, int nThreads) {
+
+    const int scenarios = matrices->scenarios.quantity;
+    int first = 0;
+
+    for (; first + 8 <= scenarios; first += 8)
+        tlmUpdateScenarioBlockEigen<8>(matrices, first, nThreads);
+    if (first + 4 <= scenarios) {
+        tlmUpdateScenarioBlockEigen<4>(matrices, first, nThreads);
+        first += 4;
+    }
+    if (first + 2 <= scenarios) {
+        tlmUpdateScenarioBlockEigen<2>(matrices, first, nThreads);
+        first += 2;
+    }
+    if (first < scenarios)
+        tlmUpdateScenarioBlockEigen<1>(matrices, first, nThreads);
+
+    // Vi_(k+1) becomes Vi_k for the next time-step
+    matrices->Vi.swap(matrices->Vi_next);
+}
+
+/*
+ * tlmUpdateIncidentVoltagesEigen: calculate Vi_(k+1) = M*Vi_k + E using the
+ * row-major copy of M. Each thread calculates a block of rows of Vi_(k+1), so
+ * no two threads write in the same position.
+ */
+void tlmUpdateIncidentVoltagesEigen(struct calculationTLMEigen *matrices, int nThreads) {
+
+    if (matrices->matrixFree.used == 1) {
+        tlmUpdateIncidentVoltagesMatrixFreeEigen(matrices, nThreads);
+        return;
+    }
+
+    if (matrices->scenarios.quantity > 1) {
+        tlmUpdateScenariosEigen(matrices, nThreads);
+        return;
+    }
+
+    const long long rows = matrices->Mrow.rows();
+    const long long *outer = matrices->Mrow.outerIndexPtr();
+    const long long *inner = matrices->Mrow.innerIndexPtr();
+    const double *values = matrices->Mrow.valuePtr();
+    const double *Vi = matrices->Vi.data();
+    const double *E = matrices->E.data();
+    double *Vi_next = matrices->Vi_next.data();
+    long long i, k;
+    double sum;
+
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(static) num_threads(nThreads) private(k, sum)
+#endif
+    for (i = 0; i < rows; i++) {
+        sum = 0;
+        for (k = outer[i]; k < outer[i + 1]; k++)
+            sum += values[k] * Vi[inner[k]];
+        Vi_next[i] = sum + E[i];
+    }
+
+    // Vi_(k+1) becomes Vi_k for the next time-step
+    matrices->Vi.swap(matrices->Vi_next);
+}
+
+/*
+ * tlmTimeStepBytesEigen: memory, in bytes, used to store the operator of the
+ * time-steps, i.e., the row-major M or the coefficients of the matrix-free engine
+ */
+static double tlmTimeStepBytesEigen(struct calculationTLMEigen *matrices) {
+
+    if (matrices->matrixFree.used == 1) {
+        return (double) matrices->Vi.size()*(5 * sizeof (double) + sizeof (long long))
+                + (double) (matrices->matrixFree.quantityOfNodes + 1) * sizeof (long long);
+    }
+
+    return (double) matrices->Mrow.nonZeros()*(sizeof (double) + sizeof (long long))
+            + (double) (matrices->Mrow.rows() + 1) * sizeof (long long);
+}
+
+/*
+ * tlmScalingReportEigen: print the time per time-step of
+ * tlmUpdateIncidentVoltagesEigen for 1, 2, 4, ... up to the number of OpenMP
+ * cores set in the simulation. It runs on the matrices of the case being solved
+ * and restores Vi at the end, so the solution is not affected.
+ */
+unsigned int tlmScalingReportEigen(struct calculationTLMEigen *matrices,
+        struct dataForSimulation *input, int id) {
+
+    int nThreads, maxThreads = input->simulationInput.nOpenMPcores, repetitions = 100;
+    double begin, end, timePerStep, timeOneThread = 0, bytesPerStep;
+    VectorXd ViSaved = matrices->Vi;
+
+    if (input->simulationInput.Benchmark == RUN_FAST_AND_SOLVE)
+        repetitions = 10;
+
+    if (maxThreads < 1)
+        maxThreads = 1;
+
+    // memory moved in one time-step: the operator, Vi, E, and Vi_(k+1). The
+    // matrix-free engine also writes and reads Vr
+    bytesPerStep = tlmTimeStepBytesEigen(matrices) + (double) matrices->Vi.size() * 3 * sizeof (double);
+    if (matrices->matrixFree.used == 1)
+        bytesPerStep += (double) matrices->Vi.size() * 2 * sizeof (double);
+
+    printf("\nScaling of the incident voltages calculation for equation %04d "
+            "(%lld ports, %s, %s, %d repetitions):\n", id + 1, (long long) matrices->Vi.size(),
+            matrices->matrixFree.used == 1 ? "matrix-free" : "matrix",
+            input->equationInput[id].Renumber == REVERSE_CUTHILL_MCKEE ? "reverse Cuthill-McKee" :
+            (input->equationInput[id].Renumber == MORTON_CURVE ? "Morton curve" : "mesh order"),
+            repetitions);
+
+    nThreads = 1;
+    while (1) {
+        // one time-step to warm up the caches and the threads
+        tlmUpdateIncidentVoltagesEigen(matrices, nThreads);
+
+        begin = wallTimeTlmbht();
+        for (int i = 0; i < repetitions; i++)
+            tlmUpdateIncidentVoltagesEigen(matrices, nThreads);
+        end = wallTimeTlmbht();
+
+        timePerStep = (end - begin) / repetitions;
+        if (nThreads == 1)
+            timeOneThread = timePerStep;
+
+        printf("%4d threads: %g ms per time-step, speedup %g, efficiency %g %%, %g GB/s\n",
+                nThreads, timePerStep * 1e3, timeOneThread / timePerStep,
+                timeOneThread / timePerStep / nThreads * 100,
+                bytesPerStep / timePerStep / 1e9);
+
+        if (nThreads == maxThreads)
+            break;
+        nThreads = (2 * nThreads < maxThreads) ? 2 * nThreads : maxThreads;
+    }
+    printf("\n");
+
+    matrices->Vi = ViSaved;
+
+    return 0;
+}
+
+/*
+ * tlmScenarioFileEigen: output file of the scenario s. The first scenario is
+ * the case, which is saved in the output file
+ */
+static FILE *tlmScenarioFileEigen(struct calculationTLMEigen *matrices,
+        struct dataForSimulation *input, int s) {
+
+    if (s == 0)
+        return input->simulationInput.outputFileHandler;
+    return matrices->scenarios.files[s];
+}
+
+/*
+ * tlmWriteScenariosEigen: writes each column of output, one for each scenario,
+ * in the output file of its scenario
+ */
+static unsigned int tlmWriteScenariosEigen(struct calculationTLMEigen *matrices,
+        struct dataForSimulation *input, int id, const double *output,
+        unsigned long long position) {
+
+    unsigned int errorTLMnumber;
+    const unsigned long long outputs = matrices->numbers.Output;
+
+    for (int s = 0; s < matrices->scenarios.quantity; s++) {
+        if ((errorTLMnumber = writeOutputToFile(input, tlmScenarioFileEigen(matrices, input, s),
+                output + s * outputs, outputs, id, position)) != 0)
+            return errorTLMnumber;
+    }
+
+    return 0;
+}
+
+/*
+ * tlmWriteCheckpointEigen: writes the outputs that are buffered in the output
+ * files of the scenarios to the disk and then the checkpoint with their sizes.
+ * The size of the file of the statistics was taken by the solver
+ */
+static unsigned int tlmWriteCheckpointEigen(struct checkpointTLMEigen *checkpoint,
+        struct calculationTLMEigen *matrices, struct dataForSimulation *input) {
+
+    unsigned int errorTLMnumber;
+    double begin = wallTimeTlmbht();
+
+    for (int s = 0; s < matrices->scenarios.quantity; s++) {
+        if ((checkpoint->offsets[s] = syncOutputFileTLM(tlmScenarioFileEigen(matrices, input, s))) < 0)
+            return 8762;
+    }
+
+    errorTLMnumber = writeCheckpointTLM(checkpoint->name, &(checkpoint->header),
+            checkpoint->offsets.data(), checkpoint->Vi.data(), checkpoint->dose.data());
+    checkpoint->quantity++;
+    checkpoint->timeWriting += wallTimeTlmbht() - begin;
+
+    return errorTLMnumber;
+}
+
+/*
+ * tlmOutputWriterThreadEigen: writes the filled buffers of the output writer
+ * until the solver finishes and all of them were written. After an error, the
+ * buffers are freed without being written so that the solver does not wait.
+ * The buffer -1 is the checkpoint
+ */
+static void tlmOutputWriterThreadEigen(struct outputWriterTLMEigen *writer,
+        struct calculationTLMEigen *matrices, struct dataForSimulation *input, int id) {
+
+    int b;
+    unsigned int errorTLMnumber;
+    double begin;
+
+    while (1) {
+        {
+            std::unique_lock<std::mutex> lock(writer->mutex);
+            while (writer->filled.empty() && writer->finish == 0)
+                writer->bufferFilled.wait(lock);
+            if (writer->filled.empty())
+                return;
+            b = writer->filled.front();
+            writer->filled.pop_front();
+            errorTLMnumber = writer->errorTLMnumber;
+        }
+
+        if (errorTLMnumber == 0 && b < 0) {
+            errorTLMnumber = tlmWriteCheckpointEigen(&(writer->checkpoint), matrices, input);
+        } else if (errorTLMnumber == 0) {
+            begin = wallTimeTlmbht();
+            errorTLMnumber = tlmWriteScenariosEigen(matrices, input, id,
+                    writer->buffers[b].data(), writer->position[b]);
+            writer->timeWriting += wallTimeTlmbht() - begin;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(writer->mutex);
+            if (writer->errorTLMnumber == 0)
+                writer->errorTLMnumber = errorTLMnumber;
+            if (b < 0)
+                writer->checkpoint.pending = 0;
+            else
+                writer->freeBuffers.push_back(b);
+        }
+        writer->bufferFreed.notify_one();
+    }
+}
+
+/*
+ * tlmStartOutputWriterEigen: allocate the buffers of the output writer and
+ * start its thread. With no buffers, the solver writes the outputs itself
+ */
+static void tlmStartOutputWriterEigen(struct outputWriterTLMEigen *writer,
+        struct calculationTLMEigen *matrices, struct dataForSimulation *input, int id) {
+
+    int b, quantityOfBuffers = input->simulationInput.outputBuffers;
+
+    writer->used = quantityOfBuffers > 0;
+    writer->finish = 0;
+    writer->errorTLMnumber = 0;
+    writer->timeWriting = 0;
+    if (writer->used == 0)
+        return;
+
+    writer->buffers.resize(quantityOfBuffers);
+    writer->position.resize(quantityOfBuffers);
+    for (b = 0; b < quantityOfBuffers; b++) {
+        writer->buffers[b].resize(matrices->output.size());
+        writer->freeBuffers.push_back(b);
+    }
+    writer->thread = std::thread(tlmOutputWriterThreadEigen, writer, matrices, input, id);
+}
+
+/*
+ * tlmWriteOutputEigen: give the output of this position to the output writer,
+ * or write it if the writer is not used. The output is swapped with a free
+ * buffer, so it is not copied
+ */
+static unsigned int tlmWriteOutputEigen(struct outputWriterTLMEigen *writer,
+        struct calculationTLMEigen *matrices, struct dataForSimulation *input, int id,
+        unsigned long long position) {
+
+    int b;
+
+    if (writer->used == 0)
+        return tlmWriteScenariosEigen(matrices, input, id, matrices->output.data(), position);
+
+    {
+        std::unique_lock<std::mutex> lock(writer->mutex);
+        while (writer->freeBuffers.empty())
+            writer->bufferFreed.wait(lock);
+        if (writer->errorTLMnumber != 0)
+            return writer->errorTLMnumber;
+        b = writer->freeBuffers.back();
+        writer->freeBuffers.pop_back();
+        matrices->output.swap(writer->buffers[b]);
+        writer->position[b] = position;
+        writer->filled.push_back(b);
+    }
+    writer->bufferFilled.notify_one();
+
+    return 0;
+}
+
+/*
+ * tlmStopOutputWriterEigen: wait for the writer thread to write the remaining
+ * outputs and release the buffers. It returns the first error of the writer
+ */
+static unsigned int tlmStopOutputWriterEigen(struct outputWriterTLMEigen *writer) {
+
+    if (writer->used == 0)
+        return 0;
+
+    {
+        std::lock_guard<std::mutex> lock(writer->mutex);
+        writer->finish = 1;
+    }
+    writer->bufferFilled.notify_one();
+    writer->thread.join();
+
+    std::vector<VectorXd>().swap(writer->buffers);
+    writer->freeBuffers.clear();
+    writer->used = 0;
+
+    return writer->errorTLMnumber;
+}
+
+/*
+ * tlmStartCheckpointEigen: prepare the checkpoints of equation id if the
+ * simulation asks for them. They are not written in sweeps
+ */
+static unsigned int tlmStartCheckpointEigen(struct checkpointTLMEigen *checkpoint,
+        struct calculationTLMEigen *matrices, struct dataForSimulation *input, int id) {
+
+    checkpoint->used = (input->simulationInput.checkpointSteps > 0 ||
+            input->simulationInput.checkpointTime > 0) &&
+            input->equationInput[id].numberOfSweepPoints == 0;
+    checkpoint->pending = 0;
+    checkpoint->name = NULL;
+    checkpoint->quantity = 0;
+    checkpoint->timeWriting = 0;
+    checkpoint->last = wallTimeTlmbht();
+    if (checkpoint->used == 0)
+        return 0;
+
+    if ((checkpoint->name = nameCheckpointTLM(input)) == NULL)
+        return 8750;
+
+    memset(&(checkpoint->header), 0, sizeof (struct tlrCheckpointHeader));
+    checkpoint->header.equation = id;
+    checkpoint->header.quantityOfFiles = matrices->scenarios.quantity + 1;
+    checkpoint->header.key = keyCheckpointTLM(input, id);
+    checkpoint->header.sizeOfVi = matrices->Vi.size();
+    checkpoint->header.sizeOfDose = matrices->statistics.used == 1 ? matrices->statistics.dose.size() : 0;
+    checkpoint->offsets.assign(checkpoint->header.quantityOfFiles, -1);
+
+    return 0;
+}
+
+/*
+ * tlmCheckpointDueEigen: a checkpoint is written after a quantity of
+ * time-jumps or when some wall-clock time has passed since the last one
+ */
+static int tlmCheckpointDueEigen(const struct checkpointTLMEigen *checkpoint,
+        const struct dataForSimulation *input, unsigned long long iteration) {
+
+    if (checkpoint->used == 0)
+        return 0;
+    if (input->simulationInput.checkpointSteps > 0 &&
+            iteration % input->simulationInput.checkpointSteps == 0)
+        return 1;
+    return input->simulationInput.checkpointTime > 0 &&
+            wallTimeTlmbht() - checkpoint->last >= input->simulationInput.checkpointTime;
+}
+
+/*
+ * tlmCheckpointEigen: copy the state after iteration time-jumps to the
+ * checkpoint and give it to the output writer, or write it if the writer is
+ * not used. If the writer has not written the last checkpoint yet, the solver
+ * waits for it
+ */
+static unsigned int tlmCheckpointEigen(struct outputWriterTLMEigen *writer,
+        struct calculationTLMEigen *matrices, struct dataForSimulation *input,
+        unsigned long long iteration, unsigned long long position, double time) {
+
+    struct checkpointTLMEigen *checkpoint = &(writer->checkpoint);
+    const int files = checkpoint->header.quantityOfFiles;
+
+    if (writer->used == 1) {
+        std::unique_lock<std::mutex> lock(writer->mutex);
+        while (checkpoint->pending == 1)
+            writer->bufferFreed.wait(lock);
+        if (writer->errorTLMnumber != 0)
+            return writer->errorTLMnumber;
+    }
+
+    checkpoint->header.iteration = iteration;
+    checkpoint->header.position = position;
+    checkpoint->header.time = time;
+    checkpoint->Vi = matrices->Vi;
+    if (matrices->statistics.used == 1) {
+        checkpoint->dose = matrices->statistics.dose;
+        if ((checkpoint->offsets[files - 1] = syncOutputFileTLM(matrices->statistics.file)) < 0)
+            return 8762;
+    }
+    checkpoint->last = wallTimeTlmbht();
+
+    if (writer->used == 0)
+        return tlmWriteCheckpointEigen(checkpoint, matrices, input);
+
+    {
+        std::lock_guard<std::mutex> lock(writer->mutex);
+        checkpoint->pending = 1;
+        writer->filled.push_back(-1);
+    }
+    writer->bufferFilled.notify_one();
+
+    return 0;
+}
+
+/*
+ * tlmRestartEigen: continue equation id from the checkpoint. The incident
+ * voltages and the thermal doses are read, and the output files are cut at
+ * their sizes in the checkpoint. iteration, position, and time are the ones
+ * after the last output of the checkpoint
+ */
+static unsigned int tlmRestartEigen(struct calculationTLMEigen *matrices,
+        struct dataForSimulation *input, int id, unsigned long long *iteration,
+        unsigned long long *position, double *time) {
+
+    struct tlrCheckpointHeader expected, header;
+    unsigned int errorTLMnumber;
+    char *name;
+
+    if ((name = nameCheckpointTLM(input)) == NULL)
+        return 8750;
+
+    memset(&expected, 0, sizeof (struct tlrCheckpointHeader));
+    expected.equation = id;
+    expected.quantityOfFiles = matrices->scenarios.quantity + 1;
+    expected.key = keyCheckpointTLM(input, id);
+    expected.sizeOfVi = matrices->Vi.size();
+    expected.sizeOfDose = matrices->statistics.used == 1 ? matrices->statistics.dose.size() : 0;
+    std::vector<long long> offsets(expected.quantityOfFiles);
+
+    errorTLMnumber = readCheckpointTLM(name, &expected, &header, offsets.data(),
+            matrices->Vi.data(), matrices->statistics.dose.data());
+    free(name);
+    if (errorTLMnumber != 0)
+        return errorTLMnumber;
+
+    for (int s = 0; s < matrices->scenarios.quantity; s++) {
+        if ((errorTLMnumber = truncateOutputFileTLM(tlmScenarioFileEigen(matrices, input, s),
+                offsets[s])) != 0)
+            return errorTLMnumber;
+    }
+    if (matrices->statistics.used == 1 &&
+            (errorTLMnumber = truncateOutputFileTLM(matrices->statistics.file,
+            offsets[expected.quantityOfFiles - 1])) != 0)
+        return errorTLMnumber;
+
+    *iteration = header.iteration;
+    *position = header.position;
+    *time = header.time;
+    input->simulationInput.restartEquation = -1;
+    printf("Continuing equation %04d from the checkpoint at %g s, after %llu time-jumps.\n",
+            id + 1, header.time, header.iteration);
+
+    return 0;
+}
+
+/*
+ * tlmRelativeChangeEigen: relative change of the output per time-step,
+ * max|output_k - output_c|/max|output_k| divided by the time-steps between
+ * them, where c is an earlier check. The outputs of the last two checks are
+ * kept in checked, by the parity of the check. The incident voltages are not
+ * compared: with fixed boundaries they keep a mode that changes its sign every
+ * time-step, so their change stops decreasing before the output is steady.
+ * The mode also reaches the output, so when the checks are an odd quantity of
+ * time-steps apart the output is compared with the one two checks before.
+ * HUGE_VAL is returned while there is no output to compare with
+ */
+static double tlmRelativeChangeEigen(struct calculationTLMEigen *matrices, VectorXd *checked,
+        unsigned long long check, unsigned long long steps, int nThreads) {
+
+    const unsigned long long distance = steps % 2 == 1 ? 2 : 1;
+    const long long rows = matrices->output.size();
+    const double *output = matrices->output.data(), *previous;
+    double change = 0, magnitude = 0;
+    long long i;
+
+    if (check < distance) {
+        checked[check % 2] = matrices->output;
+        return HUGE_VAL;
+    }
+    previous = checked[(check - distance) % 2].data();
+
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(static) num_threads(nThreads) reduction(max:change, magnitude)
+#endif
+    for (i = 0; i < rows; i++) {
+        change = std::max(change, std::fabs(output[i] - previous[i]));
+        magnitude = std::max(magnitude, std::fabs(output[i]));
+    }
+    checked[check % 2] = matrices->output;
+
+    if (magnitude == 0)
+        return change == 0 ? 0 : HUGE_VAL;
+    return change / (magnitude * steps * distance);
+}
+
+/*
+ * tlmCalculateOutputEigen: calculate the output from the incident voltages. With
+ * scenarios, the output of each one is calculated from its incident voltages,
+ * which are every quantity of scenarios values of Vi
+ */
+static void tlmCalculateOutputEigen(struct calculationTLMEigen *matrices) {
+
+    const int scenarios = matrices->scenarios.quantity;
+
+    if (scenarios == 1) {
+        if (matrices->tauRow.rows() > 0)
+            matrices->output = matrices->tauRow * matrices->Vi + matrices->E_output;
+        else
+            matrices->output = matrices->tau * matrices->Vi + matrices->E_output;
+        return;
+    }
+
+    const long long outputs = matrices->numbers.Output, ports = matrices->Vi.size() / scenarios;
+    for (int s = 0; s < scenarios; s++) {
+        Map<const VectorXd, 0, InnerStride<> > Vi(matrices->Vi.data() + s, ports, InnerStride<>(scenarios));
+        if (matrices->tauRow.rows() > 0)
+            matrices->output.segment(s * outputs, outputs) = matrices->tauRow * Vi +
+                matrices->E_output.segment(s * outputs, outputs);
+        else
+            matrices->output.segment(s * outputs, outputs) = matrices->tau * Vi +
+                matrices->E_output.segment(s * outputs, outputs);
+    }
+}
+
+/*
+ * tlmSolveMatricesTimeDomainEigen: solve the TLM matrix equation in time-domain and write
+ * data to file
+ */
+unsigned int tlmSolveMatricesTimeDomainEigen(struct calculationTLMEigen * matrices,
+        struct dataForSimulation * input, int id) {
+
+    printf("\n\nSolving dynamic problem for equation %04d directly...\n", id + 1);
+
+    unsigned long long quantityOfIterations, productsPerJump, position = 1, first = 0;
+    unsigned long long products = 0, outputs = 0;
+    double time = 0, change = 0;
+    int steadyReached = 0, checkSteady;
+    unsigned int errorTLMnumber = 0;
+    struct outputWriterTLMEigen writer;
+    // outputs of the last two checks of the steady-state
+    VectorXd outputChecked[2];
+    unsigned long long checks = 0;
+
+    // the writer thread also uses the processor, so the times are wall times
+    double begin_T, end_T, begin_write, end_write;
+    double begin_Vi, end_Vi;
+    double begin_stat, time_stat;
+    double begin_JM, time_JM;
+    double time_Vi, time_T, time_write;
+    time_Vi = 0;
+    time_T = 0;
+    time_write = 0;
+    time_stat = 0;
+
+    int nThreads = input->simulationInput.nOpenMPcores;
+
+    tlmPrepareTimeDomainEigen(matrices, nThreads);
+
+    if (input->simulationInput.verboseMode == 1) {
+        printf("Memory used by the %s engine: %g MB.\n",
+                matrices->matrixFree.used == 1 ? "matrix-free" : "matrix",
+                tlmTimeStepBytesEigen(matrices) / (1024.0 * 1024.0));
+    }
+
+    if (input->runningBenchmark == 1)
+        tlmScalingReportEigen(matrices, input, id);
+
+    quantityOfIterations = input->equationInput[id].finalTime / (
+            input->equationInput[id].timeStep *
+            input->equationInput[id].timeJump);
+
+    // the time-jump can be done with powers of M
+    begin_JM = wallTimeTlmbht();
+    adjustTimeJumpEigen(matrices, input, id, &productsPerJump);
+    time_JM = wallTimeTlmbht() - begin_JM;
+
+    // the restarted equation continues after the last output of the checkpoint
+    if (input->simulationInput.restartEquation == id &&
+            (errorTLMnumber = tlmRestartEigen(matrices, input, id, &first, &position, &time)) != 0) {
+        tlmTerminateStatisticsEigen(matrices);
+        return errorTLMnumber;
+    }
+
+    if ((errorTLMnumber = tlmStartCheckpointEigen(&(writer.checkpoint), matrices, input, id)) != 0) {
+        tlmTerminateStatisticsEigen(matrices);
+        return errorTLMnumber;
+    }
+
+    // the outputs are written by another thread while the next time-steps are
+    // calculated
+    tlmStartOutputWriterEigen(&writer, matrices, input, id);
+
+    // the statistics start from the initial scalar
+    if (matrices->statistics.used == 1 && first == 0) {
+        begin_stat = wallTimeTlmbht();
+        tlmAccumulateDoseEigen(matrices, 0, nThreads);
+        errorTLMnumber = tlmWriteStatisticsEigen(matrices, input, id, 0);
+        time_stat += wallTimeTlmbht() - begin_stat;
+    }
+
+    for (unsigned long long i = first; i < quantityOfIterations && errorTLMnumber == 0; i++) {
+        time = (i) *
+                input->equationInput[id].timeStep *
+                input->equationInput[id].timeJump +
+                (1) *
+                input->equationInput[id].timeStep;
+
+        printf("Calculating for time %g s to ", time);
+        time = (i) *
+                input->equationInput[id].timeStep *
+                input->equationInput[id].timeJump +
+                (input->equationInput[id].timeJump) *
+                input->equationInput[id].timeStep;
+        printf("%g s...", time);
+
+        for (unsigned long long j = 0; j < productsPerJump; j++) {
+
+            // Calculate Vi_(k+1), or Vi_(k+p) with M^p
+            begin_Vi = wallTimeTlmbht();
+            tlmUpdateIncidentVoltagesEigen(matrices, nThreads);
+            end_Vi = wallTimeTlmbht();
+            time_Vi += end_Vi - begin_Vi;
+            products++;
+
+            // the thermal dose is accumulated in every time-step
+            if (matrices->statistics.used == 1) {
+                tlmAccumulateDoseEigen(matrices, input->equationInput[id].timeStep, nThreads);
+                time_stat += wallTimeTlmbht() - end_Vi;
+            }
+        }
+
+
+        // calculate the output at k+1
+        if (input->simulationInput.printAdditionalMode == 1) {
+            printf("\nCalculating the output...\n");
+        }
+        begin_T = wallTimeTlmbht();
+        tlmCalculateOutputEigen(matrices);
+        end_T = wallTimeTlmbht();
+        time_T += end_T - begin_T;
+        outputs++;
+
+        // the output is compared before the writer takes it
+        checkSteady = input->equationInput[id].steadyDetectionTolerance > 0 &&
+                (i + 1) % input->equationInput[id].steadyDetectionInterval == 0;
+        if (checkSteady == 1) {
+            change = tlmRelativeChangeEigen(matrices, outputChecked, checks++,
+                    input->equationInput[id].timeJump *
+                    input->equationInput[id].steadyDetectionInterval, nThreads);
+            if (input->simulationInput.verboseMode == 1 && change != HUGE_VAL)
+                printf("Relative change of the output per time-step: %g.\n", change);
+        }
+
+        if (input->simulationInput.printAdditionalMode == 1) {
+            printf("Writing data to file...\n");
+        }
+        begin_write = wallTimeTlmbht();
+        errorTLMnumber = tlmWriteOutputEigen(&writer, matrices, input, id, position);
+        end_write = wallTimeTlmbht();
+        time_write += end_write - begin_write;
+        if (errorTLMnumber != 0)
+            break;
+
+        if (matrices->statistics.used == 1) {
+            begin_stat = wallTimeTlmbht();
+            errorTLMnumber = tlmWriteStatisticsEigen(matrices, input, id, time);
+            time_stat += wallTimeTlmbht() - begin_stat;
+            if (errorTLMnumber != 0)
+                break;
+        }
+
+        printf("Done\n\n");
+        position++;
+
+        if (tlmCheckpointDueEigen(&(writer.checkpoint), input, i + 1)) {
+            if (input->simulationInput.verboseMode == 1)
+                printf("Writing the checkpoint at %g s.\n", time);
+            if ((errorTLMnumber = tlmCheckpointEigen(&writer, matrices, input, i + 1,
+                    position, time)) != 0)
+                break;
+        }
+
+        // the last output was written, so the loop can stop here
+        if (checkSteady == 1 && change < input->equationInput[id].steadyDetectionTolerance) {
+            steadyReached = 1;
+            break;
+        }
+    }
+
+    // the last outputs are written before the file is used by other equations
+    begin_write = wallTimeTlmbht();
+    if (errorTLMnumber == 0)
+        errorTLMnumber = tlmStopOutputWriterEigen(&writer);
+    else
+        tlmStopOutputWriterEigen(&writer);
+    end_write = wallTimeTlmbht();
+    time_write += end_write - begin_write;
+    tlmTerminateStatisticsEigen(matrices);
+
+    // the equation is complete, so its checkpoint is not needed anymore
+    if (writer.checkpoint.used == 1) {
+        if (errorTLMnumber == 0)
+            remove(writer.checkpoint.name);
+        free(writer.checkpoint.name);
+    }
+    if (errorTLMnumber != 0)
+        return errorTLMnumber;
+
+    if (steadyReached == 1) {
+        printf("Equation %04d reached the steady-state at %g s (relative change %g per time-step), "
+                "before the final time %g s.\n", id + 1, time, change, input->equationInput[id].finalTime);
+        for (int s = 0; s < matrices->scenarios.quantity; s++) {
+            if ((errorTLMnumber = writeSteadyStateToFile(input, tlmScenarioFileEigen(matrices, input, s),
+                    id, time, position - 1)) != 0)
+                return errorTLMnumber;
+        }
+    }
+
+    printf("Done solving dynamic problem for equation %04d directly.\n", id + 1);
+
+    // the time-steps are too short to be phases of their own, so I add their
+    // accumulated times to the profiler once
+    if (productsPerJump != input->equationInput[id].timeJump)
+        addPhaseProfiler("calculate the power of M", time_JM, 1);
+    addPhaseProfiler("calculate the incident voltages", time_Vi, products);
+    addPhaseProfiler("calculate the outputs", time_T, outputs);
+    addPhaseProfiler("write the outputs", time_write, outputs);
+    if (input->equationInput[id].numberOfStatisticsTags > 0)
+        addPhaseProfiler("calculate the statistics", time_stat, outputs);
+    if (writer.checkpoint.quantity > 0)
+        addPhaseProfiler("write the checkpoints", writer.checkpoint.timeWriting,
+            writer.checkpoint.quantity);
+
+    if (input->simulationInput.timingMode == 1) {
+
+        if (productsPerJump != input->equationInput[id].timeJump) {
+            printTimeProfiler(time_JM, "Time to calculate the power of M");
+        }
+
+        printTimeProfiler(time_Vi, "Time to calculate the incident voltages using %d threads", nThreads);
+
+        printTimeProfiler(time_T, "Time to calculate the outputs");
+
+        printTimeProfiler(time_write, "Time to write the outputs");
+
+        if (input->simulationInput.outputBuffers > 0) {
+            printTimeProfiler(writer.timeWriting, "Time to write the outputs in the writer thread");
+        }
+
+        if (input->equationInput[id].numberOfStatisticsTags > 0) {
+            printTimeProfiler(time_stat, "Time to calculate the statistics");
+        }
+
+        if (writer.checkpoint.quantity > 0) {
+            printTimeProfiler(writer.checkpoint.timeWriting, "Time to write the %llu checkpoints", writer.checkpoint.quantity);
+        }
+    }
+
+    return 0;
+
+}
+
+/*
+ * tlmSetNodesOfPreconditionerEigen: only the block-Jacobi preconditioner needs
+ * the nodes
+ */
+template<typename Preconditioner>
+static void tlmSetNodesOfPreconditionerEigen(Preconditioner &,
+        const struct calculationTLMEigen *, int) {
+}
+
+static void tlmSetNodesOfPreconditionerEigen(BlockJacobiPreconditionerEigen &preconditioner,
+        const struct calculationTLMEigen *matrices, int nThreads) {
+    preconditioner.setNodes(matrices->matrixFree.quantityOfNodes,
+            matrices->matrixFree.nodeFirstPort, nThreads);
+}
+
+/*
+ * tlmRunIterativeSolverEigen: solve A*x = b with one of the iterative solvers of
+ * Eigen. x must have the initial guess. If the solver does not converge, I keep
+ * the last x and only warn.
+ */
+template<typename Solver, typename MatrixType>
+static unsigned int tlmRunIterativeSolverEigen(Solver &solver, const MatrixType &A,
+        const VectorXd &b, VectorXd &x, struct calculationTLMEigen *matrices,
+        const struct Equation *equation, int nThreads, int id) {
+
+    tlmSetNodesOfPreconditionerEigen(solver.preconditioner(), matrices, nThreads);
+    solver.setTolerance(equation->tolerance);
+    solver.setMaxIterations(equation->maximumIterations);
+
+    solver.compute(A);
+    if (solver.info() != Success)
+        return 8752;
+
+    x = solver.solveWithGuess(b, x);
+
+    printf("Iterations: %ld. Estimated relative residual: %g.\n",
+            (long) solver.iterations(), solver.error());
+    if (solver.info() != Success) {
+        fprintf(stderr, "\nWARNING: The steady-state solver of equation %04d did not reach "
+                "the tolerance %g in %u iterations.\n\n", id, equation->tolerance,
+                equation->maximumIterations);
+    }
+
+    return 0;
+}
+
+/*
+ * tlmSolveIterativelyEigen: choose the iterative solver for the preconditioner.
+ * The node system is solved for the scalar of the nodes with CG and then
+ * converted to Vi. Otherwise, (I - M)*Vi = E is solved with E as initial guess.
+ */
+template<typename Preconditioner>
+static unsigned int tlmSolveIterativelyEigen(struct calculationTLMEigen *matrices,
+        const struct Equation *equation, int nThreads, int id) {
+
+    unsigned int errorTLMnumber;
+
+    if (equation->SteadySolver == NODE_CG) {
+        // Lower|Upper uses the whole matrix, so Eigen does the product with OpenMP
+        ConjugateGradient<SparseMatrix<double, RowMajor, long long>, Lower | Upper, Preconditioner> solver;
+        matrices->nodeSystem.U.setZero(matrices->nodeSystem.b.size());
+        if ((errorTLMnumber = tlmRunIterativeSolverEigen(solver, matrices->nodeSystem.A,
+                matrices->nodeSystem.b, matrices->nodeSystem.U, matrices, equation, nThreads, id)) != 0)
+            return errorTLMnumber;
+        tlmNodeSystemToIncidentVoltagesEigen(matrices, nThreads);
+        return 0;
+    }
+
+    matrices->Vi = matrices->E;
+    if (equation->SteadySolver == ITERATIVE_GMRES) {
+        GMRES<SparseMatrix<double, RowMajor, long long>, Preconditioner> solver;
+        return tlmRunIterativeSolverEigen(solver, matrices->MsteadyRow, matrices->E,
+                matrices->Vi, matrices, equation, nThreads, id);
+    }
+
+    BiCGSTAB<SparseMatrix<double, RowMajor, long long>, Preconditioner> solver;
+    return tlmRunIterativeSolverEigen(solver, matrices->MsteadyRow, matrices->E,
+            matrices->Vi, matrices, equation, nThreads, id);
+}
+
+/*
+ * tlmSolveMatricesSteadyStateEigen: solve the TLM matrix equation for steady-state
+ * and write data to file
+ */
+unsigned int tlmSolveMatricesSteadyStateEigen(struct calculationTLMEigen * matrices,
+        struct dataForSimulation * input, int id) {
+
+    unsigned int errorTLMnumber = 0;
+    unsigned long long position = 1;
+    const struct Equation *equation = &(input->equationInput[id]);
+    int nThreads = input->simulationInput.nOpenMPcores;
+
+    double begin_Vi, end_Vi, begin_T, end_T, begin_write, end_write;
+    double time_Vi, time_T, time_write;
+    time_Vi = 0;
+    time_T = 0;
+    time_write = 0;
+
+    if (nThreads < 1)
+        nThreads = 1;
+
+    // Calculate Vi_(steady)
+    if (equation->SteadySolver == DIRECT_LU) {
+        printf("\n\nSolving the steady-state problem for equation %04d directly...\n", id);
+
+        if (input->simulationInput.printAdditionalMode == 1) {
+            printf("Solving Vi using LU...\n");
+        }
+
+        SparseLU< SparseMatrix<double, ColMajor, long long>, COLAMDOrdering<long long> > solver;
+        begin_Vi = wallTimeTlmbht();
+        solver.analyzePattern(matrices->Msteady);
+        solver.factorize(matrices->Msteady);
+        // if(solver.info() != Success) // decomposition failed
+        matrices->Vi = solver.solve(matrices->E);
+        // if(solver.info() != Success) // solver failed
+        end_Vi = wallTimeTlmbht();
+    } else {
+        printf("\n\nSolving the steady-state problem for equation %04d iteratively...\n", id);
+
+        if (input->simulationInput.printAdditionalMode == 1) {
+            if (equation->SteadySolver == NODE_CG) {
+                printf("Solving the scalar of the %ld nodes using CG...\n", (long) matrices->nodeSystem.b.size());
+            } else {
+                printf("Solving Vi using %s...\n", equation->SteadySolver == ITERATIVE_GMRES ? "GMRES" : "BiCGSTAB");
+            }
+        }
+
+        // the products with the matrix are done by Eigen
+        setNbThreads(nThreads);
+
+        begin_Vi = wallTimeTlmbht();
+        switch (equation->Precond) {
+            case NO_PRECONDITIONER:
+                errorTLMnumber = tlmSolveIterativelyEigen<IdentityPreconditioner>(matrices, equation, nThreads, id);
+                break;
+            case JACOBI:
+                errorTLMnumber = tlmSolveIterativelyEigen<DiagonalPreconditioner<double> >(matrices, equation, nThreads, id);
+                break;
+            case ILU:
+                errorTLMnumber = tlmSolveIterativelyEigen<IncompleteLUT<double, long long> >(matrices, equation, nThreads, id);
+                break;
+            case INCOMPLETE_CHOLESKY:
+                errorTLMnumber = tlmSolveIterativelyEigen<IncompleteCholesky<double, Lower, AMDOrdering<long long> > >(matrices, equation, nThreads, id);
+                break;
+            case BLOCK_JACOBI:
+                /* FALLTHRU */
+            default:
+                errorTLMnumber = tlmSolveIterativelyEigen<BlockJacobiPreconditionerEigen>(matrices, equation, nThreads, id);
+                break;
+        }
+        end_Vi = wallTimeTlmbht();
+
+        if (errorTLMnumber != 0)
+            return errorTLMnumber;
+    }
+    time_Vi += end_Vi - begin_Vi;
+
+
+    // calculate the output at k+1
+    if (input->simulationInput.printAdditionalMode == 1) {
+        printf("Calculating the output...\n");
+    }
+    begin_T = wallTimeTlmbht();
+    if (matrices->tauRow.rows() > 0)
+        matrices->output = matrices->tauRow * matrices->Vi + matrices->E_output;
+    else
+        matrices->output = matrices->tau * matrices->Vi + matrices->E_output;
+    end_T = wallTimeTlmbht();
+    time_T += end_T - begin_T;
+
+
+    // saving the data
+    if (input->simulationInput.printAdditionalMode == 1) {
+        printf("Writing data to file...\n");
+    }
+    begin_write = wallTimeTlmbht();
+    writePartialOutput(input, matrices, id, position);
+    end_write = wallTimeTlmbht();
+    time_write += end_write - begin_write;
+
+    // the statistics of the steady-state have no thermal dose
+    if (matrices->statistics.used == 1) {
+        tlmAccumulateDoseEigen(matrices, 0, nThreads);
+        errorTLMnumber = tlmWriteStatisticsEigen(matrices, input, id, 0);
+        tlmTerminateStatisticsEigen(matrices);
+        if (errorTLMnumber != 0)
+            return errorTLMnumber;
+    }
+    printf("\nDone solving the steady-state problem for equation %04d %s.\n", id,
+            equation->SteadySolver == DIRECT_LU ? "directly" : "iteratively");
+
+    addPhaseProfiler("calculate the incident voltages", time_Vi, 1);
+    addPhaseProfiler("calculate the outputs", time_T, 1);
+    addPhaseProfiler("write the outputs", time_write, 1);
+
+    if (input->simulationInput.timingMode == 1) {
+
+        printTimeProfiler(time_Vi, "Time to calculate the incident voltages");
+
+        printTimeProfiler(time_T, "Time to calculate the outputs");
+
+        printTimeProfiler(time_write, "Time to write the outputs");
+    }
+
+    return 0;
+
+}
+
+/*
+ * adjustTimeJumpEigen: calculate the power of M used in the time-jump. A
+ * time-jump of k time-steps is Vi_(n+k) = M^k*Vi_n + (I + M + ... + M^(k-1))*E,
+ * so it can be done with k/p products with M^p and its accumulated E when p
+ * divides k. I calculate the powers one by one while the estimate of the
+ * fill-in of the next one keeps its product cheaper than the time-steps it
+ * replaces, and I choose the power with the smallest cost per time-step. The
+ * powers stop when their products cost more than the best saving that they
+ * could give or when they have many more entries than M. The power is only
+ * used if it saves more than the time to calculate it; otherwise, M is kept. The power replaces Mrow and E, and productsPerJump returns the
+ * quantity of products in each time-jump
+ */
+unsigned int adjustTimeJumpEigen(struct calculationTLMEigen *matrices,
+        struct dataForSimulation *input, int id, unsigned long long *productsPerJump) {
+
+    const struct Equation *equation = &(input->equationInput[id]);
+    const unsigned int jump = equation->timeJump;
+    const long long rows = matrices->Mrow.rows();
+    const long long *outerM = matrices->Mrow.outerIndexPtr();
+    SparseMatrix<double, RowMajor, long long> power, best, next;
+    Matrix<double, Dynamic, Dynamic, RowMajor> term, sum;
+    const int scenarios = matrices->scenarios.quantity;
+    unsigned int i, bestPower = 1;
+    long long k;
+    double nonZeros, nonZerosLast, estimate, bound;
+    double quantityOfJumps, saved, achievable, costPowers = 0;
+
+    // a product costs one multiply-add for each entry, plus the sum of E and
+    // the store of Vi for each line
+    const double costM = (double) matrices->Mrow.nonZeros() + 2.0 * rows;
+    const double full = (double) rows * rows; // entries of a full power
+    double costBest = costM; // per time-step
+
+    // the powers are kept in the memory with M, so they cannot be much larger
+    const double maximumNonZeros = 16.0 * matrices->Mrow.nonZeros();
+
+    *productsPerJump = jump;
+    if (jump <= 1 || matrices->matrixFree.used == 1 || matrices->statistics.used == 1 ||
+            equation->JumpPower == NO_POWER)
+        return 0;
+
+    quantityOfJumps = floor(equation->finalTime / (equation->timeStep * jump));
+    power = matrices->Mrow;
+    nonZerosLast = (double) power.nonZeros();
+    for (i = 2; i <= jump; i++) {
+        // power*M has at most, in each line, the entries of the lines of M
+        // in the columns of power. It is also the cost of the product
+        bound = 0;
+        for (k = 0; k < power.nonZeros(); k++)
+            bound += outerM[power.innerIndexPtr()[k] + 1] - outerM[power.innerIndexPtr()[k]];
+
+        // the lines overlap more and more, so, after M^2, I estimate the
+        // fill-in by the growth of the last power. It stops growing when the
+        // power is full, what makes the powers of small meshes cheap
+        nonZeros = (double) power.nonZeros();
+        estimate = i == 2 ? bound : std::min(bound, nonZeros * nonZeros / nonZerosLast);
+        estimate = std::min(estimate, full);
+        if (equation->JumpPower == AUTOMATIC_POWER) {
+            if ((estimate + 2.0 * rows) / i >= costM && (full + 2.0 * rows) / jump >= costM)
+                break;
+            if (estimate > maximumNonZeros)
+                break;
+
+            // the products cannot cost more than the best saving that a power
+            // could give. The next powers have at least the entries of this
+            // one, so none costs less than it would cost with M^jump
+            achievable = (costM - std::min(costBest, (estimate + 2.0 * rows) / jump)) *
+                    jump * quantityOfJumps * scenarios;
+            if (costPowers + bound > achievable)
+                break;
+        }
+
+        next = power * matrices->Mrow;
+        power.swap(next);
+        costPowers += bound;
+        nonZerosLast = nonZeros;
+
+        if (input->simulationInput.verboseMode == 1) {
+            printf("Power %u of M has %lld entries (estimated %g).\n", i,
+                    (long long) power.nonZeros(), estimate);
+        }
+
+        // the estimate can be lower than the entries of the power
+        if (equation->JumpPower == AUTOMATIC_POWER && power.nonZeros() > maximumNonZeros)
+            break;
+
+        // if the power was requested, M^jump is used even if it is not cheaper
+        if ((equation->JumpPower == ALWAYS_POWER && i == jump) ||
+                (equation->JumpPower == AUTOMATIC_POWER && jump % i == 0 &&
+                ((double) power.nonZeros() + 2.0 * rows) / i < costBest)) {
+            costBest = ((double) power.nonZeros() + 2.0 * rows) / i;
+            bestPower = i;
+            best = power;
+        }
+    }
+    SparseMatrix<double, RowMajor, long long>().swap(power);
+    SparseMatrix<double, RowMajor, long long>().swap(next);
+
+    // the power has to pay for its calculation. Its products are shared by the
+    // scenarios
+    saved = (costM - costBest) * jump * quantityOfJumps * scenarios;
+    if (bestPower == 1 || (equation->JumpPower == AUTOMATIC_POWER && saved <= costPowers)) {
+        printf("Calculating the time-jump time-step by time-step: the power of M is not cheaper.\n");
+        return 0;
+    }
+
+    // accumulated E: (I + M + ... + M^(p-1))*E, with one column for each
+    // scenario
+    term = Map<Matrix<double, Dynamic, Dynamic, RowMajor> >(matrices->E.data(), rows, scenarios);
+    sum = term;
+    for (i = 1; i < bestPower; i++) {
+        term = matrices->Mrow * term;
+        sum += term;
+    }
+
+    matrices->Mrow.swap(best);
+    matrices->Mrow.makeCompressed();
+    Map<Matrix<double, Dynamic, Dynamic, RowMajor> >(matrices->E.data(), rows, scenarios) = sum;
+    *productsPerJump = jump / bestPower;
+
+    printf("Calculating the time-jump with M^%u: %llu product(s) per time-jump, "
+            "%g times the cost of the time-steps.\n", bestPower, *productsPerJump, costBest / costM);
 
-        printf("Time to calculate the incident voltages %g ms (or %g s, or %g min, or %g hours).\n",
-                time_Vi * 1e3, time_Vi, time_Vi / 60.0, time_Vi / (60 * 60));
-
-        printf("Time to calculate the outputs %g ms (or %g s, or %g min, or %g hours).\n",
-                time_T * 1e3, time_T, time_T / 60.0, time_T / (60 * 60));
-
-        printf("Time to write the outputs %g ms (or %g s, or %g min, or %g hours).\n",
-                time_write * 1e3, time_write, time_write / 60.0, time_write / (60 * 60));
-    }
-
-    return 0;
-
-}
-
-/*
- * adjustTimeJumpEigen: used to make a previous multiplication of the matrices M and E.
- * Tests showed that it is faster to run the algorithm without this previous multiplication
- * for the sparse matrix. Therefore, this function is deprecated. It is not used.
- */
-unsigned int adjustTimeJumpEigen(struct calculationTLMEigen *matrices, unsigned int jump) {
-    /*unsigned int i;
-    matrices->M.uncompress();
-    
-    // creating the matrix that will multiply E
-    SparseMatrix<double, RowMajor, long long> sum_for_E(matrices->numbers.Ports,
-            matrices->numbers.Ports);
-    SparseMatrix<double, RowMajor, long long> mult_for_M(matrices->numbers.Ports,
-            matrices->numbers.Ports);    
-    printf("Initiating the matrices for adjust the time jump \n");
-    sum_for_E = matrices->M;
-    mult_for_M = matrices->M;
-    
-    // jump 1 to jump - 1
-    printf("Sparsity %g (%llu)\n", (double) matrices->M.nonZeros()/
-                (matrices->numbers.Ports*matrices->numbers.Ports),
-            matrices->M.nonZeros());
-    for (i = 1; i < jump - 1; i++){
-        printf("Calculating jump %u/%u\n", (i+1), jump);
-        sum_for_E = sum_for_E + matrices->M;
-        
-        matrices->M = matrices->M*mult_for_M;
-        printf("Sparsity %g (%llu)\n", (double) matrices->M.nonZeros()/
-                (matrices->numbers.Ports*matrices->numbers.Ports),
-                matrices->M.nonZeros());
-    }
-    printf("Calculating jump %u/%u\n", (i+1), jump);
-    
-    // last jump
-    matrices->E = sum_for_E*matrices->E + matrices->E;
-    matrices->M = matrices->M*mult_for_M;
-    
-    printf("Sparsity %g (%llu)\n", (double) matrices->M.nonZeros()/
-                (matrices->numbers.Ports*matrices->numbers.Ports),
-            matrices->M.nonZeros());
-    
-    matrices->M.makeCompressed();
-    
-    sum_for_E.resize(0,0);
-     */
     return 0;
 }
 
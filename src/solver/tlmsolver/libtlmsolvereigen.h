@@ -39,7 +39,15 @@
 #ifndef LIBTLMSOLVEREIGEN_H
 #define LIBTLMSOLVEREIGEN_H
 
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include <Eigen/Sparse>
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
 using namespace Eigen;
 
 #ifdef __cplusplus
@@ -57,6 +65,114 @@ extern "C" {
 }
 #endif
 
+/*
+ * tlmThreadEigen: returns the number of the OpenMP thread that is running, or
+ * 0 if OpenMP is not available
+ */
+static inline int tlmThreadEigen() {
+#if defined(_OPENMP)
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+
+struct matrixFreeTLMEigen {
+    // Used when the engine is matrix-free. Instead of M = C*S, I keep the
+    // scattering coefficients of each node and the connection coefficients of
+    // each port. In each time-step, I do the scattering (Vr = S*Vi) node by
+    // node and then the connection (Vi = C*Vr + E) port by port.
+    int used; // 0: M is used; 1: matrix-free
+    unsigned long long quantityOfNodes;
+    long long *nodeFirstPort; // first port of each node; the last value is the number of ports. Also used by the block-Jacobi preconditioner
+    double *tau; // S(p, q) = tau[q] for p != q
+    double *diagonal; // S(p, p)
+    double *reflection; // reflection coefficient of each port
+    double *transmission; // coefficient from the connected port into this port
+    long long *connectedPort; // port connected to this port; the port itself, with transmission 0, if there is none
+    VectorXd Vr; // reflected voltages
+};
+
+struct nodeSystemTLMEigen {
+    // Used when the steady-state is solved for the scalar of the nodes. At
+    // steady-state, the current in each transmission line is constant and the
+    // TLM network becomes a conductance network between the centers of the
+    // nodes. Its matrix is symmetric and positive-definite.
+    int used; // 0: not used; 1: the steady-state is solved for the nodes
+    long long *portNode; // node of each port
+    long long *otherPort; // port connected to this port; -1 at boundaries
+    double *zConductance; // Z of the port times the conductance from the port to the other port or boundary
+    double *zCurrent; // Z of the port times the current injected by the boundary. Zero if otherPort != -1
+    std::vector< Triplet<double, long long> > triplets; // entries of A while it is assembled
+    SparseMatrix<double, RowMajor, long long> A; // conductance matrix of the nodes
+    VectorXd b; // current sources of the nodes
+    VectorXd U; // scalar in the center of each node
+};
+
+struct checkpointTLMEigen {
+    // Used in the time-domain solution to write checkpoints. The solver copies
+    // the incident voltages and the thermal doses, and the writer thread writes
+    // them after the outputs that were calculated before, while the solver goes
+    // on with the time-steps. The checkpoint is -1 in the filled buffers of the
+    // writer. Without the writer thread, the solver writes it
+    int used; // 0: no checkpoints; 1: they are written
+    int pending; // 1: the writer thread did not write the last checkpoint yet
+    char *name;
+    struct tlrCheckpointHeader header;
+    std::vector<long long> offsets; // size of the output file of each scenario and of the statistics
+    VectorXd Vi;
+    VectorXd dose;
+    double last; // wall time of the last checkpoint
+    unsigned long long quantity; // checkpoints written
+    double timeWriting; // time spent writing the checkpoints
+};
+
+struct outputWriterTLMEigen {
+    // Used in the time-domain solution to write the outputs in another thread.
+    // The solver swaps the output that it calculated with a free buffer and goes
+    // on with the time-steps. The writer thread writes the filled buffers in
+    // the order they were filled and frees them. If there is no free buffer,
+    // the solver waits (the disk is slower than the time-steps).
+    int used; // 0: the solver writes the outputs; 1: the writer thread writes them
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable bufferFilled; // notified by the solver
+    std::condition_variable bufferFreed; // notified by the writer thread
+    std::vector<VectorXd> buffers;
+    std::vector<unsigned long long> position; // position of the output in each buffer
+    std::deque<int> filled; // buffers to be written, in order
+    std::vector<int> freeBuffers;
+    int finish; // 1: no more outputs will be filled
+    unsigned int errorTLMnumber; // first error of the writer thread
+    double timeWriting; // time that the writer thread spent writing
+    struct checkpointTLMEigen checkpoint;
+};
+
+struct statisticsTLMEigen {
+    // Used when the equation has statistics tags. The scalar of the nodes of
+    // the tags has its own lines of tau, so it does not depend on what is
+    // saved. The thermal dose (CEM43) is accumulated in every time-step, and
+    // the statistics are written in the saved time-steps.
+    int used; // 0: not used; 1: the statistics are calculated
+    SparseMatrix<double, RowMajor, long long> tau; // lines of tau of the nodes of the tags
+    VectorXd E; // lines of E_output of the nodes of the tags
+    VectorXd scalar; // scalar of the nodes of the tags
+    VectorXd volume; // volume of the nodes of the tags
+    VectorXd dose; // CEM43 of the nodes of the tags, in minutes
+    std::vector<long long> firstLine; // first line of each tag; the last value is the number of lines
+    FILE *file;
+};
+
+struct scenariosTLMEigen {
+    // Used when the equation has scenarios. The scenarios only change E and the
+    // initial Vi, so they share M: Vi, Vi_next, and E have the quantity of
+    // scenarios values for each port (port by port), and all of them are
+    // updated in the same product with M. E_output and output have one column
+    // of outputs for each scenario.
+    int quantity; // 1: only the case
+    std::vector<FILE*> files; // output file of each scenario. The first is the output file
+};
+
 struct calculationTLMEigen {
     // matrix M and tau seem to be better allocated as a sparse matrix
     //SparseMatrix<double, RowMajor, long long> M; // connection * scattering.
@@ -64,20 +180,40 @@ struct calculationTLMEigen {
     // Change to ColMajor to take advantage of linear solvers. Furthermore, they seem to be slightly faster (~10%)
     SparseMatrix<double, ColMajor, long long> M; // connection * scattering
     SparseMatrix<double, ColMajor, long long> tau; // Converts incident voltage to the output variable
+    // when the outputs are restricted to probes or tags, tau has a few lines
+    // and the product is faster line by line
+    SparseMatrix<double, RowMajor, long long> tauRow; // not initialized by default, only if required
     SparseMatrix<double, ColMajor, long long> identity; // not initialized by default, only if required
     SparseMatrix<double, ColMajor, long long> Msteady; // not initialized by default, only if required
+    SparseMatrix<double, RowMajor, long long> MsteadyRow; // I - M for the iterative steady-state solvers. Only if required
+    // Eigen does the product with M in one thread. For the time-domain solution,
+    // I copy M to a row-major matrix and split its rows among the OpenMP threads.
+    SparseMatrix<double, RowMajor, long long> Mrow; // not initialized by default, only if required
     VectorXd E; // boundaries and external sources: connection * Z_hat * I_source (internal heat generation) + B (boundaries)
     double *Z; // All the impedances
     double *R; // All the resistances
     VectorXd Vi; // incident voltages.
+    VectorXd Vi_next; // incident voltages of the next time-step. Only used in time-domain
+    struct matrixFreeTLMEigen matrixFree; // not initialized by default, only if required
+    struct nodeSystemTLMEigen nodeSystem; // not initialized by default, only if required
     double *L; // All the characteristic lengths. For triangle: length of the face. For tetrahedron: Area of the face
     double *deltal; // All the ports's lengths
+    double *volume; // volume of each node. Area in 2D and length in 1D
+    struct statisticsTLMEigen statistics; // not initialized by default, only if required
+    struct scenariosTLMEigen scenarios; // not initialized by default, only if required
+    // 1: the numbers and the connections are kept for the next point of a sweep
+    // when the matrices are calculated
+    int keepTopology;
     VectorXd output; // this contains the vector with the output data, the one
     // to be saved in files
     VectorXd E_output; // this contains the vector with the constant to add to the
     struct Point *Points_output;
     // output vector
     struct TLMnumbers numbers;
+    // entries of M and tau saved by each thread while the elements are
+    // assembled. They become M and tau in tlmAssembleElementsEigen
+    std::vector< std::vector< Triplet<double, long long> > > tripletsM;
+    std::vector< std::vector< Triplet<double, long long> > > tripletsTau;
 
     // R and Z can be deallocated when no parameters is going to change during the simulation;
     // actually, depending of the case, they can be deallocated and only
@@ -86,11 +222,11 @@ struct calculationTLMEigen {
 };
 
 
-unsigned int initiate_matrices_calculationTLMEigen(struct calculationTLMEigen *,
-        unsigned int *);
+unsigned int initiate_matrices_calculationTLMEigen(struct calculationTLMEigen *);
 unsigned int terminate_matrices_calculationTLMEigen(struct calculationTLMEigen *);
 
-unsigned int tlmInitializeSteadyMatrices(struct calculationTLMEigen *);
+unsigned int tlmInitializeSteadyMatrices(struct calculationTLMEigen *,
+        const struct Equation *);
 
 unsigned int terminateVariablesTLMEigen(struct dataForSimulation*,
         struct calculationTLMEigen*, struct boundaryData**, struct connectionLeveln *,
@@ -100,13 +236,45 @@ unsigned int terminateSomeVariablesEigen(struct dataForSimulation *,
         struct calculationTLMEigen *,
         struct boundaryData**, struct connectionLeveln *, int);
 
+unsigned int tlmInitiateElementTripletsEigen(struct calculationTLMEigen *, int);
+unsigned int tlmAssembleElementsEigen(struct calculationTLMEigen *);
+unsigned int tlmConnectPortsEigen(struct calculationTLMEigen *,
+        const std::vector<double> &, std::vector< Triplet<double, long long> > &,
+        std::vector< Triplet<double, long long> > &, int, int);
+
+unsigned int tlmFindNodesEigen(struct calculationTLMEigen *);
+unsigned int tlmInitiateMatrixFreeEigen(struct calculationTLMEigen *);
+unsigned int tlmTerminateMatrixFreeEigen(struct calculationTLMEigen *);
+unsigned int tlmRenumberNodesEigen(struct calculationTLMEigen *, enum renumbering, int, int);
+unsigned int tlmSelectOutputsEigen(struct calculationTLMEigen *, struct dataForSimulation *, int);
+
+unsigned int tlmInitiateStatisticsEigen(struct calculationTLMEigen *, struct dataForSimulation *, int);
+void tlmAccumulateDoseEigen(struct calculationTLMEigen *, double, int);
+unsigned int tlmWriteStatisticsEigen(struct calculationTLMEigen *, struct dataForSimulation *, int, double);
+unsigned int tlmTerminateStatisticsEigen(struct calculationTLMEigen *);
+
+unsigned int tlmInitiateNodeSystemEigen(struct calculationTLMEigen *);
+void tlmAddConnectionToNodeSystemEigen(struct calculationTLMEigen *,
+        const struct connectionAndBoundaryCoefficients *);
+unsigned int tlmTerminateNodeSystemEigen(struct calculationTLMEigen *);
+
+unsigned int tlmTerminateScenariosEigen(struct calculationTLMEigen *);
+
+unsigned int tlmPrepareTimeDomainEigen(struct calculationTLMEigen *, int);
+
+void tlmUpdateIncidentVoltagesEigen(struct calculationTLMEigen *, int);
+
+unsigned int tlmScalingReportEigen(struct calculationTLMEigen *,
+        struct dataForSimulation *, int);
+
 unsigned int tlmSolveMatricesTimeDomainEigen(struct calculationTLMEigen *,
         struct dataForSimulation *, int);
 
 unsigned int tlmSolveMatricesSteadyStateEigen(struct calculationTLMEigen *,
         struct dataForSimulation *, int);
 
-unsigned int adjustTimeJumpEigen(struct calculationTLMEigen *, unsigned int);
+unsigned int adjustTimeJumpEigen(struct calculationTLMEigen *,
+        struct dataForSimulation *, int, unsigned long long *);
 
 unsigned int writePartialOutputEigen(struct calculationTLMEigen *,
         unsigned long long, FILE*);
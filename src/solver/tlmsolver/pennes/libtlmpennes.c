@@ -42,6 +42,7 @@
 
 #include "../src/miscellaneous/libwritetofiletlmbht.h"
 #include "../../../miscellaneous/liberrorcode.h"
+#include "../../../miscellaneous/libmiscellaneous.h"
 
 
 // Maybe this function can be independent of the physics (Pennes, EM, CFD, etc) being solved.
@@ -56,148 +57,201 @@ unsigned int initiateVariablesTLMPennes(struct dataForSimulation *input,
         void * matrices, struct TLMnumbers *numbers, struct boundaryData** boundaries,
         struct connectionLeveln *intersections, int id) {
 
-    clock_t begin_con = clock();
-    if (input->simulationInput.printAdditionalMode == 1) {
-        printf("\n\nInitiating the connection variable.\n");
-    }
-
     unsigned int errorTLMnumber;
 
-    // the level of the intersection variable
-    unsigned int level;
-    // variable that contains the initial allocation for each level of the intersection variable
-    unsigned long long *allocateForEachLevel;
-    // the values inserted for the allocateForEachLevel variable are arbitrary.
+    // the numbers and the connections are read from the topology cache if it
+    // was written for this mesh and this equation. Otherwise, they are created
+    // (and the cache is written, if required)
+    int cacheRead = 0;
+    unsigned long long cacheKey = 0;
+    char *cacheName = NULL;
+    if (input->equationInput[id].topologyCache == 1) {
+        beginPhaseProfiler("read the topology cache");
+        cacheName = (char *) malloc(strlen(input->simulationInput.nameOfOutputFile) + 32);
+        if (cacheName == NULL) {
+            endPhaseProfiler();
+            return 8750;
+        }
+        sprintf(cacheName, "%s_topology_%d.tlc", input->simulationInput.nameOfOutputFile, id + 1);
+        cacheKey = keyTopologyCacheTLM(input, id);
+        cacheRead = readTopologyCacheTLM(input, cacheName, cacheKey, numbers, intersections) == 0;
+        double time_spent_cache = endPhaseProfiler();
+
+        if (input->simulationInput.printAdditionalMode == 1) {
+            if (cacheRead == 1) {
+                printf("\n\nRead the TLM numbers and the connection variable from the topology cache %s.\n", cacheName);
+            } else {
+                printf("\n\nThe topology cache %s does not exist or is not for this mesh and equation.\n", cacheName);
+            }
+        }
+
+        if (input->simulationInput.timingMode == 1) {
+            printTimeProfiler(time_spent_cache, "Time to read the topology cache");
+        }
+    }
 
-    // TODO these are approximated calculations to initiate the connection variable.
-    switch (input->equationInput[id].dimen) {
-        case ONE:
-            level = 1;
+    if (cacheRead == 0) {
+        beginPhaseProfiler("initiate connections");
+        if (input->simulationInput.printAdditionalMode == 1) {
+            printf("\n\nInitiating the connection variable.\n");
+        }
 
-            allocateForEachLevel = (unsigned long long *) malloc(sizeof (unsigned long long)*(level + 1));
+        // the level of the intersection variable
+        unsigned int level;
+        // variable that contains the initial allocation for each level of the intersection variable
+        unsigned long long *allocateForEachLevel;
+        // the values inserted for the allocateForEachLevel variable are arbitrary.
 
-            allocateForEachLevel[0] = input->mesh.numberOfNode; // line. Level 1. 1 point
-            allocateForEachLevel[1] = 3; // level of the ports. Level 0
+        // TODO these are approximated calculations to initiate the connection variable.
+        switch (input->equationInput[id].dimen) {
+            case ONE:
+                level = 1;
 
-            break;
-        case TWO:
-            level = 2;
+                allocateForEachLevel = (unsigned long long *) malloc(sizeof (unsigned long long)*(level + 1));
 
-            allocateForEachLevel = (unsigned long long *) malloc(sizeof (unsigned long long)*(level + 1));
+                allocateForEachLevel[0] = input->mesh.numberOfNode; // line. Level 1. 1 point
+                allocateForEachLevel[1] = 3; // level of the ports. Level 0
 
-            // triangle and quadrangle. Level 2. 2 points
-            allocateForEachLevel[0] = 1 + (input->mesh.quantityOfSpecificElement[2] +
-                    input->mesh.quantityOfSpecificElement[3]) / 2;
+                break;
+            case TWO:
+                level = 2;
 
-            // line. Level 1. 1 point
-            allocateForEachLevel[1] = 1 + input->mesh.quantityOfSpecificElement[1];
-            allocateForEachLevel[2] = 3; // level of the ports. Level 0
+                allocateForEachLevel = (unsigned long long *) malloc(sizeof (unsigned long long)*(level + 1));
 
-            // this is an alternative way. I did run out of memory using the above approach.
-            // With this, we allocate much less memory.
-            // I've to find a better alternative to balance memory/time.
-            allocateForEachLevel[0] = 1;
-            allocateForEachLevel[1] = 1;
+                // triangle and quadrangle. Level 2. 2 points
+                allocateForEachLevel[0] = 1 + (input->mesh.quantityOfSpecificElement[2] +
+                        input->mesh.quantityOfSpecificElement[3]) / 2;
 
-            break;
-        case THREE:
-            if (input->mesh.quantityOfSpecificElement[5] ||
-                    input->mesh.quantityOfSpecificElement[6] ||
-                    input->mesh.quantityOfSpecificElement[7]) {
-                level = 4;
-            } else {
-                level = 3;
-            }
+                // line. Level 1. 1 point
+                allocateForEachLevel[1] = 1 + input->mesh.quantityOfSpecificElement[1];
+                allocateForEachLevel[2] = 3; // level of the ports. Level 0
 
+                // this is an alternative way. I did run out of memory using the above approach.
+                // With this, we allocate much less memory.
+                // I've to find a better alternative to balance memory/time.
+                allocateForEachLevel[0] = 1;
+                allocateForEachLevel[1] = 1;
 
-            allocateForEachLevel = (unsigned long long *) malloc(sizeof (unsigned long long)*(level + 1));
-            int leveln = 0;
-            if (level == 4) {
-                // Hexahedron, prism and pyramid. Level 4. 4 points
-                allocateForEachLevel[leveln] = 1 + (input->mesh.quantityOfSpecificElement[5] +
+                break;
+            case THREE:
+                if (input->mesh.quantityOfSpecificElement[5] ||
+                        input->mesh.quantityOfSpecificElement[6] ||
+                        input->mesh.quantityOfSpecificElement[7]) {
+                    level = 4;
+                } else {
+                    level = 3;
+                }
+
+
+                allocateForEachLevel = (unsigned long long *) malloc(sizeof (unsigned long long)*(level + 1));
+                int leveln = 0;
+                if (level == 4) {
+                    // Hexahedron, prism and pyramid. Level 4. 4 points
+                    allocateForEachLevel[leveln] = 1 + (input->mesh.quantityOfSpecificElement[5] +
+                            input->mesh.quantityOfSpecificElement[6] +
+                            input->mesh.quantityOfSpecificElement[7]) / 3;
+                    leveln++;
+                }
+
+
+
+                // Tetrahedron, hexahedron, prism and pyramid. Level 3. 3 points
+                allocateForEachLevel[leveln] = 1 + (input->mesh.quantityOfSpecificElement[4] +
+                        input->mesh.quantityOfSpecificElement[5] +
                         input->mesh.quantityOfSpecificElement[6] +
-                        input->mesh.quantityOfSpecificElement[7]) / 3;
+                        input->mesh.quantityOfSpecificElement[7]) / 8;
                 leveln++;
-            }
-
 
+                // Triangles and line. Level 2. 2 points
+                allocateForEachLevel[leveln] = 1 + (input->mesh.quantityOfSpecificElement[2] +
+                        input->mesh.quantityOfSpecificElement[3]) / 2;
+                leveln++;
+                // Level 3. 1 point
+                allocateForEachLevel[leveln] = 1 + (input->mesh.quantityOfSpecificElement[2] +
+                        input->mesh.quantityOfSpecificElement[3]) / 8;
+                leveln++;
+                // level of the port
+                allocateForEachLevel[leveln] = 3; // level of the ports. Level 0
+
+                // this is an alternative way. I did run out of memory using the above approach.
+                // With this, we allocate much less memory.
+                // I've to find a better alternative to balance memory/time.
+                for (int i2 = 0; i2 < level; i2++) {
+                    allocateForEachLevel[i2] = 1;
+                }
+                break;
+        }
 
-            // Tetrahedron, hexahedron, prism and pyramid. Level 3. 3 points
-            allocateForEachLevel[leveln] = 1 + (input->mesh.quantityOfSpecificElement[4] +
-                    input->mesh.quantityOfSpecificElement[5] +
-                    input->mesh.quantityOfSpecificElement[6] +
-                    input->mesh.quantityOfSpecificElement[7]) / 8;
-            leveln++;
-
-            // Triangles and line. Level 2. 2 points
-            allocateForEachLevel[leveln] = 1 + (input->mesh.quantityOfSpecificElement[2] +
-                    input->mesh.quantityOfSpecificElement[3]) / 2;
-            leveln++;
-            // Level 3. 1 point
-            allocateForEachLevel[leveln] = 1 + (input->mesh.quantityOfSpecificElement[2] +
-                    input->mesh.quantityOfSpecificElement[3]) / 8;
-            leveln++;
-            // level of the port
-            allocateForEachLevel[leveln] = 3; // level of the ports. Level 0
-
-            // this is an alternative way. I did run out of memory using the above approach.
-            // With this, we allocate much less memory.
-            // I've to find a better alternative to balance memory/time.
-            for (int i2 = 0; i2 < level; i2++) {
-                allocateForEachLevel[i2] = 1;
+        // VERBOSE: see the preallocation
+        if (input->simulationInput.verboseMode == 1) {
+            printf("Pre-allocations for the connection variable with %u level(s): "
+                    "%llu", level, allocateForEachLevel[0]);
+            for (int ilevel = 1; ilevel < level; ilevel++) {
+                printf(", %llu", allocateForEachLevel[ilevel]);
             }
-            break;
-    }
-
-    // VERBOSE: see the preallocation
-    if (input->simulationInput.verboseMode == 1) {
-        printf("Pre-allocations for the connection variable with %u level(s): "
-                "%llu", level, allocateForEachLevel[0]);
-        for (int ilevel = 1; ilevel < level; ilevel++) {
-            printf(", %llu", allocateForEachLevel[ilevel]);
+            printf("\n");
         }
-        printf("\n");
-    }
 
-    if ((errorTLMnumber = initiate_connectionLeveln(intersections, level, allocateForEachLevel)) != 0) {
-        return errorTLMnumber;
-    }
-    free(allocateForEachLevel);
-    allocateForEachLevel = NULL;
+        if ((errorTLMnumber = initiate_connectionLeveln(intersections, level, allocateForEachLevel)) != 0) {
+            endPhaseProfiler();
+            return errorTLMnumber;
+        }
+        free(allocateForEachLevel);
+        allocateForEachLevel = NULL;
     
-    clock_t end_con = clock();
+        double time_spent_con = endPhaseProfiler();
 
-    if (input->simulationInput.printAdditionalMode == 1) {
-        printf("Done initiating the connection variable.\n");
-    }
+        if (input->simulationInput.printAdditionalMode == 1) {
+            printf("Done initiating the connection variable.\n");
+        }
 
-    if (input->simulationInput.timingMode == 1) {
-        double time_spent_con = (double) (end_con - begin_con) / CLOCKS_PER_SEC;
-        printf("Time to initiate connections %g ms (or %g s, or %g min, or %g hours).\n",
-                time_spent_con * 1e3, time_spent_con, time_spent_con / 60.0, time_spent_con / (60 * 60));
-    }
+        if (input->simulationInput.timingMode == 1) {
+            printTimeProfiler(time_spent_con, "Time to initiate connections");
+        }
 
-    if (input->simulationInput.printAdditionalMode == 1) {
-        printf("Getting the TLM numbers (number of ports, nodes outputs, etc.) and the connection variable...\n");
-    }
+        if (input->simulationInput.printAdditionalMode == 1) {
+            printf("Getting the TLM numbers (number of ports, nodes outputs, etc.) and the connection variable...\n");
+        }
 
-    clock_t begin_get = clock();
-    // get the numbers, the connections, and wrap them
-    if ((errorTLMnumber = getTLMnumbers(input, numbers, intersections, id)) != 0) {
-        return errorTLMnumber;
-    }
+        beginPhaseProfiler("initiate TLM numbers and the connection variable");
+        // the boundary or material of each tag, used by all the elements of the equation
+        if ((errorTLMnumber = initiateTagsTLMnumbers(input, numbers, id)) != 0) {
+            endPhaseProfiler();
+            return errorTLMnumber;
+        }
+        // get the numbers, the connections, and wrap them
+        if ((errorTLMnumber = getTLMnumbers(input, numbers, intersections, id)) != 0) {
+            endPhaseProfiler();
+            return errorTLMnumber;
+        }
 
-    clock_t end_get = clock();
+        double time_spent_get = endPhaseProfiler();
 
-    if (input->simulationInput.printAdditionalMode == 1) {
-        printf("Done getting the TLM numbers (number of ports, nodes outputs, etc.) and the connection variable.\n");
-    }
+        if (input->simulationInput.printAdditionalMode == 1) {
+            printf("Done getting the TLM numbers (number of ports, nodes outputs, etc.) and the connection variable.\n");
+        }
     
-    if (input->simulationInput.timingMode == 1) {
-        double time_spent_get = (double) (end_get - begin_get) / CLOCKS_PER_SEC;
-        printf("Time to initiate TLM numbers (number of ports, nodes outputs, etc.) and the connection variable %g ms (or %g s, or %g min, or %g hours).\n",
-                time_spent_get * 1e3, time_spent_get, time_spent_get / 60.0, time_spent_get / (60 * 60));
+        if (input->simulationInput.timingMode == 1) {
+            printTimeProfiler(time_spent_get, "Time to initiate TLM numbers (number of ports, nodes outputs, etc.) and the connection variable");
+        }
+
+        if (cacheName != NULL) {
+            beginPhaseProfiler("write the topology cache");
+            if ((errorTLMnumber = writeTopologyCacheTLM(input, cacheName, cacheKey,
+                    numbers, intersections)) != 0) {
+                free(cacheName);
+                endPhaseProfiler();
+                return errorTLMnumber;
+            }
+            double time_spent_write = endPhaseProfiler();
+
+            if (input->simulationInput.timingMode == 1) {
+                printTimeProfiler(time_spent_write, "Time to write the topology cache");
+            }
+        }
     }
+    free(cacheName);
+    cacheName = NULL;
 
     // DEBUG: shows the numbers we got
     //    printf("Number of nodes %llu, number of ports %llu, number of outputs %llu\n",
@@ -206,19 +260,18 @@ unsigned int initiateVariablesTLMPennes(struct dataForSimulation *input,
     if (input->simulationInput.printAdditionalMode == 1) {
         printf("Initiating the boundary variable...\n");
     }
-    clock_t begin_bound = clock();
+    beginPhaseProfiler("initiate the boundaries");
     if ((errorTLMnumber = initiateBoundaryTypeAndDataPennes(boundaries, input, id)) != 0) {
+        endPhaseProfiler();
         return errorTLMnumber;
     }
-    clock_t end_bound = clock();
+    double time_spent_bound = endPhaseProfiler();
     if (input->simulationInput.printAdditionalMode == 1) {
         printf("Done initiating the boundary variable.\n");
     }
     
     if (input->simulationInput.timingMode == 1) {
-        double time_spent_bound = (double) (end_bound - begin_bound) / CLOCKS_PER_SEC;
-        printf("Time to initiate the boundaries %g ms (or %g s, or %g min, or %g hours).\n",
-                time_spent_bound * 1e3, time_spent_bound, time_spent_bound / 60.0, time_spent_bound / (60 * 60));
+        printTimeProfiler(time_spent_bound, "Time to initiate the boundaries");
     }
     
     if (input->simulationInput.printAdditionalMode == 1) {
@@ -235,77 +288,14 @@ unsigned int initiateVariablesTLMPennes(struct dataForSimulation *input,
         printf("Allocating and initiating the matrices...\n");
     }
 
-    clock_t begin_mat = clock();
+    beginPhaseProfiler("initiate the matrices");
     // initiating the matrices
-    int numberOfAdditionalPorts;
     switch (input->equationInput[id].libraryForCalculation) {
         case EIGEN:
-            // quantities to reserve in the sparse matrices used in the implementation
-            // using the Eigen library
-            // the number of ports depends on the equation we are solving
-            switch (input->equationInput[id].typeS) {
-            case HYPERBOLIC_DIFFUSION:
-                // break;
-                /* FALLTHRU */
-            case HYPERBOLIC_HEAT:
-                // break;
-                /* FALLTHRU */
-            case HYPERBOLIC_PENNES:
-                numberOfAdditionalPorts = 1;
-                 break;
-            case DIFFUSION : // the solver to these equations is the same
-                // break;
-                /* FALLTHRU */
-            case HEAT: // the solver to these equations is the same
-                // break;
-                /* FALLTHRU */
-            case PENNES:
-                numberOfAdditionalPorts = 0;
-                break;
-
-            case EM:
-                break;
-            case CFD:
-                break;
-        }
-            unsigned int quantityToReserve[] = {2*(2 + numberOfAdditionalPorts), 2*(2 + numberOfAdditionalPorts)}; // Initial value 
-
-            // if we have what is defined below, I increase the number to reserve. The numbers
-            // to reserve are the square of the number of ports .
-
-            // Triangle elements
-            if (input->mesh.quantityOfSpecificElement[2]) {
-                quantityToReserve[0] = 3*(3 + numberOfAdditionalPorts);
-                quantityToReserve[1] = 3*(3 + numberOfAdditionalPorts);
-            }
-
-            // quadrangle or tetrahedron elements
-            if (input->mesh.quantityOfSpecificElement[3] != 0 ||
-                    input->mesh.quantityOfSpecificElement[4] != 0) {
-                quantityToReserve[0] = 4*(4 + numberOfAdditionalPorts);
-                quantityToReserve[1] = 4*(4 + numberOfAdditionalPorts);
-            }
-
-            // pyramid elements
-            if (input->mesh.quantityOfSpecificElement[7] != 0) {
-                quantityToReserve[0] = 5*(5 + numberOfAdditionalPorts);
-                quantityToReserve[1] = 5*(5 + numberOfAdditionalPorts);
-            }
-
-            // prism elements
-            if (input->mesh.quantityOfSpecificElement[6] != 0) {
-                quantityToReserve[0] = 6*(6 + numberOfAdditionalPorts);
-                quantityToReserve[1] = 6*(6 + numberOfAdditionalPorts);
-            }
-
-            // hexahedron elements
-            if (input->mesh.quantityOfSpecificElement[5] != 0) {
-                quantityToReserve[0] = 8*(8 + numberOfAdditionalPorts);
-                quantityToReserve[1] = 8*(8 + numberOfAdditionalPorts);
-            }
-
-            if (errorTLMnumber = call_from_c_initiate_matrices_calculationTLMEigen(matrices,
-                    quantityToReserve) != 0) {
+            // nothing is reserved in the sparse matrices. They are built when
+            // the quantity of entries of each column is known
+            if (errorTLMnumber = call_from_c_initiate_matrices_calculationTLMEigen(matrices) != 0) {
+                endPhaseProfiler();
                 return errorTLMnumber;
             }
             break;
@@ -314,14 +304,12 @@ unsigned int initiateVariablesTLMPennes(struct dataForSimulation *input,
             // future implementation
             break;
     }
-    clock_t end_mat = clock();
+    double time_spent_mat = endPhaseProfiler();
     if (input->simulationInput.printAdditionalMode == 1) {
         printf("Done allocating and initiating the matrices.\n");
     }
     if (input->simulationInput.timingMode == 1) {
-        double time_spent_mat = (double) (end_mat - begin_mat) / CLOCKS_PER_SEC;
-        printf("Time to initiate the matrices %g ms (or %g s, or %g min, or %g hours).\n",
-                time_spent_mat * 1e3, time_spent_mat, time_spent_mat / 60.0, time_spent_mat / (60 * 60));
+        printTimeProfiler(time_spent_mat, "Time to initiate the matrices");
     }
 
 
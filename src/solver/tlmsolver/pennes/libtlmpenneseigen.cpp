@@ -46,6 +46,68 @@
 #include "libtlmpennes3dsolver.h"
 #include "../../../miscellaneous/liberrorcode.h"
 #include "../../../miscellaneous/libwritetofiletlmbht.h"
+#include "../../../miscellaneous/libmiscellaneous.h"
+
+/*
+ * solveCasePennesEigen: calculate the scenarios of the case, if there are any,
+ * and solve it with the matrices already calculated
+ */
+static unsigned int solveCasePennesEigen(struct dataForSimulation* input,
+        struct calculationTLMEigen *matrices, int id) {
+    unsigned int errorTLMnumber = 0;
+
+    // the other scenarios only have their own E and initial Vi
+    if (input->equationInput[id].Solv == DYNAMIC && input->equationInput[id].numberOfScenarios > 1) {
+        if (input->simulationInput.printAdditionalMode == 1) {
+            printf("Calculating the scenarios...\n");
+        }
+        beginPhaseProfiler("calculate the scenarios");
+        errorTLMnumber = calculateScenariosPennesEigen(input, matrices, id);
+        double time_spent_scenarios = endPhaseProfiler();
+        if (errorTLMnumber != 0) {
+            sendErrorCodeAndMessage(errorTLMnumber, NULL, NULL, NULL, NULL);
+            return errorTLMnumber;
+        }
+        if (input->simulationInput.printAdditionalMode == 1) {
+            printf("\nDone calculating the scenarios\n");
+        }
+        if (input->simulationInput.timingMode == 1) {
+            printTimeProfiler(time_spent_scenarios, "Total time to calculate the scenarios");
+        }
+    }
+
+    // Solve the problem
+    if (input->equationInput[id].solveDirectly == 1) {
+        if (input->simulationInput.printAdditionalMode == 1) {
+            printf("Solving this equation directly\n");
+        }
+        beginPhaseProfiler("solve the matrices");
+        // in time domain
+        if (input->equationInput[id].Solv == DYNAMIC) {
+            errorTLMnumber = tlmSolveMatricesTimeDomainEigen(matrices, input, id);
+        } else if (input->equationInput[id].Solv == STEADY) {
+            errorTLMnumber = tlmSolveMatricesSteadyStateEigen(matrices, input, id);
+        }
+        double time_spent_solve = endPhaseProfiler();
+        if (errorTLMnumber != 0) {
+            sendErrorCodeAndMessage(errorTLMnumber, NULL, NULL, NULL, NULL);
+            return errorTLMnumber;
+        }
+
+        // this equation does not need to be solved anymore. It was solved
+        input->equationInput[id].needToSolve = 0;
+
+        if (input->simulationInput.printAdditionalMode == 1) {
+            printf("Done solving this equation directly\n");
+        }
+
+        if (input->simulationInput.timingMode == 1) {
+            printTimeProfiler(time_spent_solve, "Total time to solve the matrices");
+        }
+    }
+
+    return 0;
+}
 
 /*
  * solverTLMPennesEigenGeneral: Solves the 'diffusion', 'hyperbolic diffusion',
@@ -56,7 +118,7 @@ unsigned int solverTLMPennesEigenGeneral(struct dataForSimulation* input, int id
     struct calculationTLMEigen calcs;
     struct boundaryData *boundaries;
     struct connectionLeveln intersections;
-    clock_t end_solve, begin_solve, end_matrices, begin_matrices, end_initiate, begin_initiate;
+    double time_spent_initiate, time_spent_matrices;
 
     if (input->simulationInput.printAdditionalMode == 1) {
         printf("Testing the input...\n");
@@ -92,27 +154,32 @@ unsigned int solverTLMPennesEigenGeneral(struct dataForSimulation* input, int id
         printf("Done testing the input.\n");
     }
 
+    // the case is solved for each point of the sweep
+    if (input->equationInput[id].numberOfSweepPoints > 0) {
+        *generalMatrix = NULL;
+        return solverSweepPennesEigen(input, id);
+    }
+
 
     // initiate the variables
     if (input->simulationInput.printAdditionalMode == 1) {
         printf("Allocating and initiating the variables...\n");
     }
-    begin_initiate = clock();
-    if ((errorTLMnumber = initiateVariablesTLMPennes(input, &calcs,
-            &(calcs.numbers), &boundaries, &intersections, id)) != 0) {
+    beginPhaseProfiler("allocate and initiate the variables");
+    errorTLMnumber = initiateVariablesTLMPennes(input, &calcs,
+            &(calcs.numbers), &boundaries, &intersections, id);
+    time_spent_initiate = endPhaseProfiler();
+    if (errorTLMnumber != 0) {
         sendErrorCodeAndMessage(errorTLMnumber, NULL, NULL, NULL, NULL);
         // If I find an error, I will redirect the code to the cleaning part
         goto cleaning_part;
     }
-    end_initiate = clock();
     if (input->simulationInput.printAdditionalMode == 1) {
         printf("\nDone allocating and initiating the variables.\n");
     }
 
     if (input->simulationInput.timingMode == 1) {
-        double time_spent_initiate = (double) (end_initiate - begin_initiate) / CLOCKS_PER_SEC;
-        printf("Total time to allocate and initiate the variables %g ms (or %g s, or %g min, or %g hours).\n\n",
-                time_spent_initiate * 1e3, time_spent_initiate, time_spent_initiate / 60.0, time_spent_initiate / (60 * 60));
+        printTimeProfiler(time_spent_initiate, "Total time to allocate and initiate the variables");
     }
 
     // get the matrices values. I verify if errorTLMnumber = 0 because if it is 
@@ -121,54 +188,25 @@ unsigned int solverTLMPennesEigenGeneral(struct dataForSimulation* input, int id
     if (input->simulationInput.printAdditionalMode == 1) {
         printf("Calculating the matrices...\n");
     }
-    begin_matrices = clock();
-    if ((errorTLMnumber = calculateMatricesPennesEigen(input, &calcs, &boundaries, &intersections, id)) != 0) {
+    beginPhaseProfiler("calculate the matrices");
+    errorTLMnumber = calculateMatricesPennesEigen(input, &calcs, &boundaries, &intersections, id);
+    time_spent_matrices = endPhaseProfiler();
+    if (errorTLMnumber != 0) {
         sendErrorCodeAndMessage(errorTLMnumber, NULL, NULL, NULL, NULL);
         // If I find an error, I will redirect the code to the cleaning part
         goto cleaning_part;
     }
-    end_matrices = clock();
     if (input->simulationInput.printAdditionalMode == 1) {
         printf("\nDone calculating the matrices\n");
     }
     if (input->simulationInput.timingMode == 1) {
-        double time_spent_matrices = (double) (end_matrices - begin_matrices) / CLOCKS_PER_SEC;
-        printf("Total time to calculate the matrices %g ms (or %g s, or %g min, or %g hours).\n\n",
-                time_spent_matrices * 1e3, time_spent_matrices, time_spent_matrices / 60.0, time_spent_matrices / (60 * 60));
+        printTimeProfiler(time_spent_matrices, "Total time to calculate the matrices");
     }
 
-    // Solve the problem
-    if (input->equationInput[id].solveDirectly == 1) {
-        if (input->simulationInput.printAdditionalMode == 1) {
-            printf("Solving this equation directly\n");
-        }
-        begin_solve = clock();
-        // in time domain
-        if (input->equationInput[id].Solv == DYNAMIC) {
-            errorTLMnumber = tlmSolveMatricesTimeDomainEigen(&calcs, input, id);
-        } else if (input->equationInput[id].Solv == STEADY) {
-            errorTLMnumber = tlmSolveMatricesSteadyStateEigen(&calcs, input, id);
-        }
-        if (errorTLMnumber != 0) {
-            sendErrorCodeAndMessage(errorTLMnumber, NULL, NULL, NULL, NULL);
-            // If I find an error, I will redirect the code to the cleaning part
-            goto cleaning_part;
-        }
-
-        end_solve = clock();
-
-        // this equation does not need to be solved anymore. It was solved
-        input->equationInput[id].needToSolve = 0;
-
-        if (input->simulationInput.printAdditionalMode == 1) {
-            printf("Done solving this equation directly\n");
-        }
-
-        if (input->simulationInput.timingMode == 1) {
-            double time_spent_solve = (double) (end_solve - begin_solve) / CLOCKS_PER_SEC;
-            printf("Total time to solve the matrices %g ms (or %g s, or %g min, or %g hours).\n",
-                    time_spent_solve * 1e3, time_spent_solve, time_spent_solve / 60.0, time_spent_solve / (60 * 60));
-        }
+    // solving the case and its scenarios
+    if ((errorTLMnumber = solveCasePennesEigen(input, &calcs, id)) != 0) {
+        // If I find an error, I will redirect the code to the cleaning part
+        goto cleaning_part;
     }
 
     // I deallocate the variables if I found an error during the processing, i.e.,
@@ -211,6 +249,9 @@ unsigned int calculateMatricesPennesEigen(struct dataForSimulation *input,
 
     unsigned int errorTLMnumber;
 
+    // each thread saves the entries of the elements in its own list
+    tlmInitiateElementTripletsEigen(matrices, input->simulationInput.nOpenMPcores);
+
     // calculating the matrices for material line elements
     if (input->simulationInput.verboseMode == 1) {
         printf("Quantity of material line nodes found: %llu\n", matrices->numbers.MaterialElements[1]);
@@ -222,18 +263,17 @@ unsigned int calculateMatricesPennesEigen(struct dataForSimulation *input,
         if (input->simulationInput.verboseMode == 1) {
             printf("Calculating the matrix for the line nodes...\n");
         }
-        clock_t begin_Line = clock();
+        beginPhaseProfiler("calculate the matrices for the line nodes");
         if ((errorTLMnumber = MaterialLinePennesEigen(input, matrices, id)) != 0) {
             sendErrorCodeAndMessage(errorTLMnumber, NULL, NULL, NULL, NULL);
+            endPhaseProfiler();
             return errorTLMnumber;
         }
-        clock_t end_Line = clock();
+        double time_spent_Line = endPhaseProfiler();
         if (input->simulationInput.verboseMode == 1) {
             printf("Done calculating the matrix for the line nodes.\n");
             if (input->simulationInput.timingMode == 1) {
-                double time_spent_Line = (double) (end_Line - begin_Line) / CLOCKS_PER_SEC;
-                printf("Time to calculate the matrices for the line nodes %g ms (or %g s, or %g min, or %g hours).\n",
-                        time_spent_Line * 1e3, time_spent_Line, time_spent_Line / 60.0, time_spent_Line / (60 * 60));
+                printTimeProfiler(time_spent_Line, "Time to calculate the matrices for the line nodes");
             }
         }
     }
@@ -251,18 +291,17 @@ unsigned int calculateMatricesPennesEigen(struct dataForSimulation *input,
         if (input->simulationInput.verboseMode == 1) {
             printf("Calculating the matrix for the triangle nodes...\n");
         }
-        clock_t begin_Triangle = clock();
+        beginPhaseProfiler("calculate the matrices for the triangle nodes");
         if ((errorTLMnumber = MaterialTrianglePennesEigen(input, matrices, id)) != 0) {
             sendErrorCodeAndMessage(errorTLMnumber, NULL, NULL, NULL, NULL);
+            endPhaseProfiler();
             return errorTLMnumber;
         }
-        clock_t end_Triangle = clock();
+        double time_spent_Triangle = endPhaseProfiler();
         if (input->simulationInput.verboseMode == 1) {
             printf("Done calculating the matrix for the triangle nodes.\n");
             if (input->simulationInput.timingMode == 1) {
-                double time_spent_Triangle = (double) (end_Triangle - begin_Triangle) / CLOCKS_PER_SEC;
-                printf("Time to calculate the matrices for the triangle nodes %g ms (or %g s, or %g min, or %g hours).\n",
-                        time_spent_Triangle * 1e3, time_spent_Triangle, time_spent_Triangle / 60.0, time_spent_Triangle / (60 * 60));
+                printTimeProfiler(time_spent_Triangle, "Time to calculate the matrices for the triangle nodes");
             }
         }
     }
@@ -278,18 +317,17 @@ unsigned int calculateMatricesPennesEigen(struct dataForSimulation *input,
         if (input->simulationInput.verboseMode == 1) {
             printf("Calculating the matrix for the quadrangle nodes...\n");
         }
-        clock_t begin_Quadrangle = clock();
+        beginPhaseProfiler("calculate the matrices for the quadrangle nodes");
         if ((errorTLMnumber = MaterialQuadranglePennesEigen(input, matrices, id)) != 0) {
             sendErrorCodeAndMessage(errorTLMnumber, NULL, NULL, NULL, NULL);
+            endPhaseProfiler();
             return errorTLMnumber;
         }
-        clock_t end_Quadrangle = clock();
+        double time_spent_Quadrangle = endPhaseProfiler();
         if (input->simulationInput.verboseMode == 1) {
             printf("Done calculating the matrix for the quadrangle nodes.\n");
             if (input->simulationInput.timingMode == 1) {
-                double time_spent_Quadrangle = (double) (end_Quadrangle - begin_Quadrangle) / CLOCKS_PER_SEC;
-                printf("Time to calculate the matrices for the quadrangle nodes %g ms (or %g s, or %g min, or %g hours).\n",
-                        time_spent_Quadrangle * 1e3, time_spent_Quadrangle, time_spent_Quadrangle / 60.0, time_spent_Quadrangle / (60 * 60));
+                printTimeProfiler(time_spent_Quadrangle, "Time to calculate the matrices for the quadrangle nodes");
             }
         }
     }
@@ -305,18 +343,17 @@ unsigned int calculateMatricesPennesEigen(struct dataForSimulation *input,
         if (input->simulationInput.verboseMode == 1) {
             printf("Calculating the matrix for the tetrahedron nodes...\n");
         }
-        clock_t begin_Tetrahedron = clock();
+        beginPhaseProfiler("calculate the matrices for the tetrahedral nodes");
         if ((errorTLMnumber = MaterialTetrahedronPennesEigen(input, matrices, id)) != 0) {
             sendErrorCodeAndMessage(errorTLMnumber, NULL, NULL, NULL, NULL);
+            endPhaseProfiler();
             return errorTLMnumber;
         }
-        clock_t end_Tetrahedron = clock();
+        double time_spent_Tetrahedron = endPhaseProfiler();
         if (input->simulationInput.verboseMode == 1) {
             printf("Done calculating the matrix for the tetrahedron nodes.\n");
             if (input->simulationInput.timingMode == 1) {
-                double time_spent_Tetrahedron = (double) (end_Tetrahedron - begin_Tetrahedron) / CLOCKS_PER_SEC;
-                printf("Time to calculate the matrices for the tetrahedral nodes %g ms (or %g s, or %g min, or %g hours).\n",
-                        time_spent_Tetrahedron * 1e3, time_spent_Tetrahedron, time_spent_Tetrahedron / 60.0, time_spent_Tetrahedron / (60 * 60));
+                printTimeProfiler(time_spent_Tetrahedron, "Time to calculate the matrices for the tetrahedral nodes");
             }
         }
     }
@@ -332,18 +369,17 @@ unsigned int calculateMatricesPennesEigen(struct dataForSimulation *input,
         if (input->simulationInput.verboseMode == 1) {
             printf("Calculating the matrix for the hexahedron nodes...\n");
         }
-        clock_t begin_Hexahedron = clock();
+        beginPhaseProfiler("calculate the matrices for the hexahedron nodes");
         if ((errorTLMnumber = MaterialHexahedronPennesEigen(input, matrices, id)) != 0) {
             sendErrorCodeAndMessage(errorTLMnumber, NULL, NULL, NULL, NULL);
+            endPhaseProfiler();
             return errorTLMnumber;
         }
-        clock_t end_Hexahedron = clock();
+        double time_spent_Hexahedron = endPhaseProfiler();
         if (input->simulationInput.verboseMode == 1) {
             printf("Done calculating the matrix for the hexahedron nodes.\n");
             if (input->simulationInput.timingMode == 1) {
-                double time_spent_Hexahedron = (double) (end_Hexahedron - begin_Hexahedron) / CLOCKS_PER_SEC;
-                printf("Time to calculate the matrices for the hexahedron nodes %g ms (or %g s, or %g min, or %g hours).\n",
-                        time_spent_Hexahedron * 1e3, time_spent_Hexahedron, time_spent_Hexahedron / 60.0, time_spent_Hexahedron / (60 * 60));
+                printTimeProfiler(time_spent_Hexahedron, "Time to calculate the matrices for the hexahedron nodes");
             }
         }
     }
@@ -359,19 +395,17 @@ unsigned int calculateMatricesPennesEigen(struct dataForSimulation *input,
         if (input->simulationInput.verboseMode == 1) {
             printf("Calculating the matrix for the prism nodes...\n");
         }
-        clock_t begin_Prism = clock();
+        beginPhaseProfiler("calculate the matrices for the prism nodes");
         printf("\n\nPrism node was not implemented yet\n\n");
         //        if ((errorTLMnumber = MaterialPrismPennesEigen(input, matrices, id)) != 0) {
         //            sendErrorCodeAndMessage(errorTLMnumber, NULL, NULL, NULL, NULL);
         //            return errorTLMnumber;
         //        }
-        clock_t end_Prism = clock();
+        double time_spent_Prism = endPhaseProfiler();
         if (input->simulationInput.verboseMode == 1) {
             printf("Done calculating the matrix for the prism nodes.\n");
             if (input->simulationInput.timingMode == 1) {
-                double time_spent_Prism = (double) (end_Prism - begin_Prism) / CLOCKS_PER_SEC;
-                printf("Time to calculate the matrices for the prism nodes %g ms (or %g s, or %g min, or %g hours).\n",
-                        time_spent_Prism * 1e3, time_spent_Prism, time_spent_Prism / 60.0, time_spent_Prism / (60 * 60));
+                printTimeProfiler(time_spent_Prism, "Time to calculate the matrices for the prism nodes");
             }
         }
     }
@@ -388,60 +422,180 @@ unsigned int calculateMatricesPennesEigen(struct dataForSimulation *input,
         if (input->simulationInput.verboseMode == 1) {
             printf("Calculating the matrix for the pyramid nodes...\n");
         }
-        clock_t begin_Pyramid = clock();
+        beginPhaseProfiler("calculate the matrices for the pyramid nodes");
         if ((errorTLMnumber = MaterialPyramidPennesEigen(input, matrices, id)) != 0) {
             sendErrorCodeAndMessage(errorTLMnumber, NULL, NULL, NULL, NULL);
+            endPhaseProfiler();
             return errorTLMnumber;
         }
-        clock_t end_Pyramid = clock();
+        double time_spent_Pyramid = endPhaseProfiler();
         if (input->simulationInput.verboseMode == 1) {
             printf("Done calculating the matrix for the pyramid nodes.\n");
             if (input->simulationInput.timingMode == 1) {
-                double time_spent_Pyramid = (double) (end_Pyramid - begin_Pyramid) / CLOCKS_PER_SEC;
-                printf("Time to calculate the matrices for the pyramid nodes %g ms (or %g s, or %g min, or %g hours).\n",
-                        time_spent_Pyramid * 1e3, time_spent_Pyramid, time_spent_Pyramid / 60.0, time_spent_Pyramid / (60 * 60));
+                printTimeProfiler(time_spent_Pyramid, "Time to calculate the matrices for the pyramid nodes");
             }
         }
     }
 
+    // joining the lists of the threads in M and tau
+    beginPhaseProfiler("assemble the matrices of the nodes");
+    if ((errorTLMnumber = tlmAssembleElementsEigen(matrices)) != 0) {
+        sendErrorCodeAndMessage(errorTLMnumber, NULL, NULL, NULL, NULL);
+        endPhaseProfiler();
+        return errorTLMnumber;
+    }
+    double time_spent_Assemble = endPhaseProfiler();
+    if (input->simulationInput.verboseMode == 1 && input->simulationInput.timingMode == 1) {
+        printTimeProfiler(time_spent_Assemble, "Time to assemble the matrices of the nodes");
+    }
+
+    // the matrix-free engine keeps the scattering coefficients of M before
+    // the connections are included
+    if (input->equationInput[id].Solv == DYNAMIC && input->equationInput[id].Engine == MATRIX_FREE) {
+        if (input->simulationInput.verboseMode == 1) {
+            printf("Preparing the matrix-free engine...\n");
+        }
+        if ((errorTLMnumber = tlmInitiateMatrixFreeEigen(matrices)) != 0) {
+            sendErrorCodeAndMessage(errorTLMnumber, NULL, NULL, NULL, NULL);
+            return errorTLMnumber;
+        }
+        if (input->simulationInput.verboseMode == 1) {
+            printf("Done preparing the matrix-free engine with %llu nodes.\n",
+                    matrices->matrixFree.quantityOfNodes);
+        }
+    }
+
+    // the node system gets G and Is of each node before the connections are
+    // included, and the connections are included in it instead of in M
+    if (input->equationInput[id].Solv == STEADY && input->equationInput[id].SteadySolver == NODE_CG) {
+        if (input->simulationInput.verboseMode == 1) {
+            printf("Preparing the node system...\n");
+        }
+        if ((errorTLMnumber = tlmInitiateNodeSystemEigen(matrices)) != 0) {
+            sendErrorCodeAndMessage(errorTLMnumber, NULL, NULL, NULL, NULL);
+            return errorTLMnumber;
+        }
+        if (input->simulationInput.verboseMode == 1) {
+            printf("Done preparing the node system with %llu nodes.\n",
+                    matrices->matrixFree.quantityOfNodes);
+        }
+    }
+
+    // the block-Jacobi preconditioner inverts the block of each node, so I find
+    // the nodes before the connections are included
+    if (input->equationInput[id].Solv == STEADY && input->equationInput[id].SteadySolver != DIRECT_LU &&
+            input->equationInput[id].SteadySolver != NODE_CG && input->equationInput[id].Precond == BLOCK_JACOBI) {
+        if ((errorTLMnumber = tlmFindNodesEigen(matrices)) != 0) {
+            sendErrorCodeAndMessage(errorTLMnumber, NULL, NULL, NULL, NULL);
+            return errorTLMnumber;
+        }
+        if (input->simulationInput.verboseMode == 1) {
+            printf("Found %llu nodes for the block-Jacobi preconditioner.\n",
+                    matrices->matrixFree.quantityOfNodes);
+        }
+    }
+
+    // the renumbering moves the ports of each node together, so I find the
+    // nodes before the connections are included, if they were not found yet
+    if (input->equationInput[id].Renumber != NO_RENUMBERING && matrices->matrixFree.nodeFirstPort == NULL) {
+        if ((errorTLMnumber = tlmFindNodesEigen(matrices)) != 0) {
+            sendErrorCodeAndMessage(errorTLMnumber, NULL, NULL, NULL, NULL);
+            return errorTLMnumber;
+        }
+    }
 
     // finalizing the matrices with the connection variables
     if (input->simulationInput.verboseMode == 1) {
         printf("Including connections and boundaries...\n");
     }
-    clock_t begin_CB = clock();
+    beginPhaseProfiler("include connections and boundaries");
     if ((errorTLMnumber = connectionsAndBoundariesPennesEigen(matrices, *boundaries,
             intersections, input, id)) != 0) {
         sendErrorCodeAndMessage(errorTLMnumber, NULL, NULL, NULL, NULL);
+        endPhaseProfiler();
         return errorTLMnumber;
     }
-    clock_t end_CB = clock();
+    double time_spent_CB = endPhaseProfiler();
     if (input->simulationInput.verboseMode == 1) {
         printf("Done including connections and boundaries.\n");
         if (input->simulationInput.timingMode == 1) {
-            double time_spent_CB = (double) (end_CB - begin_CB) / CLOCKS_PER_SEC;
-            printf("Time to include connections and boundaries %g ms (or %g s, or %g min, or %g hours).\n",
-                    time_spent_CB * 1e3, time_spent_CB, time_spent_CB / 60.0, time_spent_CB / (60 * 60));
+            printTimeProfiler(time_spent_CB, "Time to include connections and boundaries");
+        }
+    }
+
+
+    // ordering the nodes so that the connected ones are close in Vi
+    if (input->equationInput[id].Renumber != NO_RENUMBERING) {
+        if (input->simulationInput.verboseMode == 1) {
+            printf("Renumbering the nodes...\n");
+        }
+        beginPhaseProfiler("renumber the nodes");
+        if ((errorTLMnumber = tlmRenumberNodesEigen(matrices, input->equationInput[id].Renumber,
+                input->simulationInput.nOpenMPcores, input->simulationInput.verboseMode)) != 0) {
+            sendErrorCodeAndMessage(errorTLMnumber, NULL, NULL, NULL, NULL);
+            endPhaseProfiler();
+            return errorTLMnumber;
+        }
+        double time_spent_rn = endPhaseProfiler();
+        if (input->simulationInput.verboseMode == 1) {
+            printf("Done renumbering the nodes.\n");
+            if (input->simulationInput.timingMode == 1) {
+                printTimeProfiler(time_spent_rn, "Time to renumber the nodes");
+            }
         }
     }
 
 
+    // the statistics take the lines of the nodes of their tags before the
+    // outputs are selected
+    if (input->equationInput[id].numberOfStatisticsTags > 0) {
+        if ((errorTLMnumber = tlmInitiateStatisticsEigen(matrices, input, id)) != 0) {
+            sendErrorCodeAndMessage(errorTLMnumber, NULL, NULL, NULL, NULL);
+            return errorTLMnumber;
+        }
+        if (input->simulationInput.verboseMode == 1) {
+            printf("Calculating the statistics of %llu nodes.\n",
+                    (unsigned long long) matrices->statistics.scalar.size());
+        }
+    }
+
+    // keeping only the outputs that are saved: the probes and tags, if there
+    // are any, and not the scalar calculated only for the statistics
+    if (input->equationInput[id].numberOfOutputProbes > 0 || input->equationInput[id].numberOfOutputTags > 0 ||
+            input->equationInput[id].saveScalarForStatistics == 1) {
+        if (input->simulationInput.verboseMode == 1) {
+            printf("Selecting the outputs...\n");
+        }
+        beginPhaseProfiler("select the outputs");
+        if ((errorTLMnumber = tlmSelectOutputsEigen(matrices, input, id)) != 0) {
+            sendErrorCodeAndMessage(errorTLMnumber, NULL, NULL, NULL, NULL);
+            endPhaseProfiler();
+            return errorTLMnumber;
+        }
+        double time_spent_so = endPhaseProfiler();
+        if (input->simulationInput.verboseMode == 1) {
+            printf("Done selecting %llu outputs.\n", matrices->numbers.Output);
+            if (input->simulationInput.timingMode == 1) {
+                printTimeProfiler(time_spent_so, "Time to select the outputs");
+            }
+        }
+    }
+
     // writing data to the output file
     if (input->simulationInput.verboseMode == 1) {
         printf("Writing data to the output file...\n");
     }
-    clock_t begin_wr = clock();
+    beginPhaseProfiler("write data to file");
     if ((errorTLMnumber = writeFirstDataToFile(input, matrices, id)) != 0) {
         sendErrorCodeAndMessage(errorTLMnumber, NULL, NULL, NULL, NULL);
+        endPhaseProfiler();
         return errorTLMnumber;
     }
-    clock_t end_wr = clock();
+    double time_spent_wr = endPhaseProfiler();
     if (input->simulationInput.verboseMode == 1) {
         printf("Done writing data to the output file...\n");
         if (input->simulationInput.timingMode == 1) {
-            double time_spent_wr = (double) (end_wr - begin_wr) / CLOCKS_PER_SEC;
-            printf("Time to write data to file %g ms (or %g s, or %g min, or %g hours).\n",
-                    time_spent_wr * 1e3, time_spent_wr, time_spent_wr / 60.0, time_spent_wr / (60 * 60));
+            printTimeProfiler(time_spent_wr, "Time to write data to file");
         }
     }
 
@@ -450,17 +604,17 @@ unsigned int calculateMatricesPennesEigen(struct dataForSimulation *input,
         if (input->simulationInput.verboseMode == 1) {
             printf("Initiating the steady-state matrices...\n");
         }
-        clock_t begin_ss = clock();
-        if ((errorTLMnumber = tlmInitializeSteadyMatrices(matrices)) == 0) {
+        beginPhaseProfiler("calculate the steady-state matrices");
+        if ((errorTLMnumber = tlmInitializeSteadyMatrices(matrices, &(input->equationInput[id]))) != 0) {
+            sendErrorCodeAndMessage(errorTLMnumber, NULL, NULL, NULL, NULL);
+            endPhaseProfiler();
             return errorTLMnumber;
         }
-        clock_t end_ss = clock();
+        double time_spent_SteadyState = endPhaseProfiler();
         if (input->simulationInput.verboseMode == 1) {
             printf("Done initiating the steady-state matrices.\n");
             if (input->simulationInput.timingMode == 1) {
-                double time_spent_SteadyState = (double) (end_ss - begin_ss) / CLOCKS_PER_SEC;
-                printf("Time to calculate the steady-state matrices %g ms (or %g s, or %g min, or %g hours).\n",
-                        time_spent_SteadyState * 1e3, time_spent_SteadyState, time_spent_SteadyState / 60.0, time_spent_SteadyState / (60 * 60));
+                printTimeProfiler(time_spent_SteadyState, "Time to calculate the steady-state matrices");
             }
         }
     }
@@ -468,24 +622,355 @@ unsigned int calculateMatricesPennesEigen(struct dataForSimulation *input,
     if (input->simulationInput.verboseMode == 1) {
         printf("Terminating some variables...\n");
     }
-    clock_t begin_tr = clock();
+    beginPhaseProfiler("terminate some variables");
     if ((errorTLMnumber = terminateSomeVariablesEigen(input, matrices, boundaries, intersections, id)) != 0) {
         sendErrorCodeAndMessage(errorTLMnumber, NULL, NULL, NULL, NULL);
+        endPhaseProfiler();
         return errorTLMnumber;
     }
-    clock_t end_tr = clock();
+    double time_spent_tr = endPhaseProfiler();
     if (input->simulationInput.verboseMode == 1) {
         printf("Done terminating some variables...\n");
         if (input->simulationInput.timingMode == 1) {
-            double time_spent_tr = (double) (end_tr - begin_tr) / CLOCKS_PER_SEC;
-            printf("Time to terminate some variables %g ms (or %g s, or %g min, or %g hours).\n",
-                    time_spent_tr * 1e3, time_spent_tr, time_spent_tr / 60.0, time_spent_tr / (60 * 60));
+            printTimeProfiler(time_spent_tr, "Time to terminate some variables");
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * setChangedPennesEigen: saves the old value of field in changed, so that it
+ * can be restored, and sets its new value
+ */
+static void setChangedPennesEigen(std::vector< std::pair<double*, double> > &changed,
+        double *field, double value) {
+
+    changed.push_back(std::make_pair(field, *field));
+    *field = value;
+}
+
+/*
+ * changeScenarioPennesEigen: change the parameters of the materials and
+ * boundaries of the equation id as in the scenario (or the point of a sweep)
+ * among the quantity changes. The old values are saved in changed so that
+ * they can be restored. The generalized parameters of a material that depend
+ * on the changed one are calculated again as in the generalize functions of
+ * libmatconfig.c
+ */
+static unsigned int changeScenarioPennesEigen(struct dataForSimulation *input, int id,
+        const struct scenarioChange *changes, int quantity, int scenario,
+        std::vector< std::pair<double*, double> > &changed) {
+
+    struct Equation *equation = &(input->equationInput[id]);
+    const int pennes = equation->typeS == PENNES || equation->typeS == HYPERBOLIC_PENNES;
+    const int diffusion = equation->typeS == DIFFUSION || equation->typeS == HYPERBOLIC_DIFFUSION;
+    int i, j, k, number, found;
+
+    for (i = 0; i < quantity; i++) {
+        const struct scenarioChange *change = &(changes[i]);
+        if (change->scenario != scenario)
+            continue;
+
+        // the material or boundary of the equation with this number
+        found = 0;
+        if (change->boundary == 0) {
+            for (j = 0; j < equation->numberOfMaterials && found == 0; j++) {
+                number = equation->materialNumbers[j];
+                for (k = 0; k < input->materialInput[number].quantityOfNumberInput; k++)
+                    found |= (unsigned long) input->materialInput[number].numberInput[k] == change->tag;
+            }
+        } else {
+            for (j = 0; j < equation->numberOfBoundaries && found == 0; j++) {
+                number = equation->boundaryNumbers[j];
+                for (k = 0; k < input->boundaryInput[number].quantityOfNumberInput; k++)
+                    found |= (unsigned long) input->boundaryInput[number].numberInput[k] == change->tag;
+            }
+        }
+        if (found == 0)
+            return 8759;
+
+        struct MaterialConfig *material = &(input->materialInput[number]);
+        struct BoundaryConfig *boundary = &(input->boundaryInput[number]);
+        switch (change->parameter) {
+            case SCENARIO_SOURCE:
+            case SCENARIO_INTERNAL_HEAT_GENERATION:
+            case SCENARIO_BLOOD_PERFUSION:
+                if (material->generalized_sourceType == 2 || (pennes == 0 &&
+                        change->parameter != SCENARIO_SOURCE))
+                    return 8759;
+                if (change->parameter == SCENARIO_SOURCE) {
+                    setChangedPennesEigen(changed, &(material->source), change->value);
+                } else if (change->parameter == SCENARIO_INTERNAL_HEAT_GENERATION) {
+                    setChangedPennesEigen(changed, &(material->internalHeatGeneration), change->value);
+                } else {
+                    if (material->generalized_sink_aType == 2)
+                        return 8759;
+                    setChangedPennesEigen(changed, &(material->bloodPerfusion), change->value);
+                    setChangedPennesEigen(changed, &(material->generalized_sink_a), material->bloodPerfusion *
+                            material->bloodDensity * material->bloodSpecificHeat);
+                }
+                if (pennes == 1) {
+                    setChangedPennesEigen(changed, &(material->generalized_source), material->source +
+                            material->internalHeatGeneration + material->bloodPerfusion *
+                            material->bloodDensity * material->bloodSpecificHeat * material->bloodTemperature);
+                } else {
+                    setChangedPennesEigen(changed, &(material->generalized_source), material->source);
+                }
+                break;
+            case SCENARIO_INITIAL_SCALAR:
+                if (material->generalized_initialScalarType == 2)
+                    return 8759;
+                setChangedPennesEigen(changed, &(material->generalized_initialScalar), change->value);
+                break;
+            case SCENARIO_DIFFUSION_COEFFICIENT:
+                if (material->generalized_diffusionCoeffType == 2)
+                    return 8759;
+                setChangedPennesEigen(changed, &(material->generalized_diffusionCoeff), change->value);
+                break;
+            case SCENARIO_DENSITY:
+            case SCENARIO_SPECIFIC_HEAT:
+                if (material->generalized_coefficient_bType == 2 || diffusion == 1)
+                    return 8759;
+                setChangedPennesEigen(changed, change->parameter == SCENARIO_DENSITY ?
+                        &(material->matDensity) : &(material->matSpecificHeat), change->value);
+                setChangedPennesEigen(changed, &(material->generalized_coefficient_b),
+                        material->matDensity * material->matSpecificHeat);
+                // the steady-state needs a coefficient b for the impedances
+                if (equation->Solv == STEADY && material->generalized_coefficient_b == 0)
+                    material->generalized_coefficient_b = 1;
+                break;
+            case SCENARIO_SCALAR:
+                if (boundary->generalized_scalarDefined == 0)
+                    return 8759;
+                setChangedPennesEigen(changed, &(boundary->generalized_scalar), change->value);
+                break;
+            case SCENARIO_FLUX:
+                if (boundary->generalized_fluxDefined == 0)
+                    return 8759;
+                setChangedPennesEigen(changed, &(boundary->generalized_flux), change->value);
+                break;
+            case SCENARIO_CONVECTION_SCALAR:
+                if (boundary->generalized_convectionDefined == 0)
+                    return 8759;
+                setChangedPennesEigen(changed, &(boundary->generalized_convectionScalar), change->value);
+                break;
+            case SCENARIO_CONVECTION_COEFFICIENT:
+            default:
+                if (boundary->generalized_convectionDefined == 0)
+                    return 8759;
+                setChangedPennesEigen(changed, &(boundary->generalized_convectionCoefficient), change->value);
+                break;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * sameMatrixEigen: returns 1 if A and B are equal up to the round-off
+ */
+template<typename MatrixType>
+static int sameMatrixEigen(const MatrixType &A, const MatrixType &B) {
+
+    if (A.rows() != B.rows() || A.cols() != B.cols() || A.nonZeros() != B.nonZeros())
+        return 0;
+    return (A - B).norm() <= 1e-12 * A.norm();
+}
+
+/*
+ * calculateScenariosPennesEigen: calculate E, the initial Vi, and E_output of
+ * the scenarios after the first one (the case, already in matrices). Each
+ * scenario is calculated as the case, with its parameters changed, and it
+ * writes the beginning of its output file. Its M and tau must be the ones of
+ * the case. Then, the scenarios are placed side by side in E and Vi and as
+ * columns in E_output
+ */
+unsigned int calculateScenariosPennesEigen(struct dataForSimulation *input,
+        struct calculationTLMEigen *matrices, int id) {
+
+    const int scenarios = input->equationInput[id].numberOfScenarios;
+    const long long ports = matrices->E.size(), outputs = matrices->E_output.size();
+    VectorXd E(ports * scenarios), Vi(ports * scenarios), E_output(outputs * scenarios);
+    FILE *outputFile = input->simulationInput.outputFileHandler;
+    unsigned int errorTLMnumber = 0;
+    long long p;
+    int s;
+
+    // the first scenario is the case
+    matrices->scenarios.files.assign(scenarios, NULL);
+    matrices->scenarios.files[0] = outputFile;
+    for (p = 0; p < ports; p++) {
+        E[p * scenarios] = matrices->E[p];
+        Vi[p * scenarios] = matrices->Vi[p];
+    }
+    E_output.head(outputs) = matrices->E_output;
+
+    for (s = 1; s < scenarios && errorTLMnumber == 0; s++) {
+        struct calculationTLMEigen calcs;
+        struct boundaryData *boundaries;
+        struct connectionLeveln intersections;
+        std::vector< std::pair<double*, double> > changed;
+
+        if (input->simulationInput.verboseMode == 1) {
+            printf("Calculating the scenario %d...\n", s + 1);
+        }
+
+        if ((errorTLMnumber = creatScenarioOutputFile(input, id, "scenario", s + 1,
+                &(matrices->scenarios.files[s]))) != 0)
+            return errorTLMnumber;
+
+        if ((errorTLMnumber = changeScenarioPennesEigen(input, id, input->equationInput[id].scenarioChanges,
+                input->equationInput[id].numberOfScenarioChanges, s + 1, changed)) == 0) {
+            // the beginning of the output is written in the file of the scenario
+            if ((errorTLMnumber = initiateVariablesTLMPennes(input, &calcs,
+                    &(calcs.numbers), &boundaries, &intersections, id)) == 0) {
+                input->simulationInput.outputFileHandler = matrices->scenarios.files[s];
+                errorTLMnumber = calculateMatricesPennesEigen(input, &calcs, &boundaries, &intersections, id);
+                input->simulationInput.outputFileHandler = outputFile;
+            }
+
+            if (errorTLMnumber == 0 && (calcs.E.size() != ports || calcs.E_output.size() != outputs ||
+                    !sameMatrixEigen(calcs.M, matrices->M) || !sameMatrixEigen(calcs.tau, matrices->tau) ||
+                    !sameMatrixEigen(calcs.tauRow, matrices->tauRow)))
+                errorTLMnumber = 8760;
+
+            if (errorTLMnumber == 0) {
+                for (p = 0; p < ports; p++) {
+                    E[p * scenarios + s] = calcs.E[p];
+                    Vi[p * scenarios + s] = calcs.Vi[p];
+                }
+                E_output.segment(s * outputs, outputs) = calcs.E_output;
+            }
+
+            terminateVariablesTLMEigen(input, &calcs, &boundaries, &intersections, 0,
+                    errorTLMnumber, id);
         }
+
+        // the case is restored for the next scenarios
+        for (size_t i = changed.size(); i > 0; i--)
+            *(changed[i - 1].first) = changed[i - 1].second;
     }
+    if (errorTLMnumber != 0)
+        return errorTLMnumber;
+
+    matrices->E.swap(E);
+    matrices->Vi.swap(Vi);
+    matrices->E_output.swap(E_output);
+    matrices->output.resize(outputs * scenarios);
+    matrices->scenarios.quantity = scenarios;
 
     return 0;
 }
 
+/*
+ * solverSweepPennesEigen: solve the case of the equation id for each point of
+ * its sweep. The numbers, the tags, and the connections of the ports do not
+ * depend on the parameters, so they are calculated for the first point and
+ * kept for the others. For each point, only the boundaries and the matrices
+ * are calculated again. The point 1 is saved in the output file and the others
+ * in their own files; their statistics and scenarios are named after them
+ */
+unsigned int solverSweepPennesEigen(struct dataForSimulation *input, int id) {
+
+    struct Equation *equation = &(input->equationInput[id]);
+    const int points = equation->numberOfSweepPoints;
+    struct calculationTLMEigen calcs;
+    struct boundaryData *boundaries = NULL;
+    struct connectionLeveln intersections;
+    char *nameOfOutputFile = input->simulationInput.nameOfOutputFile;
+    std::vector<char> nameOfPoint(strlen(nameOfOutputFile) + 32);
+    FILE *outputFile = NULL, *pointFile = NULL;
+    unsigned long long outputs = 0, pointsOutput = 0;
+    unsigned int errorTLMnumber = 0;
+    int point, initiated = 0;
+
+    beginPhaseProfiler("calculate and solve the points of the sweep");
+    for (point = 1; point <= points && errorTLMnumber == 0; point++) {
+        std::vector< std::pair<double*, double> > changed;
+
+        if (input->simulationInput.printAdditionalMode == 1) {
+            printf("Calculating the point %d of the sweep...\n", point);
+        }
+        beginPhaseProfiler("calculate and solve a point of the sweep");
+
+        if ((errorTLMnumber = changeScenarioPennesEigen(input, id, equation->sweepChanges,
+                equation->numberOfSweepChanges, point, changed)) != 0) {
+            sendErrorCodeAndMessage(errorTLMnumber, NULL, NULL, NULL, NULL);
+            endPhaseProfiler();
+            break;
+        }
+
+        if (point == 1) {
+            // the output file is created with the numbers and the connections
+            initiated = 1;
+            if ((errorTLMnumber = initiateVariablesTLMPennes(input, &calcs,
+                    &(calcs.numbers), &boundaries, &intersections, id)) != 0) {
+                sendErrorCodeAndMessage(errorTLMnumber, NULL, NULL, NULL, NULL);
+            }
+            outputFile = input->simulationInput.outputFileHandler;
+            outputs = calcs.numbers.Output;
+            pointsOutput = calcs.numbers.Points_Output;
+        } else {
+            // the outputs were selected in the previous point
+            calcs.numbers.Output = outputs;
+            calcs.numbers.Points_Output = pointsOutput;
+            if ((errorTLMnumber = initiateBoundaryTypeAndDataPennes(&boundaries, input, id)) == 0 &&
+                    (errorTLMnumber = initiate_matrices_calculationTLMEigen(&calcs)) == 0 &&
+                    (errorTLMnumber = creatScenarioOutputFile(input, id, "sweep", point, &pointFile)) == 0) {
+                sprintf(nameOfPoint.data(), "%s_sweep_%d", nameOfOutputFile, point);
+                input->simulationInput.nameOfOutputFile = nameOfPoint.data();
+                input->simulationInput.outputFileHandler = pointFile;
+            } else {
+                sendErrorCodeAndMessage(errorTLMnumber, NULL, NULL, NULL, NULL);
+            }
+        }
+
+        // the last point releases the numbers and the connections
+        calcs.keepTopology = point < points;
+        if (errorTLMnumber == 0 && (errorTLMnumber = calculateMatricesPennesEigen(input,
+                &calcs, &boundaries, &intersections, id)) != 0) {
+            sendErrorCodeAndMessage(errorTLMnumber, NULL, NULL, NULL, NULL);
+        }
+        if (errorTLMnumber == 0) {
+            errorTLMnumber = solveCasePennesEigen(input, &calcs, id);
+        }
+
+        input->simulationInput.nameOfOutputFile = nameOfOutputFile;
+        input->simulationInput.outputFileHandler = outputFile;
+        if (pointFile != NULL)
+            fclose(pointFile);
+        pointFile = NULL;
+
+        if (errorTLMnumber == 0 && point < points) {
+            terminate_matrices_calculationTLMEigen(&calcs);
+        }
+
+        // the case is restored for the next points
+        for (size_t i = changed.size(); i > 0; i--)
+            *(changed[i - 1].first) = changed[i - 1].second;
+
+        double time_spent_point = endPhaseProfiler();
+        if (input->simulationInput.timingMode == 1) {
+            printTimeProfiler(time_spent_point, "Time to calculate and solve the point %d of the sweep", point);
+        }
+    }
+    double time_spent_sweep = endPhaseProfiler();
+
+    if (input->simulationInput.timingMode == 1) {
+        printTimeProfiler(time_spent_sweep, "Total time to calculate and solve the %d points of the sweep", points);
+    }
+
+    // everything is released, including the numbers and the connections if
+    // the sweep stopped before its last point
+    if (initiated == 1) {
+        calcs.keepTopology = 0;
+        terminateVariablesTLMEigen(input, &calcs, &boundaries, &intersections, 0, errorTLMnumber, id);
+    }
+
+    return errorTLMnumber;
+}
+
 /*
  * MaterialLineEigen: 
  * Line as a material was not implemented yet.
@@ -513,231 +998,228 @@ unsigned int MaterialLinePennesEigen(struct dataForSimulation *input, struct cal
     // 3D: maybe materials (?); maybe boundary conditions (?)
     //
     // element code 1: 2 nodes line.
-    double *tempVar = NULL;
-    tempVar = (double *) realloc(tempVar, sizeof (double)*4);
+    double tempVar[4];
     // 0 - length of port 1 and 2. They are equal to (nodes_length)/2.
     // 1 - Lines' center x
     // 2 - Lines' center y
     // 3 - Lines' center z
 
+    // the elements are independent. Each thread saves the entries of M and tau
+    // in its own list, and the lists become M and tau in tlmAssembleElementsEigen
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(static) num_threads(input->simulationInput.nOpenMPcores) \
+        private(numbersNodeAndPort, j2, Cd, Z, Cs, Zs, R, G, Is, Zhat, tau, taus, ros, tempVar)
+#endif
     for (unsigned long long i = 0; i < input->mesh.quantityOfSpecificElement[1]; i++) {
+        std::vector< Triplet<double, long long> > &tripletsM = matrices->tripletsM[tlmThreadEigen()];
+        std::vector< Triplet<double, long long> > &tripletsTau = matrices->tripletsTau[tlmThreadEigen()];
+
         // i: element level
-        // j: boundary type level
-        // k: different tag numbers for the same boundary type
-        for (unsigned int j = 0; j < input->equationInput[id].numberOfMaterials; j++)
-            for (unsigned int k = 0; k < input->materialInput[ input->equationInput[id].materialNumbers[j] ].quantityOfNumberInput; k++)
-                if (input->mesh.elements.Line[i].tag == input->materialInput[ input->equationInput[id].materialNumbers[j] ].numberInput[k]) {
-                    j2 = input->equationInput[id].materialNumbers[j];
-                    // I will use goto to get out of these two inner 'for' loops. Bare in mind
-                    // that I'm just getting out the loops. You can also think that 
-                    // I'm going to the next 'i', that is, incrementing i by 1 and going
-                    // to the next value of i (if any).
-
-
-                    getRealNodeAndPort_fromAbstractNode(1, // element code
-                            i, // element number
-                            matrices->numbers.abstractPortsToReal,
-                            numbersNodeAndPort);
-
-                    // the -1 is necessary because the C indexing starts at zero
-                    // and my number of node starts at 1
-                    getGeometricalVariablesTLMline(&input->mesh.nodes[input->mesh.elements.Line[i].N1 - 1],
-                            &input->mesh.nodes[input->mesh.elements.Line[i].N2 - 1], tempVar);
-
-                    matrices->L[numbersNodeAndPort[1] + 0] = 1; // this length is defined as 1 for 1D nodes
-                    matrices->L[numbersNodeAndPort[1] + 1] = 1; // this length is defined as 1 for 1D nodes
-
-                    matrices->deltal[numbersNodeAndPort[1] + 0] = tempVar[0]; // length of port 1
-                    matrices->deltal[numbersNodeAndPort[1] + 1] = tempVar[0]; // length of port 2
-
-                    // generalization of R
-                    R[0] = tempVar[0] / input->materialInput[j2].generalized_diffusionCoeff;
-
-                    // generalization of G
-                    G = 2 * tempVar[0] * input->materialInput[j2].generalized_sink_a;
-
-                    // generalization of Is
-                    Is = 2 * tempVar[0] * input->materialInput[j2].generalized_source;
-
-                    // all the resistances
-                    matrices->R[numbersNodeAndPort[1] + 0] = R[0];
-                    matrices->R[numbersNodeAndPort[1] + 1] = R[0];
-
-
-                    // here I switch the code accordingly to what type of node I have
-                    // 
-                    // this is the simplest of all. Also called parabolic equation.
-                    // Used for 'diffusion', 'heat', and 'pennes'
-                    if (input->materialInput[j2].generalized_relaxationTime == 0) {
-                        // this has two nodes that connect with others elements
-
-                        // generalization of Cd
-                        Cd = input->materialInput[j2].generalized_coefficient_b;
-
-                        // Z = dt/(2*Cd*deltal). Manually validated
-                        Z[0] = input->equationInput[id].timeStep / (tempVar[0] * 2 * Cd);
-
-                        // all the impedances
-                        matrices->Z[numbersNodeAndPort[2] + 0] = Z[0];
-                        matrices->Z[numbersNodeAndPort[2] + 1] = Z[0];
-
-                        // Manually validated
-                        Zhat = Z[0] / (2 + Z[0] * G);
-
-                        // Manually validated
-                        tau[0] = 2 * Zhat / Z[0];
-                        // this is actually matrix S.
-                        // M = C*S
-                        // this matrix is M[line][column].
-                        matrices->M.insert(numbersNodeAndPort[2] + 0,
-                                numbersNodeAndPort[2] + 0) = tau[0] - 1;
-                        matrices->M.insert(numbersNodeAndPort[2] + 0,
-                                numbersNodeAndPort[2] + 1) = tau[0];
-
-                        matrices->M.insert(numbersNodeAndPort[2] + 1,
-                                numbersNodeAndPort[2] + 0) = tau[0];
-                        matrices->M.insert(numbersNodeAndPort[2] + 1,
-                                numbersNodeAndPort[2] + 1) = tau[0] - 1;
-
-                        // matrix tau
-                        matrices->tau.insert(numbersNodeAndPort[0],
-                                numbersNodeAndPort[2] + 0) = tau[0];
-                        matrices->tau.insert(numbersNodeAndPort[0],
-                                numbersNodeAndPort[2] + 1) = tau[0];
-
-                        // this is actually matrix ZIS.
-                        // E = C*ZIS + B
-                        matrices->E(numbersNodeAndPort[2] + 0) = Zhat*Is;
-                        matrices->E(numbersNodeAndPort[2] + 1) = Zhat*Is;
-
-                        // initial value
-                        // Vi0 = (Ti - ZIS)/sum(tau)
-                        matrices->Vi(numbersNodeAndPort[2] + 0) = (input->materialInput[j2].generalized_initialScalar
-                                - matrices->E(numbersNodeAndPort[2] + 0)) / (2 * tau[0]);
-                        matrices->Vi(numbersNodeAndPort[2] + 1) = matrices->Vi(numbersNodeAndPort[2] + 0);
-
-
-                        // this is for the wave models. Also called hyperbolic equation.
-                        // Used for 'hyperbolic diffusion', 'hyperbolic heat', and 
-                        // 'hyperbolic pennes'
-                    } else {
-                        // this has three nodes. Two nodes connect with others elements
-                        // and one extra node is used to model the relaxation time
-
-                        // generalization of Cd
-                        //                        Cd = input->materialInput[j2].generalized_diffusionCoeff *
-                        //                                input->equationInput[id].timeStep * input->equationInput[id].timeStep /
-                        //                                (4 * tempVar[0] * tempVar[0] * input->materialInput[j2].generalized_relaxationTime);
-
-                        // generalization of Cs
-                        //                        Cs = (input->materialInput[j2].generalized_coefficient_b - Cd)* 2 * tempVar[0];
-
-                        // Z = dt/(2*Cd*deltal). Manually validated
-                        //                        Z[0] = input->equationInput[id].timeStep / (tempVar[0] * 2 * Cd);
-
-                        // trying new approach
-                        double Ld;
-                        Ld = input->materialInput[j2].generalized_diffusionCoeff / input->materialInput[j2].generalized_relaxationTime;
-                        Cd = input->materialInput[j2].generalized_coefficient_b;
-                        Cs = input->materialInput[j2].generalized_coefficient_b * (1 - 2 * tempVar[0]);
-                        Z[0] = sqrt(Ld / Cd);
-
-                        // Zs = dt/(2*Cs)
-                        if (Cs > 0) {
-                            Zs = input->equationInput[id].timeStep / (2 * Cs);
-                        } else if (Cs < 0) {
-                            Zs = -input->equationInput[id].timeStep / (2 * Cs);
-                        } else {
-                            Zs = INFINITY;
-                        }
-
-
-                        // all the impedances
-                        matrices->Z[numbersNodeAndPort[2] + 0] = Z[0];
-                        matrices->Z[numbersNodeAndPort[2] + 1] = Z[0];
-                        // this is the stub impedance
-                        matrices->Z[numbersNodeAndPort[2] + 2] = Zs;
-                        // Calculating Zhat
-                        // In this case I don't have Zs
-                        if (Cs == 0) {
-                            Zhat = Z[0] / (2 + Z[0] * G);
-                            taus = 0;
-
-                            // this is the case that I have Zs
-                        } else {
-                            Zhat = 1 / (G + 1 / Zs + 2 / Z[0]);
-                            if (Cs < 0) {
-                                taus = -2 * Zhat / Zs;
-                                ros = taus + 1;
-                            } else {
-                                taus = 2 * Zhat / Zs;
-                                ros = taus - 1;
-                            }
-                        }
-
-
-                        // Manually validated
-                        tau[0] = 2 * Zhat / Z[0];
-
-                        // this is actually matrix S.
-                        // M = C*S
-                        // this matrix is M[line][column].
-                        matrices->M.insert(numbersNodeAndPort[2] + 0,
-                                numbersNodeAndPort[2] + 0) = tau[0] - 1;
-                        matrices->M.insert(numbersNodeAndPort[2] + 0,
-                                numbersNodeAndPort[2] + 1) = tau[0];
-                        matrices->M.insert(numbersNodeAndPort[2] + 0,
-                                numbersNodeAndPort[2] + 2) = taus;
-
-                        matrices->M.insert(numbersNodeAndPort[2] + 1,
-                                numbersNodeAndPort[2] + 0) = tau[0];
-                        matrices->M.insert(numbersNodeAndPort[2] + 1,
-                                numbersNodeAndPort[2] + 1) = tau[0] - 1;
-                        matrices->M.insert(numbersNodeAndPort[2] + 1,
-                                numbersNodeAndPort[2] + 2) = taus;
-
-                        matrices->M.insert(numbersNodeAndPort[2] + 2,
-                                numbersNodeAndPort[2] + 0) = tau[0];
-                        matrices->M.insert(numbersNodeAndPort[2] + 2,
-                                numbersNodeAndPort[2] + 1) = tau[0];
-                        matrices->M.insert(numbersNodeAndPort[2] + 2,
-                                numbersNodeAndPort[2] + 2) = ros;
-
-                        // matrix tau
-                        matrices->tau.insert(numbersNodeAndPort[0],
-                                numbersNodeAndPort[2] + 0) = tau[0];
-                        matrices->tau.insert(numbersNodeAndPort[0],
-                                numbersNodeAndPort[2] + 1) = tau[0];
-                        matrices->tau.insert(numbersNodeAndPort[0],
-                                numbersNodeAndPort[2] + 2) = taus;
-
-                        // this is actually matrix ZIS.
-                        // E = C*ZIS + B
-                        matrices->E(numbersNodeAndPort[2] + 0) = Zhat*Is;
-                        matrices->E(numbersNodeAndPort[2] + 1) = Zhat*Is;
-                        matrices->E(numbersNodeAndPort[2] + 2) = Zhat*Is;
-
-                        // initial value
-                        // Vi0 = (Ti - ZIS)/sum(tau)
-                        matrices->Vi(numbersNodeAndPort[2] + 0) = (input->materialInput[j2].generalized_initialScalar
-                                - matrices->E(numbersNodeAndPort[2] + 0)) / (2 * tau[0] + taus);
-                        matrices->Vi(numbersNodeAndPort[2] + 1) = matrices->Vi(numbersNodeAndPort[2] + 0);
-                        matrices->Vi(numbersNodeAndPort[2] + 2) = matrices->Vi(numbersNodeAndPort[2] + 0);
-                        // I'm initiating Vs as 0
+        // j2: the material of the element, from the table of tags of the equation
+        if (getTagTLMnumbers(&(matrices->numbers), input->mesh.elements.Line[i].tag, &j2) == 2) {
+            getRealNodeAndPort_fromAbstractNode(1, // element code
+                    i, // element number
+                    matrices->numbers.abstractPortsToReal,
+                    numbersNodeAndPort);
+
+            // the -1 is necessary because the C indexing starts at zero
+            // and my number of node starts at 1
+            getGeometricalVariablesTLMline(&input->mesh.nodes[input->mesh.elements.Line[i].N1 - 1],
+                    &input->mesh.nodes[input->mesh.elements.Line[i].N2 - 1], tempVar);
+
+            matrices->L[numbersNodeAndPort[1] + 0] = 1; // this length is defined as 1 for 1D nodes
+            matrices->L[numbersNodeAndPort[1] + 1] = 1; // this length is defined as 1 for 1D nodes
+
+            matrices->deltal[numbersNodeAndPort[1] + 0] = tempVar[0]; // length of port 1
+            matrices->deltal[numbersNodeAndPort[1] + 1] = tempVar[0]; // length of port 2
+
+            // generalization of R
+            R[0] = tempVar[0] / input->materialInput[j2].generalized_diffusionCoeff;
+
+            // generalization of G
+            G = 2 * tempVar[0] * input->materialInput[j2].generalized_sink_a;
+
+            // generalization of Is
+            Is = 2 * tempVar[0] * input->materialInput[j2].generalized_source;
+
+            // all the resistances
+            matrices->R[numbersNodeAndPort[1] + 0] = R[0];
+            matrices->R[numbersNodeAndPort[1] + 1] = R[0];
+
+
+            // here I switch the code accordingly to what type of node I have
+            // 
+            // this is the simplest of all. Also called parabolic equation.
+            // Used for 'diffusion', 'heat', and 'pennes'
+            if (input->materialInput[j2].generalized_relaxationTime == 0) {
+                // this has two nodes that connect with others elements
+
+                // generalization of Cd
+                Cd = input->materialInput[j2].generalized_coefficient_b;
+
+                // Z = dt/(2*Cd*deltal). Manually validated
+                Z[0] = input->equationInput[id].timeStep / (tempVar[0] * 2 * Cd);
+
+                // all the impedances
+                matrices->Z[numbersNodeAndPort[2] + 0] = Z[0];
+                matrices->Z[numbersNodeAndPort[2] + 1] = Z[0];
+
+                // Manually validated
+                Zhat = Z[0] / (2 + Z[0] * G);
+
+                // Manually validated
+                tau[0] = 2 * Zhat / Z[0];
+                // this is actually matrix S.
+                // M = C*S
+                // this matrix is M[line][column].
+                tripletsM.emplace_back(numbersNodeAndPort[2] + 0,
+                        numbersNodeAndPort[2] + 0, tau[0] - 1);
+                tripletsM.emplace_back(numbersNodeAndPort[2] + 0,
+                        numbersNodeAndPort[2] + 1, tau[0]);
+
+                tripletsM.emplace_back(numbersNodeAndPort[2] + 1,
+                        numbersNodeAndPort[2] + 0, tau[0]);
+                tripletsM.emplace_back(numbersNodeAndPort[2] + 1,
+                        numbersNodeAndPort[2] + 1, tau[0] - 1);
+
+                // matrix tau
+                tripletsTau.emplace_back(numbersNodeAndPort[0],
+                        numbersNodeAndPort[2] + 0, tau[0]);
+                tripletsTau.emplace_back(numbersNodeAndPort[0],
+                        numbersNodeAndPort[2] + 1, tau[0]);
+
+                // this is actually matrix ZIS.
+                // E = C*ZIS + B
+                matrices->E(numbersNodeAndPort[2] + 0) = Zhat*Is;
+                matrices->E(numbersNodeAndPort[2] + 1) = Zhat*Is;
+
+                // initial value
+                // Vi0 = (Ti - ZIS)/sum(tau)
+                matrices->Vi(numbersNodeAndPort[2] + 0) = (input->materialInput[j2].generalized_initialScalar
+                        - matrices->E(numbersNodeAndPort[2] + 0)) / (2 * tau[0]);
+                matrices->Vi(numbersNodeAndPort[2] + 1) = matrices->Vi(numbersNodeAndPort[2] + 0);
+
+
+                // this is for the wave models. Also called hyperbolic equation.
+                // Used for 'hyperbolic diffusion', 'hyperbolic heat', and 
+                // 'hyperbolic pennes'
+            } else {
+                // this has three nodes. Two nodes connect with others elements
+                // and one extra node is used to model the relaxation time
+
+                // generalization of Cd
+                //                        Cd = input->materialInput[j2].generalized_diffusionCoeff *
+                //                                input->equationInput[id].timeStep * input->equationInput[id].timeStep /
+                //                                (4 * tempVar[0] * tempVar[0] * input->materialInput[j2].generalized_relaxationTime);
+
+                // generalization of Cs
+                //                        Cs = (input->materialInput[j2].generalized_coefficient_b - Cd)* 2 * tempVar[0];
+
+                // Z = dt/(2*Cd*deltal). Manually validated
+                //                        Z[0] = input->equationInput[id].timeStep / (tempVar[0] * 2 * Cd);
+
+                // trying new approach
+                double Ld;
+                Ld = input->materialInput[j2].generalized_diffusionCoeff / input->materialInput[j2].generalized_relaxationTime;
+                Cd = input->materialInput[j2].generalized_coefficient_b;
+                Cs = input->materialInput[j2].generalized_coefficient_b * (1 - 2 * tempVar[0]);
+                Z[0] = sqrt(Ld / Cd);
+
+                // Zs = dt/(2*Cs)
+                if (Cs > 0) {
+                    Zs = input->equationInput[id].timeStep / (2 * Cs);
+                } else if (Cs < 0) {
+                    Zs = -input->equationInput[id].timeStep / (2 * Cs);
+                } else {
+                    Zs = INFINITY;
+                }
+
 
+                // all the impedances
+                matrices->Z[numbersNodeAndPort[2] + 0] = Z[0];
+                matrices->Z[numbersNodeAndPort[2] + 1] = Z[0];
+                // this is the stub impedance
+                matrices->Z[numbersNodeAndPort[2] + 2] = Zs;
+                // Calculating Zhat
+                // In this case I don't have Zs
+                if (Cs == 0) {
+                    Zhat = Z[0] / (2 + Z[0] * G);
+                    taus = 0;
+
+                    // this is the case that I have Zs
+                } else {
+                    Zhat = 1 / (G + 1 / Zs + 2 / Z[0]);
+                    if (Cs < 0) {
+                        taus = -2 * Zhat / Zs;
+                        ros = taus + 1;
+                    } else {
+                        taus = 2 * Zhat / Zs;
+                        ros = taus - 1;
                     }
+                }
 
-                    // matrix E_output
-                    matrices->E_output(numbersNodeAndPort[0]) = Zhat*Is;
 
-                    matrices->Points_output[numbersNodeAndPort[0]].x = tempVar[1];
-                    matrices->Points_output[numbersNodeAndPort[0]].y = tempVar[2];
-                    matrices->Points_output[numbersNodeAndPort[0]].z = tempVar[3];
+                // Manually validated
+                tau[0] = 2 * Zhat / Z[0];
+
+                // this is actually matrix S.
+                // M = C*S
+                // this matrix is M[line][column].
+                tripletsM.emplace_back(numbersNodeAndPort[2] + 0,
+                        numbersNodeAndPort[2] + 0, tau[0] - 1);
+                tripletsM.emplace_back(numbersNodeAndPort[2] + 0,
+                        numbersNodeAndPort[2] + 1, tau[0]);
+                tripletsM.emplace_back(numbersNodeAndPort[2] + 0,
+                        numbersNodeAndPort[2] + 2, taus);
+
+                tripletsM.emplace_back(numbersNodeAndPort[2] + 1,
+                        numbersNodeAndPort[2] + 0, tau[0]);
+                tripletsM.emplace_back(numbersNodeAndPort[2] + 1,
+                        numbersNodeAndPort[2] + 1, tau[0] - 1);
+                tripletsM.emplace_back(numbersNodeAndPort[2] + 1,
+                        numbersNodeAndPort[2] + 2, taus);
+
+                tripletsM.emplace_back(numbersNodeAndPort[2] + 2,
+                        numbersNodeAndPort[2] + 0, tau[0]);
+                tripletsM.emplace_back(numbersNodeAndPort[2] + 2,
+                        numbersNodeAndPort[2] + 1, tau[0]);
+                tripletsM.emplace_back(numbersNodeAndPort[2] + 2,
+                        numbersNodeAndPort[2] + 2, ros);
+
+                // matrix tau
+                tripletsTau.emplace_back(numbersNodeAndPort[0],
+                        numbersNodeAndPort[2] + 0, tau[0]);
+                tripletsTau.emplace_back(numbersNodeAndPort[0],
+                        numbersNodeAndPort[2] + 1, tau[0]);
+                tripletsTau.emplace_back(numbersNodeAndPort[0],
+                        numbersNodeAndPort[2] + 2, taus);
+
+                // this is actually matrix ZIS.
+                // E = C*ZIS + B
+                matrices->E(numbersNodeAndPort[2] + 0) = Zhat*Is;
+                matrices->E(numbersNodeAndPort[2] + 1) = Zhat*Is;
+                matrices->E(numbersNodeAndPort[2] + 2) = Zhat*Is;
+
+                // initial value
+                // Vi0 = (Ti - ZIS)/sum(tau)
+                matrices->Vi(numbersNodeAndPort[2] + 0) = (input->materialInput[j2].generalized_initialScalar
+                        - matrices->E(numbersNodeAndPort[2] + 0)) / (2 * tau[0] + taus);
+                matrices->Vi(numbersNodeAndPort[2] + 1) = matrices->Vi(numbersNodeAndPort[2] + 0);
+                matrices->Vi(numbersNodeAndPort[2] + 2) = matrices->Vi(numbersNodeAndPort[2] + 0);
+                // I'm initiating Vs as 0
 
-                    goto end_for_j_and_for_k_line;
-                }
-end_for_j_and_for_k_line:
-        ;
+            }
+
+            // matrix E_output
+            matrices->E_output(numbersNodeAndPort[0]) = Zhat*Is;
+
+            // the volume of the node, used by the statistics
+            matrices->volume[numbersNodeAndPort[0]] = 2 * tempVar[0];
+
+            matrices->Points_output[numbersNodeAndPort[0]].x = tempVar[1];
+            matrices->Points_output[numbersNodeAndPort[0]].y = tempVar[2];
+            matrices->Points_output[numbersNodeAndPort[0]].z = tempVar[3];
+        }
     }
     return 0;
 }
@@ -749,9 +1231,10 @@ end_for_j_and_for_k_line:
  */
 unsigned int MaterialTrianglePennesEigen(struct dataForSimulation *input, struct calculationTLMEigen *matrices, int id) {
     unsigned int errorTLMnumber;
-    unsigned long long numbersNodeAndPort[] = {0, 0};
+    unsigned long long numbersNodeAndPort[] = {0, 0, 0};
     // 0 - number of node
     // 1 - number of port 0
+    // 2 - number of port 0 considering offsets that stubs might do
     unsigned int j2;
     double Cd, Z[3], R[3], G, Is, Zhat, tau[3];
 
@@ -772,8 +1255,7 @@ unsigned int MaterialTrianglePennesEigen(struct dataForSimulation *input, struct
     // 3D: Boundary Condition (treated elsewhere).
     //
     // element code 2: 3 nodes triangle.
-    double *tempVar = NULL;
-    tempVar = (double *) realloc(tempVar, sizeof (double)*10);
+    double tempVar[10];
     // 0 - length of port 1 (from center of triangle to center of face 1)
     // 1 - length of port 2 (from center of triangle to center of face 2)
     // 2 - length of port 3 (from center of triangle to center of face 3)
@@ -785,135 +1267,134 @@ unsigned int MaterialTrianglePennesEigen(struct dataForSimulation *input, struct
     // 8 - Triangles' center y
     // 9 - Triangles' center z
 
+    // the elements are independent. Each thread saves the entries of M and tau
+    // in its own list, and the lists become M and tau in tlmAssembleElementsEigen
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(static) num_threads(input->simulationInput.nOpenMPcores) \
+        private(numbersNodeAndPort, j2, Cd, Z, R, G, Is, Zhat, tau, tempVar)
+#endif
     for (unsigned long long i = 0; i < input->mesh.quantityOfSpecificElement[2]; i++) {
+        std::vector< Triplet<double, long long> > &tripletsM = matrices->tripletsM[tlmThreadEigen()];
+        std::vector< Triplet<double, long long> > &tripletsTau = matrices->tripletsTau[tlmThreadEigen()];
+
         // i: element level
-        // j: boundary type level
-        // k: different tag numbers for the same boundary type
-        for (unsigned int j = 0; j < input->equationInput[id].numberOfMaterials; j++)
-            for (unsigned int k = 0; k < input->materialInput[ input->equationInput[id].materialNumbers[j] ].quantityOfNumberInput; k++)
-                if (input->mesh.elements.Triangle[i].tag == input->materialInput[ input->equationInput[id].materialNumbers[j] ].numberInput[k]) {
-                    j2 = input->equationInput[id].materialNumbers[j];
-                    // I will use goto to get out of these two inner 'for' loops. Bare in mind
-                    // that I'm just getting out the loops. You can also think that 
-                    // I'm going to the next 'i', that is, incrementing i by 1 and going
-                    // to the next value of i (if any).
-
-                    getRealNodeAndPort_fromAbstractNode(2, // element code
-                            i, // element number
-                            matrices->numbers.abstractPortsToReal,
-                            numbersNodeAndPort);
-
-                    // the -1 is necessary because the C indexing starts at zero
-                    // and my number of node starts at 1
-                    getGeometricalVariablesTLMtriangle(&input->mesh.nodes[input->mesh.elements.Triangle[i].N1 - 1],
-                            &input->mesh.nodes[input->mesh.elements.Triangle[i].N2 - 1],
-                            &input->mesh.nodes[input->mesh.elements.Triangle[i].N3 - 1], tempVar);
-
-                    matrices->L[numbersNodeAndPort[1] + 0] = tempVar[4]; // length of face 1
-                    matrices->L[numbersNodeAndPort[1] + 1] = tempVar[5]; // length of face 2
-                    matrices->L[numbersNodeAndPort[1] + 2] = tempVar[6]; // length of face 3
-
-                    matrices->deltal[numbersNodeAndPort[1] + 0] = tempVar[0]; // length of port 1
-                    matrices->deltal[numbersNodeAndPort[1] + 1] = tempVar[1]; // length of port 2
-                    matrices->deltal[numbersNodeAndPort[1] + 2] = tempVar[2]; // length of port 3
-
-                    // generalization of Cd
-                    Cd = tempVar[3] * input->materialInput[j2].generalized_coefficient_b /
-                            (tempVar[0] + tempVar[1] + tempVar[2]);
-
-                    // generalization of R
-                    R[0] = tempVar[0] / (input->materialInput[j2].generalized_diffusionCoeff * tempVar[4]);
-                    R[1] = tempVar[1] / (input->materialInput[j2].generalized_diffusionCoeff * tempVar[5]);
-                    R[2] = tempVar[2] / (input->materialInput[j2].generalized_diffusionCoeff * tempVar[6]);
-
-                    // generalization of G
-                    G = tempVar[3] * input->materialInput[j2].generalized_sink_a;
-
-                    // generalization of Is
-                    Is = tempVar[3] * input->materialInput[j2].generalized_source;
-
-                    // Z = dt/(2*Cd*deltal). Manually validated
-                    Z[0] = input->equationInput[id].timeStep / (2 * Cd);
-                    Z[1] = Z[0] / tempVar[1];
-                    Z[2] = Z[0] / tempVar[2];
-                    Z[0] = Z[0] / tempVar[0];
-
-                    // all the impedances
-                    matrices->Z[numbersNodeAndPort[1] + 0] = Z[0];
-                    matrices->Z[numbersNodeAndPort[1] + 1] = Z[1];
-                    matrices->Z[numbersNodeAndPort[1] + 2] = Z[2];
-
-                    // all the resistances
-                    matrices->R[numbersNodeAndPort[1] + 0] = R[0];
-                    matrices->R[numbersNodeAndPort[1] + 1] = R[1];
-                    matrices->R[numbersNodeAndPort[1] + 2] = R[2];
-
-                    // Manually validated
-                    Zhat = 1 / (1 / Z[0] + 1 / Z[1] + 1 / Z[2] + G);
-                    //                    Zhat = Z[0] * Z[1] * Z[2] / (Z[0] * Z[1] + Z[0] * Z[2] + Z[1] * Z[2]
-                    //                            + Z[0] * Z[1] * Z[2] * G);
-
-                    // Manually validated
-                    tau[0] = 2 * Zhat / Z[0];
-                    tau[1] = 2 * Zhat / Z[1];
-                    tau[2] = 2 * Zhat / Z[2];
-                    // this is actually matrix S.
-                    // M = C*S
-                    // this matrix is M[line][column].
-                    matrices->M.insert(numbersNodeAndPort[1] + 0,
-                            numbersNodeAndPort[1] + 0) = tau[0] - 1;
-                    matrices->M.insert(numbersNodeAndPort[1] + 0,
-                            numbersNodeAndPort[1] + 1) = tau[1];
-                    matrices->M.insert(numbersNodeAndPort[1] + 0,
-                            numbersNodeAndPort[1] + 2) = tau[2];
-
-                    matrices->M.insert(numbersNodeAndPort[1] + 1,
-                            numbersNodeAndPort[1] + 0) = tau[0];
-                    matrices->M.insert(numbersNodeAndPort[1] + 1,
-                            numbersNodeAndPort[1] + 1) = tau[1] - 1;
-                    matrices->M.insert(numbersNodeAndPort[1] + 1,
-                            numbersNodeAndPort[1] + 2) = tau[2];
-
-                    matrices->M.insert(numbersNodeAndPort[1] + 2,
-                            numbersNodeAndPort[1] + 0) = tau[0];
-                    matrices->M.insert(numbersNodeAndPort[1] + 2,
-                            numbersNodeAndPort[1] + 1) = tau[1];
-                    matrices->M.insert(numbersNodeAndPort[1] + 2,
-                            numbersNodeAndPort[1] + 2) = tau[2] - 1;
-
-                    // matrix tau
-                    matrices->tau.insert(numbersNodeAndPort[0],
-                            numbersNodeAndPort[1] + 0) = tau[0];
-                    matrices->tau.insert(numbersNodeAndPort[0],
-                            numbersNodeAndPort[1] + 1) = tau[1];
-                    matrices->tau.insert(numbersNodeAndPort[0],
-                            numbersNodeAndPort[1] + 2) = tau[2];
-
-                    // this is actually matrix ZIS.
-                    // E = C*ZIS + B
-                    matrices->E(numbersNodeAndPort[1] + 0) = Zhat*Is;
-                    matrices->E(numbersNodeAndPort[1] + 1) = Zhat*Is;
-                    matrices->E(numbersNodeAndPort[1] + 2) = Zhat*Is;
-
-                    // matrix E_output
-                    matrices->E_output(numbersNodeAndPort[0]) = Zhat*Is;
-
-                    matrices->Points_output[numbersNodeAndPort[0]].x = tempVar[7];
-                    matrices->Points_output[numbersNodeAndPort[0]].y = tempVar[8];
-                    matrices->Points_output[numbersNodeAndPort[0]].z = tempVar[9];
-
-
-                    // initial value
-                    // Vi0 = (Ti - ZIS)/sum(tau)
-                    matrices->Vi(numbersNodeAndPort[1] + 0) = (input->materialInput[j2].generalized_initialScalar
-                            - matrices->E(numbersNodeAndPort[1] + 0)) / (tau[0] + tau[1] + tau[2]);
-                    matrices->Vi(numbersNodeAndPort[1] + 1) = matrices->Vi(numbersNodeAndPort[1] + 0);
-                    matrices->Vi(numbersNodeAndPort[1] + 2) = matrices->Vi(numbersNodeAndPort[1] + 0);
-
-                    goto end_for_j_and_for_k_triangle;
-                }
-end_for_j_and_for_k_triangle:
-        ;
+        // j2: the material of the element, from the table of tags of the equation
+        if (getTagTLMnumbers(&(matrices->numbers), input->mesh.elements.Triangle[i].tag, &j2) == 2) {
+            getRealNodeAndPort_fromAbstractNode(2, // element code
+                    i, // element number
+                    matrices->numbers.abstractPortsToReal,
+                    numbersNodeAndPort);
+
+            // the -1 is necessary because the C indexing starts at zero
+            // and my number of node starts at 1
+            getGeometricalVariablesTLMtriangle(&input->mesh.nodes[input->mesh.elements.Triangle[i].N1 - 1],
+                    &input->mesh.nodes[input->mesh.elements.Triangle[i].N2 - 1],
+                    &input->mesh.nodes[input->mesh.elements.Triangle[i].N3 - 1], tempVar);
+
+            matrices->L[numbersNodeAndPort[1] + 0] = tempVar[4]; // length of face 1
+            matrices->L[numbersNodeAndPort[1] + 1] = tempVar[5]; // length of face 2
+            matrices->L[numbersNodeAndPort[1] + 2] = tempVar[6]; // length of face 3
+
+            matrices->deltal[numbersNodeAndPort[1] + 0] = tempVar[0]; // length of port 1
+            matrices->deltal[numbersNodeAndPort[1] + 1] = tempVar[1]; // length of port 2
+            matrices->deltal[numbersNodeAndPort[1] + 2] = tempVar[2]; // length of port 3
+
+            // generalization of Cd
+            Cd = tempVar[3] * input->materialInput[j2].generalized_coefficient_b /
+                    (tempVar[0] + tempVar[1] + tempVar[2]);
+
+            // generalization of R
+            R[0] = tempVar[0] / (input->materialInput[j2].generalized_diffusionCoeff * tempVar[4]);
+            R[1] = tempVar[1] / (input->materialInput[j2].generalized_diffusionCoeff * tempVar[5]);
+            R[2] = tempVar[2] / (input->materialInput[j2].generalized_diffusionCoeff * tempVar[6]);
+
+            // generalization of G
+            G = tempVar[3] * input->materialInput[j2].generalized_sink_a;
+
+            // generalization of Is
+            Is = tempVar[3] * input->materialInput[j2].generalized_source;
+
+            // Z = dt/(2*Cd*deltal). Manually validated
+            Z[0] = input->equationInput[id].timeStep / (2 * Cd);
+            Z[1] = Z[0] / tempVar[1];
+            Z[2] = Z[0] / tempVar[2];
+            Z[0] = Z[0] / tempVar[0];
+
+            // all the impedances
+            matrices->Z[numbersNodeAndPort[1] + 0] = Z[0];
+            matrices->Z[numbersNodeAndPort[1] + 1] = Z[1];
+            matrices->Z[numbersNodeAndPort[1] + 2] = Z[2];
+
+            // all the resistances
+            matrices->R[numbersNodeAndPort[1] + 0] = R[0];
+            matrices->R[numbersNodeAndPort[1] + 1] = R[1];
+            matrices->R[numbersNodeAndPort[1] + 2] = R[2];
+
+            // Manually validated
+            Zhat = 1 / (1 / Z[0] + 1 / Z[1] + 1 / Z[2] + G);
+            //                    Zhat = Z[0] * Z[1] * Z[2] / (Z[0] * Z[1] + Z[0] * Z[2] + Z[1] * Z[2]
+            //                            + Z[0] * Z[1] * Z[2] * G);
+
+            // Manually validated
+            tau[0] = 2 * Zhat / Z[0];
+            tau[1] = 2 * Zhat / Z[1];
+            tau[2] = 2 * Zhat / Z[2];
+            // this is actually matrix S.
+            // M = C*S
+            // this matrix is M[line][column].
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 0,
+                    numbersNodeAndPort[1] + 0, tau[0] - 1);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 0,
+                    numbersNodeAndPort[1] + 1, tau[1]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 0,
+                    numbersNodeAndPort[1] + 2, tau[2]);
+
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 1,
+                    numbersNodeAndPort[1] + 0, tau[0]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 1,
+                    numbersNodeAndPort[1] + 1, tau[1] - 1);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 1,
+                    numbersNodeAndPort[1] + 2, tau[2]);
+
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 2,
+                    numbersNodeAndPort[1] + 0, tau[0]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 2,
+                    numbersNodeAndPort[1] + 1, tau[1]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 2,
+                    numbersNodeAndPort[1] + 2, tau[2] - 1);
+
+            // matrix tau
+            tripletsTau.emplace_back(numbersNodeAndPort[0],
+                    numbersNodeAndPort[1] + 0, tau[0]);
+            tripletsTau.emplace_back(numbersNodeAndPort[0],
+                    numbersNodeAndPort[1] + 1, tau[1]);
+            tripletsTau.emplace_back(numbersNodeAndPort[0],
+                    numbersNodeAndPort[1] + 2, tau[2]);
+
+            // this is actually matrix ZIS.
+            // E = C*ZIS + B
+            matrices->E(numbersNodeAndPort[1] + 0) = Zhat*Is;
+            matrices->E(numbersNodeAndPort[1] + 1) = Zhat*Is;
+            matrices->E(numbersNodeAndPort[1] + 2) = Zhat*Is;
+
+            // matrix E_output
+            matrices->E_output(numbersNodeAndPort[0]) = Zhat*Is;
+
+            // the volume of the node, used by the statistics
+            matrices->volume[numbersNodeAndPort[0]] = tempVar[3];
+
+            matrices->Points_output[numbersNodeAndPort[0]].x = tempVar[7];
+            matrices->Points_output[numbersNodeAndPort[0]].y = tempVar[8];
+            matrices->Points_output[numbersNodeAndPort[0]].z = tempVar[9];
+
+
+            // initial value
+            // Vi0 = (Ti - ZIS)/sum(tau)
+            matrices->Vi(numbersNodeAndPort[1] + 0) = (input->materialInput[j2].generalized_initialScalar
+                    - matrices->E(numbersNodeAndPort[1] + 0)) / (tau[0] + tau[1] + tau[2]);
+            matrices->Vi(numbersNodeAndPort[1] + 1) = matrices->Vi(numbersNodeAndPort[1] + 0);
+            matrices->Vi(numbersNodeAndPort[1] + 2) = matrices->Vi(numbersNodeAndPort[1] + 0);
+        }
     }
     return 0;
 }
@@ -925,9 +1406,10 @@ end_for_j_and_for_k_triangle:
  */
 unsigned int MaterialQuadranglePennesEigen(struct dataForSimulation *input, struct calculationTLMEigen *matrices, int id) {
     unsigned int errorTLMnumber;
-    unsigned long long numbersNodeAndPort[] = {0, 0};
+    unsigned long long numbersNodeAndPort[] = {0, 0, 0};
     // 0 - number of node
     // 1 - number of port 0
+    // 2 - number of port 0 considering offsets that stubs might do
     unsigned int j2;
     double Cd, Z[4], R[4], G, Is, Zhat, tau[4];
 
@@ -955,8 +1437,7 @@ unsigned int MaterialQuadranglePennesEigen(struct dataForSimulation *input, stru
     // 3D: Boundary Condition (treated elsewhere).
     //
     // element code 3: 4 nodes triangle.
-    double *tempVar = NULL;
-    tempVar = (double *) realloc(tempVar, sizeof (double)*12);
+    double tempVar[12];
     // 0 - length of port 1 (from center of quadrangle to center of face 1)
     // 1 - length of port 2 (from center of quadrangle to center of face 2)
     // 2 - length of port 3 (from center of quadrangle to center of face 3)
@@ -970,164 +1451,163 @@ unsigned int MaterialQuadranglePennesEigen(struct dataForSimulation *input, stru
     // 10 - Quadrangle's center y
     // 11 - Quadrangle's center z
 
+    // the elements are independent. Each thread saves the entries of M and tau
+    // in its own list, and the lists become M and tau in tlmAssembleElementsEigen
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(static) num_threads(input->simulationInput.nOpenMPcores) \
+        private(numbersNodeAndPort, j2, Cd, Z, R, G, Is, Zhat, tau, tempVar)
+#endif
     for (unsigned long long i = 0; i < input->mesh.quantityOfSpecificElement[3]; i++) {
+        std::vector< Triplet<double, long long> > &tripletsM = matrices->tripletsM[tlmThreadEigen()];
+        std::vector< Triplet<double, long long> > &tripletsTau = matrices->tripletsTau[tlmThreadEigen()];
+
         // i: element level
-        // j: boundary type level
-        // k: different tag numbers for the same boundary type
-        for (unsigned int j = 0; j < input->equationInput[id].numberOfMaterials; j++)
-            for (unsigned int k = 0; k < input->materialInput[ input->equationInput[id].materialNumbers[j] ].quantityOfNumberInput; k++)
-                if (input->mesh.elements.Quadrangle[i].tag == input->materialInput[ input->equationInput[id].materialNumbers[j] ].numberInput[k]) {
-                    j2 = input->equationInput[id].materialNumbers[j];
-                    // I will use goto to get out of these two inner 'for' loops. Bare in mind
-                    // that I'm just getting out the loops. You can also think that 
-                    // I'm going to the next 'i', that is, incrementing i by 1 and going
-                    // to the next value of i (if any).
-
-                    getRealNodeAndPort_fromAbstractNode(3, // element code
-                            i, // element number
-                            matrices->numbers.abstractPortsToReal,
-                            numbersNodeAndPort);
-
-                    // the -1 is necessary because the C indexing starts at zero
-                    // and my number of node starts at 1
-                    getGeometricalVariablesTLMquadrangle(&input->mesh.nodes[input->mesh.elements.Quadrangle[i].N1 - 1],
-                            &input->mesh.nodes[input->mesh.elements.Quadrangle[i].N2 - 1],
-                            &input->mesh.nodes[input->mesh.elements.Quadrangle[i].N3 - 1],
-                            &input->mesh.nodes[input->mesh.elements.Quadrangle[i].N4 - 1], tempVar);
-
-                    matrices->L[numbersNodeAndPort[1] + 0] = tempVar[5]; // length of face 1
-                    matrices->L[numbersNodeAndPort[1] + 1] = tempVar[6]; // length of face 2
-                    matrices->L[numbersNodeAndPort[1] + 2] = tempVar[7]; // length of face 3
-                    matrices->L[numbersNodeAndPort[1] + 3] = tempVar[8]; // length of face 4
-
-                    matrices->deltal[numbersNodeAndPort[1] + 0] = tempVar[0]; // length of port 1
-                    matrices->deltal[numbersNodeAndPort[1] + 1] = tempVar[1]; // length of port 2
-                    matrices->deltal[numbersNodeAndPort[1] + 2] = tempVar[2]; // length of port 3
-                    matrices->deltal[numbersNodeAndPort[1] + 3] = tempVar[3]; // length of port 4
-
-                    // generalization of Cd
-                    Cd = tempVar[4] * input->materialInput[j2].generalized_coefficient_b /
-                            (tempVar[0] + tempVar[1] + tempVar[2] + tempVar[3]);
-
-                    // generalization of R
-                    R[0] = tempVar[0] / (input->materialInput[j2].generalized_diffusionCoeff * tempVar[5]);
-                    R[1] = tempVar[1] / (input->materialInput[j2].generalized_diffusionCoeff * tempVar[6]);
-                    R[2] = tempVar[2] / (input->materialInput[j2].generalized_diffusionCoeff * tempVar[7]);
-                    R[3] = tempVar[3] / (input->materialInput[j2].generalized_diffusionCoeff * tempVar[8]);
-
-                    // generalization of G
-                    G = tempVar[4] * input->materialInput[j2].generalized_sink_a;
-
-                    // generalization of Is
-                    Is = tempVar[4] * input->materialInput[j2].generalized_source;
-
-                    // Z = dt/(2*Cd*deltal). Manually validated
-                    Z[0] = input->equationInput[id].timeStep / (2 * Cd);
-                    Z[1] = Z[0] / tempVar[1];
-                    Z[2] = Z[0] / tempVar[2];
-                    Z[3] = Z[0] / tempVar[3];
-                    Z[0] = Z[0] / tempVar[0];
-
-                    // all the impedances
-                    matrices->Z[numbersNodeAndPort[1] + 0] = Z[0];
-                    matrices->Z[numbersNodeAndPort[1] + 1] = Z[1];
-                    matrices->Z[numbersNodeAndPort[1] + 2] = Z[2];
-                    matrices->Z[numbersNodeAndPort[1] + 3] = Z[3];
-
-                    // all the resistances
-                    matrices->R[numbersNodeAndPort[1] + 0] = R[0];
-                    matrices->R[numbersNodeAndPort[1] + 1] = R[1];
-                    matrices->R[numbersNodeAndPort[1] + 2] = R[2];
-                    matrices->R[numbersNodeAndPort[1] + 3] = R[3];
-
-                    // Manually validated
-                    Zhat = 1 / (1 / Z[0] + 1 / Z[1] + 1 / Z[2] + 1 / Z[3] + G);
-                    //                    Zhat = Z[0] * Z[1] * Z[2] * Z[3] / (Z[0] * Z[1] * Z[2]
-                    //                            + Z[0] * Z[1] * Z[3] + Z[0] * Z[2] * Z[3]
-                    //                            + Z[1] * Z[2] * Z[3] + Z[0] * Z[1] * Z[2] * Z[3] * G);
-
-                    // Manually validated
-                    tau[0] = 2 * Zhat / Z[0];
-                    tau[1] = 2 * Zhat / Z[1];
-                    tau[2] = 2 * Zhat / Z[2];
-                    tau[3] = 2 * Zhat / Z[3];
-
-                    // this is actually matrix S.
-                    // M = C*S
-                    // this matrix is M[line][column].
-                    matrices->M.insert(numbersNodeAndPort[1] + 0,
-                            numbersNodeAndPort[1] + 0) = tau[0] - 1;
-                    matrices->M.insert(numbersNodeAndPort[1] + 0,
-                            numbersNodeAndPort[1] + 1) = tau[1];
-                    matrices->M.insert(numbersNodeAndPort[1] + 0,
-                            numbersNodeAndPort[1] + 2) = tau[2];
-                    matrices->M.insert(numbersNodeAndPort[1] + 0,
-                            numbersNodeAndPort[1] + 3) = tau[3];
-
-                    matrices->M.insert(numbersNodeAndPort[1] + 1,
-                            numbersNodeAndPort[1] + 0) = tau[0];
-                    matrices->M.insert(numbersNodeAndPort[1] + 1,
-                            numbersNodeAndPort[1] + 1) = tau[1] - 1;
-                    matrices->M.insert(numbersNodeAndPort[1] + 1,
-                            numbersNodeAndPort[1] + 2) = tau[2];
-                    matrices->M.insert(numbersNodeAndPort[1] + 1,
-                            numbersNodeAndPort[1] + 3) = tau[3];
-
-                    matrices->M.insert(numbersNodeAndPort[1] + 2,
-                            numbersNodeAndPort[1] + 0) = tau[0];
-                    matrices->M.insert(numbersNodeAndPort[1] + 2,
-                            numbersNodeAndPort[1] + 1) = tau[1];
-                    matrices->M.insert(numbersNodeAndPort[1] + 2,
-                            numbersNodeAndPort[1] + 2) = tau[2] - 1;
-                    matrices->M.insert(numbersNodeAndPort[1] + 2,
-                            numbersNodeAndPort[1] + 3) = tau[3];
-
-                    matrices->M.insert(numbersNodeAndPort[1] + 3,
-                            numbersNodeAndPort[1] + 0) = tau[0];
-                    matrices->M.insert(numbersNodeAndPort[1] + 3,
-                            numbersNodeAndPort[1] + 1) = tau[1];
-                    matrices->M.insert(numbersNodeAndPort[1] + 3,
-                            numbersNodeAndPort[1] + 2) = tau[2];
-                    matrices->M.insert(numbersNodeAndPort[1] + 3,
-                            numbersNodeAndPort[1] + 3) = tau[3] - 1;
-
-                    // matrix tau
-                    matrices->tau.insert(numbersNodeAndPort[0],
-                            numbersNodeAndPort[1] + 0) = tau[0];
-                    matrices->tau.insert(numbersNodeAndPort[0],
-                            numbersNodeAndPort[1] + 1) = tau[1];
-                    matrices->tau.insert(numbersNodeAndPort[0],
-                            numbersNodeAndPort[1] + 2) = tau[2];
-                    matrices->tau.insert(numbersNodeAndPort[0],
-                            numbersNodeAndPort[1] + 3) = tau[3];
-
-                    // this is actually matrix ZIS.
-                    // E = C*ZIS + B
-                    matrices->E(numbersNodeAndPort[1] + 0) = Zhat*Is;
-                    matrices->E(numbersNodeAndPort[1] + 1) = Zhat*Is;
-                    matrices->E(numbersNodeAndPort[1] + 2) = Zhat*Is;
-                    matrices->E(numbersNodeAndPort[1] + 3) = Zhat*Is;
-
-                    // matrix E_output
-                    matrices->E_output(numbersNodeAndPort[0]) = Zhat*Is;
-
-                    // the center of the tetrahedron
-                    matrices->Points_output[numbersNodeAndPort[0]].x = tempVar[9];
-                    matrices->Points_output[numbersNodeAndPort[0]].y = tempVar[10];
-                    matrices->Points_output[numbersNodeAndPort[0]].z = tempVar[11];
-
-                    // Vi0 = (Ti - ZIS)/sum(tau)
-                    // generalization of the initial value
-                    matrices->Vi(numbersNodeAndPort[1]) = (input->materialInput[j2].generalized_initialScalar
-                            - matrices->E(numbersNodeAndPort[1])) / (tau[0] + tau[1] + tau[2] + tau[3]);
-                    matrices->Vi(numbersNodeAndPort[1] + 1) = matrices->Vi(numbersNodeAndPort[1]);
-                    matrices->Vi(numbersNodeAndPort[1] + 2) = matrices->Vi(numbersNodeAndPort[1]);
-                    matrices->Vi(numbersNodeAndPort[1] + 3) = matrices->Vi(numbersNodeAndPort[1]);
-
-                    goto end_for_j_and_for_k_quadrangle;
-                }
-end_for_j_and_for_k_quadrangle:
-        ;
+        // j2: the material of the element, from the table of tags of the equation
+        if (getTagTLMnumbers(&(matrices->numbers), input->mesh.elements.Quadrangle[i].tag, &j2) == 2) {
+            getRealNodeAndPort_fromAbstractNode(3, // element code
+                    i, // element number
+                    matrices->numbers.abstractPortsToReal,
+                    numbersNodeAndPort);
+
+            // the -1 is necessary because the C indexing starts at zero
+            // and my number of node starts at 1
+            getGeometricalVariablesTLMquadrangle(&input->mesh.nodes[input->mesh.elements.Quadrangle[i].N1 - 1],
+                    &input->mesh.nodes[input->mesh.elements.Quadrangle[i].N2 - 1],
+                    &input->mesh.nodes[input->mesh.elements.Quadrangle[i].N3 - 1],
+                    &input->mesh.nodes[input->mesh.elements.Quadrangle[i].N4 - 1], tempVar);
+
+            matrices->L[numbersNodeAndPort[1] + 0] = tempVar[5]; // length of face 1
+            matrices->L[numbersNodeAndPort[1] + 1] = tempVar[6]; // length of face 2
+            matrices->L[numbersNodeAndPort[1] + 2] = tempVar[7]; // length of face 3
+            matrices->L[numbersNodeAndPort[1] + 3] = tempVar[8]; // length of face 4
+
+            matrices->deltal[numbersNodeAndPort[1] + 0] = tempVar[0]; // length of port 1
+            matrices->deltal[numbersNodeAndPort[1] + 1] = tempVar[1]; // length of port 2
+            matrices->deltal[numbersNodeAndPort[1] + 2] = tempVar[2]; // length of port 3
+            matrices->deltal[numbersNodeAndPort[1] + 3] = tempVar[3]; // length of port 4
+
+            // generalization of Cd
+            Cd = tempVar[4] * input->materialInput[j2].generalized_coefficient_b /
+                    (tempVar[0] + tempVar[1] + tempVar[2] + tempVar[3]);
+
+            // generalization of R
+            R[0] = tempVar[0] / (input->materialInput[j2].generalized_diffusionCoeff * tempVar[5]);
+            R[1] = tempVar[1] / (input->materialInput[j2].generalized_diffusionCoeff * tempVar[6]);
+            R[2] = tempVar[2] / (input->materialInput[j2].generalized_diffusionCoeff * tempVar[7]);
+            R[3] = tempVar[3] / (input->materialInput[j2].generalized_diffusionCoeff * tempVar[8]);
+
+            // generalization of G
+            G = tempVar[4] * input->materialInput[j2].generalized_sink_a;
+
+            // generalization of Is
+            Is = tempVar[4] * input->materialInput[j2].generalized_source;
+
+            // Z = dt/(2*Cd*deltal). Manually validated
+            Z[0] = input->equationInput[id].timeStep / (2 * Cd);
+            Z[1] = Z[0] / tempVar[1];
+            Z[2] = Z[0] / tempVar[2];
+            Z[3] = Z[0] / tempVar[3];
+            Z[0] = Z[0] / tempVar[0];
+
+            // all the impedances
+            matrices->Z[numbersNodeAndPort[1] + 0] = Z[0];
+            matrices->Z[numbersNodeAndPort[1] + 1] = Z[1];
+            matrices->Z[numbersNodeAndPort[1] + 2] = Z[2];
+            matrices->Z[numbersNodeAndPort[1] + 3] = Z[3];
+
+            // all the resistances
+            matrices->R[numbersNodeAndPort[1] + 0] = R[0];
+            matrices->R[numbersNodeAndPort[1] + 1] = R[1];
+            matrices->R[numbersNodeAndPort[1] + 2] = R[2];
+            matrices->R[numbersNodeAndPort[1] + 3] = R[3];
+
+            // Manually validated
+            Zhat = 1 / (1 / Z[0] + 1 / Z[1] + 1 / Z[2] + 1 / Z[3] + G);
+            //                    Zhat = Z[0] * Z[1] * Z[2] * Z[3] / (Z[0] * Z[1] * Z[2]
+            //                            + Z[0] * Z[1] * Z[3] + Z[0] * Z[2] * Z[3]
+            //                            + Z[1] * Z[2] * Z[3] + Z[0] * Z[1] * Z[2] * Z[3] * G);
+
+            // Manually validated
+            tau[0] = 2 * Zhat / Z[0];
+            tau[1] = 2 * Zhat / Z[1];
+            tau[2] = 2 * Zhat / Z[2];
+            tau[3] = 2 * Zhat / Z[3];
+
+            // this is actually matrix S.
+            // M = C*S
+            // this matrix is M[line][column].
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 0,
+                    numbersNodeAndPort[1] + 0, tau[0] - 1);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 0,
+                    numbersNodeAndPort[1] + 1, tau[1]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 0,
+                    numbersNodeAndPort[1] + 2, tau[2]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 0,
+                    numbersNodeAndPort[1] + 3, tau[3]);
+
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 1,
+                    numbersNodeAndPort[1] + 0, tau[0]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 1,
+                    numbersNodeAndPort[1] + 1, tau[1] - 1);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 1,
+                    numbersNodeAndPort[1] + 2, tau[2]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 1,
+                    numbersNodeAndPort[1] + 3, tau[3]);
+
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 2,
+                    numbersNodeAndPort[1] + 0, tau[0]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 2,
+                    numbersNodeAndPort[1] + 1, tau[1]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 2,
+                    numbersNodeAndPort[1] + 2, tau[2] - 1);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 2,
+                    numbersNodeAndPort[1] + 3, tau[3]);
+
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 3,
+                    numbersNodeAndPort[1] + 0, tau[0]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 3,
+                    numbersNodeAndPort[1] + 1, tau[1]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 3,
+                    numbersNodeAndPort[1] + 2, tau[2]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 3,
+                    numbersNodeAndPort[1] + 3, tau[3] - 1);
+
+            // matrix tau
+            tripletsTau.emplace_back(numbersNodeAndPort[0],
+                    numbersNodeAndPort[1] + 0, tau[0]);
+            tripletsTau.emplace_back(numbersNodeAndPort[0],
+                    numbersNodeAndPort[1] + 1, tau[1]);
+            tripletsTau.emplace_back(numbersNodeAndPort[0],
+                    numbersNodeAndPort[1] + 2, tau[2]);
+            tripletsTau.emplace_back(numbersNodeAndPort[0],
+                    numbersNodeAndPort[1] + 3, tau[3]);
+
+            // this is actually matrix ZIS.
+            // E = C*ZIS + B
+            matrices->E(numbersNodeAndPort[1] + 0) = Zhat*Is;
+            matrices->E(numbersNodeAndPort[1] + 1) = Zhat*Is;
+            matrices->E(numbersNodeAndPort[1] + 2) = Zhat*Is;
+            matrices->E(numbersNodeAndPort[1] + 3) = Zhat*Is;
+
+            // matrix E_output
+            matrices->E_output(numbersNodeAndPort[0]) = Zhat*Is;
+
+            // the volume of the node, used by the statistics
+            matrices->volume[numbersNodeAndPort[0]] = tempVar[4];
+
+            // the center of the tetrahedron
+            matrices->Points_output[numbersNodeAndPort[0]].x = tempVar[9];
+            matrices->Points_output[numbersNodeAndPort[0]].y = tempVar[10];
+            matrices->Points_output[numbersNodeAndPort[0]].z = tempVar[11];
+
+            // Vi0 = (Ti - ZIS)/sum(tau)
+            // generalization of the initial value
+            matrices->Vi(numbersNodeAndPort[1]) = (input->materialInput[j2].generalized_initialScalar
+                    - matrices->E(numbersNodeAndPort[1])) / (tau[0] + tau[1] + tau[2] + tau[3]);
+            matrices->Vi(numbersNodeAndPort[1] + 1) = matrices->Vi(numbersNodeAndPort[1]);
+            matrices->Vi(numbersNodeAndPort[1] + 2) = matrices->Vi(numbersNodeAndPort[1]);
+            matrices->Vi(numbersNodeAndPort[1] + 3) = matrices->Vi(numbersNodeAndPort[1]);
+        }
     }
     return 0;
 }
@@ -1139,9 +1619,10 @@ end_for_j_and_for_k_quadrangle:
  */
 unsigned int MaterialTetrahedronPennesEigen(struct dataForSimulation *input, struct calculationTLMEigen *matrices, int id) {
     unsigned int errorTLMnumber;
-    unsigned long long numbersNodeAndPort[] = {0, 0};
+    unsigned long long numbersNodeAndPort[] = {0, 0, 0};
     // 0 - number of node
     // 1 - number of port 0
+    // 2 - number of port 0 considering offsets that stubs might do
     unsigned int j2;
     double Cd, Z[4], R[4], G, Is, Zhat, tau[4];
 
@@ -1172,8 +1653,7 @@ unsigned int MaterialTetrahedronPennesEigen(struct dataForSimulation *input, str
     // version was not implemented yet.   
     // element code 4: 4 nodes tetrahedron. Used only for medium only. The boundary
     // condition version was not implemented yet
-    double *tempVar = NULL;
-    tempVar = (double *) realloc(tempVar, sizeof (double)*12);
+    double tempVar[12];
     // 0 - length of port 1 (from center of tetrahedron to center of area 1)
     // 1 - length of port 2 (from center of tetrahedron to center of area 2)
     // 2 - length of port 3 (from center of tetrahedron to center of area 3)
@@ -1186,162 +1666,161 @@ unsigned int MaterialTetrahedronPennesEigen(struct dataForSimulation *input, str
     // 9 - tetrahedron's center x
     // 10 - tetrahedron's center y
     // 11 - tetrahedron's center z
+    // the elements are independent. Each thread saves the entries of M and tau
+    // in its own list, and the lists become M and tau in tlmAssembleElementsEigen
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(static) num_threads(input->simulationInput.nOpenMPcores) \
+        private(numbersNodeAndPort, j2, Cd, Z, R, G, Is, Zhat, tau, tempVar)
+#endif
     for (unsigned long long i = 0; i < input->mesh.quantityOfSpecificElement[4]; i++) {
+        std::vector< Triplet<double, long long> > &tripletsM = matrices->tripletsM[tlmThreadEigen()];
+        std::vector< Triplet<double, long long> > &tripletsTau = matrices->tripletsTau[tlmThreadEigen()];
+
         // i: element level
-        // j: material (of equation id) type level
-        // k: different tag numbers for the same material type
-        // j2: the material number from equation. Used to reduce the access to input->equationInput[id].materialNumbers[j]
-        for (unsigned int j = 0; j < input->equationInput[id].numberOfMaterials; j++)
-            for (unsigned int k = 0; k < input->materialInput[ input->equationInput[id].materialNumbers[j] ].quantityOfNumberInput; k++)
-                if (input->mesh.elements.Tetrahedron[i].tag == input->materialInput[ input->equationInput[id].materialNumbers[j] ].numberInput[k]) {
-                    j2 = input->equationInput[id].materialNumbers[j];
-                    // I will use goto to get out of these two inner 'for' loops. Bare in mind
-                    // that I'm just getting out the loops. You can also think that 
-                    // I'm going to the next 'i', that is, incrementing i by 1 and going
-                    // to the next value of i (if any).
-                    getRealNodeAndPort_fromAbstractNode(4, // element code
-                            i, // element number
-                            matrices->numbers.abstractPortsToReal,
-                            numbersNodeAndPort);
-
-                    // the -1 is necessary because the C indexing starts at zero
-                    // and my number of node starts at 1
-                    getGeometricalVariablesTLMtetrahedron(&input->mesh.nodes[input->mesh.elements.Tetrahedron[i].N1 - 1],
-                            &input->mesh.nodes[input->mesh.elements.Tetrahedron[i].N2 - 1],
-                            &input->mesh.nodes[input->mesh.elements.Tetrahedron[i].N3 - 1],
-                            &input->mesh.nodes[input->mesh.elements.Tetrahedron[i].N4 - 1], tempVar);
-
-                    matrices->L[numbersNodeAndPort[1] + 0] = tempVar[4]; // area of face 1
-                    matrices->L[numbersNodeAndPort[1] + 1] = tempVar[5]; // area of face 2
-                    matrices->L[numbersNodeAndPort[1] + 2] = tempVar[6]; // area of face 3
-                    matrices->L[numbersNodeAndPort[1] + 3] = tempVar[7]; // area of face 4
-
-                    matrices->deltal[numbersNodeAndPort[1] + 0] = tempVar[0]; // length of port 1
-                    matrices->deltal[numbersNodeAndPort[1] + 1] = tempVar[1]; // length of port 2
-                    matrices->deltal[numbersNodeAndPort[1] + 2] = tempVar[2]; // length of port 3
-                    matrices->deltal[numbersNodeAndPort[1] + 3] = tempVar[3]; // length of port 4
-
-                    // generalization of Cd
-                    Cd = tempVar[8] * input->materialInput[j2].generalized_coefficient_b /
-                            (tempVar[0] + tempVar[1] + tempVar[2] + tempVar[3]);
-
-                    // generalization of R
-                    R[0] = tempVar[0] / (input->materialInput[j2].generalized_diffusionCoeff * tempVar[4]);
-                    R[1] = tempVar[1] / (input->materialInput[j2].generalized_diffusionCoeff * tempVar[5]);
-                    R[2] = tempVar[2] / (input->materialInput[j2].generalized_diffusionCoeff * tempVar[6]);
-                    R[3] = tempVar[3] / (input->materialInput[j2].generalized_diffusionCoeff * tempVar[7]);
-
-                    // generalization of G
-                    G = tempVar[8] * input->materialInput[j2].generalized_sink_a;
-
-                    // generalization of Is
-                    Is = tempVar[8] * input->materialInput[j2].generalized_source;
-
-                    // Z = dt/(2*C*deltal).
-                    Z[0] = input->equationInput[id].timeStep / (2 * Cd);
-                    Z[1] = Z[0] / tempVar[1];
-                    Z[2] = Z[0] / tempVar[2];
-                    Z[3] = Z[0] / tempVar[3];
-                    Z[0] = Z[0] / tempVar[0];
-
-                    // all the impedances
-                    matrices->Z[numbersNodeAndPort[1] + 0] = Z[0];
-                    matrices->Z[numbersNodeAndPort[1] + 1] = Z[1];
-                    matrices->Z[numbersNodeAndPort[1] + 2] = Z[2];
-                    matrices->Z[numbersNodeAndPort[1] + 3] = Z[3];
-
-                    // all the resistances
-                    matrices->R[numbersNodeAndPort[1] + 0] = R[0];
-                    matrices->R[numbersNodeAndPort[1] + 1] = R[1];
-                    matrices->R[numbersNodeAndPort[1] + 2] = R[2];
-                    matrices->R[numbersNodeAndPort[1] + 3] = R[3];
-
-
-                    // Manually validated
-                    Zhat = 1 / (1 / Z[0] + 1 / Z[1] + 1 / Z[2] + 1 / Z[3] + G);
-
-                    // Manually validated
-                    tau[0] = 2 * Zhat / Z[0];
-                    tau[1] = 2 * Zhat / Z[1];
-                    tau[2] = 2 * Zhat / Z[2];
-                    tau[3] = 2 * Zhat / Z[3];
-
-                    // this is actually matrix S.
-                    // M = C*S
-                    // this matrix is M[line][column].
-                    matrices->M.insert(numbersNodeAndPort[1] + 0,
-                            numbersNodeAndPort[1] + 0) = tau[0] - 1;
-                    matrices->M.insert(numbersNodeAndPort[1] + 0,
-                            numbersNodeAndPort[1] + 1) = tau[1];
-                    matrices->M.insert(numbersNodeAndPort[1] + 0,
-                            numbersNodeAndPort[1] + 2) = tau[2];
-                    matrices->M.insert(numbersNodeAndPort[1] + 0,
-                            numbersNodeAndPort[1] + 3) = tau[3];
-
-                    matrices->M.insert(numbersNodeAndPort[1] + 1,
-                            numbersNodeAndPort[1] + 0) = tau[0];
-                    matrices->M.insert(numbersNodeAndPort[1] + 1,
-                            numbersNodeAndPort[1] + 1) = tau[1] - 1;
-                    matrices->M.insert(numbersNodeAndPort[1] + 1,
-                            numbersNodeAndPort[1] + 2) = tau[2];
-                    matrices->M.insert(numbersNodeAndPort[1] + 1,
-                            numbersNodeAndPort[1] + 3) = tau[3];
-
-                    matrices->M.insert(numbersNodeAndPort[1] + 2,
-                            numbersNodeAndPort[1] + 0) = tau[0];
-                    matrices->M.insert(numbersNodeAndPort[1] + 2,
-                            numbersNodeAndPort[1] + 1) = tau[1];
-                    matrices->M.insert(numbersNodeAndPort[1] + 2,
-                            numbersNodeAndPort[1] + 2) = tau[2] - 1;
-                    matrices->M.insert(numbersNodeAndPort[1] + 2,
-                            numbersNodeAndPort[1] + 3) = tau[3];
-
-                    matrices->M.insert(numbersNodeAndPort[1] + 3,
-                            numbersNodeAndPort[1] + 0) = tau[0];
-                    matrices->M.insert(numbersNodeAndPort[1] + 3,
-                            numbersNodeAndPort[1] + 1) = tau[1];
-                    matrices->M.insert(numbersNodeAndPort[1] + 3,
-                            numbersNodeAndPort[1] + 2) = tau[2];
-                    matrices->M.insert(numbersNodeAndPort[1] + 3,
-                            numbersNodeAndPort[1] + 3) = tau[3] - 1;
-
-                    // matrix tau
-                    matrices->tau.insert(numbersNodeAndPort[0],
-                            numbersNodeAndPort[1] + 0) = tau[0];
-                    matrices->tau.insert(numbersNodeAndPort[0],
-                            numbersNodeAndPort[1] + 1) = tau[1];
-                    matrices->tau.insert(numbersNodeAndPort[0],
-                            numbersNodeAndPort[1] + 2) = tau[2];
-                    matrices->tau.insert(numbersNodeAndPort[0],
-                            numbersNodeAndPort[1] + 3) = tau[3];
-
-                    // this is actually matrix ZIS.
-                    // E = C*ZIS + B
-                    matrices->E(numbersNodeAndPort[1] + 0) = Zhat*Is;
-                    matrices->E(numbersNodeAndPort[1] + 1) = Zhat*Is;
-                    matrices->E(numbersNodeAndPort[1] + 2) = Zhat*Is;
-                    matrices->E(numbersNodeAndPort[1] + 3) = Zhat*Is;
-
-                    // matrix E_output
-                    matrices->E_output(numbersNodeAndPort[0]) = Zhat*Is;
-
-                    // the center of the tetrahedron
-                    matrices->Points_output[numbersNodeAndPort[0]].x = tempVar[9];
-                    matrices->Points_output[numbersNodeAndPort[0]].y = tempVar[10];
-                    matrices->Points_output[numbersNodeAndPort[0]].z = tempVar[11];
-
-                    // Vi0 = (Ti - ZIS)/sum(tau)
-                    // generalization of the initial value
-                    matrices->Vi(numbersNodeAndPort[1]) = (input->materialInput[j2].generalized_initialScalar
-                            - matrices->E(numbersNodeAndPort[1])) / (tau[0] + tau[1] + tau[2] + tau[3]);
-                    matrices->Vi(numbersNodeAndPort[1] + 1) = matrices->Vi(numbersNodeAndPort[1]);
-                    matrices->Vi(numbersNodeAndPort[1] + 2) = matrices->Vi(numbersNodeAndPort[1]);
-                    matrices->Vi(numbersNodeAndPort[1] + 3) = matrices->Vi(numbersNodeAndPort[1]);
-
-                    goto end_for_j_and_for_k_tetrahedron;
-                }
-end_for_j_and_for_k_tetrahedron:
-        ;
+        // j2: the material of the element, from the table of tags of the equation
+        if (getTagTLMnumbers(&(matrices->numbers), input->mesh.elements.Tetrahedron[i].tag, &j2) == 2) {
+            getRealNodeAndPort_fromAbstractNode(4, // element code
+                    i, // element number
+                    matrices->numbers.abstractPortsToReal,
+                    numbersNodeAndPort);
+
+            // the -1 is necessary because the C indexing starts at zero
+            // and my number of node starts at 1
+            getGeometricalVariablesTLMtetrahedron(&input->mesh.nodes[input->mesh.elements.Tetrahedron[i].N1 - 1],
+                    &input->mesh.nodes[input->mesh.elements.Tetrahedron[i].N2 - 1],
+                    &input->mesh.nodes[input->mesh.elements.Tetrahedron[i].N3 - 1],
+                    &input->mesh.nodes[input->mesh.elements.Tetrahedron[i].N4 - 1], tempVar);
+
+            matrices->L[numbersNodeAndPort[1] + 0] = tempVar[4]; // area of face 1
+            matrices->L[numbersNodeAndPort[1] + 1] = tempVar[5]; // area of face 2
+            matrices->L[numbersNodeAndPort[1] + 2] = tempVar[6]; // area of face 3
+            matrices->L[numbersNodeAndPort[1] + 3] = tempVar[7]; // area of face 4
+
+            matrices->deltal[numbersNodeAndPort[1] + 0] = tempVar[0]; // length of port 1
+            matrices->deltal[numbersNodeAndPort[1] + 1] = tempVar[1]; // length of port 2
+            matrices->deltal[numbersNodeAndPort[1] + 2] = tempVar[2]; // length of port 3
+            matrices->deltal[numbersNodeAndPort[1] + 3] = tempVar[3]; // length of port 4
+
+            // generalization of Cd
+            Cd = tempVar[8] * input->materialInput[j2].generalized_coefficient_b /
+                    (tempVar[0] + tempVar[1] + tempVar[2] + tempVar[3]);
+
+            // generalization of R
+            R[0] = tempVar[0] / (input->materialInput[j2].generalized_diffusionCoeff * tempVar[4]);
+            R[1] = tempVar[1] / (input->materialInput[j2].generalized_diffusionCoeff * tempVar[5]);
+            R[2] = tempVar[2] / (input->materialInput[j2].generalized_diffusionCoeff * tempVar[6]);
+            R[3] = tempVar[3] / (input->materialInput[j2].generalized_diffusionCoeff * tempVar[7]);
+
+            // generalization of G
+            G = tempVar[8] * input->materialInput[j2].generalized_sink_a;
+
+            // generalization of Is
+            Is = tempVar[8] * input->materialInput[j2].generalized_source;
+
+            // Z = dt/(2*C*deltal).
+            Z[0] = input->equationInput[id].timeStep / (2 * Cd);
+            Z[1] = Z[0] / tempVar[1];
+            Z[2] = Z[0] / tempVar[2];
+            Z[3] = Z[0] / tempVar[3];
+            Z[0] = Z[0] / tempVar[0];
+
+            // all the impedances
+            matrices->Z[numbersNodeAndPort[1] + 0] = Z[0];
+            matrices->Z[numbersNodeAndPort[1] + 1] = Z[1];
+            matrices->Z[numbersNodeAndPort[1] + 2] = Z[2];
+            matrices->Z[numbersNodeAndPort[1] + 3] = Z[3];
+
+            // all the resistances
+            matrices->R[numbersNodeAndPort[1] + 0] = R[0];
+            matrices->R[numbersNodeAndPort[1] + 1] = R[1];
+            matrices->R[numbersNodeAndPort[1] + 2] = R[2];
+            matrices->R[numbersNodeAndPort[1] + 3] = R[3];
+
+
+            // Manually validated
+            Zhat = 1 / (1 / Z[0] + 1 / Z[1] + 1 / Z[2] + 1 / Z[3] + G);
+
+            // Manually validated
+            tau[0] = 2 * Zhat / Z[0];
+            tau[1] = 2 * Zhat / Z[1];
+            tau[2] = 2 * Zhat / Z[2];
+            tau[3] = 2 * Zhat / Z[3];
+
+            // this is actually matrix S.
+            // M = C*S
+            // this matrix is M[line][column].
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 0,
+                    numbersNodeAndPort[1] + 0, tau[0] - 1);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 0,
+                    numbersNodeAndPort[1] + 1, tau[1]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 0,
+                    numbersNodeAndPort[1] + 2, tau[2]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 0,
+                    numbersNodeAndPort[1] + 3, tau[3]);
+
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 1,
+                    numbersNodeAndPort[1] + 0, tau[0]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 1,
+                    numbersNodeAndPort[1] + 1, tau[1] - 1);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 1,
+                    numbersNodeAndPort[1] + 2, tau[2]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 1,
+                    numbersNodeAndPort[1] + 3, tau[3]);
+
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 2,
+                    numbersNodeAndPort[1] + 0, tau[0]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 2,
+                    numbersNodeAndPort[1] + 1, tau[1]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 2,
+                    numbersNodeAndPort[1] + 2, tau[2] - 1);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 2,
+                    numbersNodeAndPort[1] + 3, tau[3]);
+
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 3,
+                    numbersNodeAndPort[1] + 0, tau[0]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 3,
+                    numbersNodeAndPort[1] + 1, tau[1]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 3,
+                    numbersNodeAndPort[1] + 2, tau[2]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 3,
+                    numbersNodeAndPort[1] + 3, tau[3] - 1);
+
+            // matrix tau
+            tripletsTau.emplace_back(numbersNodeAndPort[0],
+                    numbersNodeAndPort[1] + 0, tau[0]);
+            tripletsTau.emplace_back(numbersNodeAndPort[0],
+                    numbersNodeAndPort[1] + 1, tau[1]);
+            tripletsTau.emplace_back(numbersNodeAndPort[0],
+                    numbersNodeAndPort[1] + 2, tau[2]);
+            tripletsTau.emplace_back(numbersNodeAndPort[0],
+                    numbersNodeAndPort[1] + 3, tau[3]);
+
+            // this is actually matrix ZIS.
+            // E = C*ZIS + B
+            matrices->E(numbersNodeAndPort[1] + 0) = Zhat*Is;
+            matrices->E(numbersNodeAndPort[1] + 1) = Zhat*Is;
+            matrices->E(numbersNodeAndPort[1] + 2) = Zhat*Is;
+            matrices->E(numbersNodeAndPort[1] + 3) = Zhat*Is;
+
+            // matrix E_output
+            matrices->E_output(numbersNodeAndPort[0]) = Zhat*Is;
+
+            // the volume of the node, used by the statistics
+            matrices->volume[numbersNodeAndPort[0]] = tempVar[8];
+
+            // the center of the tetrahedron
+            matrices->Points_output[numbersNodeAndPort[0]].x = tempVar[9];
+            matrices->Points_output[numbersNodeAndPort[0]].y = tempVar[10];
+            matrices->Points_output[numbersNodeAndPort[0]].z = tempVar[11];
+
+            // Vi0 = (Ti - ZIS)/sum(tau)
+            // generalization of the initial value
+            matrices->Vi(numbersNodeAndPort[1]) = (input->materialInput[j2].generalized_initialScalar
+                    - matrices->E(numbersNodeAndPort[1])) / (tau[0] + tau[1] + tau[2] + tau[3]);
+            matrices->Vi(numbersNodeAndPort[1] + 1) = matrices->Vi(numbersNodeAndPort[1]);
+            matrices->Vi(numbersNodeAndPort[1] + 2) = matrices->Vi(numbersNodeAndPort[1]);
+            matrices->Vi(numbersNodeAndPort[1] + 3) = matrices->Vi(numbersNodeAndPort[1]);
+        }
     }
     return 0;
 }
@@ -1353,9 +1832,10 @@ end_for_j_and_for_k_tetrahedron:
  */
 unsigned int MaterialHexahedronPennesEigen(struct dataForSimulation *input, struct calculationTLMEigen *matrices, int id) {
     unsigned int errorTLMnumber;
-    unsigned long long numbersNodeAndPort[] = {0, 0};
+    unsigned long long numbersNodeAndPort[] = {0, 0, 0};
     // 0 - number of node
     // 1 - number of port 0
+    // 2 - number of port 0 considering offsets that stubs might do
     unsigned int j2;
     double Cd, Z[6], R[6], G, Is, Zhat, tau[6];
 
@@ -1393,8 +1873,7 @@ unsigned int MaterialHexahedronPennesEigen(struct dataForSimulation *input, stru
     // version was not implemented yet.   
     // element code 5: 8 nodes hexahedron. Used only for medium only. The boundary
     // condition version was not implemented yet
-    double *tempVar = NULL;
-    tempVar = (double *) realloc(tempVar, sizeof (double)*16);
+    double tempVar[16];
     // 0 - length of port 1 (from center of tetrahedron to center of area 1)
     // 1 - length of port 2 (from center of tetrahedron to center of area 2)
     // 2 - length of port 3 (from center of tetrahedron to center of area 3)
@@ -1411,233 +1890,232 @@ unsigned int MaterialHexahedronPennesEigen(struct dataForSimulation *input, stru
     // 13 - hexahedron's center x
     // 14 - hexahedron's center y
     // 15 - hexahedron's center z
+    // the elements are independent. Each thread saves the entries of M and tau
+    // in its own list, and the lists become M and tau in tlmAssembleElementsEigen
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(static) num_threads(input->simulationInput.nOpenMPcores) \
+        private(numbersNodeAndPort, j2, Cd, Z, R, G, Is, Zhat, tau, tempVar)
+#endif
     for (unsigned long long i = 0; i < input->mesh.quantityOfSpecificElement[5]; i++) {
+        std::vector< Triplet<double, long long> > &tripletsM = matrices->tripletsM[tlmThreadEigen()];
+        std::vector< Triplet<double, long long> > &tripletsTau = matrices->tripletsTau[tlmThreadEigen()];
+
         // i: element level
-        // j: material (of equation id) type level
-        // k: different tag numbers for the same material type
-        // j2: the material number from equation. Used to reduce the access to input->equationInput[id].materialNumbers[j]
-        for (unsigned int j = 0; j < input->equationInput[id].numberOfMaterials; j++)
-            for (unsigned int k = 0; k < input->materialInput[ input->equationInput[id].materialNumbers[j] ].quantityOfNumberInput; k++)
-                if (input->mesh.elements.Hexahedron[i].tag == input->materialInput[ input->equationInput[id].materialNumbers[j] ].numberInput[k]) {
-                    j2 = input->equationInput[id].materialNumbers[j];
-                    // I will use goto to get out of these two inner 'for' loops. Bare in mind
-                    // that I'm just getting out the loops. You can also think that 
-                    // I'm going to the next 'i', that is, incrementing i by 1 and going
-                    // to the next value of i (if any).
-                    getRealNodeAndPort_fromAbstractNode(5, // element code
-                            i, // element number
-                            matrices->numbers.abstractPortsToReal,
-                            numbersNodeAndPort);
-
-                    // the -1 is necessary because the C indexing starts at zero
-                    // and my number of node starts at 1
-                    getGeometricalVariablesTLMhexahedron(&input->mesh.nodes[input->mesh.elements.Hexahedron[i].N1 - 1],
-                            &input->mesh.nodes[input->mesh.elements.Hexahedron[i].N2 - 1],
-                            &input->mesh.nodes[input->mesh.elements.Hexahedron[i].N3 - 1],
-                            &input->mesh.nodes[input->mesh.elements.Hexahedron[i].N4 - 1],
-                            &input->mesh.nodes[input->mesh.elements.Hexahedron[i].N5 - 1],
-                            &input->mesh.nodes[input->mesh.elements.Hexahedron[i].N6 - 1],
-                            &input->mesh.nodes[input->mesh.elements.Hexahedron[i].N7 - 1],
-                            &input->mesh.nodes[input->mesh.elements.Hexahedron[i].N8 - 1], tempVar);
-
-                    matrices->L[numbersNodeAndPort[1] + 0] = tempVar[6]; // area of face 1
-                    matrices->L[numbersNodeAndPort[1] + 1] = tempVar[7]; // area of face 2
-                    matrices->L[numbersNodeAndPort[1] + 2] = tempVar[8]; // area of face 3
-                    matrices->L[numbersNodeAndPort[1] + 3] = tempVar[9]; // area of face 4
-                    matrices->L[numbersNodeAndPort[1] + 4] = tempVar[10]; // area of face 5
-                    matrices->L[numbersNodeAndPort[1] + 5] = tempVar[11]; // area of face 6
-
-                    matrices->deltal[numbersNodeAndPort[1] + 0] = tempVar[0]; // length of port 1
-                    matrices->deltal[numbersNodeAndPort[1] + 1] = tempVar[1]; // length of port 2
-                    matrices->deltal[numbersNodeAndPort[1] + 2] = tempVar[2]; // length of port 3
-                    matrices->deltal[numbersNodeAndPort[1] + 3] = tempVar[3]; // length of port 4
-                    matrices->deltal[numbersNodeAndPort[1] + 4] = tempVar[4]; // length of port 5
-                    matrices->deltal[numbersNodeAndPort[1] + 5] = tempVar[5]; // length of port 6
-
-                    // generalization of Cd
-                    Cd = tempVar[12] * input->materialInput[j2].generalized_coefficient_b /
-                            (tempVar[0] + tempVar[1] + tempVar[2] + tempVar[3] + tempVar[4] + tempVar[5]);
-                    
-                    // debugging volume calculation:
-                    // fprintf(stderr, "%.17g\n", tempVar[12]);
-
-                    // generalization of R
-                    R[0] = tempVar[0] / (input->materialInput[j2].generalized_diffusionCoeff * tempVar[6]);
-                    R[1] = tempVar[1] / (input->materialInput[j2].generalized_diffusionCoeff * tempVar[7]);
-                    R[2] = tempVar[2] / (input->materialInput[j2].generalized_diffusionCoeff * tempVar[8]);
-                    R[3] = tempVar[3] / (input->materialInput[j2].generalized_diffusionCoeff * tempVar[9]);
-                    R[4] = tempVar[4] / (input->materialInput[j2].generalized_diffusionCoeff * tempVar[10]);
-                    R[5] = tempVar[5] / (input->materialInput[j2].generalized_diffusionCoeff * tempVar[11]);
-
-                    // generalization of G
-                    G = tempVar[12] * input->materialInput[j2].generalized_sink_a;
-
-                    // generalization of Is
-                    Is = tempVar[12] * input->materialInput[j2].generalized_source;
-
-                    // Z = dt/(2*C*deltal).
-                    Z[0] = input->equationInput[id].timeStep / (2 * Cd);
-                    Z[1] = Z[0] / tempVar[1];
-                    Z[2] = Z[0] / tempVar[2];
-                    Z[3] = Z[0] / tempVar[3];
-                    Z[4] = Z[0] / tempVar[4];
-                    Z[5] = Z[0] / tempVar[5];
-                    Z[0] = Z[0] / tempVar[0];
-
-                    // all the impedances
-                    matrices->Z[numbersNodeAndPort[1] + 0] = Z[0];
-                    matrices->Z[numbersNodeAndPort[1] + 1] = Z[1];
-                    matrices->Z[numbersNodeAndPort[1] + 2] = Z[2];
-                    matrices->Z[numbersNodeAndPort[1] + 3] = Z[3];
-                    matrices->Z[numbersNodeAndPort[1] + 4] = Z[4];
-                    matrices->Z[numbersNodeAndPort[1] + 5] = Z[5];
-
-                    // all the resistances
-                    matrices->R[numbersNodeAndPort[1] + 0] = R[0];
-                    matrices->R[numbersNodeAndPort[1] + 1] = R[1];
-                    matrices->R[numbersNodeAndPort[1] + 2] = R[2];
-                    matrices->R[numbersNodeAndPort[1] + 3] = R[3];
-                    matrices->R[numbersNodeAndPort[1] + 4] = R[4];
-                    matrices->R[numbersNodeAndPort[1] + 5] = R[5];
-
-
-                    // impedance
-                    Zhat = 1 / (1 / Z[0] + 1 / Z[1] + 1 / Z[2] + 1 / Z[3] + 1 / Z[4] + 1 / Z[5] + G);
-
-                    // Manually validated
-                    tau[0] = 2 * Zhat / Z[0];
-                    tau[1] = 2 * Zhat / Z[1];
-                    tau[2] = 2 * Zhat / Z[2];
-                    tau[3] = 2 * Zhat / Z[3];
-                    tau[4] = 2 * Zhat / Z[4];
-                    tau[5] = 2 * Zhat / Z[5];
-
-                    // this is actually matrix S.
-                    // M = C*S
-                    // this matrix is M[line][column].
-                    matrices->M.insert(numbersNodeAndPort[1] + 0,
-                            numbersNodeAndPort[1] + 0) = tau[0] - 1;
-                    matrices->M.insert(numbersNodeAndPort[1] + 0,
-                            numbersNodeAndPort[1] + 1) = tau[1];
-                    matrices->M.insert(numbersNodeAndPort[1] + 0,
-                            numbersNodeAndPort[1] + 2) = tau[2];
-                    matrices->M.insert(numbersNodeAndPort[1] + 0,
-                            numbersNodeAndPort[1] + 3) = tau[3];
-                    matrices->M.insert(numbersNodeAndPort[1] + 0,
-                            numbersNodeAndPort[1] + 4) = tau[4];
-                    matrices->M.insert(numbersNodeAndPort[1] + 0,
-                            numbersNodeAndPort[1] + 5) = tau[5];
-
-                    matrices->M.insert(numbersNodeAndPort[1] + 1,
-                            numbersNodeAndPort[1] + 0) = tau[0];
-                    matrices->M.insert(numbersNodeAndPort[1] + 1,
-                            numbersNodeAndPort[1] + 1) = tau[1] - 1;
-                    matrices->M.insert(numbersNodeAndPort[1] + 1,
-                            numbersNodeAndPort[1] + 2) = tau[2];
-                    matrices->M.insert(numbersNodeAndPort[1] + 1,
-                            numbersNodeAndPort[1] + 3) = tau[3];
-                    matrices->M.insert(numbersNodeAndPort[1] + 1,
-                            numbersNodeAndPort[1] + 4) = tau[4];
-                    matrices->M.insert(numbersNodeAndPort[1] + 1,
-                            numbersNodeAndPort[1] + 5) = tau[5];
-
-                    matrices->M.insert(numbersNodeAndPort[1] + 2,
-                            numbersNodeAndPort[1] + 0) = tau[0];
-                    matrices->M.insert(numbersNodeAndPort[1] + 2,
-                            numbersNodeAndPort[1] + 1) = tau[1];
-                    matrices->M.insert(numbersNodeAndPort[1] + 2,
-                            numbersNodeAndPort[1] + 2) = tau[2] - 1;
-                    matrices->M.insert(numbersNodeAndPort[1] + 2,
-                            numbersNodeAndPort[1] + 3) = tau[3];
-                    matrices->M.insert(numbersNodeAndPort[1] + 2,
-                            numbersNodeAndPort[1] + 4) = tau[4];
-                    matrices->M.insert(numbersNodeAndPort[1] + 2,
-                            numbersNodeAndPort[1] + 5) = tau[5];
-
-                    matrices->M.insert(numbersNodeAndPort[1] + 3,
-                            numbersNodeAndPort[1] + 0) = tau[0];
-                    matrices->M.insert(numbersNodeAndPort[1] + 3,
-                            numbersNodeAndPort[1] + 1) = tau[1];
-                    matrices->M.insert(numbersNodeAndPort[1] + 3,
-                            numbersNodeAndPort[1] + 2) = tau[2];
-                    matrices->M.insert(numbersNodeAndPort[1] + 3,
-                            numbersNodeAndPort[1] + 3) = tau[3] - 1;
-                    matrices->M.insert(numbersNodeAndPort[1] + 3,
-                            numbersNodeAndPort[1] + 4) = tau[4];
-                    matrices->M.insert(numbersNodeAndPort[1] + 3,
-                            numbersNodeAndPort[1] + 5) = tau[5];
-
-                    matrices->M.insert(numbersNodeAndPort[1] + 4,
-                            numbersNodeAndPort[1] + 0) = tau[0];
-                    matrices->M.insert(numbersNodeAndPort[1] + 4,
-                            numbersNodeAndPort[1] + 1) = tau[1];
-                    matrices->M.insert(numbersNodeAndPort[1] + 4,
-                            numbersNodeAndPort[1] + 2) = tau[2];
-                    matrices->M.insert(numbersNodeAndPort[1] + 4,
-                            numbersNodeAndPort[1] + 3) = tau[3];
-                    matrices->M.insert(numbersNodeAndPort[1] + 4,
-                            numbersNodeAndPort[1] + 4) = tau[4] - 1;
-                    matrices->M.insert(numbersNodeAndPort[1] + 4,
-                            numbersNodeAndPort[1] + 5) = tau[5];
-
-                    matrices->M.insert(numbersNodeAndPort[1] + 5,
-                            numbersNodeAndPort[1] + 0) = tau[0];
-                    matrices->M.insert(numbersNodeAndPort[1] + 5,
-                            numbersNodeAndPort[1] + 1) = tau[1];
-                    matrices->M.insert(numbersNodeAndPort[1] + 5,
-                            numbersNodeAndPort[1] + 2) = tau[2];
-                    matrices->M.insert(numbersNodeAndPort[1] + 5,
-                            numbersNodeAndPort[1] + 3) = tau[3];
-                    matrices->M.insert(numbersNodeAndPort[1] + 5,
-                            numbersNodeAndPort[1] + 4) = tau[4];
-                    matrices->M.insert(numbersNodeAndPort[1] + 5,
-                            numbersNodeAndPort[1] + 5) = tau[5] - 1;
-
-                    // matrix tau
-                    matrices->tau.insert(numbersNodeAndPort[0],
-                            numbersNodeAndPort[1] + 0) = tau[0];
-                    matrices->tau.insert(numbersNodeAndPort[0],
-                            numbersNodeAndPort[1] + 1) = tau[1];
-                    matrices->tau.insert(numbersNodeAndPort[0],
-                            numbersNodeAndPort[1] + 2) = tau[2];
-                    matrices->tau.insert(numbersNodeAndPort[0],
-                            numbersNodeAndPort[1] + 3) = tau[3];
-                    matrices->tau.insert(numbersNodeAndPort[0],
-                            numbersNodeAndPort[1] + 4) = tau[4];
-                    matrices->tau.insert(numbersNodeAndPort[0],
-                            numbersNodeAndPort[1] + 5) = tau[5];
-
-                    // this is actually matrix ZIS.
-                    // E = C*ZIS + B
-                    matrices->E(numbersNodeAndPort[1] + 0) = Zhat*Is;
-                    matrices->E(numbersNodeAndPort[1] + 1) = Zhat*Is;
-                    matrices->E(numbersNodeAndPort[1] + 2) = Zhat*Is;
-                    matrices->E(numbersNodeAndPort[1] + 3) = Zhat*Is;
-                    matrices->E(numbersNodeAndPort[1] + 4) = Zhat*Is;
-                    matrices->E(numbersNodeAndPort[1] + 5) = Zhat*Is;
-
-                    // matrix E_output
-                    matrices->E_output(numbersNodeAndPort[0]) = Zhat*Is;
-
-                    // the center of the tetrahedron
-                    matrices->Points_output[numbersNodeAndPort[0]].x = tempVar[13];
-                    matrices->Points_output[numbersNodeAndPort[0]].y = tempVar[14];
-                    matrices->Points_output[numbersNodeAndPort[0]].z = tempVar[15];
-
-                    // Vi0 = (Ti - ZIS)/sum(tau)
-                    // generalization of the initial value
-                    matrices->Vi(numbersNodeAndPort[1]) = (input->materialInput[j2].generalized_initialScalar
-                            - matrices->E(numbersNodeAndPort[1])) / (tau[0] + tau[1] + tau[2] + tau[3] + tau[4] + tau[5]);
-                    matrices->Vi(numbersNodeAndPort[1] + 1) = matrices->Vi(numbersNodeAndPort[1]);
-                    matrices->Vi(numbersNodeAndPort[1] + 2) = matrices->Vi(numbersNodeAndPort[1]);
-                    matrices->Vi(numbersNodeAndPort[1] + 3) = matrices->Vi(numbersNodeAndPort[1]);
-                    matrices->Vi(numbersNodeAndPort[1] + 4) = matrices->Vi(numbersNodeAndPort[1]);
-                    matrices->Vi(numbersNodeAndPort[1] + 5) = matrices->Vi(numbersNodeAndPort[1]);
-
-                    goto end_for_j_and_for_k_hexadron;
-                }
-end_for_j_and_for_k_hexadron:
-        ;
+        // j2: the material of the element, from the table of tags of the equation
+        if (getTagTLMnumbers(&(matrices->numbers), input->mesh.elements.Hexahedron[i].tag, &j2) == 2) {
+            getRealNodeAndPort_fromAbstractNode(5, // element code
+                    i, // element number
+                    matrices->numbers.abstractPortsToReal,
+                    numbersNodeAndPort);
+
+            // the -1 is necessary because the C indexing starts at zero
+            // and my number of node starts at 1
+            getGeometricalVariablesTLMhexahedron(&input->mesh.nodes[input->mesh.elements.Hexahedron[i].N1 - 1],
+                    &input->mesh.nodes[input->mesh.elements.Hexahedron[i].N2 - 1],
+                    &input->mesh.nodes[input->mesh.elements.Hexahedron[i].N3 - 1],
+                    &input->mesh.nodes[input->mesh.elements.Hexahedron[i].N4 - 1],
+                    &input->mesh.nodes[input->mesh.elements.Hexahedron[i].N5 - 1],
+                    &input->mesh.nodes[input->mesh.elements.Hexahedron[i].N6 - 1],
+                    &input->mesh.nodes[input->mesh.elements.Hexahedron[i].N7 - 1],
+                    &input->mesh.nodes[input->mesh.elements.Hexahedron[i].N8 - 1], tempVar);
+
+            matrices->L[numbersNodeAndPort[1] + 0] = tempVar[6]; // area of face 1
+            matrices->L[numbersNodeAndPort[1] + 1] = tempVar[7]; // area of face 2
+            matrices->L[numbersNodeAndPort[1] + 2] = tempVar[8]; // area of face 3
+            matrices->L[numbersNodeAndPort[1] + 3] = tempVar[9]; // area of face 4
+            matrices->L[numbersNodeAndPort[1] + 4] = tempVar[10]; // area of face 5
+            matrices->L[numbersNodeAndPort[1] + 5] = tempVar[11]; // area of face 6
+
+            matrices->deltal[numbersNodeAndPort[1] + 0] = tempVar[0]; // length of port 1
+            matrices->deltal[numbersNodeAndPort[1] + 1] = tempVar[1]; // length of port 2
+            matrices->deltal[numbersNodeAndPort[1] + 2] = tempVar[2]; // length of port 3
+            matrices->deltal[numbersNodeAndPort[1] + 3] = tempVar[3]; // length of port 4
+            matrices->deltal[numbersNodeAndPort[1] + 4] = tempVar[4]; // length of port 5
+            matrices->deltal[numbersNodeAndPort[1] + 5] = tempVar[5]; // length of port 6
+
+            // generalization of Cd
+            Cd = tempVar[12] * input->materialInput[j2].generalized_coefficient_b /
+                    (tempVar[0] + tempVar[1] + tempVar[2] + tempVar[3] + tempVar[4] + tempVar[5]);
+            
+            // debugging volume calculation:
+            // fprintf(stderr, "%.17g\n", tempVar[12]);
+
+            // generalization of R
+            R[0] = tempVar[0] / (input->materialInput[j2].generalized_diffusionCoeff * tempVar[6]);
+            R[1] = tempVar[1] / (input->materialInput[j2].generalized_diffusionCoeff * tempVar[7]);
+            R[2] = tempVar[2] / (input->materialInput[j2].generalized_diffusionCoeff * tempVar[8]);
+            R[3] = tempVar[3] / (input->materialInput[j2].generalized_diffusionCoeff * tempVar[9]);
+            R[4] = tempVar[4] / (input->materialInput[j2].generalized_diffusionCoeff * tempVar[10]);
+            R[5] = tempVar[5] / (input->materialInput[j2].generalized_diffusionCoeff * tempVar[11]);
+
+            // generalization of G
+            G = tempVar[12] * input->materialInput[j2].generalized_sink_a;
+
+            // generalization of Is
+            Is = tempVar[12] * input->materialInput[j2].generalized_source;
+
+            // Z = dt/(2*C*deltal).
+            Z[0] = input->equationInput[id].timeStep / (2 * Cd);
+            Z[1] = Z[0] / tempVar[1];
+            Z[2] = Z[0] / tempVar[2];
+            Z[3] = Z[0] / tempVar[3];
+            Z[4] = Z[0] / tempVar[4];
+            Z[5] = Z[0] / tempVar[5];
+            Z[0] = Z[0] / tempVar[0];
+
+            // all the impedances
+            matrices->Z[numbersNodeAndPort[1] + 0] = Z[0];
+            matrices->Z[numbersNodeAndPort[1] + 1] = Z[1];
+            matrices->Z[numbersNodeAndPort[1] + 2] = Z[2];
+            matrices->Z[numbersNodeAndPort[1] + 3] = Z[3];
+            matrices->Z[numbersNodeAndPort[1] + 4] = Z[4];
+            matrices->Z[numbersNodeAndPort[1] + 5] = Z[5];
+
+            // all the resistances
+            matrices->R[numbersNodeAndPort[1] + 0] = R[0];
+            matrices->R[numbersNodeAndPort[1] + 1] = R[1];
+            matrices->R[numbersNodeAndPort[1] + 2] = R[2];
+            matrices->R[numbersNodeAndPort[1] + 3] = R[3];
+            matrices->R[numbersNodeAndPort[1] + 4] = R[4];
+            matrices->R[numbersNodeAndPort[1] + 5] = R[5];
+
+
+            // impedance
+            Zhat = 1 / (1 / Z[0] + 1 / Z[1] + 1 / Z[2] + 1 / Z[3] + 1 / Z[4] + 1 / Z[5] + G);
+
+            // Manually validated
+            tau[0] = 2 * Zhat / Z[0];
+            tau[1] = 2 * Zhat / Z[1];
+            tau[2] = 2 * Zhat / Z[2];
+            tau[3] = 2 * Zhat / Z[3];
+            tau[4] = 2 * Zhat / Z[4];
+            tau[5] = 2 * Zhat / Z[5];
+
+            // this is actually matrix S.
+            // M = C*S
+            // this matrix is M[line][column].
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 0,
+                    numbersNodeAndPort[1] + 0, tau[0] - 1);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 0,
+                    numbersNodeAndPort[1] + 1, tau[1]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 0,
+                    numbersNodeAndPort[1] + 2, tau[2]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 0,
+                    numbersNodeAndPort[1] + 3, tau[3]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 0,
+                    numbersNodeAndPort[1] + 4, tau[4]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 0,
+                    numbersNodeAndPort[1] + 5, tau[5]);
+
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 1,
+                    numbersNodeAndPort[1] + 0, tau[0]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 1,
+                    numbersNodeAndPort[1] + 1, tau[1] - 1);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 1,
+                    numbersNodeAndPort[1] + 2, tau[2]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 1,
+                    numbersNodeAndPort[1] + 3, tau[3]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 1,
+                    numbersNodeAndPort[1] + 4, tau[4]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 1,
+                    numbersNodeAndPort[1] + 5, tau[5]);
+
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 2,
+                    numbersNodeAndPort[1] + 0, tau[0]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 2,
+                    numbersNodeAndPort[1] + 1, tau[1]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 2,
+                    numbersNodeAndPort[1] + 2, tau[2] - 1);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 2,
+                    numbersNodeAndPort[1] + 3, tau[3]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 2,
+                    numbersNodeAndPort[1] + 4, tau[4]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 2,
+                    numbersNodeAndPort[1] + 5, tau[5]);
+
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 3,
+                    numbersNodeAndPort[1] + 0, tau[0]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 3,
+                    numbersNodeAndPort[1] + 1, tau[1]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 3,
+                    numbersNodeAndPort[1] + 2, tau[2]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 3,
+                    numbersNodeAndPort[1] + 3, tau[3] - 1);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 3,
+                    numbersNodeAndPort[1] + 4, tau[4]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 3,
+                    numbersNodeAndPort[1] + 5, tau[5]);
+
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 4,
+                    numbersNodeAndPort[1] + 0, tau[0]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 4,
+                    numbersNodeAndPort[1] + 1, tau[1]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 4,
+                    numbersNodeAndPort[1] + 2, tau[2]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 4,
+                    numbersNodeAndPort[1] + 3, tau[3]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 4,
+                    numbersNodeAndPort[1] + 4, tau[4] - 1);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 4,
+                    numbersNodeAndPort[1] + 5, tau[5]);
+
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 5,
+                    numbersNodeAndPort[1] + 0, tau[0]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 5,
+                    numbersNodeAndPort[1] + 1, tau[1]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 5,
+                    numbersNodeAndPort[1] + 2, tau[2]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 5,
+                    numbersNodeAndPort[1] + 3, tau[3]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 5,
+                    numbersNodeAndPort[1] + 4, tau[4]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 5,
+                    numbersNodeAndPort[1] + 5, tau[5] - 1);
+
+            // matrix tau
+            tripletsTau.emplace_back(numbersNodeAndPort[0],
+                    numbersNodeAndPort[1] + 0, tau[0]);
+            tripletsTau.emplace_back(numbersNodeAndPort[0],
+                    numbersNodeAndPort[1] + 1, tau[1]);
+            tripletsTau.emplace_back(numbersNodeAndPort[0],
+                    numbersNodeAndPort[1] + 2, tau[2]);
+            tripletsTau.emplace_back(numbersNodeAndPort[0],
+                    numbersNodeAndPort[1] + 3, tau[3]);
+            tripletsTau.emplace_back(numbersNodeAndPort[0],
+                    numbersNodeAndPort[1] + 4, tau[4]);
+            tripletsTau.emplace_back(numbersNodeAndPort[0],
+                    numbersNodeAndPort[1] + 5, tau[5]);
+
+            // this is actually matrix ZIS.
+            // E = C*ZIS + B
+            matrices->E(numbersNodeAndPort[1] + 0) = Zhat*Is;
+            matrices->E(numbersNodeAndPort[1] + 1) = Zhat*Is;
+            matrices->E(numbersNodeAndPort[1] + 2) = Zhat*Is;
+            matrices->E(numbersNodeAndPort[1] + 3) = Zhat*Is;
+            matrices->E(numbersNodeAndPort[1] + 4) = Zhat*Is;
+            matrices->E(numbersNodeAndPort[1] + 5) = Zhat*Is;
+
+            // matrix E_output
+            matrices->E_output(numbersNodeAndPort[0]) = Zhat*Is;
+
+            // the volume of the node, used by the statistics
+            matrices->volume[numbersNodeAndPort[0]] = tempVar[12];
+
+            // the center of the tetrahedron
+            matrices->Points_output[numbersNodeAndPort[0]].x = tempVar[13];
+            matrices->Points_output[numbersNodeAndPort[0]].y = tempVar[14];
+            matrices->Points_output[numbersNodeAndPort[0]].z = tempVar[15];
+
+            // Vi0 = (Ti - ZIS)/sum(tau)
+            // generalization of the initial value
+            matrices->Vi(numbersNodeAndPort[1]) = (input->materialInput[j2].generalized_initialScalar
+                    - matrices->E(numbersNodeAndPort[1])) / (tau[0] + tau[1] + tau[2] + tau[3] + tau[4] + tau[5]);
+            matrices->Vi(numbersNodeAndPort[1] + 1) = matrices->Vi(numbersNodeAndPort[1]);
+            matrices->Vi(numbersNodeAndPort[1] + 2) = matrices->Vi(numbersNodeAndPort[1]);
+            matrices->Vi(numbersNodeAndPort[1] + 3) = matrices->Vi(numbersNodeAndPort[1]);
+            matrices->Vi(numbersNodeAndPort[1] + 4) = matrices->Vi(numbersNodeAndPort[1]);
+            matrices->Vi(numbersNodeAndPort[1] + 5) = matrices->Vi(numbersNodeAndPort[1]);
+        }
     }
     return 0;
 }
@@ -1649,9 +2127,10 @@ end_for_j_and_for_k_hexadron:
  */
 unsigned int MaterialPyramidPennesEigen(struct dataForSimulation *input, struct calculationTLMEigen *matrices, int id) {
     unsigned int errorTLMnumber;
-    unsigned long long numbersNodeAndPort[] = {0, 0};
+    unsigned long long numbersNodeAndPort[] = {0, 0, 0};
     // 0 - number of node
     // 1 - number of port 0
+    // 2 - number of port 0 considering offsets that stubs might do
     unsigned int j2;
     double Cd, Z[5], R[5], G, Is, Zhat, tau[5];
 
@@ -1676,8 +2155,7 @@ unsigned int MaterialPyramidPennesEigen(struct dataForSimulation *input, struct
     // version was not implemented yet.   
     // element code 7: 5 nodes pyramid. Used only for medium only. The boundary
     // condition version was not implemented yet
-    double *tempVar = NULL;
-    tempVar = (double *) realloc(tempVar, sizeof (double)*14);
+    double tempVar[14];
     // 0 - length of port 1 (from center of pyramid to center of area 1)
     // 1 - length of port 2 (from center of pyramid to center of area 2)
     // 2 - length of port 3 (from center of pyramid to center of area 3)
@@ -1692,194 +2170,192 @@ unsigned int MaterialPyramidPennesEigen(struct dataForSimulation *input, struct
     // 11 - pyramid's center x
     // 12 - pyramid's center y
     // 13 - pyramid's center z
+    // the elements are independent. Each thread saves the entries of M and tau
+    // in its own list, and the lists become M and tau in tlmAssembleElementsEigen
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(static) num_threads(input->simulationInput.nOpenMPcores) \
+        private(numbersNodeAndPort, j2, Cd, Z, R, G, Is, Zhat, tau, tempVar)
+#endif
     for (unsigned long long i = 0; i < input->mesh.quantityOfSpecificElement[7]; i++) {
+        std::vector< Triplet<double, long long> > &tripletsM = matrices->tripletsM[tlmThreadEigen()];
+        std::vector< Triplet<double, long long> > &tripletsTau = matrices->tripletsTau[tlmThreadEigen()];
+
         // i: element level
-        // j: material (of equation id) type level
-        // k: different tag numbers for the same material type
-        // j2: the material number from equation. Used to reduce the access to input->equationInput[id].materialNumbers[j]
-        for (unsigned int j = 0; j < input->equationInput[id].numberOfMaterials; j++)
-            for (unsigned int k = 0; k < input->materialInput[ input->equationInput[id].materialNumbers[j] ].quantityOfNumberInput; k++)
-                if (input->mesh.elements.Pyramid[i].tag == input->materialInput[ input->equationInput[id].materialNumbers[j] ].numberInput[k]) {
-                    j2 = input->equationInput[id].materialNumbers[j];
-                    // I will use goto to get out of these two inner 'for' loops. Bare in mind
-                    // that I'm just getting out the loops. You can also think that 
-                    // I'm going to the next 'i', that is, incrementing i by 1 and going
-                    // to the next value of i (if any).
-                    getRealNodeAndPort_fromAbstractNode(7, // element code
-                            i, // element number
-                            matrices->numbers.abstractPortsToReal,
-                            numbersNodeAndPort);
-
-                    // the -1 is necessary because the C indexing starts at zero
-                    // and my number of node starts at 1
-                    getGeometricalVariablesTLMpyramid(&input->mesh.nodes[input->mesh.elements.Pyramid[i].N1 - 1],
-                            &input->mesh.nodes[input->mesh.elements.Pyramid[i].N2 - 1],
-                            &input->mesh.nodes[input->mesh.elements.Pyramid[i].N3 - 1],
-                            &input->mesh.nodes[input->mesh.elements.Pyramid[i].N4 - 1],
-                            &input->mesh.nodes[input->mesh.elements.Pyramid[i].N5 - 1], tempVar);
-
-                    matrices->L[numbersNodeAndPort[1] + 0] = tempVar[5]; // area of face 1
-                    matrices->L[numbersNodeAndPort[1] + 1] = tempVar[6]; // area of face 2
-                    matrices->L[numbersNodeAndPort[1] + 2] = tempVar[7]; // area of face 3
-                    matrices->L[numbersNodeAndPort[1] + 3] = tempVar[8]; // area of face 4
-                    matrices->L[numbersNodeAndPort[1] + 4] = tempVar[9]; // area of face 5
-
-                    matrices->deltal[numbersNodeAndPort[1] + 0] = tempVar[0]; // length of port 1
-                    matrices->deltal[numbersNodeAndPort[1] + 1] = tempVar[1]; // length of port 2
-                    matrices->deltal[numbersNodeAndPort[1] + 2] = tempVar[2]; // length of port 3
-                    matrices->deltal[numbersNodeAndPort[1] + 3] = tempVar[3]; // length of port 4
-                    matrices->deltal[numbersNodeAndPort[1] + 4] = tempVar[4]; // length of port 5
-
-                    // generalization of Cd
-                    Cd = tempVar[10] * input->materialInput[j2].generalized_coefficient_b /
-                            (tempVar[0] + tempVar[1] + tempVar[2] + tempVar[3] + tempVar[4]);
-
-                    // generalization of R
-                    R[0] = tempVar[0] / (input->materialInput[j2].generalized_diffusionCoeff * tempVar[5]);
-                    R[1] = tempVar[1] / (input->materialInput[j2].generalized_diffusionCoeff * tempVar[6]);
-                    R[2] = tempVar[2] / (input->materialInput[j2].generalized_diffusionCoeff * tempVar[7]);
-                    R[3] = tempVar[3] / (input->materialInput[j2].generalized_diffusionCoeff * tempVar[8]);
-                    R[4] = tempVar[4] / (input->materialInput[j2].generalized_diffusionCoeff * tempVar[9]);
-
-                    // generalization of G
-                    G = tempVar[10] * input->materialInput[j2].generalized_sink_a;
-
-                    // generalization of Is
-                    Is = tempVar[10] * input->materialInput[j2].generalized_source;
-
-                    // Z = dt/(2*C*deltal).
-                    Z[0] = input->equationInput[id].timeStep / (2 * Cd);
-                    Z[1] = Z[0] / tempVar[1];
-                    Z[2] = Z[0] / tempVar[2];
-                    Z[3] = Z[0] / tempVar[3];
-                    Z[4] = Z[0] / tempVar[4];
-                    Z[0] = Z[0] / tempVar[0];
-
-                    // all the impedances
-                    matrices->Z[numbersNodeAndPort[1] + 0] = Z[0];
-                    matrices->Z[numbersNodeAndPort[1] + 1] = Z[1];
-                    matrices->Z[numbersNodeAndPort[1] + 2] = Z[2];
-                    matrices->Z[numbersNodeAndPort[1] + 3] = Z[3];
-                    matrices->Z[numbersNodeAndPort[1] + 4] = Z[4];
-
-                    // all the resistances
-                    matrices->R[numbersNodeAndPort[1] + 0] = R[0];
-                    matrices->R[numbersNodeAndPort[1] + 1] = R[1];
-                    matrices->R[numbersNodeAndPort[1] + 2] = R[2];
-                    matrices->R[numbersNodeAndPort[1] + 3] = R[3];
-                    matrices->R[numbersNodeAndPort[1] + 4] = R[4];
-
-
-                    // Manually validated
-                    Zhat = 1 / (1 / Z[0] + 1 / Z[1] + 1 / Z[2] + 1 / Z[3] + 1 / Z[4] + G);
-
-                    // Manually validated
-                    tau[0] = 2 * Zhat / Z[0];
-                    tau[1] = 2 * Zhat / Z[1];
-                    tau[2] = 2 * Zhat / Z[2];
-                    tau[3] = 2 * Zhat / Z[3];
-                    tau[4] = 2 * Zhat / Z[4];
-
-                    // this is actually matrix S.
-                    // M = C*S
-                    // this matrix is M[line][column].
-                    matrices->M.insert(numbersNodeAndPort[1] + 0,
-                            numbersNodeAndPort[1] + 0) = tau[0] - 1;
-                    matrices->M.insert(numbersNodeAndPort[1] + 0,
-                            numbersNodeAndPort[1] + 1) = tau[1];
-                    matrices->M.insert(numbersNodeAndPort[1] + 0,
-                            numbersNodeAndPort[1] + 2) = tau[2];
-                    matrices->M.insert(numbersNodeAndPort[1] + 0,
-                            numbersNodeAndPort[1] + 3) = tau[3];
-                    matrices->M.insert(numbersNodeAndPort[1] + 0,
-                            numbersNodeAndPort[1] + 4) = tau[4];
-
-                    matrices->M.insert(numbersNodeAndPort[1] + 1,
-                            numbersNodeAndPort[1] + 0) = tau[0];
-                    matrices->M.insert(numbersNodeAndPort[1] + 1,
-                            numbersNodeAndPort[1] + 1) = tau[1] - 1;
-                    matrices->M.insert(numbersNodeAndPort[1] + 1,
-                            numbersNodeAndPort[1] + 2) = tau[2];
-                    matrices->M.insert(numbersNodeAndPort[1] + 1,
-                            numbersNodeAndPort[1] + 3) = tau[3];
-                    matrices->M.insert(numbersNodeAndPort[1] + 1,
-                            numbersNodeAndPort[1] + 4) = tau[4];
-
-                    matrices->M.insert(numbersNodeAndPort[1] + 2,
-                            numbersNodeAndPort[1] + 0) = tau[0];
-                    matrices->M.insert(numbersNodeAndPort[1] + 2,
-                            numbersNodeAndPort[1] + 1) = tau[1];
-                    matrices->M.insert(numbersNodeAndPort[1] + 2,
-                            numbersNodeAndPort[1] + 2) = tau[2] - 1;
-                    matrices->M.insert(numbersNodeAndPort[1] + 2,
-                            numbersNodeAndPort[1] + 3) = tau[3];
-                    matrices->M.insert(numbersNodeAndPort[1] + 2,
-                            numbersNodeAndPort[1] + 4) = tau[4];
-
-                    matrices->M.insert(numbersNodeAndPort[1] + 3,
-                            numbersNodeAndPort[1] + 0) = tau[0];
-                    matrices->M.insert(numbersNodeAndPort[1] + 3,
-                            numbersNodeAndPort[1] + 1) = tau[1];
-                    matrices->M.insert(numbersNodeAndPort[1] + 3,
-                            numbersNodeAndPort[1] + 2) = tau[2];
-                    matrices->M.insert(numbersNodeAndPort[1] + 3,
-                            numbersNodeAndPort[1] + 3) = tau[3] - 1;
-                    matrices->M.insert(numbersNodeAndPort[1] + 3,
-                            numbersNodeAndPort[1] + 4) = tau[4];
-
-                    matrices->M.insert(numbersNodeAndPort[1] + 4,
-                            numbersNodeAndPort[1] + 0) = tau[0];
-                    matrices->M.insert(numbersNodeAndPort[1] + 4,
-                            numbersNodeAndPort[1] + 1) = tau[1];
-                    matrices->M.insert(numbersNodeAndPort[1] + 4,
-                            numbersNodeAndPort[1] + 2) = tau[2];
-                    matrices->M.insert(numbersNodeAndPort[1] + 4,
-                            numbersNodeAndPort[1] + 3) = tau[3];
-                    matrices->M.insert(numbersNodeAndPort[1] + 4,
-                            numbersNodeAndPort[1] + 4) = tau[4] - 1;
-
-                    // matrix tau
-                    matrices->tau.insert(numbersNodeAndPort[0],
-                            numbersNodeAndPort[1] + 0) = tau[0];
-                    matrices->tau.insert(numbersNodeAndPort[0],
-                            numbersNodeAndPort[1] + 1) = tau[1];
-                    matrices->tau.insert(numbersNodeAndPort[0],
-                            numbersNodeAndPort[1] + 2) = tau[2];
-                    matrices->tau.insert(numbersNodeAndPort[0],
-                            numbersNodeAndPort[1] + 3) = tau[3];
-                    matrices->tau.insert(numbersNodeAndPort[0],
-                            numbersNodeAndPort[1] + 4) = tau[4];
-
-                    // this is actually matrix ZIS.
-                    // E = C*ZIS + B
-                    matrices->E(numbersNodeAndPort[1] + 0) = Zhat*Is;
-                    matrices->E(numbersNodeAndPort[1] + 1) = Zhat*Is;
-                    matrices->E(numbersNodeAndPort[1] + 2) = Zhat*Is;
-                    matrices->E(numbersNodeAndPort[1] + 3) = Zhat*Is;
-                    matrices->E(numbersNodeAndPort[1] + 4) = Zhat*Is;
-
-                    // matrix E_output
-                    matrices->E_output(numbersNodeAndPort[0]) = Zhat*Is;
-
-                    // the center of the pyramid
-                    matrices->Points_output[numbersNodeAndPort[0]].x = tempVar[11];
-                    matrices->Points_output[numbersNodeAndPort[0]].y = tempVar[12];
-                    matrices->Points_output[numbersNodeAndPort[0]].z = tempVar[13];
-
-                    // Vi0 = (Ti - ZIS)/sum(tau)
-                    // generalization of the initial value
-                    matrices->Vi(numbersNodeAndPort[1]) = (input->materialInput[j2].generalized_initialScalar
-                            - matrices->E(numbersNodeAndPort[1])) / (tau[0] + tau[1] + tau[2] + tau[3] + tau[4]);
-                    matrices->Vi(numbersNodeAndPort[1] + 1) = matrices->Vi(numbersNodeAndPort[1]);
-                    matrices->Vi(numbersNodeAndPort[1] + 2) = matrices->Vi(numbersNodeAndPort[1]);
-                    matrices->Vi(numbersNodeAndPort[1] + 3) = matrices->Vi(numbersNodeAndPort[1]);
-                    matrices->Vi(numbersNodeAndPort[1] + 4) = matrices->Vi(numbersNodeAndPort[1]);
-
-
-                    goto end_for_j_and_for_k_pyramid;
-                }
-end_for_j_and_for_k_pyramid:
-        ;
+        // j2: the material of the element, from the table of tags of the equation
+        if (getTagTLMnumbers(&(matrices->numbers), input->mesh.elements.Pyramid[i].tag, &j2) == 2) {
+            getRealNodeAndPort_fromAbstractNode(7, // element code
+                    i, // element number
+                    matrices->numbers.abstractPortsToReal,
+                    numbersNodeAndPort);
+
+            // the -1 is necessary because the C indexing starts at zero
+            // and my number of node starts at 1
+            getGeometricalVariablesTLMpyramid(&input->mesh.nodes[input->mesh.elements.Pyramid[i].N1 - 1],
+                    &input->mesh.nodes[input->mesh.elements.Pyramid[i].N2 - 1],
+                    &input->mesh.nodes[input->mesh.elements.Pyramid[i].N3 - 1],
+                    &input->mesh.nodes[input->mesh.elements.Pyramid[i].N4 - 1],
+                    &input->mesh.nodes[input->mesh.elements.Pyramid[i].N5 - 1], tempVar);
+
+            matrices->L[numbersNodeAndPort[1] + 0] = tempVar[5]; // area of face 1
+            matrices->L[numbersNodeAndPort[1] + 1] = tempVar[6]; // area of face 2
+            matrices->L[numbersNodeAndPort[1] + 2] = tempVar[7]; // area of face 3
+            matrices->L[numbersNodeAndPort[1] + 3] = tempVar[8]; // area of face 4
+            matrices->L[numbersNodeAndPort[1] + 4] = tempVar[9]; // area of face 5
+
+            matrices->deltal[numbersNodeAndPort[1] + 0] = tempVar[0]; // length of port 1
+            matrices->deltal[numbersNodeAndPort[1] + 1] = tempVar[1]; // length of port 2
+            matrices->deltal[numbersNodeAndPort[1] + 2] = tempVar[2]; // length of port 3
+            matrices->deltal[numbersNodeAndPort[1] + 3] = tempVar[3]; // length of port 4
+            matrices->deltal[numbersNodeAndPort[1] + 4] = tempVar[4]; // length of port 5
+
+            // generalization of Cd
+            Cd = tempVar[10] * input->materialInput[j2].generalized_coefficient_b /
+                    (tempVar[0] + tempVar[1] + tempVar[2] + tempVar[3] + tempVar[4]);
+
+            // generalization of R
+            R[0] = tempVar[0] / (input->materialInput[j2].generalized_diffusionCoeff * tempVar[5]);
+            R[1] = tempVar[1] / (input->materialInput[j2].generalized_diffusionCoeff * tempVar[6]);
+            R[2] = tempVar[2] / (input->materialInput[j2].generalized_diffusionCoeff * tempVar[7]);
+            R[3] = tempVar[3] / (input->materialInput[j2].generalized_diffusionCoeff * tempVar[8]);
+            R[4] = tempVar[4] / (input->materialInput[j2].generalized_diffusionCoeff * tempVar[9]);
+
+            // generalization of G
+            G = tempVar[10] * input->materialInput[j2].generalized_sink_a;
+
+            // generalization of Is
+            Is = tempVar[10] * input->materialInput[j2].generalized_source;
+
+            // Z = dt/(2*C*deltal).
+            Z[0] = input->equationInput[id].timeStep / (2 * Cd);
+            Z[1] = Z[0] / tempVar[1];
+            Z[2] = Z[0] / tempVar[2];
+            Z[3] = Z[0] / tempVar[3];
+            Z[4] = Z[0] / tempVar[4];
+            Z[0] = Z[0] / tempVar[0];
+
+            // all the impedances
+            matrices->Z[numbersNodeAndPort[1] + 0] = Z[0];
+            matrices->Z[numbersNodeAndPort[1] + 1] = Z[1];
+            matrices->Z[numbersNodeAndPort[1] + 2] = Z[2];
+            matrices->Z[numbersNodeAndPort[1] + 3] = Z[3];
+            matrices->Z[numbersNodeAndPort[1] + 4] = Z[4];
+
+            // all the resistances
+            matrices->R[numbersNodeAndPort[1] + 0] = R[0];
+            matrices->R[numbersNodeAndPort[1] + 1] = R[1];
+            matrices->R[numbersNodeAndPort[1] + 2] = R[2];
+            matrices->R[numbersNodeAndPort[1] + 3] = R[3];
+            matrices->R[numbersNodeAndPort[1] + 4] = R[4];
+
+
+            // Manually validated
+            Zhat = 1 / (1 / Z[0] + 1 / Z[1] + 1 / Z[2] + 1 / Z[3] + 1 / Z[4] + G);
+
+            // Manually validated
+            tau[0] = 2 * Zhat / Z[0];
+            tau[1] = 2 * Zhat / Z[1];
+            tau[2] = 2 * Zhat / Z[2];
+            tau[3] = 2 * Zhat / Z[3];
+            tau[4] = 2 * Zhat / Z[4];
+
+            // this is actually matrix S.
+            // M = C*S
+            // this matrix is M[line][column].
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 0,
+                    numbersNodeAndPort[1] + 0, tau[0] - 1);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 0,
+                    numbersNodeAndPort[1] + 1, tau[1]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 0,
+                    numbersNodeAndPort[1] + 2, tau[2]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 0,
+                    numbersNodeAndPort[1] + 3, tau[3]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 0,
+                    numbersNodeAndPort[1] + 4, tau[4]);
+
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 1,
+                    numbersNodeAndPort[1] + 0, tau[0]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 1,
+                    numbersNodeAndPort[1] + 1, tau[1] - 1);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 1,
+                    numbersNodeAndPort[1] + 2, tau[2]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 1,
+                    numbersNodeAndPort[1] + 3, tau[3]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 1,
+                    numbersNodeAndPort[1] + 4, tau[4]);
+
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 2,
+                    numbersNodeAndPort[1] + 0, tau[0]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 2,
+                    numbersNodeAndPort[1] + 1, tau[1]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 2,
+                    numbersNodeAndPort[1] + 2, tau[2] - 1);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 2,
+                    numbersNodeAndPort[1] + 3, tau[3]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 2,
+                    numbersNodeAndPort[1] + 4, tau[4]);
+
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 3,
+                    numbersNodeAndPort[1] + 0, tau[0]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 3,
+                    numbersNodeAndPort[1] + 1, tau[1]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 3,
+                    numbersNodeAndPort[1] + 2, tau[2]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 3,
+                    numbersNodeAndPort[1] + 3, tau[3] - 1);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 3,
+                    numbersNodeAndPort[1] + 4, tau[4]);
+
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 4,
+                    numbersNodeAndPort[1] + 0, tau[0]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 4,
+                    numbersNodeAndPort[1] + 1, tau[1]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 4,
+                    numbersNodeAndPort[1] + 2, tau[2]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 4,
+                    numbersNodeAndPort[1] + 3, tau[3]);
+            tripletsM.emplace_back(numbersNodeAndPort[1] + 4,
+                    numbersNodeAndPort[1] + 4, tau[4] - 1);
+
+            // matrix tau
+            tripletsTau.emplace_back(numbersNodeAndPort[0],
+                    numbersNodeAndPort[1] + 0, tau[0]);
+            tripletsTau.emplace_back(numbersNodeAndPort[0],
+                    numbersNodeAndPort[1] + 1, tau[1]);
+            tripletsTau.emplace_back(numbersNodeAndPort[0],
+                    numbersNodeAndPort[1] + 2, tau[2]);
+            tripletsTau.emplace_back(numbersNodeAndPort[0],
+                    numbersNodeAndPort[1] + 3, tau[3]);
+            tripletsTau.emplace_back(numbersNodeAndPort[0],
+                    numbersNodeAndPort[1] + 4, tau[4]);
+
+            // this is actually matrix ZIS.
+            // E = C*ZIS + B
+            matrices->E(numbersNodeAndPort[1] + 0) = Zhat*Is;
+            matrices->E(numbersNodeAndPort[1] + 1) = Zhat*Is;
+            matrices->E(numbersNodeAndPort[1] + 2) = Zhat*Is;
+            matrices->E(numbersNodeAndPort[1] + 3) = Zhat*Is;
+            matrices->E(numbersNodeAndPort[1] + 4) = Zhat*Is;
+
+            // matrix E_output
+            matrices->E_output(numbersNodeAndPort[0]) = Zhat*Is;
+
+            // the volume of the node, used by the statistics
+            matrices->volume[numbersNodeAndPort[0]] = tempVar[10];
+
+            // the center of the pyramid
+            matrices->Points_output[numbersNodeAndPort[0]].x = tempVar[11];
+            matrices->Points_output[numbersNodeAndPort[0]].y = tempVar[12];
+            matrices->Points_output[numbersNodeAndPort[0]].z = tempVar[13];
+
+            // Vi0 = (Ti - ZIS)/sum(tau)
+            // generalization of the initial value
+            matrices->Vi(numbersNodeAndPort[1]) = (input->materialInput[j2].generalized_initialScalar
+                    - matrices->E(numbersNodeAndPort[1])) / (tau[0] + tau[1] + tau[2] + tau[3] + tau[4]);
+            matrices->Vi(numbersNodeAndPort[1] + 1) = matrices->Vi(numbersNodeAndPort[1]);
+            matrices->Vi(numbersNodeAndPort[1] + 2) = matrices->Vi(numbersNodeAndPort[1]);
+            matrices->Vi(numbersNodeAndPort[1] + 3) = matrices->Vi(numbersNodeAndPort[1]);
+            matrices->Vi(numbersNodeAndPort[1] + 4) = matrices->Vi(numbersNodeAndPort[1]);
+        }
     }
     return 0;
 }
@@ -1894,10 +2370,9 @@ end_for_j_and_for_k_pyramid:
 unsigned int connectionsAndBoundariesPennesEigen(struct calculationTLMEigen *matrices,
         struct boundaryData* boundaries, struct connectionLeveln *connection,
         struct dataForSimulation *input, int id) {
-    // TODO: THIS IS A GOOD CANDIDATE FOR OPENMP PARALLELIZATION. ANALYSE AND DO IT
     unsigned errorTLMnumber = 0;
 
-    unsigned long long i, j1, offset, j2, j3, offset_TB, offset_heat_flux;
+    unsigned long long i, j1, offset, j3, offset_TB, offset_heat_flux;
 
     offset_TB = matrices->numbers.Nodes * input->equationInput[id].saveScalar;
     // starting position to calculate the temperature between nodes
@@ -1911,6 +2386,15 @@ unsigned int connectionsAndBoundariesPennesEigen(struct calculationTLMEigen *mat
         return errorTLMnumber;
     }
 
+    // where the line of S of each port goes. M and tau are built from S with
+    // them in tlmConnectPortsEigen, after all the intersections are visited
+    std::vector<double> reflection(matrices->M.cols(), 1);
+    std::vector< Triplet<double, long long> > transmission, output;
+    transmission.reserve(matrices->numbers.Ports);
+    if (input->equationInput[id].saveScalarBetween || input->equationInput[id].saveFlux) {
+        output.reserve(2 * matrices->numbers.Intersections *
+                (input->equationInput[id].saveScalarBetween + input->equationInput[id].saveFlux));
+    }
 
     for (i = 0; i < connection->accumulatedIntersections[0]; i++) {
         getPortsOrPoints(connection, i, &(coeff.portsNumbers));
@@ -1922,6 +2406,17 @@ unsigned int connectionsAndBoundariesPennesEigen(struct calculationTLMEigen *mat
             return errorTLMnumber;
         }
 
+        // the matrix-free engine saves only one connected port for each port
+        if (matrices->matrixFree.used == 1 && coeff.startEnd[0] > 2) {
+            return 8751;
+        }
+
+        // the node system only needs the coefficients of the intersection. B
+        // does not have the transmission of E yet
+        if (matrices->nodeSystem.used == 1) {
+            tlmAddConnectionToNodeSystemEigen(matrices, &coeff);
+        }
+
 
         // efficient TLM matrix multiplication. From kVr = S*kVi to k+1Vi = M*kVi
         for (j1 = 0; j1 < coeff.startEnd[0]; j1++) {
@@ -1958,15 +2453,12 @@ unsigned int connectionsAndBoundariesPennesEigen(struct calculationTLMEigen *mat
                         + coeff.transmission_out[j1] * matrices->E(coeff.startEnd[j1 * coeff.distanceBetweenPorts + coeff.offsetStubPort])
                         + coeff.B_out[j1];
                 // transmission effects of port j1 into TB. Besides port numbering,
-                // this doesn't change with stub
-                for (j2 = coeff.startEnd[j1 * coeff.distanceBetweenPorts + coeff.offsetStubPortFirst]; j2 < coeff.startEnd[j1 * coeff.distanceBetweenPorts + coeff.offsetStubPortLast]; j2++) {
-                    matrices->tau.insert(offset_TB + i, j2) =
-                            coeff.transmission_out[j1] * matrices->M.coeff(coeff.startEnd[j1 * coeff.distanceBetweenPorts + coeff.offsetStubPort], j2);
-                    // I fix the line of matrix M and I go in the different columns. At this point of the code,
-                    // M is in kVr = M*kVi. So, I'm calculating the effects of kVr on the temperature between nodes (TB).
-                    // No that columns in M represents effect of different ports on the port that I'm now (which I 
-                    // calculate using coeff.startEnd[j1 * coeff.distanceBetweenPorts + coeff.offsetStubPort] )
-                }
+                // this doesn't change with stub. M is in kVr = M*kVi, so this is
+                // the effect of kVr of port j1 (its line of S) on the temperature
+                // between nodes (TB)
+                output.push_back(Triplet<double, long long>(
+                        coeff.startEnd[j1 * coeff.distanceBetweenPorts + coeff.offsetStubPort],
+                        offset_TB + i, coeff.transmission_out[j1]));
             }
 
 
@@ -1979,31 +2471,39 @@ unsigned int connectionsAndBoundariesPennesEigen(struct calculationTLMEigen *mat
                         // the effect of port 1
                         + coeff.transmission_out_flux[j1] * matrices->E(coeff.startEnd[j1 * coeff.distanceBetweenPorts + coeff.offsetStubPort])
                         + coeff.B_out_flux[j1];
-                // transmission effects of port j1 into TB. Besides port numbering,
-                // this doesn't change with stub
-                for (j2 = coeff.startEnd[j1 * coeff.distanceBetweenPorts + coeff.offsetStubPortFirst]; j2 < coeff.startEnd[j1 * coeff.distanceBetweenPorts + coeff.offsetStubPortLast]; j2++) {
-                    matrices->tau.insert(offset_heat_flux + i, j2) =
-                            coeff.transmission_out_flux[j1] * matrices->M.coeff(coeff.startEnd[j1 * coeff.distanceBetweenPorts + coeff.offsetStubPort], j2);
-                    // I fix the line of matrix M and I go in the different columns. At this point of the code,
-                    // M is in kVr = M*kVi. So, I'm calculating the effects of kVr on the temperature between nodes (TB).
-                    // No that columns in M represents effect of different ports on the port that I'm now (which I 
-                    // calculate using coeff.startEnd[j1 * coeff.distanceBetweenPorts + coeff.offsetStubPort] )
-                }
+                // transmission effects of port j1 into the heat flux. Besides port
+                // numbering, this doesn't change with stub
+                output.push_back(Triplet<double, long long>(
+                        coeff.startEnd[j1 * coeff.distanceBetweenPorts + coeff.offsetStubPort],
+                        offset_heat_flux + i, coeff.transmission_out_flux[j1]));
             }
 
 
             // Now I will calculate how to go from kVr to k+1Vi
             for (j3 = j1 + 1; j3 < coeff.startEnd[0]; j3++) {
-                // transmission effects of port j1 into port j3
-                for (j2 = coeff.startEnd[j1 * coeff.distanceBetweenPorts + coeff.offsetStubPortFirst]; j2 < coeff.startEnd[j1 * coeff.distanceBetweenPorts + coeff.offsetStubPortLast]; j2++) {
-                    matrices->M.insert(coeff.startEnd[j3 * coeff.distanceBetweenPorts + coeff.offsetStubPort], j2) =
-                            coeff.transmission[offset] * matrices->M.coeff(coeff.startEnd[j1 * coeff.distanceBetweenPorts + coeff.offsetStubPort], j2);
-                }
-
-                // transmission effects of port j3 into port j1
-                for (j2 = coeff.startEnd[j3 * coeff.distanceBetweenPorts + coeff.offsetStubPortFirst]; j2 < coeff.startEnd[j3 * coeff.distanceBetweenPorts + coeff.offsetStubPortLast]; j2++) {
-                    matrices->M.insert(coeff.startEnd[j1 * coeff.distanceBetweenPorts + coeff.offsetStubPort], j2) =
-                            coeff.transmission[offset + (coeff.startEnd[0] - 1) * j3] * matrices->M.coeff(coeff.startEnd[j3 * coeff.distanceBetweenPorts + coeff.offsetStubPort], j2);
+                if (matrices->matrixFree.used == 1) {
+                    // I only save the coefficients. S stays in M until the end
+                    matrices->matrixFree.connectedPort[coeff.startEnd[j3 * coeff.distanceBetweenPorts + coeff.offsetStubPort]] =
+                            coeff.startEnd[j1 * coeff.distanceBetweenPorts + coeff.offsetStubPort];
+                    matrices->matrixFree.transmission[coeff.startEnd[j3 * coeff.distanceBetweenPorts + coeff.offsetStubPort]] =
+                            coeff.transmission[offset];
+
+                    matrices->matrixFree.connectedPort[coeff.startEnd[j1 * coeff.distanceBetweenPorts + coeff.offsetStubPort]] =
+                            coeff.startEnd[j3 * coeff.distanceBetweenPorts + coeff.offsetStubPort];
+                    matrices->matrixFree.transmission[coeff.startEnd[j1 * coeff.distanceBetweenPorts + coeff.offsetStubPort]] =
+                            coeff.transmission[offset + (coeff.startEnd[0] - 1) * j3];
+                } else if (matrices->nodeSystem.used == 0) {
+                    // transmission effects of port j1 into port j3
+                    transmission.push_back(Triplet<double, long long>(
+                            coeff.startEnd[j1 * coeff.distanceBetweenPorts + coeff.offsetStubPort],
+                            coeff.startEnd[j3 * coeff.distanceBetweenPorts + coeff.offsetStubPort],
+                            coeff.transmission[offset]));
+
+                    // transmission effects of port j3 into port j1
+                    transmission.push_back(Triplet<double, long long>(
+                            coeff.startEnd[j3 * coeff.distanceBetweenPorts + coeff.offsetStubPort],
+                            coeff.startEnd[j1 * coeff.distanceBetweenPorts + coeff.offsetStubPort],
+                            coeff.transmission[offset + (coeff.startEnd[0] - 1) * j3]));
                 }
 
                 // transmission effects of port j3 into port j1
@@ -2018,9 +2518,12 @@ unsigned int connectionsAndBoundariesPennesEigen(struct calculationTLMEigen *mat
 
         // reflection effects
         for (j1 = 0; j1 < coeff.startEnd[0]; j1++) {
-            for (j2 = coeff.startEnd[j1 * coeff.distanceBetweenPorts + coeff.offsetStubPortFirst]; j2 < coeff. startEnd[j1 * coeff.distanceBetweenPorts + coeff.offsetStubPortLast]; j2++) {
-                matrices->M.coeffRef(coeff.startEnd[j1 * coeff.distanceBetweenPorts + coeff.offsetStubPort], j2) =
-                        coeff.reflection[j1] * matrices->M.coeff(coeff.startEnd[j1 * coeff.distanceBetweenPorts + coeff.offsetStubPort], j2);
+            if (matrices->matrixFree.used == 1) {
+                matrices->matrixFree.reflection[coeff.startEnd[j1 * coeff.distanceBetweenPorts + coeff.offsetStubPort]] =
+                        coeff.reflection[j1];
+            } else if (matrices->nodeSystem.used == 0) {
+                reflection[coeff.startEnd[j1 * coeff.distanceBetweenPorts + coeff.offsetStubPort]] =
+                        coeff.reflection[j1];
             }
             matrices->E(coeff.startEnd[j1 * coeff.distanceBetweenPorts + coeff.offsetStubPort]) =
                     coeff.reflection[j1] * matrices->E(coeff.startEnd[j1 * coeff.distanceBetweenPorts + coeff.offsetStubPort])
@@ -2030,8 +2533,14 @@ unsigned int connectionsAndBoundariesPennesEigen(struct calculationTLMEigen *mat
 
     }
 
-    matrices->M.makeCompressed();
-    matrices->tau.makeCompressed();
+    // S is only needed for tau if the matrix-free engine is used, since it has
+    // its own copy of the scattering coefficients, or if the node system is
+    // used, since it does not use S
+    if ((errorTLMnumber = tlmConnectPortsEigen(matrices, reflection, transmission, output,
+            matrices->matrixFree.used == 0 && matrices->nodeSystem.used == 0,
+            input->simulationInput.nOpenMPcores)) != 0) {
+        return errorTLMnumber;
+    }
 
     // terminating the variable that contains the coefficients
     if ((errorTLMnumber = terminateConnectionAndBoundaryCoefficients(&coeff)) != 0) {
@@ -47,6 +47,11 @@ unsigned int calculateMatricesPennesEigen(struct dataForSimulation *,
         struct calculationTLMEigen *, struct boundaryData**,
         struct connectionLeveln *, int);
 
+unsigned int calculateScenariosPennesEigen(struct dataForSimulation *,
+        struct calculationTLMEigen *, int);
+
+unsigned int solverSweepPennesEigen(struct dataForSimulation *, int);
+
 unsigned int MaterialLinePennesEigen(struct dataForSimulation *,
         struct calculationTLMEigen *, int id);
 